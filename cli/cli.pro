@@ -0,0 +1,30 @@
+include (../common.pri)
+include (../lib/core.pri)
+
+# The command line interface neither links the library nor Qt's GUI modules, but compiles the
+# library's GUI-independent sources together with a headless OpenGL implementation
+QT             -= gui widgets opengl openglextensions
+TEMPLATE        = app
+DESTDIR         = $$OUT_PWD/..
+DEPENDPATH     += src 
+INCLUDEPATH    += src $$PWD/../lib/src
+SOURCES        += src/main.cpp src/opengl-headless.cpp
+
+for (source, CORE_SOURCES): SOURCES += ../lib/$$source
+for (header, CORE_HEADERS): HEADERS += ../lib/$$header
+
+CONFIG(release, debug|release): TARGET = dilay-cli
+CONFIG(debug  , debug|release): TARGET = dilay-cli_debug
+
+win32 {
+  CONFIG += console
+  LIBS   += -lpsapi
+}
+
+unix {
+  target.path     = $$PREFIX/bin/
+  INSTALLS       += target
+
+  format.commands = clang-format -style=file -i $$SOURCES $$HEADERS
+  QMAKE_EXTRA_TARGETS += format
+}
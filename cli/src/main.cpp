@@ -0,0 +1,431 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <string>
+#include <vector>
+#include "dynamic/mesh.hpp"
+#include "import-export.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "remesh.hpp"
+#include "sketch/mesh.hpp"
+#include "tool/sculpt/util/action.hpp"
+#include "util.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+  enum class StageType
+  {
+    Load,
+    ConvertSketches,
+    ConvertSketchesAdaptive,
+    Remesh,
+    Union,
+    Difference,
+    Intersection,
+    Decimate,
+    Smooth,
+    Export
+  };
+
+  struct Stage
+  {
+    StageType    type;
+    std::string  name;
+    std::string  fileName;
+    float        resolution;
+    unsigned int number;
+  };
+
+  struct Session
+  {
+    std::list<DynamicMesh> meshes;
+    std::list<SketchMesh>  sketches;
+  };
+
+  void printUsage ()
+  {
+    std::cout
+      << "usage: dilay-cli INPUT [STAGE ...]\n"
+      << "\n"
+      << "Loads INPUT (*.dly, *.dlb, *.stl or *.ply) and runs all stages in the given order.\n"
+      << "\n"
+      << "stages:\n"
+      << "  --convert-sketches RESOLUTION  convert all sketches to meshes\n"
+      << "  --convert-adaptive RESOLUTION  convert all sketches with adaptive sampling\n"
+      << "  --remesh RESOLUTION            remesh every mesh\n"
+      << "  --union RESOLUTION             combine all meshes into their union\n"
+      << "  --difference RESOLUTION        subtract all other meshes from the first one\n"
+      << "  --intersection RESOLUTION      combine all meshes into their intersection\n"
+      << "  --decimate FACES               reduce every mesh to at most FACES faces\n"
+      << "  --smooth ITERATIONS            smooth every mesh\n"
+      << "  --output FILE                  save to FILE (*.dly, *.dlb, *.obj, *.stl or *.ply)\n"
+      << "\n"
+      << "Resolutions are given in scene units, e.g. 0.06.  Wall time and peak resident set\n"
+      << "size are reported after each stage.\n";
+  }
+
+  bool parseFloat (const std::string& string, float& value)
+  {
+    char* end = nullptr;
+    value = std::strtof (string.c_str (), &end);
+    return end != string.c_str () && *end == '\0' && value > 0.0f;
+  }
+
+  // Values that don't fit into an `unsigned int` are rejected rather than truncated
+  bool parseUnsigned (const std::string& string, unsigned int& value)
+  {
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long long l = std::strtoull (string.c_str (), &end, 10);
+    value = (unsigned int) l;
+    return end != string.c_str () && *end == '\0' && string[0] != '-' && errno == 0 &&
+           l <= std::numeric_limits<unsigned int>::max ();
+  }
+
+  bool parseStages (int argc, char** argv, std::vector<Stage>& stages)
+  {
+    if (argc < 2 || argv[1][0] == '-')
+    {
+      return false;
+    }
+    stages.push_back (Stage{StageType::Load, "load", argv[1], 0.0f, 0});
+
+    for (int i = 2; i < argc; i++)
+    {
+      const std::string option (argv[i]);
+      Stage             stage{StageType::Load, option.substr (2), "", 0.0f, 0};
+      bool              isValid = true;
+
+      if (i + 1 >= argc)
+      {
+        std::cerr << "missing argument of " << option << "\n";
+        return false;
+      }
+      const std::string argument (argv[++i]);
+
+      if (option == "--convert-sketches")
+      {
+        stage.type = StageType::ConvertSketches;
+        isValid = parseFloat (argument, stage.resolution);
+      }
+      else if (option == "--convert-adaptive")
+      {
+        stage.type = StageType::ConvertSketchesAdaptive;
+        isValid = parseFloat (argument, stage.resolution);
+      }
+      else if (option == "--remesh")
+      {
+        stage.type = StageType::Remesh;
+        isValid = parseFloat (argument, stage.resolution);
+      }
+      else if (option == "--union")
+      {
+        stage.type = StageType::Union;
+        isValid = parseFloat (argument, stage.resolution);
+      }
+      else if (option == "--difference")
+      {
+        stage.type = StageType::Difference;
+        isValid = parseFloat (argument, stage.resolution);
+      }
+      else if (option == "--intersection")
+      {
+        stage.type = StageType::Intersection;
+        isValid = parseFloat (argument, stage.resolution);
+      }
+      else if (option == "--decimate")
+      {
+        stage.type = StageType::Decimate;
+        isValid = parseUnsigned (argument, stage.number);
+      }
+      else if (option == "--smooth")
+      {
+        stage.type = StageType::Smooth;
+        isValid = parseUnsigned (argument, stage.number);
+      }
+      else if (option == "--output")
+      {
+        stage.type = StageType::Export;
+        stage.fileName = argument;
+      }
+      else
+      {
+        std::cerr << "unknown stage " << option << "\n";
+        return false;
+      }
+
+      if (isValid == false)
+      {
+        std::cerr << "invalid argument " << argument << " of " << option << "\n";
+        return false;
+      }
+      stages.push_back (stage);
+    }
+    return true;
+  }
+
+  std::size_t peakResidentSetSize ()
+  {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo (GetCurrentProcess (), &counters, sizeof (counters)))
+    {
+      return counters.PeakWorkingSetSize;
+    }
+#else
+    struct rusage usage;
+    if (getrusage (RUSAGE_SELF, &usage) == 0)
+    {
+#ifdef __APPLE__
+      return std::size_t (usage.ru_maxrss);
+#else
+      return std::size_t (usage.ru_maxrss) * 1024;
+#endif
+    }
+#endif
+    return 0;
+  }
+
+  bool load (const std::string& fileName, Session& session)
+  {
+    ImportExport::SceneData data;
+
+    if (ImportExport::fromDlyFile (fileName, data) == false)
+    {
+      std::cerr << "could not load " << fileName << "\n";
+      return false;
+    }
+    for (const Mesh& m : data.meshes)
+    {
+      if (m.numVertices () == 0)
+      {
+        continue;
+      }
+      else if (MeshUtil::checkConsistency (m) == false)
+      {
+        std::cerr << "inconsistent mesh in " << fileName << "\n";
+        return false;
+      }
+      session.meshes.emplace_back (m);
+    }
+    for (const ImportExport::SketchData& s : data.sketches)
+    {
+      session.sketches.emplace_back ();
+      session.sketches.back ().fromTree (s.tree);
+
+      for (const SketchPath& p : s.paths)
+      {
+        session.sketches.back ().addPath (p);
+      }
+    }
+    return true;
+  }
+
+  bool save (const std::string& fileName, Session& session)
+  {
+    ImportExport::SceneData data;
+
+    for (DynamicMesh& mesh : session.meshes)
+    {
+      mesh.prune ();
+      data.meshes.push_back (mesh.mesh ());
+    }
+    for (const SketchMesh& sketch : session.sketches)
+    {
+      data.sketches.push_back (ImportExport::SketchData{sketch.tree (), sketch.paths ()});
+    }
+
+    const bool isObjFile = Util::hasSuffix (fileName, ".obj");
+    const bool success = Util::withCLocale<bool> ([&fileName, &data, isObjFile]() {
+      return ImportExport::toDlyFile (fileName, data, isObjFile);
+    });
+
+    if (success == false)
+    {
+      std::cerr << "could not save " << fileName << "\n";
+    }
+    return success;
+  }
+
+  void convertSketches (float resolution, bool adaptive, Session& session)
+  {
+    for (SketchMesh& sketch : session.sketches)
+    {
+      DynamicMesh mesh;
+
+      if (adaptive)
+      {
+        Remesh::convertAdaptive (sketch, resolution, 0.0f, mesh);
+      }
+      else
+      {
+        Remesh::convert (sketch, resolution, mesh);
+      }
+
+      if (mesh.isEmpty () == false)
+      {
+        ToolSculptAction::smoothMesh (mesh);
+        session.meshes.push_back (std::move (mesh));
+      }
+    }
+    session.sketches.clear ();
+  }
+
+  void remesh (float resolution, Session& session)
+  {
+    std::list<DynamicMesh> remeshed;
+
+    for (DynamicMesh& mesh : session.meshes)
+    {
+      DynamicMesh extractedMesh;
+      Remesh::remesh (mesh, resolution, extractedMesh);
+
+      if (extractedMesh.isEmpty () == false)
+      {
+        ToolSculptAction::smoothMesh (extractedMesh);
+        remeshed.push_back (std::move (extractedMesh));
+      }
+    }
+    session.meshes.swap (remeshed);
+  }
+
+  // All meshes are combined in a single pass
+  void combine (Remesh::Operation operation, float resolution, Session& session)
+  {
+    if (session.meshes.size () < 2)
+    {
+      return;
+    }
+    std::vector<DynamicMesh*> operands;
+    for (DynamicMesh& mesh : session.meshes)
+    {
+      operands.push_back (&mesh);
+    }
+
+    DynamicMesh extractedMesh;
+    Remesh::remesh (operands, operation, resolution, extractedMesh);
+    session.meshes.clear ();
+
+    if (extractedMesh.isEmpty () == false)
+    {
+      ToolSculptAction::smoothMesh (extractedMesh);
+      session.meshes.push_back (std::move (extractedMesh));
+    }
+  }
+
+  void decimate (unsigned int numFaces, Session& session)
+  {
+    for (DynamicMesh& mesh : session.meshes)
+    {
+      if (mesh.numFaces () > numFaces)
+      {
+        ToolSculptAction::decimate (mesh, numFaces);
+      }
+    }
+  }
+
+  void smooth (unsigned int iterations, Session& session)
+  {
+    for (DynamicMesh& mesh : session.meshes)
+    {
+      for (unsigned int i = 0; i < iterations; i++)
+      {
+        ToolSculptAction::smoothMesh (mesh);
+      }
+    }
+  }
+
+  bool runStage (const Stage& stage, Session& session)
+  {
+    switch (stage.type)
+    {
+      case StageType::Load:
+        return load (stage.fileName, session);
+      case StageType::ConvertSketches:
+        convertSketches (stage.resolution, false, session);
+        return true;
+      case StageType::ConvertSketchesAdaptive:
+        convertSketches (stage.resolution, true, session);
+        return true;
+      case StageType::Remesh:
+        remesh (stage.resolution, session);
+        return true;
+      case StageType::Union:
+        combine (Remesh::Operation::Union, stage.resolution, session);
+        return true;
+      case StageType::Difference:
+        combine (Remesh::Operation::Difference, stage.resolution, session);
+        return true;
+      case StageType::Intersection:
+        combine (Remesh::Operation::Intersection, stage.resolution, session);
+        return true;
+      case StageType::Decimate:
+        decimate (stage.number, session);
+        return true;
+      case StageType::Smooth:
+        smooth (stage.number, session);
+        return true;
+      case StageType::Export:
+        return save (stage.fileName, session);
+    }
+    DILAY_IMPOSSIBLE
+  }
+
+  void printReport (const Stage& stage, double seconds, const Session& session)
+  {
+    unsigned int numFaces = 0;
+    for (const DynamicMesh& mesh : session.meshes)
+    {
+      numFaces += mesh.numFaces ();
+    }
+    const double peakRss = double(peakResidentSetSize ()) / (1024.0 * 1024.0);
+
+    std::cout << std::left << std::setw (18) << stage.name << std::right << std::fixed
+              << std::setprecision (3) << std::setw (10) << seconds << " s" << std::setprecision (1)
+              << std::setw (10) << peakRss << " MiB peak RSS" << std::setw (6)
+              << session.meshes.size () << " meshes" << std::setw (10) << numFaces << " faces"
+              << std::setw (4) << session.sketches.size () << " sketches\n";
+  }
+}
+
+int main (int argc, char** argv)
+{
+  std::vector<Stage> stages;
+
+  if (parseStages (argc, argv, stages) == false)
+  {
+    printUsage ();
+    return 1;
+  }
+
+  Session session;
+  for (const Stage& stage : stages)
+  {
+    const auto start = std::chrono::steady_clock::now ();
+    const bool success = runStage (stage, session);
+    const auto end = std::chrono::steady_clock::now ();
+
+    if (success == false)
+    {
+      return 1;
+    }
+    printReport (stage, std::chrono::duration<double> (end - start).count (), session);
+  }
+  return 0;
+}
@@ -0,0 +1,117 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <glm/glm.hpp>
+#include "opengl.hpp"
+#include "util.hpp"
+
+// There is no OpenGL context without a GUI: meshes are never rendered, and any attempt to do
+// so is an error
+#define HEADLESS_GL_CONSTANT(method) \
+  unsigned int method () { return 0; }
+#define HEADLESS_GL(r, method, ...) \
+  r method (__VA_ARGS__) { DILAY_PANIC ("OpenGL is not available in headless builds") }
+
+namespace OpenGL
+{
+  HEADLESS_GL (void, setDefaultFormat)
+  HEADLESS_GL (void, initializeFunctions, bool)
+
+  bool isInitialized () { return false; }
+
+  HEADLESS_GL_CONSTANT (Always)
+  HEADLESS_GL_CONSTANT (ArrayBuffer)
+  HEADLESS_GL_CONSTANT (Back)
+  HEADLESS_GL_CONSTANT (Blend)
+  HEADLESS_GL_CONSTANT (BufferSize)
+  HEADLESS_GL_CONSTANT (ColorBufferBit)
+  HEADLESS_GL_CONSTANT (CullFace)
+  HEADLESS_GL_CONSTANT (CW)
+  HEADLESS_GL_CONSTANT (CCW)
+  HEADLESS_GL_CONSTANT (Decr)
+  HEADLESS_GL_CONSTANT (DecrWrap)
+  HEADLESS_GL_CONSTANT (DepthBufferBit)
+  HEADLESS_GL_CONSTANT (DepthTest)
+  HEADLESS_GL_CONSTANT (DstColor)
+  HEADLESS_GL_CONSTANT (ElementArrayBuffer)
+  HEADLESS_GL_CONSTANT (Equal)
+  HEADLESS_GL_CONSTANT (Fill)
+  HEADLESS_GL_CONSTANT (Float)
+  HEADLESS_GL_CONSTANT (Front)
+  HEADLESS_GL_CONSTANT (FrontAndBack)
+  HEADLESS_GL_CONSTANT (FuncAdd)
+  HEADLESS_GL_CONSTANT (Greater)
+  HEADLESS_GL_CONSTANT (Incr)
+  HEADLESS_GL_CONSTANT (IncrWrap)
+  HEADLESS_GL_CONSTANT (Invert)
+  HEADLESS_GL_CONSTANT (Keep)
+  HEADLESS_GL_CONSTANT (LEqual)
+  HEADLESS_GL_CONSTANT (Line)
+  HEADLESS_GL_CONSTANT (Lines)
+  HEADLESS_GL_CONSTANT (Never)
+  HEADLESS_GL_CONSTANT (PolygonOffsetFill)
+  HEADLESS_GL_CONSTANT (Replace)
+  HEADLESS_GL_CONSTANT (StaticDraw)
+  HEADLESS_GL_CONSTANT (StencilBufferBit)
+  HEADLESS_GL_CONSTANT (StencilTest)
+  HEADLESS_GL_CONSTANT (Triangles)
+  HEADLESS_GL_CONSTANT (UnsignedInt)
+  HEADLESS_GL_CONSTANT (Zero)
+
+  HEADLESS_GL (void, glBindBuffer, unsigned int, unsigned int)
+  HEADLESS_GL (void, glBlendEquation, unsigned int)
+  HEADLESS_GL (void, glBlendFunc, unsigned int, unsigned int)
+  HEADLESS_GL (void, glBufferData, unsigned int, unsigned int, const void*, unsigned int)
+  HEADLESS_GL (void, glBufferSubData, unsigned int, unsigned int, unsigned int, const void*)
+  HEADLESS_GL (void, glClear, unsigned int)
+  HEADLESS_GL (void, glClearColor, float, float, float, float)
+  HEADLESS_GL (void, glClearStencil, int)
+  HEADLESS_GL (void, glColorMask, bool, bool, bool, bool)
+  HEADLESS_GL (void, glCullFace, unsigned int)
+  HEADLESS_GL (void, glDepthFunc, unsigned int)
+  HEADLESS_GL (void, glDepthMask, bool)
+  HEADLESS_GL (void, glDisable, unsigned int)
+  HEADLESS_GL (void, glDisableVertexAttribArray, unsigned int)
+  HEADLESS_GL (void, glDrawElements, unsigned int, unsigned int, unsigned int, const void*)
+  HEADLESS_GL (void, glDrawElementsInstanced, unsigned int, unsigned int, unsigned int,
+               const void*, unsigned int)
+  HEADLESS_GL (void, glEnable, unsigned int)
+  HEADLESS_GL (void, glEnableVertexAttribArray, unsigned int)
+  HEADLESS_GL (void, glFrontFace, unsigned int)
+  HEADLESS_GL (void, glGenBuffers, unsigned int, unsigned int*)
+  HEADLESS_GL (void, glGetBufferParameteriv, unsigned int, unsigned int, int*)
+  HEADLESS_GL (int, glGetUniformLocation, unsigned int, const char*)
+  HEADLESS_GL (bool, glIsBuffer, unsigned int)
+  HEADLESS_GL (bool, glIsProgram, unsigned int)
+  HEADLESS_GL (void, glPolygonMode, unsigned int, unsigned int)
+  HEADLESS_GL (void, glPolygonOffset, float, float)
+  HEADLESS_GL (void, glStencilFunc, unsigned int, int, unsigned int)
+  HEADLESS_GL (void, glStencilOp, unsigned int, unsigned int, unsigned int)
+  HEADLESS_GL (void, glUniform1f, int, float)
+  HEADLESS_GL (void, glUniformMatrix3fv, int, unsigned int, bool, const float*)
+  HEADLESS_GL (void, glUniformMatrix4fv, int, unsigned int, bool, const float*)
+  HEADLESS_GL (void, glUseProgram, unsigned int)
+  HEADLESS_GL (void, glVertexAttribDivisor, unsigned int, unsigned int)
+  HEADLESS_GL (void, glVertexAttribPointer, unsigned int, int, unsigned int, bool, unsigned int,
+               const void*)
+  HEADLESS_GL (void, glViewport, unsigned int, unsigned int, unsigned int, unsigned int)
+
+  bool hasGeometryShader () { return false; }
+
+  bool hasInstancing () { return false; }
+
+  HEADLESS_GL (void, glUniformVec3, unsigned int, const glm::vec3&)
+  HEADLESS_GL (void, glUniformVec4, unsigned int, const glm::vec4&)
+
+  // Objects are never allocated, but may be released
+  void safeDeleteBuffer (unsigned int& id) { id = 0; }
+
+  void safeDeleteShader (unsigned int& id) { id = 0; }
+
+  void safeDeleteProgram (unsigned int& id) { id = 0; }
+
+  HEADLESS_GL (unsigned int, loadProgram, const char*, const char*, bool)
+  HEADLESS_GL (void, clearError)
+  HEADLESS_GL (void, printError)
+}
@@ -1,6 +1,6 @@
 CONFIG      += debug_and_release
 TEMPLATE     = subdirs
-SUBDIRS      = lib app test
+SUBDIRS      = lib app cli test
 
 app.depends  = lib
 test.depends = lib
@@ -13,6 +13,10 @@ disable-app {
   SUBDIRS -= app
 }
 
+disable-cli {
+  SUBDIRS -= cli
+}
+
 unix {
   gdb.commands = gdb -ex run ./dilay_debug
   valgrind.commands = valgrind ./dilay_debug &> valgrind.log
@@ -0,0 +1,115 @@
+# Sources without Qt GUI dependencies, which are shared by the library and the headless command
+# line interface.  OpenGL is only accessed through `opengl.hpp`, whose implementation is provided
+# by each target.  Paths are relative to this directory.
+CORE_SOURCES = \
+           src/camera.cpp \
+           src/color.cpp \
+           src/config.cpp \
+           src/configurable.cpp \
+           src/dimension.cpp \
+           src/distance.cpp \
+           src/dly-parser.cpp \
+           src/dly-writer.cpp \
+           src/dynamic/faces.cpp \
+           src/dynamic/mesh-intersection.cpp \
+           src/dynamic/mesh.cpp \
+           src/dynamic/octree.cpp \
+           src/import-export.cpp \
+           src/intersection.cpp \
+           src/isosurface-extraction.cpp \
+           src/isosurface-extraction/grid.cpp \
+           src/isosurface-extraction/octree.cpp \
+           src/kvstore.cpp \
+           src/log.cpp \
+           src/mesh-formats.cpp \
+           src/mesh-util.cpp \
+           src/mesh.cpp \
+           src/opengl-buffer-id.cpp \
+           src/primitive/aabox.cpp \
+           src/primitive/cone-sphere.cpp \
+           src/primitive/cone.cpp \
+           src/primitive/cylinder.cpp \
+           src/primitive/plane.cpp \
+           src/primitive/ray.cpp \
+           src/primitive/sphere.cpp \
+           src/primitive/triangle.cpp \
+           src/remesh.cpp \
+           src/render-mode.cpp \
+           src/renderer.cpp \
+           src/scene.cpp \
+           src/shader.cpp \
+           src/sketch/bone-intersection.cpp \
+           src/sketch/bvh.cpp \
+           src/sketch/instances.cpp \
+           src/sketch/mesh-intersection.cpp \
+           src/sketch/mesh.cpp \
+           src/sketch/node-intersection.cpp \
+           src/sketch/path-intersection.cpp \
+           src/sketch/path.cpp \
+           src/sketch/preview.cpp \
+           src/tool/sculpt/util/action.cpp \
+           src/tool/sculpt/util/brush.cpp \
+           src/tool/sculpt/util/edge-collection.cpp \
+           src/util.cpp \
+           src/xml-conversion.cpp \
+
+CORE_HEADERS = \
+           src/bitset.hpp \
+           src/camera.hpp \
+           src/color.hpp \
+           src/config.hpp \
+           src/configurable.hpp \
+           src/dimension.hpp \
+           src/distance.hpp \
+           src/dly-parser.hpp \
+           src/dly-writer.hpp \
+           src/dynamic/faces.hpp \
+           src/dynamic/mesh-changes.hpp \
+           src/dynamic/mesh-intersection.hpp \
+           src/dynamic/mesh.hpp \
+           src/dynamic/octree.hpp \
+           src/hash.hpp \
+           src/import-export.hpp \
+           src/intersection.hpp \
+           src/isosurface-extraction.hpp \
+           src/isosurface-extraction/grid.hpp \
+           src/isosurface-extraction/octree.hpp \
+           src/kvstore.hpp \
+           src/log.hpp \
+           src/macro.hpp \
+           src/maybe.hpp \
+           src/mesh-formats.hpp \
+           src/mesh-util.hpp \
+           src/mesh.hpp \
+           src/opengl-buffer-id.hpp \
+           src/opengl.hpp \
+           src/primitive/aabox.hpp \
+           src/primitive/cone-sphere.hpp \
+           src/primitive/cone.hpp \
+           src/primitive/cylinder.hpp \
+           src/primitive/plane.hpp \
+           src/primitive/ray.hpp \
+           src/primitive/sphere.hpp \
+           src/primitive/triangle.hpp \
+           src/remesh.hpp \
+           src/render-mode.hpp \
+           src/renderer.hpp \
+           src/scene.hpp \
+           src/shader.hpp \
+           src/sketch/bone-intersection.hpp \
+           src/sketch/bvh.hpp \
+           src/sketch/fwd.hpp \
+           src/sketch/instances.hpp \
+           src/sketch/mesh-intersection.hpp \
+           src/sketch/mesh.hpp \
+           src/sketch/node-intersection.hpp \
+           src/sketch/path-intersection.hpp \
+           src/sketch/path.hpp \
+           src/sketch/preview.hpp \
+           src/tool/sculpt/util/action.hpp \
+           src/tool/sculpt/util/brush.hpp \
+           src/tool/sculpt/util/edge-collection.hpp \
+           src/tree.hpp \
+           src/util.hpp \
+           src/variant.hpp \
+           src/xml-conversion.hpp \
@@ -1,4 +1,5 @@
 include (../common.pri)
+include (core.pri)
 
 TEMPLATE     = lib
 TARGET       = dilay
@@ -6,47 +7,12 @@ DEPENDPATH  += src
 INCLUDEPATH += src 
 CONFIG      += staticlib
 
-SOURCES += \
-           src/camera.cpp \
-           src/color.cpp \
-           src/config.cpp \
-           src/configurable.cpp \
-           src/dimension.cpp \
-           src/distance.cpp \
-           src/dynamic/faces.cpp \
-           src/dynamic/mesh.cpp \
-           src/dynamic/mesh-intersection.cpp \
-           src/dynamic/octree.cpp \
+SOURCES += $$CORE_SOURCES \
+           src/autosave.cpp \
+           src/compressed-mesh.cpp \
            src/history.cpp \
-           src/import-export.cpp \
-           src/intersection.cpp \
-           src/isosurface-extraction.cpp \
-           src/isosurface-extraction/grid.cpp \
-           src/kvstore.cpp \
-           src/log.cpp \
-           src/mesh.cpp \
-           src/mesh-util.cpp \
            src/mirror.cpp \
            src/opengl.cpp \
-           src/opengl-buffer-id.cpp \
-           src/primitive/aabox.cpp \
-           src/primitive/cone.cpp \
-           src/primitive/cone-sphere.cpp \
-           src/primitive/cylinder.cpp \
-           src/primitive/plane.cpp \
-           src/primitive/ray.cpp \
-           src/primitive/sphere.cpp \
-           src/primitive/triangle.cpp \
-           src/render-mode.cpp \
-           src/renderer.cpp \
-           src/scene.cpp \
-           src/shader.cpp \
-           src/sketch/bone-intersection.cpp \
-           src/sketch/mesh.cpp \
-           src/sketch/mesh-intersection.cpp \
-           src/sketch/node-intersection.cpp \
-           src/sketch/path.cpp \
-           src/sketch/path-intersection.cpp \
            src/state.cpp \
            src/time-delta.cpp \
            src/tool.cpp \
@@ -65,9 +31,7 @@ SOURCES += \
            src/tool/sculpt/pinch.cpp \
            src/tool/sculpt/reduce.cpp \
            src/tool/sculpt/smooth.cpp \
-           src/tool/sculpt/util/action.cpp \
-           src/tool/sculpt/util/brush.cpp \
-           src/tool/sculpt/util/edge-collection.cpp \
+           src/tool/sculpt/util/worker.cpp \
            src/tool/sketch-spheres.cpp \
            src/tool/transform-mesh.cpp \
            src/tool/trim-mesh.cpp \
@@ -78,7 +42,6 @@ SOURCES += \
            src/tool/util/rotation.cpp \
            src/tool/util/scaling.cpp \
            src/tool/util/step.cpp \
-           src/util.cpp \
            src/view/axis.cpp \
            src/view/color-button.cpp \
            src/view/configuration.cpp \
@@ -103,64 +66,20 @@ SOURCES += \
            src/view/two-column-grid.cpp \
            src/view/util.cpp \
            src/view/vector-edit.cpp \
-           src/xml-conversion.cpp \
 
-HEADERS += \
-           src/bitset.hpp \
+HEADERS += $$CORE_HEADERS \
+           src/autosave.hpp \
            src/cache.hpp \
-           src/camera.hpp \
-           src/color.hpp \
-           src/config.hpp \
-           src/configurable.hpp \
-           src/dimension.hpp \
-           src/distance.hpp \
-           src/dynamic/faces.hpp \
-           src/dynamic/mesh.hpp \
-           src/dynamic/mesh-intersection.hpp \
-           src/dynamic/octree.hpp \
-           src/hash.hpp \
+           src/compressed-mesh.hpp \
            src/history.hpp \
-           src/import-export.hpp \
-           src/intersection.hpp \
-           src/isosurface-extraction.hpp \
-           src/isosurface-extraction/grid.hpp \
-           src/kvstore.hpp \
-           src/log.hpp \
-           src/macro.hpp \
-           src/maybe.hpp \
-           src/mesh.hpp \
-           src/mesh-util.hpp \
            src/mirror.hpp \
-           src/opengl.hpp \
-           src/opengl-buffer-id.hpp \
-           src/primitive/aabox.hpp \
-           src/primitive/cone.hpp \
-           src/primitive/cone-sphere.hpp \
-           src/primitive/cylinder.hpp \
-           src/primitive/plane.hpp \
-           src/primitive/ray.hpp \
-           src/primitive/sphere.hpp \
-           src/primitive/triangle.hpp \
-           src/render-mode.hpp \
-           src/renderer.hpp \
-           src/scene.hpp \
-           src/shader.hpp \
-           src/sketch/bone-intersection.hpp \
-           src/sketch/fwd.hpp \
-           src/sketch/mesh.hpp \
-           src/sketch/mesh-intersection.hpp \
-           src/sketch/node-intersection.hpp \
-           src/sketch/path.hpp \
-           src/sketch/path-intersection.hpp \
            src/state.hpp \
            src/time-delta.hpp \
            src/tool.hpp \
            src/tool/key.hpp \
            src/tool/move-camera.hpp \
            src/tool/sculpt.hpp \
-           src/tool/sculpt/util/action.hpp \
-           src/tool/sculpt/util/brush.hpp \
-           src/tool/sculpt/util/edge-collection.hpp \
+           src/tool/sculpt/util/worker.hpp \
            src/tool/trim-mesh/action.hpp \
            src/tool/trim-mesh/border.hpp \
            src/tool/trim-mesh/split-mesh.hpp \
@@ -169,9 +88,6 @@ HEADERS += \
            src/tool/util/scaling.hpp \
            src/tool/util/step.hpp \
            src/tools.hpp \
-           src/tree.hpp \
-           src/util.hpp \
-           src/variant.hpp \
            src/view/axis.hpp \
            src/view/color-button.hpp \
            src/view/configuration.hpp \
@@ -196,7 +112,6 @@ HEADERS += \
            src/view/two-column-grid.hpp \
            src/view/util.hpp \
            src/view/vector-edit.hpp \
-           src/xml-conversion.hpp \
 
 unix {
   format.commands = clang-format -style=file -i $$SOURCES $$HEADERS
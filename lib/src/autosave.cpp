@@ -0,0 +1,814 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QLockFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+#include "autosave.hpp"
+#include "config.hpp"
+#include "dynamic/mesh.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "scene.hpp"
+#include "sketch/mesh.hpp"
+#include "util.hpp"
+
+namespace
+{
+  /* Autosave journal
+   *
+   * header:       "DLYJ", version
+   * record:       payload size, payload checksum (FNV-1a), payload
+   * payload:      number of meshes, meshes, size of sketches, sketches (*.dlb)
+   * mesh:         id, begins capture, ends capture, number of vertex slots, number of face
+   *               slots, position, scaling, rotation, number of vertex states, number of face
+   *               states, vertex states, face states
+   * vertex state: index, is free, position
+   * face state:   index, is free, three vertex indices
+   *
+   * Fields are stored in the host's byte order, since a journal is only replayed on the machine
+   * that wrote it.  Sketches of size 0 have not changed since the previous record.  Records are
+   * appended and flushed one at a time, so that a crash can only tear the most recent record.
+   * A mesh whose capture has begun but not ended is replayed in its previously captured state.
+   */
+  const char         journalMagic[4] = {'D', 'L', 'Y', 'J'};
+  const unsigned int journalVersion = 2;
+
+  // Maximum number of vertex and face slots that are captured by a single checkpoint, and the
+  // interval between checkpoints while a capture is pending
+  constexpr unsigned int maxCapturedSlots = 1 << 18;
+  constexpr int          pendingCaptureInterval = 20;
+
+  // Progress of capturing the complete state of a mesh
+  struct Capture
+  {
+    unsigned int id;
+    unsigned int nextVertex;
+    unsigned int nextFace;
+  };
+
+  using AutosaveJournal::Checkpoint;
+  using AutosaveJournal::FaceState;
+  using AutosaveJournal::MeshDelta;
+  using AutosaveJournal::VertexState;
+
+  unsigned int checksum (const char* bytes, std::size_t size)
+  {
+    unsigned int hash = 2166136261u;
+
+    for (std::size_t i = 0; i < size; i++)
+    {
+      hash ^= static_cast<unsigned char> (bytes[i]);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  template <typename T> void append (std::string& bytes, const T& value)
+  {
+    static_assert (std::is_trivially_copyable<T>::value, "Unexpected type");
+    bytes.append (reinterpret_cast<const char*> (&value), sizeof (T));
+  }
+
+  void append (std::string& bytes, bool value) { append<unsigned int> (bytes, value ? 1 : 0); }
+
+  struct Reader
+  {
+    const char* bytes;
+    std::size_t size;
+    std::size_t offset;
+
+    Reader (const char* b, std::size_t s)
+      : bytes (b)
+      , size (s)
+      , offset (0)
+    {
+    }
+
+    const char* view (std::size_t n)
+    {
+      if (this->size - this->offset < n)
+      {
+        return nullptr;
+      }
+      const char* v = this->bytes + this->offset;
+      this->offset += n;
+      return v;
+    }
+
+    template <typename T> bool read (T& value)
+    {
+      const char* v = this->view (sizeof (T));
+      if (v)
+      {
+        std::memcpy (&value, v, sizeof (T));
+        return true;
+      }
+      return false;
+    }
+
+    bool read (bool& value)
+    {
+      unsigned int v;
+      if (this->read (v) && v <= 1)
+      {
+        value = v == 1;
+        return true;
+      }
+      return false;
+    }
+  };
+
+  void appendMesh (std::string& bytes, const MeshDelta& mesh)
+  {
+    append (bytes, mesh.id);
+    append (bytes, mesh.beginsCapture);
+    append (bytes, mesh.endsCapture);
+    append (bytes, mesh.numVertexSlots);
+    append (bytes, mesh.numFaceSlots);
+    append (bytes, mesh.position);
+    append (bytes, mesh.scaling);
+    append (bytes, mesh.rotation);
+    append<unsigned int> (bytes, mesh.vertices.size ());
+    append<unsigned int> (bytes, mesh.faces.size ());
+
+    for (const VertexState& v : mesh.vertices)
+    {
+      append (bytes, v.index);
+      append (bytes, v.isFree);
+      append (bytes, v.position);
+    }
+    for (const FaceState& f : mesh.faces)
+    {
+      append (bytes, f.index);
+      append (bytes, f.isFree);
+      append (bytes, f.i1);
+      append (bytes, f.i2);
+      append (bytes, f.i3);
+    }
+  }
+
+  bool readMesh (Reader& reader, MeshDelta& mesh)
+  {
+    unsigned int numVertices, numFaces;
+
+    if (reader.read (mesh.id) && reader.read (mesh.beginsCapture) &&
+        reader.read (mesh.endsCapture) && reader.read (mesh.numVertexSlots) &&
+        reader.read (mesh.numFaceSlots) && reader.read (mesh.position) &&
+        reader.read (mesh.scaling) && reader.read (mesh.rotation) && reader.read (numVertices) &&
+        reader.read (numFaces))
+    {
+      if (numVertices > mesh.numVertexSlots || numFaces > mesh.numFaceSlots)
+      {
+        return false;
+      }
+      mesh.vertices.resize (numVertices);
+      mesh.faces.resize (numFaces);
+
+      for (VertexState& v : mesh.vertices)
+      {
+        if (reader.read (v.index) == false || reader.read (v.isFree) == false ||
+            reader.read (v.position) == false || v.index >= mesh.numVertexSlots)
+        {
+          return false;
+        }
+      }
+      for (FaceState& f : mesh.faces)
+      {
+        if (reader.read (f.index) == false || reader.read (f.isFree) == false ||
+            reader.read (f.i1) == false || reader.read (f.i2) == false ||
+            reader.read (f.i3) == false || f.index >= mesh.numFaceSlots)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+    return false;
+  }
+
+  bool sameMeshes (const std::vector<MeshDelta>& a, const std::vector<MeshDelta>& b)
+  {
+    return std::equal (a.begin (), a.end (), b.begin (), b.end (),
+                       [](const MeshDelta& m1, const MeshDelta& m2) {
+                         return m1.id == m2.id && m1.numVertexSlots == m2.numVertexSlots &&
+                                m1.numFaceSlots == m2.numFaceSlots &&
+                                m1.position == m2.position && m1.scaling == m2.scaling &&
+                                m1.rotation == m2.rotation;
+                       });
+  }
+
+  // Replayed state of a dynamic mesh, including its free slots
+  struct JournalMesh
+  {
+    unsigned int               id;
+    glm::vec3                  position;
+    glm::vec3                  scaling;
+    glm::mat4x4                rotation;
+    std::vector<glm::vec3>     vertices;
+    std::vector<unsigned char> isFreeVertex;
+    std::vector<unsigned int>  indices;
+    std::vector<unsigned char> isFreeFace;
+
+    void apply (const MeshDelta& delta)
+    {
+      this->id = delta.id;
+      this->position = delta.position;
+      this->scaling = delta.scaling;
+      this->rotation = delta.rotation;
+      this->vertices.resize (delta.numVertexSlots, glm::vec3 (0.0f));
+      this->isFreeVertex.resize (delta.numVertexSlots, 1);
+      this->indices.resize (3 * delta.numFaceSlots, 0);
+      this->isFreeFace.resize (delta.numFaceSlots, 1);
+
+      for (const VertexState& v : delta.vertices)
+      {
+        this->vertices[v.index] = v.position;
+        this->isFreeVertex[v.index] = v.isFree ? 1 : 0;
+      }
+      for (const FaceState& f : delta.faces)
+      {
+        this->indices[(3 * f.index) + 0] = f.i1;
+        this->indices[(3 * f.index) + 1] = f.i2;
+        this->indices[(3 * f.index) + 2] = f.i3;
+        this->isFreeFace[f.index] = f.isFree ? 1 : 0;
+      }
+    }
+
+    // Only vertices of non-free faces are kept
+    bool toMesh (Mesh& mesh) const
+    {
+      std::vector<unsigned int> newIndices (this->vertices.size (), Util::invalidIndex ());
+
+      mesh.reset ();
+      for (unsigned int i = 0; i < this->isFreeFace.size (); i++)
+      {
+        if (this->isFreeFace[i] == 0)
+        {
+          for (unsigned int j = 0; j < 3; j++)
+          {
+            const unsigned int index = this->indices[(3 * i) + j];
+
+            if (index >= this->vertices.size () || this->isFreeVertex[index])
+            {
+              return false;
+            }
+            else if (newIndices[index] == Util::invalidIndex ())
+            {
+              newIndices[index] = mesh.addVertex (this->vertices[index]);
+            }
+            mesh.addIndex (newIndices[index]);
+          }
+        }
+      }
+      mesh.position (this->position);
+      mesh.scaling (this->scaling);
+      mesh.rotationMatrix (this->rotation);
+      return true;
+    }
+  };
+
+  typedef std::vector<JournalMesh> JournalMeshes;
+
+  JournalMeshes::iterator findMesh (JournalMeshes& meshes, unsigned int id)
+  {
+    return std::find_if (meshes.begin (), meshes.end (),
+                         [id](const JournalMesh& m) { return m.id == id; });
+  }
+
+  struct Replay
+  {
+    JournalMeshes                         meshes;
+    JournalMeshes                         captures;
+    std::vector<ImportExport::SketchData> sketches;
+
+    // Records are applied as a whole or not at all
+    bool apply (const char* bytes, std::size_t size)
+    {
+      Reader                  reader (bytes, size);
+      Checkpoint              checkpoint;
+      unsigned int            numMeshes, numSketchBytes;
+      ImportExport::SceneData sketchData;
+
+      if (reader.read (numMeshes) == false || numMeshes > size)
+      {
+        return false;
+      }
+      checkpoint.meshes.resize (numMeshes);
+
+      for (MeshDelta& m : checkpoint.meshes)
+      {
+        if (readMesh (reader, m) == false)
+        {
+          return false;
+        }
+        else if (m.beginsCapture == false &&
+                 findMesh (this->meshes, m.id) == this->meshes.end () &&
+                 findMesh (this->captures, m.id) == this->captures.end ())
+        {
+          return false;
+        }
+      }
+
+      if (reader.read (numSketchBytes) == false)
+      {
+        return false;
+      }
+      else if (numSketchBytes > 0)
+      {
+        const char* sketchBytes = reader.view (numSketchBytes);
+
+        if (sketchBytes == nullptr ||
+            ImportExport::fromDlbData (sketchBytes, numSketchBytes, sketchData) == false)
+        {
+          return false;
+        }
+      }
+
+      // Deltas of a mesh whose capture is pending apply to the capture, which replaces the
+      // mesh's state once it has ended
+      JournalMeshes newMeshes;
+      JournalMeshes newCaptures;
+
+      for (const MeshDelta& m : checkpoint.meshes)
+      {
+        const auto mesh = findMesh (this->meshes, m.id);
+        const auto capture = findMesh (this->captures, m.id);
+        const bool hasMesh = mesh != this->meshes.end ();
+
+        if (hasMesh)
+        {
+          newMeshes.push_back (std::move (*mesh));
+        }
+
+        if (m.beginsCapture)
+        {
+          newCaptures.emplace_back ();
+        }
+        else if (capture != this->captures.end ())
+        {
+          newCaptures.push_back (std::move (*capture));
+        }
+        else
+        {
+          newMeshes.back ().apply (m);
+          continue;
+        }
+        newCaptures.back ().apply (m);
+
+        if (m.endsCapture)
+        {
+          if (hasMesh)
+          {
+            newMeshes.back () = std::move (newCaptures.back ());
+          }
+          else
+          {
+            newMeshes.push_back (std::move (newCaptures.back ()));
+          }
+          newCaptures.pop_back ();
+        }
+      }
+      this->meshes = std::move (newMeshes);
+      this->captures = std::move (newCaptures);
+
+      if (numSketchBytes > 0)
+      {
+        this->sketches = std::move (sketchData.sketches);
+      }
+      return true;
+    }
+  };
+
+  // Each process writes its own journal, which is locked while the process is running
+  QDir autosaveDirectory ()
+  {
+    QDir directory (QStandardPaths::writableLocation (QStandardPaths::AppDataLocation));
+    directory.mkpath (".");
+    return directory;
+  }
+
+  std::string autosaveFileName (const char* extension)
+  {
+    const QString fileName = QString ("autosave-%1.%2")
+                               .arg (QCoreApplication::applicationPid ())
+                               .arg (extension);
+    return autosaveDirectory ().filePath (fileName).toStdString ();
+  }
+
+  QString lockFileName (const QString& journalFileName) { return journalFileName + ".lock"; }
+}
+
+namespace AutosaveJournal
+{
+  void writeHeader (std::ostream& stream)
+  {
+    stream.write (journalMagic, 4);
+    stream.write (reinterpret_cast<const char*> (&journalVersion), sizeof (unsigned int));
+  }
+
+  std::size_t write (std::ostream& stream, const Checkpoint& checkpoint,
+                     std::string& previousSketches)
+  {
+    std::stringstream       sketchStream;
+    ImportExport::SceneData sketchData;
+    std::string             sketches;
+
+    sketchData.sketches = checkpoint.sketches;
+    if (ImportExport::toDlbFile (sketchStream, sketchData))
+    {
+      sketches = sketchStream.str ();
+    }
+    const bool sketchesChanged = sketches.empty () == false && sketches != previousSketches;
+
+    if (checkpoint.meshesChanged == false && sketchesChanged == false)
+    {
+      return 0;
+    }
+
+    std::string payload;
+    append<unsigned int> (payload, checkpoint.meshes.size ());
+
+    for (const MeshDelta& m : checkpoint.meshes)
+    {
+      appendMesh (payload, m);
+    }
+
+    if (sketchesChanged)
+    {
+      append<unsigned int> (payload, sketches.size ());
+      payload.append (sketches);
+      previousSketches = std::move (sketches);
+    }
+    else
+    {
+      append<unsigned int> (payload, 0);
+    }
+
+    std::string record;
+    append<unsigned int> (record, payload.size ());
+    append<unsigned int> (record, checksum (payload.data (), payload.size ()));
+
+    stream.write (record.data (), record.size ());
+    stream.write (payload.data (), payload.size ());
+    return record.size () + payload.size ();
+  }
+
+  bool replay (const char* bytes, std::size_t size, ImportExport::SceneData& data)
+  {
+    Reader       reader (bytes, size);
+    const char*  magic = reader.view (4);
+    unsigned int version;
+
+    if (magic == nullptr || std::memcmp (magic, journalMagic, 4) != 0 ||
+        reader.read (version) == false || version != journalVersion)
+    {
+      return false;
+    }
+
+    Replay       replay;
+    unsigned int payloadSize, payloadChecksum;
+
+    while (reader.read (payloadSize) && reader.read (payloadChecksum))
+    {
+      const char* payload = reader.view (payloadSize);
+
+      if (payload == nullptr || checksum (payload, payloadSize) != payloadChecksum ||
+          replay.apply (payload, payloadSize) == false)
+      {
+        DILAY_WARN ("ignoring torn or corrupt autosave record")
+        break;
+      }
+    }
+
+    for (const JournalMesh& m : replay.meshes)
+    {
+      data.meshes.emplace_back ();
+      if (m.toMesh (data.meshes.back ()) == false || data.meshes.back ().numIndices () == 0)
+      {
+        data.meshes.pop_back ();
+      }
+    }
+    std::move (replay.sketches.begin (), replay.sketches.end (),
+               std::back_inserter (data.sketches));
+    return true;
+  }
+}
+
+struct Autosave::Impl
+{
+  const std::string         fileName;
+  QLockFile                 lock;
+  int                       interval;
+  std::vector<MeshDelta>    previousMeshes;
+  std::vector<Capture>      captures;
+  std::vector<unsigned int> modifiedVertices;
+  std::vector<unsigned int> modifiedFaces;
+
+  std::mutex              writeMutex;
+  std::condition_variable writeCondition;
+  std::deque<Checkpoint>  writeQueue;
+  bool                    isWriting;
+  bool                    isFailed;
+  bool                    stopWriting;
+  std::thread             writeThread;
+
+  Impl (const Config& config, const std::string& f)
+    : fileName (f)
+    , lock (lockFileName (f.c_str ()))
+    , isWriting (false)
+    , isFailed (false)
+    , stopWriting (false)
+  {
+    if (this->lock.tryLock (0) == false)
+    {
+      DILAY_WARN ("could not lock autosave journal %s", this->fileName.c_str ())
+      this->isFailed = true;
+    }
+    this->runFromConfig (config);
+    this->writeThread = std::thread ([this]() { this->runWriter (); });
+  }
+
+  // A journal is only kept if the application does not terminate regularly
+  ~Impl ()
+  {
+    {
+      std::lock_guard<std::mutex> lock (this->writeMutex);
+      this->stopWriting = true;
+    }
+    this->writeCondition.notify_one ();
+    this->writeThread.join ();
+
+    if (this->lock.isLocked ())
+    {
+      QFile::remove (this->fileName.c_str ());
+    }
+  }
+
+  void runWriter ()
+  {
+    std::ofstream                journal;
+    std::string                  previousSketches;
+    std::unique_lock<std::mutex> lock (this->writeMutex);
+
+    while (true)
+    {
+      this->writeCondition.wait (
+        lock, [this]() { return this->stopWriting || this->writeQueue.empty () == false; });
+
+      if (this->stopWriting)
+      {
+        return;
+      }
+
+      Checkpoint checkpoint = std::move (this->writeQueue.front ());
+      this->writeQueue.pop_front ();
+      lock.unlock ();
+
+      if (journal.is_open () == false)
+      {
+        // A file of a previous process with the same id is not appended to
+        QFile::remove (this->fileName.c_str ());
+        journal.open (this->fileName, std::ios::binary | std::ios::trunc);
+        AutosaveJournal::writeHeader (journal);
+      }
+      AutosaveJournal::write (journal, checkpoint, previousSketches);
+      journal.flush ();
+
+      lock.lock ();
+      this->isWriting = false;
+
+      if (journal.good () == false)
+      {
+        DILAY_WARN ("could not write autosave journal %s", this->fileName.c_str ())
+        this->isFailed = true;
+        return;
+      }
+    }
+  }
+
+  // Changes are only taken if they can be written right away
+  bool checkpoint (Scene& scene)
+  {
+    {
+      std::lock_guard<std::mutex> lock (this->writeMutex);
+      if (this->isFailed)
+      {
+        return false;
+      }
+      else if (this->isWriting)
+      {
+        return this->captures.empty () == false;
+      }
+    }
+
+    Checkpoint             checkpoint;
+    std::vector<MeshDelta> headers;
+    std::vector<Capture>   captures;
+    bool                   hasChanges = false;
+    unsigned int           numCapturedSlots = 0;
+
+    scene.forEachMesh ([this, &checkpoint, &headers, &captures, &hasChanges,
+                        &numCapturedSlots](DynamicMesh& mesh) {
+      checkpoint.meshes.emplace_back ();
+
+      MeshDelta& delta = checkpoint.meshes.back ();
+
+      delta.id = mesh.id ();
+      delta.beginsCapture = mesh.takeModified (this->modifiedVertices, this->modifiedFaces);
+      delta.endsCapture = false;
+      delta.numVertexSlots = mesh.mesh ().numVertices ();
+      delta.numFaceSlots = mesh.mesh ().numIndices () / 3;
+      delta.position = mesh.position ();
+      delta.scaling = mesh.scaling ();
+      delta.rotation = mesh.rotationMatrix ();
+      headers.push_back (delta);
+
+      const auto addVertex = [&mesh, &delta](unsigned int i) {
+        delta.vertices.push_back ({i, mesh.isFreeVertex (i), mesh.mesh ().vertex (i)});
+      };
+      const auto addFace = [&mesh, &delta](unsigned int i) {
+        delta.faces.push_back ({i, mesh.isFreeFace (i), mesh.mesh ().index ((3 * i) + 0),
+                                mesh.mesh ().index ((3 * i) + 1),
+                                mesh.mesh ().index ((3 * i) + 2)});
+      };
+
+      for (unsigned int i : this->modifiedVertices)
+      {
+        addVertex (i);
+      }
+      for (unsigned int i : this->modifiedFaces)
+      {
+        addFace (i);
+      }
+
+      // Slots that are modified after being captured are taken as modified slots
+      const auto capture =
+        std::find_if (this->captures.begin (), this->captures.end (),
+                      [&delta](const Capture& c) { return c.id == delta.id; });
+
+      if (delta.beginsCapture)
+      {
+        captures.push_back ({delta.id, 0, 0});
+      }
+      else if (capture != this->captures.end ())
+      {
+        captures.push_back (*capture);
+      }
+
+      if (delta.beginsCapture || capture != this->captures.end ())
+      {
+        Capture& c = captures.back ();
+
+        for (; c.nextVertex < delta.numVertexSlots && numCapturedSlots < maxCapturedSlots;
+             c.nextVertex++, numCapturedSlots++)
+        {
+          addVertex (c.nextVertex);
+        }
+        for (; c.nextFace < delta.numFaceSlots && numCapturedSlots < maxCapturedSlots;
+             c.nextFace++, numCapturedSlots++)
+        {
+          addFace (c.nextFace);
+        }
+
+        if (c.nextVertex >= delta.numVertexSlots && c.nextFace >= delta.numFaceSlots)
+        {
+          delta.endsCapture = true;
+          captures.pop_back ();
+        }
+      }
+      hasChanges = hasChanges || delta.beginsCapture || delta.endsCapture ||
+                   delta.vertices.empty () == false || delta.faces.empty () == false;
+    });
+
+    scene.forEachConstMesh ([&checkpoint](const SketchMesh& mesh) {
+      checkpoint.sketches.push_back ({mesh.tree (), mesh.paths ()});
+    });
+
+    checkpoint.meshesChanged = hasChanges || sameMeshes (headers, this->previousMeshes) == false;
+
+    this->previousMeshes = std::move (headers);
+    this->captures = std::move (captures);
+
+    std::lock_guard<std::mutex> lock (this->writeMutex);
+    this->writeQueue.push_back (std::move (checkpoint));
+    this->isWriting = true;
+    this->writeCondition.notify_one ();
+
+    return this->captures.empty () == false;
+  }
+
+  static int captureInterval () { return pendingCaptureInterval; }
+
+  static std::string journalFileName () { return autosaveFileName ("journal"); }
+
+  static std::string recoveryFileName () { return autosaveFileName ("recovery"); }
+
+  // Journals of running instances are locked.  Renaming claims a journal, so that concurrently
+  // starting instances don't recover the same one.  Journals of terminated processes that are
+  // older than the claimed one are removed.
+  static bool claimJournal ()
+  {
+    const QDir          directory = autosaveDirectory ();
+    const QFileInfoList journals =
+      directory.entryInfoList (QStringList ("autosave-*.journal"), QDir::Files, QDir::Time);
+    const QString ownJournal (journalFileName ().c_str ());
+    const QString recovery (recoveryFileName ().c_str ());
+    bool          isClaimed = false;
+
+    for (const QFileInfo& journal : journals)
+    {
+      const QString fileName = journal.absoluteFilePath ();
+      QLockFile     lock (lockFileName (fileName));
+
+      if (fileName != ownJournal && lock.tryLock (0))
+      {
+        if (isClaimed)
+        {
+          QFile::remove (fileName);
+        }
+        else
+        {
+          QFile::remove (recovery);
+          isClaimed = QFile::rename (fileName, recovery);
+        }
+      }
+    }
+    return isClaimed;
+  }
+
+  static bool recover (const std::string& fileName, const Config& config, Scene& scene)
+  {
+    std::ifstream file (fileName, std::ios::binary);
+
+    if (file.is_open ())
+    {
+      const std::string       bytes ((std::istreambuf_iterator<char> (file)),
+                               std::istreambuf_iterator<char> ());
+      ImportExport::SceneData data;
+
+      if (AutosaveJournal::replay (bytes.data (), bytes.size (), data) == false)
+      {
+        return false;
+      }
+
+      for (const Mesh& m : data.meshes)
+      {
+        if (MeshUtil::checkConsistency (m))
+        {
+          DynamicMesh& mesh = scene.newDynamicMesh (config, m);
+
+          mesh.position (m.position ());
+          mesh.scaling (m.scaling ());
+          mesh.rotationMatrix (m.rotationMatrix ());
+        }
+        else
+        {
+          DILAY_WARN ("skipping inconsistent autosaved mesh")
+        }
+      }
+      for (const ImportExport::SketchData& s : data.sketches)
+      {
+        SketchMesh& sketch = scene.newSketchMesh (config, s.tree);
+
+        for (const SketchPath& p : s.paths)
+        {
+          sketch.addPath (p);
+        }
+      }
+      return true;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  void runFromConfig (const Config& config)
+  {
+    this->interval = std::max (0, config.get<int> ("editor/autosave-interval")) * 1000;
+  }
+};
+
+DELEGATE2_BIG2 (Autosave, const Config&, const std::string&)
+GETTER_CONST (int, Autosave, interval)
+DELEGATE1 (bool, Autosave, checkpoint, Scene&)
+DELEGATE_STATIC (int, Autosave, captureInterval)
+DELEGATE_STATIC (std::string, Autosave, journalFileName)
+DELEGATE_STATIC (std::string, Autosave, recoveryFileName)
+DELEGATE_STATIC (bool, Autosave, claimJournal)
+DELEGATE3_STATIC (bool, Autosave, recover, const std::string&, const Config&, Scene&)
+DELEGATE1 (void, Autosave, runFromConfig, const Config&)
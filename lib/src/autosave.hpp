@@ -0,0 +1,109 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_AUTOSAVE
+#define DILAY_AUTOSAVE
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "configurable.hpp"
+#include "import-export.hpp"
+#include "macro.hpp"
+
+class Scene;
+
+// Incremental checkpoints of a scene, see `autosave.cpp` for the journal's layout
+namespace AutosaveJournal
+{
+  struct VertexState
+  {
+    unsigned int index;
+    bool         isFree;
+    glm::vec3    position;
+  };
+
+  struct FaceState
+  {
+    unsigned int index;
+    bool         isFree;
+    unsigned int i1;
+    unsigned int i2;
+    unsigned int i3;
+  };
+
+  // Modified vertex and face slots of a dynamic mesh.  Complete states are captured in chunks
+  // over several deltas: a delta that begins a capture starts from free slots only, and the
+  // previous state of the mesh is kept until a delta ends the capture.
+  struct MeshDelta
+  {
+    unsigned int             id;
+    bool                     beginsCapture;
+    bool                     endsCapture;
+    unsigned int             numVertexSlots;
+    unsigned int             numFaceSlots;
+    glm::vec3                position;
+    glm::vec3                scaling;
+    glm::mat4x4              rotation;
+    std::vector<VertexState> vertices;
+    std::vector<FaceState>   faces;
+  };
+
+  // Dynamic meshes that are missing from a checkpoint have been deleted
+  struct Checkpoint
+  {
+    std::vector<MeshDelta>                meshes;
+    bool                                  meshesChanged;
+    std::vector<ImportExport::SketchData> sketches;
+
+    Checkpoint ()
+      : meshesChanged (true)
+    {
+    }
+  };
+
+  void writeHeader (std::ostream&);
+
+  // Sketches are only written if they differ from the previously written ones, which are kept in
+  // the given string.  Nothing is written if neither meshes nor sketches have changed.  Returns
+  // the number of written bytes.
+  std::size_t write (std::ostream&, const Checkpoint&, std::string&);
+
+  // Replays all intact checkpoints of a journal.  A torn or corrupt record ends the replay.
+  bool replay (const char*, std::size_t, ImportExport::SceneData&);
+}
+
+class Autosave : public Configurable
+{
+public:
+  DECLARE_BIG2 (Autosave, const Config&, const std::string&)
+
+  // Interval between two checkpoints in milliseconds, or 0 if autosaving is disabled
+  int interval () const;
+
+  // Captures all changes since the previous checkpoint, which are written on a background thread.
+  // Complete states of meshes are captured in bounded chunks. Returns `true` if a capture is
+  // pending, i.e., if the next checkpoint should follow after `captureInterval`.
+  bool checkpoint (Scene&);
+
+  static int captureInterval ();
+
+  // Files of the running process in the application's data directory
+  static std::string journalFileName ();
+  static std::string recoveryFileName ();
+
+  // Moves the most recent journal of a terminated process to `recoveryFileName` and removes
+  // older ones
+  static bool claimJournal ();
+  static bool recover (const std::string&, const Config&, Scene&);
+
+private:
+  IMPLEMENTATION
+
+  void runFromConfig (const Config&);
+};
+
+#endif
@@ -2,7 +2,6 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
-#include <QColor>
 #include <glm/glm.hpp>
 #include "color.hpp"
 #include "util.hpp"
@@ -40,11 +39,6 @@ Color::Color (const glm::vec4& v)
 {
 }
 
-Color::Color (const QColor& c)
-  : Color (c.redF (), c.greenF (), c.blueF (), c.alphaF ())
-{
-}
-
 Color::Color (const Color& c, float f)
   : Color (c)
 {
@@ -88,11 +82,4 @@ glm::vec3 Color::vec3 () const { return glm::vec3 (this->_r, this->_g, this->_b)
 
 glm::vec4 Color::vec4 () const { return glm::vec4 (this->_r, this->_g, this->_b, this->_opacity); }
 
-QColor Color::qColor () const
-{
-  return QColor (glm::min (255, int(255.0f * this->_r)), glm::min (255, int(255.0f * this->_g)),
-                 glm::min (255, int(255.0f * this->_b)),
-                 glm::min (255, int(255.0f * this->_opacity)));
-}
-
 bool Color::isOpaque () const { return Util::almostEqual (this->_opacity, 1.0f); }
@@ -7,8 +7,6 @@
 
 #include <glm/fwd.hpp>
 
-class QColor;
-
 class Color
 {
 public:
@@ -18,7 +16,6 @@ public:
   Color (float, float, float, float);
   explicit Color (const glm::vec3&);
   explicit Color (const glm::vec4&);
-  explicit Color (const QColor&);
 
   // copies and scales a color using `scale`
   Color (const Color&, float);
@@ -44,7 +41,6 @@ public:
 
   glm::vec3 vec3 () const;
   glm::vec4 vec4 () const;
-  QColor    qColor () const;
   bool      isOpaque () const;
 
 private:
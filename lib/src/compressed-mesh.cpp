@@ -0,0 +1,231 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <QByteArray>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <vector>
+#include "compressed-mesh.hpp"
+#include "dynamic/mesh.hpp"
+#include "mesh.hpp"
+#include "util.hpp"
+
+namespace
+{
+  constexpr unsigned int maxQuantized = (1 << 20) - 1;
+
+  unsigned int zigZag (int value)
+  {
+    return ((unsigned int) (value) << 1) ^ (unsigned int) (value >> 31);
+  }
+
+  int unZigZag (unsigned int value) { return int(value >> 1) ^ -int(value & 1); }
+
+  int toBits (float value)
+  {
+    int bits;
+    std::memcpy (&bits, &value, sizeof (float));
+    return bits;
+  }
+
+  float fromBits (int bits)
+  {
+    float value;
+    std::memcpy (&value, &bits, sizeof (float));
+    return value;
+  }
+
+  void writeDelta (QByteArray& data, int delta)
+  {
+    unsigned int value = zigZag (delta);
+
+    while (value >= 0x80)
+    {
+      data.append (char((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    data.append (char(value));
+  }
+
+  int readDelta (const QByteArray& data, int& pos)
+  {
+    unsigned int value = 0;
+    unsigned int shift = 0;
+    unsigned char byte = 0;
+
+    do
+    {
+      assert (pos < data.size ());
+
+      byte = (unsigned char) (data.at (pos++));
+      value |= (unsigned int) (byte & 0x7f) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+
+    return unZigZag (value);
+  }
+}
+
+struct CompressedMesh::Impl
+{
+  glm::vec3    position;
+  glm::vec3    scaling;
+  glm::mat4x4  rotationMatrix;
+  bool         quantize;
+  glm::vec3    minimum;
+  glm::vec3    extent;
+  unsigned int numVertexSlots;
+  unsigned int numFaceSlots;
+  QByteArray   data;
+
+  Impl (const DynamicMesh& mesh, bool q)
+    : position (mesh.position ())
+    , scaling (mesh.scaling ())
+    , rotationMatrix (mesh.rotationMatrix ())
+    , quantize (q)
+    , minimum (Util::maxFloat ())
+    , extent (1.0f)
+    , numVertexSlots (mesh.mesh ().numVertices ())
+    , numFaceSlots (mesh.mesh ().numIndices () / 3)
+  {
+    if (this->quantize)
+    {
+      glm::vec3 maximum (Util::minFloat ());
+
+      mesh.forEachVertex ([this, &mesh, &maximum](unsigned int i) {
+        this->minimum = glm::min (this->minimum, mesh.vertex (i));
+        maximum = glm::max (maximum, mesh.vertex (i));
+      });
+      this->extent = glm::max (glm::vec3 (Util::epsilon ()), maximum - this->minimum);
+    }
+
+    QByteArray raw;
+    raw.reserve ((this->numVertexSlots + this->numFaceSlots) * 7);
+
+    for (unsigned int i = 0; i < this->numVertexSlots; i++)
+    {
+      raw.append (char(mesh.isFreeVertex (i) ? 1 : 0));
+    }
+    for (unsigned int i = 0; i < this->numFaceSlots; i++)
+    {
+      raw.append (char(mesh.isFreeFace (i) ? 1 : 0));
+    }
+
+    glm::ivec3 prevVertex (0);
+    mesh.forEachVertex ([this, &mesh, &raw, &prevVertex](unsigned int i) {
+      const glm::ivec3 vertex = this->encode (mesh.vertex (i));
+
+      // Differences of raw float bits may overflow, which is undone when decoding
+      writeDelta (raw, int((unsigned int) (vertex.x) - (unsigned int) (prevVertex.x)));
+      writeDelta (raw, int((unsigned int) (vertex.y) - (unsigned int) (prevVertex.y)));
+      writeDelta (raw, int((unsigned int) (vertex.z) - (unsigned int) (prevVertex.z)));
+      prevVertex = vertex;
+    });
+
+    int prevIndex = 0;
+    mesh.forEachFace ([&mesh, &raw, &prevIndex](unsigned int f) {
+      unsigned int indices[3];
+      mesh.vertexIndices (f, indices[0], indices[1], indices[2]);
+
+      for (unsigned int i : indices)
+      {
+        writeDelta (raw, int(i) - prevIndex);
+        prevIndex = int(i);
+      }
+    });
+    this->data = qCompress (raw);
+  }
+
+  glm::ivec3 encode (const glm::vec3& v) const
+  {
+    if (this->quantize)
+    {
+      const glm::vec3 normalized = (v - this->minimum) / this->extent;
+      return glm::ivec3 (glm::round (normalized * float(maxQuantized)));
+    }
+    else
+    {
+      return glm::ivec3 (toBits (v.x), toBits (v.y), toBits (v.z));
+    }
+  }
+
+  glm::vec3 decode (const glm::ivec3& e) const
+  {
+    if (this->quantize)
+    {
+      return this->minimum + (glm::vec3 (e) * this->extent / float(maxQuantized));
+    }
+    else
+    {
+      return glm::vec3 (fromBits (e.x), fromBits (e.y), fromBits (e.z));
+    }
+  }
+
+  void decompress (DynamicMesh& dynamicMesh) const
+  {
+    const QByteArray  raw = qUncompress (this->data);
+    Mesh              mesh;
+    std::vector<bool> isFreeVertex (this->numVertexSlots);
+    std::vector<bool> isFreeFace (this->numFaceSlots);
+    int               pos = 0;
+
+    for (unsigned int i = 0; i < this->numVertexSlots; i++)
+    {
+      isFreeVertex[i] = raw.at (pos++) != 0;
+    }
+    for (unsigned int i = 0; i < this->numFaceSlots; i++)
+    {
+      isFreeFace[i] = raw.at (pos++) != 0;
+    }
+
+    mesh.reserveVertices (this->numVertexSlots);
+    mesh.reserveIndices (3 * this->numFaceSlots);
+
+    glm::ivec3 vertex (0);
+    for (unsigned int i = 0; i < this->numVertexSlots; i++)
+    {
+      if (isFreeVertex[i])
+      {
+        mesh.addVertex (glm::vec3 (0.0f));
+      }
+      else
+      {
+        vertex.x = int((unsigned int) (vertex.x) + (unsigned int) (readDelta (raw, pos)));
+        vertex.y = int((unsigned int) (vertex.y) + (unsigned int) (readDelta (raw, pos)));
+        vertex.z = int((unsigned int) (vertex.z) + (unsigned int) (readDelta (raw, pos)));
+
+        mesh.addVertex (this->decode (vertex));
+      }
+    }
+
+    int index = 0;
+    for (unsigned int i = 0; i < this->numFaceSlots; i++)
+    {
+      for (unsigned int j = 0; j < 3; j++)
+      {
+        if (isFreeFace[i])
+        {
+          mesh.addIndex (0);
+        }
+        else
+        {
+          index += readDelta (raw, pos);
+          mesh.addIndex ((unsigned int) (index));
+        }
+      }
+    }
+    assert (pos == raw.size ());
+
+    dynamicMesh.fromMesh (mesh, isFreeVertex, isFreeFace);
+    dynamicMesh.position (this->position);
+    dynamicMesh.scaling (this->scaling);
+    dynamicMesh.rotationMatrix (this->rotationMatrix);
+  }
+
+  std::size_t numBytes () const { return sizeof (Impl) + std::size_t (this->data.size ()); }
+};
+
+DELEGATE2_BIG3 (CompressedMesh, const DynamicMesh&, bool)
+DELEGATE1_CONST (void, CompressedMesh, decompress, DynamicMesh&)
+DELEGATE_CONST (std::size_t, CompressedMesh, numBytes)
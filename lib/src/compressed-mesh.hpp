@@ -0,0 +1,29 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_COMPRESSED_MESH
+#define DILAY_COMPRESSED_MESH
+
+#include <cstddef>
+#include "macro.hpp"
+
+class DynamicMesh;
+
+// Compressed geometry, slot layout and transformation of a dynamic mesh: free slots are kept, so
+// that changes recorded for the mesh remain applicable to the restored mesh.  Positions and
+// indices are delta-encoded and then deflated.  Positions are only quantized relative to the
+// mesh's bounds if `quantize` is set, which is lossy.  Normals are not stored but recomputed.
+class CompressedMesh
+{
+public:
+  DECLARE_BIG3 (CompressedMesh, const DynamicMesh&, bool)
+
+  void        decompress (DynamicMesh&) const;
+  std::size_t numBytes () const;
+
+private:
+  IMPLEMENTATION
+};
+
+#endif
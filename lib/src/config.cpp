@@ -9,7 +9,7 @@
 
 namespace
 {
-  static constexpr int latestVersion = 10;
+  static constexpr int latestVersion = 15;
 
   template <typename T>
   void updateValue (Config& config, const std::string& path, const T& oldValue, const T& newValue)
@@ -77,6 +77,7 @@ void Config::restoreDefaults ()
   this->set ("editor/sketch/node/color", Color (0.5f, 0.5f, 0.9f));
   this->set ("editor/sketch/bubble/color", Color (0.5f, 0.5f, 0.7f));
   this->set ("editor/sketch/sphere/color", Color (0.7f, 0.7f, 0.9f));
+  this->set ("editor/sketch/preview/resolution", 0.05f);
 
   this->set ("editor/tool/cursor-color", Color (1.0f, 0.9f, 0.9f));
 
@@ -90,8 +91,12 @@ void Config::restoreDefaults ()
   this->set ("editor/tool/sketch-spheres/step-width-factor", 0.3f);
 
   this->set ("editor/undo-depth", 15);
+  this->set ("editor/undo-memory", 512);
+  this->set ("editor/undo-quantization", false);
+  this->set ("editor/autosave-interval", 60);
 
   this->set ("editor/tablet-pressure-intensity", 1.0f);
+  this->set ("editor/pointing-event-coalescing-distance", 4);
 
   this->set ("editor/use-geometry-shader", true);
 
@@ -146,6 +151,26 @@ void Config::update ()
       this->remove ("editor/camera/zoom-in-factor");
       break;
 
+    case 10:
+      forceUpdateValue<int> (*this, "editor/pointing-event-coalescing-distance", 4);
+      break;
+
+    case 11:
+      forceUpdateValue<int> (*this, "editor/undo-memory", 512);
+      break;
+
+    case 12:
+      forceUpdateValue<int> (*this, "editor/autosave-interval", 60);
+      break;
+
+    case 13:
+      forceUpdateValue<float> (*this, "editor/sketch/preview/resolution", 0.05f);
+      break;
+
+    case 14:
+      forceUpdateValue<bool> (*this, "editor/undo-quantization", false);
+      break;
+
     case latestVersion:
       return;
 
@@ -0,0 +1,714 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <locale>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "dly-parser.hpp"
+#include "import-export.hpp"
+#include "mesh.hpp"
+#include "primitive/sphere.hpp"
+#include "sketch/path.hpp"
+#include "util.hpp"
+
+namespace
+{
+  const std::size_t minChunkSize = 1 << 20;
+  const std::size_t progressInterval = 1 << 16;
+
+  // Consecutive `v` and `f` lines of a single mesh within a chunk
+  struct MeshPart
+  {
+    bool                      isNewMesh;
+    std::vector<glm::vec3>    vertices;
+    std::vector<unsigned int> indices;
+
+    // Positions in `indices` of negative (i.e., relative) face indices.  They are stored relative
+    // to the first vertex of this part and get fixed-up once all chunks are parsed.
+    std::vector<unsigned int> relativeIndices;
+
+    MeshPart (bool n)
+      : isNewMesh (n)
+    {
+    }
+  };
+
+  struct SketchRecord
+  {
+    enum class Type
+    {
+      Mesh,
+      Node,
+      Path,
+      Sphere
+    };
+
+    Type         type;
+    unsigned int lineNumber;
+    unsigned int nodeIndex;
+    unsigned int parentIndex;
+    glm::vec3    position1;
+    glm::vec3    position2;
+    float        radius;
+
+    SketchRecord (Type t, unsigned int l)
+      : type (t)
+      , lineNumber (l)
+      , nodeIndex (0)
+      , parentIndex (0)
+      , position1 (0.0f)
+      , position2 (0.0f)
+      , radius (0.0f)
+    {
+    }
+  };
+
+  struct Chunk
+  {
+    const char*               begin;
+    const char*               end;
+    unsigned int              numLines;
+    std::vector<MeshPart>     parts;
+    std::vector<SketchRecord> sketchRecords;
+    const char*               error;
+
+    Chunk (const char* b, const char* e)
+      : begin (b)
+      , end (e)
+      , numLines (0)
+      , error (nullptr)
+    {
+    }
+
+    MeshPart& currentPart ()
+    {
+      if (this->parts.empty ())
+      {
+        this->parts.emplace_back (false);
+      }
+      return this->parts.back ();
+    }
+  };
+
+  bool isSpace (char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+  }
+
+  bool isDigit (char c) { return c >= '0' && c <= '9'; }
+
+  bool isTokenEnd (const char* it, const char* end) { return it == end || isSpace (*it); }
+
+  void skipSpaces (const char*& it, const char* end)
+  {
+    while (it != end && isSpace (*it))
+    {
+      it++;
+    }
+  }
+
+  bool parseFloatSlow (const char* begin, const char* end, float& value)
+  {
+    std::istringstream stream (std::string (begin, end));
+    stream.imbue (std::locale::classic ());
+    stream >> value;
+    return stream.fail () == false;
+  }
+
+  // Narrows a correctly rounded double to single precision.  Double rounding can only go wrong if
+  // the double lies exactly between two floats, since such midpoints are doubles themselves.
+  bool narrow (double d, float& value)
+  {
+    const float f = float(d);
+
+    if (double(f) != d)
+    {
+      const float next = std::nextafter (f, double(f) < d ? Util::maxFloat () : -Util::maxFloat ());
+
+      if (2.0 * d == double(f) + double(next))
+      {
+        return false;
+      }
+    }
+    value = f;
+    return true;
+  }
+
+  // Mantissas up to 2^53 and powers of ten up to 10^22 are exact in double precision, so a single
+  // multiplication or division is correctly rounded (Clinger's fast path), and is then narrowed.
+  // Everything else falls back to the stream.
+  bool parseFloat (const char*& it, const char* end, float& value)
+  {
+    static const double powersOf10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                        1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                        1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    skipSpaces (it, end);
+
+    const char* begin = it;
+    bool        isNegative = false;
+    bool        hasDigits = false;
+    uint64_t    mantissa = 0;
+    int         numDigits = 0;
+    int         exponent = 0;
+
+    if (it != end && (*it == '-' || *it == '+'))
+    {
+      isNegative = *it == '-';
+      it++;
+    }
+    for (; it != end && isDigit (*it); it++)
+    {
+      hasDigits = true;
+      if (numDigits < 19)
+      {
+        mantissa = (10 * mantissa) + uint64_t (*it - '0');
+        numDigits += mantissa > 0 ? 1 : 0;
+      }
+      else
+      {
+        exponent++;
+      }
+    }
+    if (it != end && *it == '.')
+    {
+      for (it++; it != end && isDigit (*it); it++)
+      {
+        hasDigits = true;
+        if (numDigits < 19)
+        {
+          mantissa = (10 * mantissa) + uint64_t (*it - '0');
+          numDigits += mantissa > 0 ? 1 : 0;
+          exponent--;
+        }
+      }
+    }
+    if (hasDigits == false)
+    {
+      return false;
+    }
+    if (it != end && (*it == 'e' || *it == 'E'))
+    {
+      bool isNegativeExponent = false;
+      int  explicitExponent = 0;
+
+      it++;
+      if (it != end && (*it == '-' || *it == '+'))
+      {
+        isNegativeExponent = *it == '-';
+        it++;
+      }
+      if (it == end || isDigit (*it) == false)
+      {
+        return false;
+      }
+      for (; it != end && isDigit (*it); it++)
+      {
+        explicitExponent = glm::min (10000, (10 * explicitExponent) + (*it - '0'));
+      }
+      exponent += isNegativeExponent ? -explicitExponent : explicitExponent;
+    }
+    if (isTokenEnd (it, end) == false)
+    {
+      return false;
+    }
+    else if (mantissa <= (uint64_t (1) << 53) && exponent >= -22 && exponent <= 22 &&
+             narrow (exponent < 0 ? double(mantissa) / powersOf10[-exponent]
+                                  : double(mantissa) * powersOf10[exponent],
+                     value))
+    {
+      value = isNegative ? -value : value;
+      return true;
+    }
+    else
+    {
+      return parseFloatSlow (begin, it, value);
+    }
+  }
+
+  bool parseVec3 (const char*& it, const char* end, glm::vec3& v)
+  {
+    return parseFloat (it, end, v.x) && parseFloat (it, end, v.y) && parseFloat (it, end, v.z);
+  }
+
+  bool parseUnsigned (const char*& it, const char* end, unsigned int& value)
+  {
+    skipSpaces (it, end);
+
+    uint64_t v = 0;
+    if (it == end || isDigit (*it) == false)
+    {
+      return false;
+    }
+    for (; it != end && isDigit (*it); it++)
+    {
+      v = glm::min (uint64_t (Util::invalidIndex ()), (10 * v) + uint64_t (*it - '0'));
+    }
+    value = (unsigned int) (v);
+    return isTokenEnd (it, end);
+  }
+
+  // Parses the vertex index of a face corner (`v`, `v/vt`, `v//vn` or `v/vt/vn`)
+  bool parseCorner (const char*& it, const char* end, int64_t& value)
+  {
+    skipSpaces (it, end);
+
+    const bool isNegative = it != end && *it == '-';
+    int64_t    v = 0;
+
+    it += isNegative ? 1 : 0;
+    if (it == end || isDigit (*it) == false)
+    {
+      return false;
+    }
+    for (; it != end && isDigit (*it); it++)
+    {
+      v = glm::min (int64_t (Util::invalidIndex ()), (10 * v) + int64_t (*it - '0'));
+    }
+    if (it != end && *it == '/')
+    {
+      while (isTokenEnd (it, end) == false)
+      {
+        it++;
+      }
+    }
+    value = isNegative ? -v : v;
+    return isTokenEnd (it, end) && v > 0;
+  }
+
+  bool isKeyword (const char* begin, const char* end, const char* keyword)
+  {
+    const std::size_t length = std::strlen (keyword);
+    return std::size_t (end - begin) == length && std::memcmp (begin, keyword, length) == 0;
+  }
+
+  bool parseFace (MeshPart& part, const char* it, const char* end)
+  {
+    const unsigned int numVertices = part.vertices.size ();
+    unsigned int       corners[3];
+    unsigned int       numCorners = 0;
+    bool               isRelative[3];
+
+    while (true)
+    {
+      skipSpaces (it, end);
+      if (it == end)
+      {
+        break;
+      }
+
+      int64_t corner;
+      if (parseCorner (it, end, corner) == false)
+      {
+        return false;
+      }
+      const unsigned int slot = glm::min (numCorners, 2u);
+
+      corners[slot] =
+        corner > 0 ? (unsigned int) (corner - 1) : (unsigned int) (numVertices + corner);
+      isRelative[slot] = corner < 0;
+      numCorners++;
+
+      if (numCorners >= 3)
+      {
+        // triangulate polygons as fans around their first corner
+        for (unsigned int i = 0; i < 3; i++)
+        {
+          if (isRelative[i])
+          {
+            part.relativeIndices.push_back (part.indices.size ());
+          }
+          part.indices.push_back (corners[i]);
+        }
+        corners[1] = corners[2];
+        isRelative[1] = isRelative[2];
+      }
+    }
+    return numCorners >= 3;
+  }
+
+  bool parseLine (Chunk& chunk, const char* it, const char* end)
+  {
+    skipSpaces (it, end);
+
+    const char* keyword = it;
+    while (isTokenEnd (it, end) == false)
+    {
+      it++;
+    }
+    const char* keywordEnd = it;
+
+    if (keyword == keywordEnd)
+    {
+      return true;
+    }
+    else if (isKeyword (keyword, keywordEnd, "v"))
+    {
+      glm::vec3 vertex;
+      if (parseVec3 (it, end, vertex) == false)
+      {
+        chunk.error = "could not parse vertex at line %u";
+        return false;
+      }
+      chunk.currentPart ().vertices.push_back (vertex);
+    }
+    else if (isKeyword (keyword, keywordEnd, "f"))
+    {
+      if (parseFace (chunk.currentPart (), it, end) == false)
+      {
+        chunk.error = "could not parse face at line %u";
+        return false;
+      }
+    }
+    else if (isKeyword (keyword, keywordEnd, "o"))
+    {
+      chunk.parts.emplace_back (true);
+    }
+    else if (isKeyword (keyword, keywordEnd, "dly_sketch_mesh"))
+    {
+      chunk.sketchRecords.emplace_back (SketchRecord::Type::Mesh, chunk.numLines);
+    }
+    else if (isKeyword (keyword, keywordEnd, "dly_sketch_node"))
+    {
+      SketchRecord record (SketchRecord::Type::Node, chunk.numLines);
+
+      if (parseUnsigned (it, end, record.nodeIndex) == false ||
+          parseUnsigned (it, end, record.parentIndex) == false ||
+          parseVec3 (it, end, record.position1) == false ||
+          parseFloat (it, end, record.radius) == false)
+      {
+        chunk.error = "could not parse sketch node at line %u";
+        return false;
+      }
+      chunk.sketchRecords.push_back (record);
+    }
+    else if (isKeyword (keyword, keywordEnd, "dly_sketch_path"))
+    {
+      SketchRecord record (SketchRecord::Type::Path, chunk.numLines);
+
+      if (parseVec3 (it, end, record.position1) == false ||
+          parseVec3 (it, end, record.position2) == false)
+      {
+        chunk.error = "could not parse sketch path at line %u";
+        return false;
+      }
+      chunk.sketchRecords.push_back (record);
+    }
+    else if (isKeyword (keyword, keywordEnd, "dly_sketch_sphere"))
+    {
+      SketchRecord record (SketchRecord::Type::Sphere, chunk.numLines);
+
+      if (parseVec3 (it, end, record.position1) == false ||
+          parseFloat (it, end, record.radius) == false)
+      {
+        chunk.error = "could not parse sketch sphere at line %u";
+        return false;
+      }
+      chunk.sketchRecords.push_back (record);
+    }
+    return true;
+  }
+
+  void parseChunk (Chunk& chunk, std::atomic<std::size_t>& numParsedBytes,
+                   const std::atomic<bool>& isCanceled)
+  {
+    const char* it = chunk.begin;
+    const char* lastReport = it;
+
+    while (it != chunk.end)
+    {
+      const char* lineEnd = static_cast<const char*> (std::memchr (it, '\n', chunk.end - it));
+      lineEnd = lineEnd ? lineEnd : chunk.end;
+
+      chunk.numLines++;
+      if (parseLine (chunk, it, lineEnd) == false)
+      {
+        return;
+      }
+      it = lineEnd == chunk.end ? lineEnd : lineEnd + 1;
+
+      if (std::size_t (it - lastReport) >= progressInterval)
+      {
+        numParsedBytes += it - lastReport;
+        lastReport = it;
+
+        if (isCanceled)
+        {
+          return;
+        }
+      }
+    }
+    numParsedBytes += it - lastReport;
+  }
+
+  std::vector<Chunk> splitChunks (const char* data, std::size_t size)
+  {
+    const std::size_t numThreads = glm::max (1u, std::thread::hardware_concurrency ());
+    const std::size_t numChunks = glm::clamp (size / minChunkSize, std::size_t (1), numThreads);
+    const char*       end = data + size;
+    const char*       begin = data;
+
+    std::vector<Chunk> chunks;
+
+    for (std::size_t i = 1; i <= numChunks && begin != end; i++)
+    {
+      const char* chunkEnd = std::max (begin, data + ((size * i) / numChunks));
+
+      if (chunkEnd != end)
+      {
+        const void* newLine = std::memchr (chunkEnd, '\n', end - chunkEnd);
+        chunkEnd = newLine ? static_cast<const char*> (newLine) + 1 : end;
+      }
+      chunks.emplace_back (begin, chunkEnd);
+      begin = chunkEnd;
+    }
+    return chunks;
+  }
+
+  bool mergeMeshParts (std::vector<Chunk>& chunks, ImportExport::SceneData& data)
+  {
+    struct Target
+    {
+      MeshPart*    part;
+      unsigned int meshIndex;
+      unsigned int baseIndex;
+    };
+    std::vector<Target> targets;
+
+    for (Chunk& chunk : chunks)
+    {
+      for (MeshPart& part : chunk.parts)
+      {
+        if (part.isNewMesh || data.meshes.empty ())
+        {
+          data.meshes.emplace_back ();
+        }
+        Mesh& mesh = data.meshes.back ();
+
+        targets.push_back (Target{&part, (unsigned int) (data.meshes.size () - 1),
+                                  mesh.numVertices ()});
+        mesh.reserveVertices (mesh.numVertices () + part.vertices.size ());
+
+        for (const glm::vec3& v : part.vertices)
+        {
+          mesh.addVertex (v);
+        }
+      }
+    }
+
+    for (Target& target : targets)
+    {
+      Mesh&     mesh = data.meshes.at (target.meshIndex);
+      MeshPart& part = *target.part;
+
+      for (unsigned int i : part.relativeIndices)
+      {
+        part.indices[i] += target.baseIndex;
+      }
+      for (unsigned int i : part.indices)
+      {
+        if (i >= mesh.numVertices ())
+        {
+          DILAY_WARN ("invalid vertex index %u", i + 1)
+          return false;
+        }
+      }
+      mesh.addIndices (part.indices.data (), part.indices.size ());
+    }
+    return true;
+  }
+
+  struct SketchReplay
+  {
+    std::vector<SketchNode*>  nodes;
+    ImportExport::SketchData* sketch;
+    SketchPath*               sketchPath;
+    glm::vec3                 intersectionFirst;
+    glm::vec3                 intersectionLast;
+
+    SketchReplay ()
+      : sketch (nullptr)
+      , sketchPath (nullptr)
+    {
+    }
+
+    bool run (const SketchRecord& record, unsigned int lineNumber, ImportExport::SceneData& data)
+    {
+      switch (record.type)
+      {
+        case SketchRecord::Type::Mesh:
+          this->nodes.clear ();
+          data.sketches.emplace_back ();
+          this->sketch = &data.sketches.back ();
+          this->sketchPath = nullptr;
+          return true;
+
+        case SketchRecord::Type::Node:
+        {
+          const PrimSphere sphere (record.position1, record.radius);
+
+          if (this->sketch == nullptr)
+          {
+            DILAY_WARN ("could not parse sketch node: no sketch found at line %u", lineNumber)
+            return false;
+          }
+          else if (record.nodeIndex != this->nodes.size ())
+          {
+            DILAY_WARN ("invalid node index at line %u", lineNumber)
+            return false;
+          }
+          else if (record.nodeIndex == 0)
+          {
+            this->nodes.push_back (&this->sketch->tree.emplaceRoot (sphere));
+          }
+          else if (record.parentIndex < this->nodes.size ())
+          {
+            this->nodes.push_back (&this->nodes.at (record.parentIndex)->emplaceChild (sphere));
+          }
+          else
+          {
+            DILAY_WARN ("invalid parent index at line %u", lineNumber)
+            return false;
+          }
+          return true;
+        }
+
+        case SketchRecord::Type::Path:
+          if (this->sketch == nullptr)
+          {
+            DILAY_WARN ("could not parse sketch path: no sketch found at line %u", lineNumber)
+            return false;
+          }
+          this->intersectionFirst = record.position1;
+          this->intersectionLast = record.position2;
+          this->sketch->paths.emplace_back ();
+          this->sketchPath = &this->sketch->paths.back ();
+          return true;
+
+        case SketchRecord::Type::Sphere:
+          if (this->sketchPath == nullptr)
+          {
+            DILAY_WARN ("could not parse sketch sphere: no sketch path found at line %u",
+                        lineNumber)
+            return false;
+          }
+          this->sketchPath->addSphere (this->sketchPath->isEmpty () ? this->intersectionFirst
+                                                                    : this->intersectionLast,
+                                       record.position1, record.radius);
+          return true;
+      }
+      return false;
+    }
+  };
+}
+
+namespace DlyParser
+{
+  bool parse (const char* data, std::size_t size, ImportExport::SceneData& sceneData,
+              const std::function<bool(float)>& progress)
+  {
+    std::vector<Chunk>       chunks = splitChunks (data, size);
+    std::atomic<std::size_t> numParsedBytes (0);
+    std::atomic<bool>        isCanceled (false);
+
+    if (chunks.size () <= 1 && progress == nullptr)
+    {
+      for (Chunk& chunk : chunks)
+      {
+        parseChunk (chunk, numParsedBytes, isCanceled);
+      }
+    }
+    else
+    {
+      std::mutex               mutex;
+      std::condition_variable  condition;
+      unsigned int             numFinished = 0;
+      std::vector<std::thread> threads;
+
+      for (Chunk& chunk : chunks)
+      {
+        threads.emplace_back ([&chunk, &numParsedBytes, &isCanceled, &mutex, &condition,
+                               &numFinished]() {
+          parseChunk (chunk, numParsedBytes, isCanceled);
+
+          std::lock_guard<std::mutex> lock (mutex);
+          numFinished++;
+          condition.notify_one ();
+        });
+      }
+
+      std::unique_lock<std::mutex> lock (mutex);
+      while (numFinished < chunks.size ())
+      {
+        condition.wait_for (lock, std::chrono::milliseconds (50));
+
+        if (progress && isCanceled == false)
+        {
+          const float p = float(numParsedBytes) / float(glm::max (std::size_t (1), size));
+
+          lock.unlock ();
+          isCanceled = progress (p) == false;
+          lock.lock ();
+        }
+      }
+      lock.unlock ();
+
+      for (std::thread& thread : threads)
+      {
+        thread.join ();
+      }
+    }
+
+    if (isCanceled)
+    {
+      return false;
+    }
+
+    unsigned int lineOffset = 0;
+    for (const Chunk& chunk : chunks)
+    {
+      if (chunk.error)
+      {
+        DILAY_WARN (chunk.error, lineOffset + chunk.numLines)
+        return false;
+      }
+      lineOffset += chunk.numLines;
+    }
+
+    if (mergeMeshParts (chunks, sceneData) == false)
+    {
+      return false;
+    }
+
+    SketchReplay replay;
+    lineOffset = 0;
+    for (const Chunk& chunk : chunks)
+    {
+      for (const SketchRecord& record : chunk.sketchRecords)
+      {
+        if (replay.run (record, lineOffset + record.lineNumber, sceneData) == false)
+        {
+          return false;
+        }
+      }
+      lineOffset += chunk.numLines;
+    }
+
+    if (progress)
+    {
+      progress (1.0f);
+    }
+    return true;
+  }
+}
@@ -0,0 +1,25 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_DLY_PARSER
+#define DILAY_DLY_PARSER
+
+#include <cstddef>
+#include <functional>
+
+namespace ImportExport
+{
+  struct SceneData;
+}
+
+namespace DlyParser
+{
+  // Parses the text format (*.dly, *.obj) directly out of a buffer.  Large buffers are split at
+  // line boundaries and parsed in parallel.  The progress callback is invoked on the calling
+  // thread with values between 0 and 1; returning false cancels parsing.
+  bool parse (const char*, std::size_t, ImportExport::SceneData&,
+              const std::function<bool(float)>& = nullptr);
+}
+
+#endif
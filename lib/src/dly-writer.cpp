@@ -0,0 +1,189 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <glm/glm.hpp>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "dly-writer.hpp"
+#include "mesh.hpp"
+#include "primitive/sphere.hpp"
+#include "sketch/path.hpp"
+#include "util.hpp"
+
+namespace
+{
+  const unsigned int linesPerChunk = 1 << 16;
+
+  void append (std::string& buffer, unsigned int value)
+  {
+    char         digits[10];
+    unsigned int n = 0;
+
+    do
+    {
+      digits[n++] = char('0' + (value % 10));
+      value /= 10;
+    } while (value > 0);
+
+    while (n > 0)
+    {
+      buffer.push_back (digits[--n]);
+    }
+  }
+
+  // Nine significant digits always parse back to the same value, so a single call suffices
+  void append (std::string& buffer, float value)
+  {
+    char      digits[32];
+    const int n = std::snprintf (digits, sizeof (digits), "%.9g", double(value));
+
+    buffer.append (digits, n);
+  }
+
+  void append (std::string& buffer, const glm::vec3& v)
+  {
+    append (buffer, v.x);
+    buffer.push_back (' ');
+    append (buffer, v.y);
+    buffer.push_back (' ');
+    append (buffer, v.z);
+  }
+
+  void writeLines (std::ostream& stream, unsigned int numLines,
+                   const std::function<void(std::string&, unsigned int)>& formatLine)
+  {
+    const unsigned int       numThreads = glm::max (1u, std::thread::hardware_concurrency ());
+    std::vector<std::string> buffers (numThreads);
+
+    auto formatChunk = [&buffers, &formatLine](unsigned int chunk, unsigned int begin,
+                                               unsigned int end) {
+      buffers[chunk].clear ();
+      for (unsigned int i = begin; i < end; i++)
+      {
+        formatLine (buffers[chunk], i);
+      }
+    };
+
+    for (unsigned int batch = 0; batch < numLines; batch += numThreads * linesPerChunk)
+    {
+      std::vector<std::thread> threads;
+      unsigned int             numChunks = 0;
+
+      for (; numChunks < numThreads; numChunks++)
+      {
+        const unsigned int begin = batch + (numChunks * linesPerChunk);
+        const unsigned int end = glm::min (numLines, begin + linesPerChunk);
+
+        if (begin >= end)
+        {
+          break;
+        }
+        else if (numChunks > 0)
+        {
+          threads.emplace_back (formatChunk, numChunks, begin, end);
+        }
+      }
+      formatChunk (0, batch, glm::min (numLines, batch + linesPerChunk));
+
+      for (std::thread& thread : threads)
+      {
+        thread.join ();
+      }
+      for (unsigned int i = 0; i < numChunks; i++)
+      {
+        stream.write (buffers[i].data (), buffers[i].size ());
+      }
+    }
+  }
+
+  unsigned int write (std::string& buffer, const SketchNode& node, unsigned int parentIndex,
+                      unsigned nodeIndex)
+  {
+    buffer.append ("dly_sketch_node ");
+    append (buffer, nodeIndex);
+    buffer.push_back (' ');
+    append (buffer, parentIndex);
+    buffer.push_back (' ');
+    append (buffer, node.data ().center ());
+    buffer.push_back (' ');
+    append (buffer, node.data ().radius ());
+    buffer.push_back ('\n');
+
+    unsigned int childIndex = nodeIndex;
+
+    node.forEachConstChild ([&buffer, nodeIndex, &childIndex](const SketchNode& child) {
+      childIndex = write (buffer, child, nodeIndex, childIndex + 1);
+    });
+    return childIndex;
+  }
+
+  void write (std::string& buffer, const SketchPath& path)
+  {
+    if (path.isEmpty () == false)
+    {
+      buffer.append ("dly_sketch_path ");
+      append (buffer, path.intersectionFirst ());
+      buffer.push_back (' ');
+      append (buffer, path.intersectionLast ());
+      buffer.push_back ('\n');
+
+      for (const PrimSphere& s : path.spheres ())
+      {
+        buffer.append ("dly_sketch_sphere ");
+        append (buffer, s.center ());
+        buffer.push_back (' ');
+        append (buffer, s.radius ());
+        buffer.push_back ('\n');
+      }
+    }
+  }
+}
+
+namespace DlyWriter
+{
+  void write (std::ostream& stream, const Mesh& mesh)
+  {
+    stream.write ("o\n", 2);
+
+    writeLines (stream, mesh.numVertices (), [&mesh](std::string& buffer, unsigned int i) {
+      buffer.append ("v ");
+      append (buffer, mesh.vertex (i));
+      buffer.push_back ('\n');
+    });
+
+    writeLines (stream, mesh.numIndices () / 3, [&mesh](std::string& buffer, unsigned int i) {
+      buffer.append ("f ");
+      append (buffer, mesh.index ((3 * i) + 0) + 1);
+      buffer.push_back (' ');
+      append (buffer, mesh.index ((3 * i) + 1) + 1);
+      buffer.push_back (' ');
+      append (buffer, mesh.index ((3 * i) + 2) + 1);
+      buffer.push_back ('\n');
+    });
+  }
+
+  void write (std::ostream& stream, const SketchTree& tree, const SketchPaths& paths)
+  {
+    if (tree.hasRoot () || paths.empty () == false)
+    {
+      std::string buffer ("dly_sketch_mesh\n");
+
+      if (tree.hasRoot ())
+      {
+        ::write (buffer, tree.root (), Util::invalidIndex (), 0);
+      }
+
+      for (const SketchPath& p : paths)
+      {
+        ::write (buffer, p);
+      }
+      stream.write (buffer.data (), buffer.size ());
+    }
+  }
+}
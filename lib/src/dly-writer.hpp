@@ -0,0 +1,21 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_DLY_WRITER
+#define DILAY_DLY_WRITER
+
+#include <iosfwd>
+#include "sketch/fwd.hpp"
+
+class Mesh;
+
+namespace DlyWriter
+{
+  // Formats the text format (*.dly, *.obj) into large buffers that are written without flushing.
+  // Lines of big meshes are formatted in parallel and written in order.
+  void write (std::ostream&, const Mesh&);
+  void write (std::ostream&, const SketchTree&, const SketchPaths&);
+}
+
+#endif
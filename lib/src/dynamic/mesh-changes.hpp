@@ -0,0 +1,65 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_DYNAMIC_MESH_CHANGES
+#define DILAY_DYNAMIC_MESH_CHANGES
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Prior states of all vertices and faces of a dynamic mesh that have been touched while tracking
+// changes (see `DynamicMesh::trackChanges`)
+class DynamicMeshChanges
+{
+public:
+  struct Vertex
+  {
+    unsigned int              index;
+    bool                      isFree;
+    glm::vec3                 position;
+    glm::vec3                 normal;
+    std::vector<unsigned int> adjacentFaces;
+  };
+
+  struct Face
+  {
+    unsigned int index;
+    bool         isFree;
+    unsigned int i1;
+    unsigned int i2;
+    unsigned int i3;
+  };
+
+  std::vector<Vertex>&       vertices () { return this->_vertices; }
+  const std::vector<Vertex>& vertices () const { return this->_vertices; }
+  std::vector<Face>&         faces () { return this->_faces; }
+  const std::vector<Face>&   faces () const { return this->_faces; }
+
+  bool isEmpty () const { return this->_vertices.empty () && this->_faces.empty (); }
+
+  std::size_t numBytes () const
+  {
+    std::size_t n = (sizeof (Vertex) * this->_vertices.size ()) +
+                    (sizeof (Face) * this->_faces.size ());
+
+    for (const Vertex& v : this->_vertices)
+    {
+      n += sizeof (unsigned int) * v.adjacentFaces.size ();
+    }
+    return n;
+  }
+
+  void reset ()
+  {
+    this->_vertices.clear ();
+    this->_faces.clear ();
+  }
+
+private:
+  std::vector<Vertex> _vertices;
+  std::vector<Face>   _faces;
+};
+
+#endif
@@ -2,14 +2,18 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
 #include <cstring>
 #include <glm/glm.hpp>
 #include <glm/gtx/norm.hpp>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include "../mesh.hpp"
 #include "config.hpp"
 #include "distance.hpp"
 #include "dynamic/faces.hpp"
+#include "dynamic/mesh-changes.hpp"
 #include "dynamic/mesh-intersection.hpp"
 #include "dynamic/mesh.hpp"
 #include "dynamic/octree.hpp"
@@ -59,6 +63,222 @@ namespace
     FaceData () { this->reset (); }
     void reset () { this->isFree = true; }
   };
+
+  struct ChangeTracker
+  {
+    bool                       isActive;
+    DynamicMeshChanges         changes;
+    std::vector<unsigned char> vertexTracked;
+    std::vector<unsigned char> faceTracked;
+
+    ChangeTracker ()
+      : isActive (false)
+    {
+    }
+
+    // Copies of a mesh don't inherit its tracked changes
+    ChangeTracker (const ChangeTracker&)
+      : ChangeTracker ()
+    {
+    }
+
+    const ChangeTracker& operator= (const ChangeTracker&)
+    {
+      this->isActive = false;
+      this->changes.reset ();
+      this->vertexTracked.clear ();
+      this->faceTracked.clear ();
+      return *this;
+    }
+
+    static bool mark (std::vector<unsigned char>& tracked, unsigned int i)
+    {
+      if (i >= tracked.size ())
+      {
+        tracked.resize (i + 1, 0);
+      }
+      if (tracked[i])
+      {
+        return false;
+      }
+      else
+      {
+        tracked[i] = 1;
+        return true;
+      }
+    }
+  };
+
+  // Vertices and faces that have been modified since they were last taken
+  struct ModificationMarks
+  {
+    bool                       isModifiedAll;
+    std::vector<unsigned char> vertexMarks;
+    std::vector<unsigned char> faceMarks;
+    std::vector<unsigned int>  vertices;
+    std::vector<unsigned int>  faces;
+
+    ModificationMarks ()
+      : isModifiedAll (true)
+    {
+    }
+
+    // Copies of a mesh are considered to be modified entirely
+    ModificationMarks (const ModificationMarks&)
+      : ModificationMarks ()
+    {
+    }
+
+    const ModificationMarks& operator= (const ModificationMarks&)
+    {
+      this->markAll ();
+      return *this;
+    }
+
+    void markVertex (unsigned int i)
+    {
+      if (this->isModifiedAll == false && ChangeTracker::mark (this->vertexMarks, i))
+      {
+        this->vertices.push_back (i);
+      }
+    }
+
+    void markFace (unsigned int i)
+    {
+      if (this->isModifiedAll == false && ChangeTracker::mark (this->faceMarks, i))
+      {
+        this->faces.push_back (i);
+      }
+    }
+
+    void markAll ()
+    {
+      this->isModifiedAll = true;
+      this->vertexMarks.clear ();
+      this->faceMarks.clear ();
+      this->vertices.clear ();
+      this->faces.clear ();
+    }
+
+    bool take (std::vector<unsigned int>& vs, std::vector<unsigned int>& fs)
+    {
+      vs.clear ();
+      fs.clear ();
+
+      if (this->isModifiedAll)
+      {
+        this->isModifiedAll = false;
+        return true;
+      }
+      else
+      {
+        for (unsigned int i : this->vertices)
+        {
+          this->vertexMarks[i] = 0;
+        }
+        for (unsigned int i : this->faces)
+        {
+          this->faceMarks[i] = 0;
+        }
+        vs.swap (this->vertices);
+        fs.swap (this->faces);
+        return false;
+      }
+    }
+  };
+
+  // Adjacent faces of each vertex and the octree of all faces
+  struct Topology
+  {
+    std::vector<std::vector<unsigned int>> adjacentFaces;
+    DynamicOctree                          octree;
+
+    void addFace (const Mesh& mesh, unsigned int i)
+    {
+      const PrimTriangle tri (mesh.vertex (mesh.index ((3 * i) + 0)),
+                              mesh.vertex (mesh.index ((3 * i) + 1)),
+                              mesh.vertex (mesh.index ((3 * i) + 2)));
+
+      if (this->octree.hasRoot () == false)
+      {
+        this->octree.setupRoot (tri.center (), tri.maxDimExtent ());
+      }
+      this->octree.addElement (i, tri.center (), tri.maxDimExtent ());
+    }
+
+    // Each adjacency is allocated once.  Free faces are skipped if `isFreeFace` is given.
+    void build (const Mesh& mesh, const std::vector<bool>* isFreeFace = nullptr)
+    {
+      const unsigned int numFaces = mesh.numIndices () / 3;
+      const auto         isFree = [isFreeFace](unsigned int f) {
+        return isFreeFace && isFreeFace->at (f);
+      };
+
+      std::vector<unsigned int> valences (mesh.numVertices (), 0);
+      for (unsigned int i = 0; i < mesh.numIndices (); i++)
+      {
+        if (isFree (i / 3) == false)
+        {
+          assert (mesh.index (i) < mesh.numVertices ());
+          valences[mesh.index (i)]++;
+        }
+      }
+
+      this->adjacentFaces.resize (mesh.numVertices ());
+      for (unsigned int i = 0; i < mesh.numVertices (); i++)
+      {
+        this->adjacentFaces[i].reserve (valences[i]);
+      }
+      for (unsigned int i = 0; i < numFaces; i++)
+      {
+        if (isFree (i))
+        {
+          continue;
+        }
+        this->adjacentFaces[mesh.index ((3 * i) + 0)].push_back (i);
+        this->adjacentFaces[mesh.index ((3 * i) + 1)].push_back (i);
+        this->adjacentFaces[mesh.index ((3 * i) + 2)].push_back (i);
+        this->addFace (mesh, i);
+      }
+    }
+  };
+
+  // Topology of a deferred mesh, which is built from a copy of its faces by whichever thread
+  // needs it first
+  struct PendingTopology
+  {
+    std::mutex mutex;
+    Mesh       mesh;
+    bool       isBuilt;
+    Topology   topology;
+
+    PendingTopology (const Mesh& m)
+      : mesh (m)
+      , isBuilt (false)
+    {
+    }
+
+    void build ()
+    {
+      std::lock_guard<std::mutex> lock (this->mutex);
+
+      if (this->isBuilt == false)
+      {
+        this->topology.build (this->mesh);
+        this->mesh.reset ();
+        this->isBuilt = true;
+      }
+    }
+  };
+
+  void eraseIndex (std::vector<unsigned int>& indices, unsigned int i)
+  {
+    auto it = std::find (indices.begin (), indices.end (), i);
+    assert (it != indices.end ());
+
+    *it = indices.back ();
+    indices.pop_back ();
+  }
 }
 
 struct DynamicMesh::Impl
@@ -72,14 +292,23 @@ struct DynamicMesh::Impl
   std::vector<unsigned char> faceVisited;
   std::vector<unsigned int>  freeFaceIndices;
   DynamicOctree              octree;
+  std::vector<unsigned int>  scratchIndices;
+  std::vector<glm::vec3>     scratchPositions;
+  ChangeTracker              tracker;
+  ModificationMarks          modifications;
+  unsigned int               id;
+
+  std::shared_ptr<PendingTopology> pendingTopology;
 
   Impl (DynamicMesh* s)
     : self (s)
+    , id (Util::invalidIndex ())
   {
   }
 
   Impl (DynamicMesh* s, const Mesh& m)
     : self (s)
+    , id (Util::invalidIndex ())
   {
     this->fromMesh (m);
   }
@@ -118,6 +347,7 @@ struct DynamicMesh::Impl
 
   unsigned int valence (unsigned int i) const
   {
+    this->materialize ();
     assert (this->isFreeVertex (i) == false);
     return this->vertexData[i].adjacentFaces.size ();
   }
@@ -157,6 +387,7 @@ struct DynamicMesh::Impl
                      unsigned int& leftVertex, unsigned int& rightFace,
                      unsigned int& rightVertex) const
   {
+    this->materialize ();
     assert (this->isFreeVertex (e1) == false);
     assert (this->isFreeVertex (e2) == false);
 
@@ -209,6 +440,7 @@ struct DynamicMesh::Impl
 
   const std::vector<unsigned int>& adjacentFaces (unsigned int i) const
   {
+    this->materialize ();
     assert (this->isFreeVertex (i) == false);
     return this->vertexData[i].adjacentFaces;
   }
@@ -268,6 +500,7 @@ struct DynamicMesh::Impl
 
   void forEachVertexExt (const DynamicFaces& faces, const std::function<void(unsigned int)>& f)
   {
+    this->materialize ();
     this->unvisitVertices ();
     this->unvisitFaces ();
 
@@ -290,6 +523,7 @@ struct DynamicMesh::Impl
   void forEachVertexAdjacentToVertex (unsigned int                             i,
                                       const std::function<void(unsigned int)>& f) const
   {
+    this->materialize ();
     assert (this->isFreeVertex (i) == false);
 
     for (unsigned int a : this->vertexData[i].adjacentFaces)
@@ -342,6 +576,7 @@ struct DynamicMesh::Impl
 
   void forEachFaceExt (const DynamicFaces& faces, const std::function<void(unsigned int)>& f)
   {
+    this->materialize ();
     this->unvisitVertices ();
     this->unvisitFaces ();
 
@@ -403,6 +638,7 @@ struct DynamicMesh::Impl
 
   glm::vec3 averagePosition (unsigned int i) const
   {
+    this->materialize ();
     assert (this->isFreeVertex (i) == false);
     assert (this->vertexData[i].adjacentFaces.size () > 0);
 
@@ -432,6 +668,7 @@ struct DynamicMesh::Impl
 
   glm::vec3 averageNormal (unsigned int i) const
   {
+    this->materialize ();
     assert (this->isFreeVertex (i) == false);
     assert (this->vertexData[i].adjacentFaces.size () > 0);
 
@@ -476,9 +713,12 @@ struct DynamicMesh::Impl
 
   unsigned int addVertex (const glm::vec3& vertex, const glm::vec3& normal)
   {
+    this->materialize ();
     assert (this->vertexData.size () == this->mesh.numVertices ());
     assert (this->vertexVisited.size () == this->mesh.numVertices ());
 
+    this->trackVertex (this->freeVertexIndices.empty () ? this->vertexData.size ()
+                                                        : this->freeVertexIndices.back ());
     if (this->freeVertexIndices.empty ())
     {
       this->vertexData.emplace_back ();
@@ -501,6 +741,7 @@ struct DynamicMesh::Impl
 
   unsigned int addFace (unsigned int i1, unsigned int i2, unsigned int i3)
   {
+    this->materialize ();
     assert (i1 < this->mesh.numVertices ());
     assert (i2 < this->mesh.numVertices ());
     assert (i3 < this->mesh.numVertices ());
@@ -509,6 +750,12 @@ struct DynamicMesh::Impl
 
     unsigned int index = Util::invalidIndex ();
 
+    this->trackFace (this->freeFaceIndices.empty () ? this->faceData.size ()
+                                                    : this->freeFaceIndices.back ());
+    this->trackVertex (i1);
+    this->trackVertex (i2);
+    this->trackVertex (i3);
+
     if (this->freeFaceIndices.empty ())
     {
       index = this->numFaces ();
@@ -555,9 +802,12 @@ struct DynamicMesh::Impl
 
   void deleteVertex (unsigned int i)
   {
+    this->materialize ();
     assert (i < this->vertexData.size ());
     assert (i < this->vertexVisited.size ());
 
+    this->trackVertex (i);
+
     std::vector<unsigned int> adjacentFaces = this->vertexData[i].adjacentFaces;
     for (unsigned int f : adjacentFaces)
     {
@@ -570,9 +820,15 @@ struct DynamicMesh::Impl
 
   void deleteFace (unsigned int i)
   {
+    this->materialize ();
     assert (i < this->faceData.size ());
     assert (i < this->faceVisited.size ());
 
+    this->trackFace (i);
+    this->trackVertex (this->mesh.index ((3 * i) + 0));
+    this->trackVertex (this->mesh.index ((3 * i) + 1));
+    this->trackVertex (this->mesh.index ((3 * i) + 2));
+
     this->vertexData[this->mesh.index ((3 * i) + 0)].deleteAdjacentFace (i);
     this->vertexData[this->mesh.index ((3 * i) + 1)].deleteAdjacentFace (i);
     this->vertexData[this->mesh.index ((3 * i) + 2)].deleteAdjacentFace (i);
@@ -583,11 +839,19 @@ struct DynamicMesh::Impl
     this->octree.deleteElement (i);
   }
 
+  void vertex (unsigned int i, const glm::vec3& v)
+  {
+    this->materialize ();
+    this->trackVertex (i);
+    this->mesh.vertex (i, v);
+  }
+
   void vertexNormal (unsigned int i, const glm::vec3& n)
   {
     assert (this->isFreeVertex (i) == false);
     assert (this->mesh.numVertices () == this->vertexData.size ());
 
+    this->trackVertex (i);
     this->mesh.normal (i, n);
   }
 
@@ -595,6 +859,8 @@ struct DynamicMesh::Impl
   {
     const glm::vec3 avg = this->averageNormal (i);
 
+    this->trackVertex (i);
+
     if (Util::isNaN (avg))
     {
       this->mesh.normal (i, glm::vec3 (0.0f));
@@ -612,6 +878,10 @@ struct DynamicMesh::Impl
 
   void reset ()
   {
+    assert (this->tracker.isActive == false);
+
+    this->pendingTopology.reset ();
+    this->modifications.markAll ();
     this->mesh.reset ();
     this->vertexData.clear ();
     this->vertexVisited.clear ();
@@ -622,29 +892,151 @@ struct DynamicMesh::Impl
     this->octree.reset ();
   }
 
-  void fromMesh (const Mesh& mesh)
+  // Copies vertices and indices in bulk, without any adjacency
+  void copyMesh (const Mesh& mesh)
   {
+    assert (mesh.numIndices () % 3 == 0);
+
+    const unsigned int numVertices = mesh.numVertices ();
+    const unsigned int numFaces = mesh.numIndices () / 3;
+
     this->reset ();
-    this->mesh.reserveVertices (mesh.numVertices ());
+    this->mesh.reserveVertices (numVertices);
+    this->mesh.reserveIndices (mesh.numIndices ());
+    this->mesh.addVertices (mesh.vertexData (), mesh.normalData (), numVertices);
+    this->mesh.addIndices (mesh.indexData (), mesh.numIndices ());
+
+    this->vertexData.resize (numVertices);
+    this->vertexVisited.resize (numVertices, 0);
+    this->faceData.resize (numFaces);
+    this->faceVisited.resize (numFaces, 0);
 
-    for (unsigned int i = 0; i < mesh.numVertices (); i++)
+    for (VertexData& v : this->vertexData)
     {
-      this->addVertex (mesh.vertex (i), mesh.normal (i));
+      v.isFree = false;
     }
+    for (FaceData& f : this->faceData)
+    {
+      f.isFree = false;
+    }
+  }
 
-    assert (mesh.numIndices () % 3 == 0);
-    this->mesh.reserveIndices (mesh.numIndices ());
+  void installTopology (Topology& topology)
+  {
+    assert (topology.adjacentFaces.size () == this->vertexData.size ());
 
-    for (unsigned int i = 0; i < mesh.numIndices (); i += 3)
+    for (unsigned int i = 0; i < this->vertexData.size (); i++)
     {
-      this->addFace (mesh.index (i), mesh.index (i + 1), mesh.index (i + 2));
+      this->vertexData[i].adjacentFaces.swap (topology.adjacentFaces[i]);
     }
+    this->octree.swap (topology.octree);
+  }
+
+  void fromMesh (const Mesh& mesh)
+  {
+    this->copyMesh (mesh);
+
+    Topology topology;
+    topology.build (this->mesh);
+
+    this->installTopology (topology);
     this->setAllNormals ();
     this->mesh.bufferData ();
   }
 
+  void fromMesh (const Mesh& mesh, const std::vector<bool>& isFreeVertex,
+                 const std::vector<bool>& isFreeFace)
+  {
+    assert (isFreeVertex.size () == mesh.numVertices ());
+    assert (3 * isFreeFace.size () == mesh.numIndices ());
+
+    this->copyMesh (mesh);
+
+    for (unsigned int i = 0; i < this->vertexData.size (); i++)
+    {
+      if (isFreeVertex[i])
+      {
+        this->vertexData[i].isFree = true;
+        this->freeVertexIndices.push_back (i);
+      }
+    }
+    for (unsigned int i = 0; i < this->faceData.size (); i++)
+    {
+      if (isFreeFace[i])
+      {
+        this->faceData[i].isFree = true;
+        this->freeFaceIndices.push_back (i);
+      }
+    }
+
+    Topology topology;
+    topology.build (this->mesh, &isFreeFace);
+
+    this->installTopology (topology);
+    this->setAllNormals ();
+    this->bufferData ();
+  }
+
+  // Normals are accumulated per face, since adjacency isn't available yet.  Buffers are left to
+  // the first call of `bufferData`.
+  void fromMeshDeferred (const Mesh& mesh)
+  {
+    this->copyMesh (mesh);
+    this->pendingTopology = std::make_shared<PendingTopology> (this->mesh);
+
+    std::vector<glm::vec3> normals (this->mesh.numVertices (), glm::vec3 (0.0f));
+    for (unsigned int i = 0; i < this->faceData.size (); i++)
+    {
+      const unsigned int i1 = this->mesh.index ((3 * i) + 0);
+      const unsigned int i2 = this->mesh.index ((3 * i) + 1);
+      const unsigned int i3 = this->mesh.index ((3 * i) + 2);
+      const glm::vec3    n = glm::cross (this->mesh.vertex (i2) - this->mesh.vertex (i1),
+                                      this->mesh.vertex (i3) - this->mesh.vertex (i1));
+      normals[i1] += n;
+      normals[i2] += n;
+      normals[i3] += n;
+    }
+    for (unsigned int i = 0; i < this->mesh.numVertices (); i++)
+    {
+      const glm::vec3 n = glm::normalize (normals[i]);
+      this->mesh.normal (i, Util::isNaN (n) ? glm::vec3 (0.0f) : n);
+    }
+  }
+
+  void materialize () const
+  {
+    if (this->pendingTopology)
+    {
+      Impl& impl = const_cast<Impl&> (*this);
+
+      impl.pendingTopology->build ();
+      impl.installTopology (impl.pendingTopology->topology);
+      impl.pendingTopology.reset ();
+    }
+  }
+
+  const Impl& materialized () const
+  {
+    this->materialize ();
+    return *this;
+  }
+
+  std::function<void()> materializationTask () const
+  {
+    if (this->pendingTopology)
+    {
+      std::shared_ptr<PendingTopology> pending = this->pendingTopology;
+      return [pending]() { pending->build (); };
+    }
+    else
+    {
+      return nullptr;
+    }
+  }
+
   void realignFace (unsigned int i)
   {
+    this->materialize ();
     assert (this->isFreeFace (i) == false);
 
     const PrimTriangle tri = this->face (i);
@@ -667,14 +1059,20 @@ struct DynamicMesh::Impl
 
   void sanitize ()
   {
+    this->materialize ();
     this->octree.deleteEmptyChildren ();
     this->octree.shrinkRoot ();
   }
 
   void prune (std::vector<unsigned int>* pVertexIndexMap, std::vector<unsigned int>* pFaceIndexMap)
   {
+    this->materialize ();
     if (this->isPruned () == false)
     {
+      assert (this->tracker.isActive == false);
+
+      this->modifications.markAll ();
+
       std::vector<unsigned int> defaultVertexIndexMap;
       std::vector<unsigned int> defaultFaceIndexMap;
 
@@ -761,9 +1159,53 @@ struct DynamicMesh::Impl
   bool pruneAndCheckConsistency (std::vector<unsigned int>* pVertexIndexMap,
                                  std::vector<unsigned int>* pFaceIndexMap)
   {
-    this->prune (pVertexIndexMap, pFaceIndexMap);
-    this->bufferData ();
+    if (this->tracker.isActive)
+    {
+      // Pruning would invalidate all tracked changes, so a pruned copy is checked instead
+      DynamicMesh copy (*this->self);
+      copy.impl->prune (pVertexIndexMap, pFaceIndexMap);
+      return copy.impl->checkConsistency ();
+    }
+    else
+    {
+      this->prune (pVertexIndexMap, pFaceIndexMap);
+      this->bufferData ();
+      return this->checkConsistency ();
+    }
+  }
+
+  // Unlike `prune`, these keep the slot layout that recorded changes refer to
+  Mesh prunedMesh () const
+  {
+    if (this->isPruned ())
+    {
+      return this->mesh;
+    }
+    else
+    {
+      DynamicMesh copy (*this->self);
+      copy.impl->prune (nullptr, nullptr);
+      return copy.mesh ();
+    }
+  }
 
+  bool checkPrunedConsistency () const
+  {
+    if (this->isPruned ())
+    {
+      return this->checkConsistency ();
+    }
+    else
+    {
+      DynamicMesh copy (*this->self);
+      copy.impl->prune (nullptr, nullptr);
+      return copy.impl->checkConsistency ();
+    }
+  }
+
+  bool checkConsistency () const
+  {
+    this->materialize ();
     if (MeshUtil::checkConsistency (this->mesh))
     {
       for (unsigned int i = 0; i < this->vertexData.size (); i++)
@@ -787,7 +1229,7 @@ struct DynamicMesh::Impl
 
   bool mirrorPositive (const PrimPlane& plane)
   {
-    assert (this->pruneAndCheckConsistency (nullptr, nullptr));
+    assert (this->checkPrunedConsistency ());
 
     const auto inBorder = [this, &plane](unsigned int f) {
       unsigned int i1, i2, i3;
@@ -834,6 +1276,7 @@ struct DynamicMesh::Impl
 
   void mirror (const PrimPlane& plane)
   {
+    this->modifications.markAll ();
     MeshUtil::mirror (this->mesh, plane);
     this->realignAllFaces ();
     this->bufferData ();
@@ -841,6 +1284,7 @@ struct DynamicMesh::Impl
 
   void moveToCenter ()
   {
+    this->modifications.markAll ();
     MeshUtil::moveToCenter (this->mesh);
     this->realignAllFaces ();
     this->bufferData ();
@@ -848,11 +1292,195 @@ struct DynamicMesh::Impl
 
   void normalizeScaling ()
   {
+    this->modifications.markAll ();
     MeshUtil::normalizeScaling (this->mesh);
     this->realignAllFaces ();
     this->bufferData ();
   }
 
+  void trackVertex (unsigned int i)
+  {
+    this->materialize ();
+    this->modifications.markVertex (i);
+
+    if (this->tracker.isActive && ChangeTracker::mark (this->tracker.vertexTracked, i))
+    {
+      DynamicMeshChanges::Vertex v;
+      v.index = i;
+
+      if (i < this->vertexData.size ())
+      {
+        v.isFree = this->vertexData[i].isFree;
+        v.position = this->mesh.vertex (i);
+        v.normal = this->mesh.normal (i);
+        v.adjacentFaces = this->vertexData[i].adjacentFaces;
+      }
+      else
+      {
+        v.isFree = true;
+        v.position = glm::vec3 (0.0f);
+        v.normal = glm::vec3 (0.0f);
+      }
+      this->tracker.changes.vertices ().push_back (std::move (v));
+    }
+  }
+
+  void trackFace (unsigned int i)
+  {
+    this->materialize ();
+    this->modifications.markFace (i);
+
+    if (this->tracker.isActive && ChangeTracker::mark (this->tracker.faceTracked, i))
+    {
+      DynamicMeshChanges::Face f;
+      f.index = i;
+
+      if (i < this->faceData.size ())
+      {
+        f.isFree = this->faceData[i].isFree;
+        f.i1 = this->mesh.index ((3 * i) + 0);
+        f.i2 = this->mesh.index ((3 * i) + 1);
+        f.i3 = this->mesh.index ((3 * i) + 2);
+      }
+      else
+      {
+        f.isFree = true;
+        f.i1 = 0;
+        f.i2 = 0;
+        f.i3 = 0;
+      }
+      this->tracker.changes.faces ().push_back (f);
+    }
+  }
+
+  void trackChanges ()
+  {
+    assert (this->tracker.isActive == false);
+    assert (this->tracker.changes.isEmpty ());
+
+    this->tracker.isActive = true;
+  }
+
+  bool isTrackingChanges () const { return this->tracker.isActive; }
+
+  const DynamicMeshChanges& trackedChanges () const { return this->tracker.changes; }
+
+  DynamicMeshChanges untrackChanges ()
+  {
+    assert (this->tracker.isActive);
+
+    for (const DynamicMeshChanges::Vertex& v : this->tracker.changes.vertices ())
+    {
+      this->tracker.vertexTracked[v.index] = 0;
+    }
+    for (const DynamicMeshChanges::Face& f : this->tracker.changes.faces ())
+    {
+      this->tracker.faceTracked[f.index] = 0;
+    }
+    DynamicMeshChanges changes = std::move (this->tracker.changes);
+
+    this->tracker.changes.reset ();
+    this->tracker.isActive = false;
+    return changes;
+  }
+
+  bool takeModified (std::vector<unsigned int>& vertices, std::vector<unsigned int>& faces)
+  {
+    return this->modifications.take (vertices, faces);
+  }
+
+  void applyChanges (DynamicMeshChanges& changes)
+  {
+    this->materialize ();
+    assert (this->tracker.isActive == false);
+
+    for (const DynamicMeshChanges::Face& f : changes.faces ())
+    {
+      assert (f.index < this->faceData.size ());
+
+      if (this->faceData[f.index].isFree == false)
+      {
+        this->octree.deleteElement (f.index);
+      }
+    }
+
+    for (DynamicMeshChanges::Face& f : changes.faces ())
+    {
+      this->modifications.markFace (f.index);
+
+      FaceData&          data = this->faceData[f.index];
+      const bool         wasFree = data.isFree;
+      const unsigned int i1 = this->mesh.index ((3 * f.index) + 0);
+      const unsigned int i2 = this->mesh.index ((3 * f.index) + 1);
+      const unsigned int i3 = this->mesh.index ((3 * f.index) + 2);
+
+      data.isFree = f.isFree;
+      this->faceVisited[f.index] = 0;
+      this->mesh.index ((3 * f.index) + 0, f.i1);
+      this->mesh.index ((3 * f.index) + 1, f.i2);
+      this->mesh.index ((3 * f.index) + 2, f.i3);
+
+      if (wasFree && data.isFree == false)
+      {
+        eraseIndex (this->freeFaceIndices, f.index);
+      }
+      else if (wasFree == false && data.isFree)
+      {
+        this->freeFaceIndices.push_back (f.index);
+      }
+      f.isFree = wasFree;
+      f.i1 = i1;
+      f.i2 = i2;
+      f.i3 = i3;
+    }
+
+    for (DynamicMeshChanges::Vertex& v : changes.vertices ())
+    {
+      assert (v.index < this->vertexData.size ());
+      this->modifications.markVertex (v.index);
+
+      VertexData&     data = this->vertexData[v.index];
+      const bool      wasFree = data.isFree;
+      const glm::vec3 position = this->mesh.vertex (v.index);
+      const glm::vec3 normal = this->mesh.normal (v.index);
+
+      data.isFree = v.isFree;
+      data.adjacentFaces.swap (v.adjacentFaces);
+      this->vertexVisited[v.index] = 0;
+      this->mesh.vertex (v.index, v.position);
+      this->mesh.normal (v.index, v.normal);
+
+      if (wasFree && data.isFree == false)
+      {
+        eraseIndex (this->freeVertexIndices, v.index);
+      }
+      else if (wasFree == false && data.isFree)
+      {
+        this->freeVertexIndices.push_back (v.index);
+      }
+      v.isFree = wasFree;
+      v.position = position;
+      v.normal = normal;
+    }
+
+    for (const DynamicMeshChanges::Face& f : changes.faces ())
+    {
+      if (this->faceData[f.index].isFree == false)
+      {
+        this->addFaceToOctree (f.index);
+      }
+    }
+
+    // Faces that have not been tracked themselves may still have moved with their vertices
+    for (const DynamicMeshChanges::Vertex& v : changes.vertices ())
+    {
+      for (unsigned int f : this->vertexData[v.index].adjacentFaces)
+      {
+        this->realignFace (f);
+      }
+    }
+  }
+
   void bufferData ()
   {
     const auto findNonFreeFaceIndex = [this]() -> unsigned int {
@@ -892,6 +1520,7 @@ struct DynamicMesh::Impl
 
   bool intersects (const PrimRay& ray, Intersection& intersection, bool bothSides) const
   {
+    this->materialize ();
     this->octree.intersects (ray, [this, &ray, &intersection, bothSides](unsigned int i) -> float {
       const PrimTriangle tri = this->face (i);
       float              t;
@@ -911,6 +1540,7 @@ struct DynamicMesh::Impl
 
   bool intersects (const PrimRay& ray, DynamicMeshIntersection& intersection)
   {
+    this->materialize ();
     this->octree.intersects (ray, [this, &ray, &intersection](unsigned int i) -> float {
       const PrimTriangle tri = this->face (i);
       float              t;
@@ -931,6 +1561,7 @@ struct DynamicMesh::Impl
   template <typename T, typename... Ts>
   bool intersectsT (const T& t, DynamicFaces& faces, const Ts&... args) const
   {
+    this->materialize ();
     this->octree.intersects (t, [this, &t, &faces, &args...](unsigned int i) {
       if (IntersectionUtil::intersects (t, this->face (i), args...))
       {
@@ -944,6 +1575,7 @@ struct DynamicMesh::Impl
   template <typename T, typename... Ts>
   bool containsOrIntersectsT (const T& t, DynamicFaces& faces, const Ts&... args) const
   {
+    this->materialize ();
     this->octree.intersects (t, [this, &t, &faces, &args...](bool contains, unsigned int i) {
       if (contains || IntersectionUtil::intersects (t, this->face (i), args...))
       {
@@ -971,19 +1603,25 @@ struct DynamicMesh::Impl
 
   float unsignedDistance (const glm::vec3& pos) const
   {
+    this->materialize ();
     return this->octree.distance (
       pos, [this, &pos](unsigned int i) { return Distance::distance (this->face (i), pos); });
   }
 
   void normalize ()
   {
+    this->materialize ();
     this->mesh.normalize ();
     this->octree.reset ();
 
     this->forEachFace ([this](unsigned int i) { this->addFaceToOctree (i); });
   }
 
-  void printStatistics () const { this->octree.printStatistics (); }
+  void printStatistics () const
+  {
+    this->materialize ();
+    this->octree.printStatistics ();
+  }
 
   void runFromConfig (const Config& config)
   {
@@ -992,8 +1630,19 @@ struct DynamicMesh::Impl
   }
 };
 
-DELEGATE_BIG4_COPY_SELF (DynamicMesh)
+DELEGATE_CONSTRUCTOR_SELF (DynamicMesh)
+DELEGATE_BIG3_WITHOUT_CONSTRUCTOR_SELF (DynamicMesh)
+
+// Copies never share the pending topology of their source
+DynamicMesh::DynamicMesh (const DynamicMesh& a1)
+  : impl (new Impl (a1.impl->materialized ()))
+{
+  SET_SELF
+}
+
 DELEGATE1_CONSTRUCTOR_SELF (DynamicMesh, const Mesh&)
+GETTER_CONST (unsigned int, DynamicMesh, id)
+SETTER (unsigned int, DynamicMesh, id)
 DELEGATE_CONST (unsigned int, DynamicMesh, numVertices)
 DELEGATE_CONST (unsigned int, DynamicMesh, numFaces)
 DELEGATE_CONST (bool, DynamicMesh, isEmpty)
@@ -1031,17 +1680,24 @@ DELEGATE2 (unsigned int, DynamicMesh, addVertex, const glm::vec3&, const glm::ve
 DELEGATE3 (unsigned int, DynamicMesh, addFace, unsigned int, unsigned int, unsigned int)
 DELEGATE1 (void, DynamicMesh, deleteVertex, unsigned int)
 DELEGATE1 (void, DynamicMesh, deleteFace, unsigned int)
-DELEGATE2_MEMBER (void, DynamicMesh, vertex, mesh, unsigned int, const glm::vec3&)
+DELEGATE2 (void, DynamicMesh, vertex, unsigned int, const glm::vec3&)
 DELEGATE2 (void, DynamicMesh, vertexNormal, unsigned int, const glm::vec3&)
 DELEGATE1 (void, DynamicMesh, setVertexNormal, unsigned int)
 DELEGATE (void, DynamicMesh, setAllNormals)
 DELEGATE (void, DynamicMesh, reset)
 DELEGATE1 (void, DynamicMesh, fromMesh, const Mesh&)
+DELEGATE3 (void, DynamicMesh, fromMesh, const Mesh&, const std::vector<bool>&,
+           const std::vector<bool>&)
+DELEGATE1 (void, DynamicMesh, fromMeshDeferred, const Mesh&)
+DELEGATE_CONST (std::function<void()>, DynamicMesh, materializationTask)
 DELEGATE1 (void, DynamicMesh, realignFace, unsigned int)
 DELEGATE1 (void, DynamicMesh, realignFaces, const DynamicFaces&)
 DELEGATE (void, DynamicMesh, realignAllFaces)
 DELEGATE (void, DynamicMesh, sanitize)
 DELEGATE2 (void, DynamicMesh, prune, std::vector<unsigned int>*, std::vector<unsigned int>*)
+DELEGATE_CONST (bool, DynamicMesh, isPruned)
+DELEGATE_CONST (Mesh, DynamicMesh, prunedMesh)
+DELEGATE_CONST (bool, DynamicMesh, checkPrunedConsistency)
 DELEGATE2 (bool, DynamicMesh, pruneAndCheckConsistency, std::vector<unsigned int>*,
            std::vector<unsigned int>*)
 DELEGATE1 (bool, DynamicMesh, mirrorPositive, const PrimPlane&)
@@ -1052,6 +1708,14 @@ DELEGATE (void, DynamicMesh, bufferData)
 DELEGATE1_CONST (void, DynamicMesh, render, Camera&)
 DELEGATE_MEMBER_CONST (const RenderMode&, DynamicMesh, renderMode, mesh)
 DELEGATE_MEMBER (RenderMode&, DynamicMesh, renderMode, mesh)
+GETTER (std::vector<unsigned int>&, DynamicMesh, scratchIndices)
+GETTER (std::vector<glm::vec3>&, DynamicMesh, scratchPositions)
+DELEGATE (void, DynamicMesh, trackChanges)
+DELEGATE_CONST (bool, DynamicMesh, isTrackingChanges)
+DELEGATE_CONST (const DynamicMeshChanges&, DynamicMesh, trackedChanges)
+DELEGATE (DynamicMeshChanges, DynamicMesh, untrackChanges)
+DELEGATE1 (void, DynamicMesh, applyChanges, DynamicMeshChanges&)
+DELEGATE2 (bool, DynamicMesh, takeModified, std::vector<unsigned int>&, std::vector<unsigned int>&)
 
 DELEGATE3_CONST (bool, DynamicMesh, intersects, const PrimRay&, Intersection&, bool)
 DELEGATE2 (bool, DynamicMesh, intersects, const PrimRay&, DynamicMeshIntersection&)
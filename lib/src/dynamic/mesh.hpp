@@ -14,6 +14,7 @@
 class Camera;
 class Color;
 class DynamicFaces;
+class DynamicMeshChanges;
 class DynamicMeshIntersection;
 class Intersection;
 class Mesh;
@@ -30,6 +31,10 @@ public:
   DECLARE_BIG4_EXPLICIT_COPY (DynamicMesh);
   DynamicMesh (const Mesh&);
 
+  // Identifies a mesh across undo and redo (see `Scene::newDynamicMesh`)
+  unsigned int id () const;
+  void         id (unsigned int);
+
   unsigned int     numVertices () const;
   unsigned int     numFaces () const;
   bool             isEmpty () const;
@@ -75,6 +80,15 @@ public:
 
   void reset ();
   void fromMesh (const Mesh&);
+
+  // Restores a mesh with free slots, which are flagged by the given vertex and face masks
+  void fromMesh (const Mesh&, const std::vector<bool>&, const std::vector<bool>&);
+
+  // Sets up rendering data only: adjacency and octree are built by the returned task of
+  // `materializationTask`, which may run on any thread, or on first use otherwise
+  void                  fromMeshDeferred (const Mesh&);
+  std::function<void()> materializationTask () const;
+
   void realignFace (unsigned int);
   void realignFaces (const DynamicFaces&);
   void realignAllFaces ();
@@ -82,6 +96,13 @@ public:
   void prune (std::vector<unsigned int>* = nullptr, std::vector<unsigned int>* = nullptr);
   bool pruneAndCheckConsistency (std::vector<unsigned int>* = nullptr,
                                  std::vector<unsigned int>* = nullptr);
+
+  // Pruning in place would invalidate the changes recorded by the history: these work on a
+  // pruned copy if the mesh has free slots
+  bool isPruned () const;
+  Mesh prunedMesh () const;
+  bool checkPrunedConsistency () const;
+
   bool mirrorPositive (const PrimPlane&);
   void mirror (const PrimPlane&);
   void moveToCenter ();
@@ -93,6 +114,25 @@ public:
   const RenderMode& renderMode () const;
   RenderMode&       renderMode ();
 
+  // Reusable buffers for two-phase passes over a subset of the mesh: their capacity is kept
+  // between passes, so that steady-state sculpting does not allocate
+  std::vector<unsigned int>& scratchIndices ();
+  std::vector<glm::vec3>&    scratchPositions ();
+
+  // While tracking changes, the prior state of every modified vertex and face is recorded.
+  // Applying the recorded changes restores these states and records the replaced ones in turn,
+  // i.e., applying them twice is a no-op.  Pruning is not allowed while tracking changes.
+  void                      trackChanges ();
+  bool                      isTrackingChanges () const;
+  const DynamicMeshChanges& trackedChanges () const;
+  DynamicMeshChanges        untrackChanges ();
+  void                      applyChanges (DynamicMeshChanges&);
+
+  // Takes the indices of all vertex and face slots that have been modified since the last call.
+  // Initially, and after resetting or pruning, all slots are considered to be modified: no indices
+  // are taken then, which is indicated by the return value.
+  bool takeModified (std::vector<unsigned int>&, std::vector<unsigned int>&);
+
   bool  intersects (const PrimRay&, Intersection&, bool = false) const;
   bool  intersects (const PrimRay&, DynamicMeshIntersection&);
   bool  intersects (const PrimPlane&, DynamicFaces&) const;
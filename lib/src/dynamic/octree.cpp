@@ -733,3 +733,5 @@ DELEGATE2_CONST (void, DynamicOctree, intersects, const PrimAABox&,
 DELEGATE2_CONST (float, DynamicOctree, distance, const glm::vec3&,
                  const DynamicOctree::DistanceCallback&)
 DELEGATE_CONST (void, DynamicOctree, printStatistics)
+
+void DynamicOctree::swap (DynamicOctree& other) { this->impl.swap (other.impl); }
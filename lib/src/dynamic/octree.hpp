@@ -35,6 +35,7 @@ public:
   void  updateIndices (const std::vector<unsigned int>&);
   void  shrinkRoot ();
   void  reset ();
+  void  swap (DynamicOctree&);
   void  render (Camera&) const;
   void  intersects (const PrimRay&, const RayIntersectionCallback&) const;
   void  intersects (const PrimPlane&, const IntersectionCallback&) const;
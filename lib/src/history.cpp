@@ -2,9 +2,18 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
+#include "compressed-mesh.hpp"
 #include "config.hpp"
+#include "dynamic/mesh-changes.hpp"
 #include "dynamic/mesh.hpp"
 #include "history.hpp"
 #include "maybe.hpp"
@@ -20,43 +29,144 @@ namespace
   {
     bool snapshotDynamicMeshes;
     bool snapshotSketchMeshes;
+    bool trackDynamicMeshes;
 
-    SnapshotConfig (bool d, bool s)
+    SnapshotConfig (bool d, bool s, bool t = false)
       : snapshotDynamicMeshes (d)
       , snapshotSketchMeshes (s)
+      , trackDynamicMeshes (t)
     {
-      assert (this->snapshotDynamicMeshes || this->snapshotSketchMeshes);
+      assert (this->snapshotDynamicMeshes || this->snapshotSketchMeshes ||
+              this->trackDynamicMeshes);
+      assert (this->trackDynamicMeshes == false || this->snapshotDynamicMeshes == false);
     }
   };
 
+  // Dynamic meshes of a snapshot, which are compressed in the background as soon as the
+  // snapshot is not the most recent one anymore.  `meshes` is not modified while it is shared
+  // with the compression thread, and is released once `isCompressed` is set.
+  struct DynamicMeshesSnapshot
+  {
+    std::vector<unsigned int> ids;
+    std::list<DynamicMesh>    meshes;
+    std::list<CompressedMesh> compressedMeshes;
+    bool                      isCompressed;
+    bool                      isScheduled;
+
+    DynamicMeshesSnapshot ()
+      : isCompressed (false)
+      , isScheduled (false)
+    {
+    }
+  };
+
+  // Dynamic snapshots only hold the meshes that are touched by an operation, but the ids of all
+  // dynamic meshes, so that meshes which are added afterwards can be deleted when undoing
   struct SceneSnapshot
   {
-    const SnapshotConfig   config;
-    std::list<DynamicMesh> dynamicMeshes;
-    std::list<SketchMesh>  sketchMeshes;
+    const SnapshotConfig                   config;
+    std::vector<unsigned int>              dynamicMeshIds;
+    std::shared_ptr<DynamicMeshesSnapshot> dynamicMeshes;
+    std::list<SketchMesh>                  sketchMeshes;
+    std::size_t                            numBytes;
+
+    // Changes of each dynamic mesh in `dynamicMeshIds`, if `config.trackDynamicMeshes` is set
+    std::vector<DynamicMeshChanges> dynamicMeshChanges;
 
     SceneSnapshot (const SnapshotConfig& c)
       : config (c)
+      , numBytes (0)
     {
     }
   };
 
   typedef std::list<SceneSnapshot> Timeline;
 
-  SceneSnapshot sceneSnapshot (const Scene& scene, const SnapshotConfig& config)
+  std::size_t numBytes (const DynamicMesh& mesh)
+  {
+    // Indices are counted thrice to account for adjacency and octree data
+    return (2 * sizeof (glm::vec3) * mesh.mesh ().numVertices ()) +
+           (3 * sizeof (unsigned int) * mesh.mesh ().numIndices ());
+  }
+
+  std::size_t numBytes (const SketchMesh& mesh)
+  {
+    std::size_t n = 0;
+
+    if (mesh.tree ().hasRoot ())
+    {
+      n += sizeof (SketchNode) * mesh.tree ().root ().numNodes ();
+    }
+    for (const SketchPath& p : mesh.paths ())
+    {
+      n += sizeof (PrimSphere) * p.spheres ().size ();
+    }
+    return n;
+  }
+
+  std::size_t numBytes (const SceneSnapshot& snapshot)
+  {
+    std::size_t n = sizeof (SceneSnapshot);
+
+    if (snapshot.dynamicMeshes)
+    {
+      // Compressed meshes are stable once the uncompressed ones have been released
+      if (snapshot.dynamicMeshes->meshes.empty ())
+      {
+        for (const CompressedMesh& m : snapshot.dynamicMeshes->compressedMeshes)
+        {
+          n += m.numBytes ();
+        }
+      }
+      else
+      {
+        for (const DynamicMesh& m : snapshot.dynamicMeshes->meshes)
+        {
+          n += numBytes (m);
+        }
+      }
+    }
+    for (const SketchMesh& m : snapshot.sketchMeshes)
+    {
+      n += numBytes (m);
+    }
+    for (const DynamicMeshChanges& c : snapshot.dynamicMeshChanges)
+    {
+      n += c.numBytes ();
+    }
+    return n;
+  }
+
+  bool contains (const std::vector<unsigned int>& ids, unsigned int id)
+  {
+    return std::find (ids.begin (), ids.end (), id) != ids.end ();
+  }
+
+  SceneSnapshot sceneSnapshot (const Scene& scene, const SnapshotConfig& config,
+                               const std::function<bool(const DynamicMesh&)>& isTouched)
   {
     SceneSnapshot snapshot (config);
 
     if (config.snapshotDynamicMeshes)
     {
-      scene.forEachConstMesh (
-        [&snapshot](const DynamicMesh& mesh) { snapshot.dynamicMeshes.emplace_back (mesh); });
+      snapshot.dynamicMeshes = std::make_shared<DynamicMeshesSnapshot> ();
+
+      scene.forEachConstMesh ([&snapshot, &isTouched](const DynamicMesh& mesh) {
+        snapshot.dynamicMeshIds.push_back (mesh.id ());
+
+        if (isTouched (mesh))
+        {
+          snapshot.dynamicMeshes->ids.push_back (mesh.id ());
+          snapshot.dynamicMeshes->meshes.emplace_back (mesh);
+        }
+      });
     }
     if (config.snapshotSketchMeshes)
     {
       scene.forEachConstMesh (
         [&snapshot](const SketchMesh& mesh) { snapshot.sketchMeshes.emplace_back (mesh); });
     }
+    snapshot.numBytes = numBytes (snapshot);
     return snapshot;
   }
 
@@ -66,11 +176,35 @@ namespace
 
     if (snapshot.config.snapshotDynamicMeshes)
     {
-      scene.deleteDynamicMeshes ();
+      std::vector<DynamicMesh*> addedMeshes;
+      scene.forEachMesh ([&snapshot, &addedMeshes](DynamicMesh& mesh) {
+        if (contains (snapshot.dynamicMeshIds, mesh.id ()) == false)
+        {
+          addedMeshes.push_back (&mesh);
+        }
+      });
+      for (DynamicMesh* mesh : addedMeshes)
+      {
+        scene.deleteMesh (*mesh);
+      }
 
-      for (const DynamicMesh& mesh : snapshot.dynamicMeshes)
+      if (snapshot.dynamicMeshes->meshes.empty ())
       {
-        scene.newDynamicMesh (state.config (), mesh);
+        unsigned int i = 0;
+        for (const CompressedMesh& compressed : snapshot.dynamicMeshes->compressedMeshes)
+        {
+          DynamicMesh mesh;
+          compressed.decompress (mesh);
+          mesh.id (snapshot.dynamicMeshes->ids[i++]);
+          scene.restoreDynamicMesh (state.config (), mesh);
+        }
+      }
+      else
+      {
+        for (const DynamicMesh& mesh : snapshot.dynamicMeshes->meshes)
+        {
+          scene.restoreDynamicMesh (state.config (), mesh);
+        }
       }
     }
     if (snapshot.config.snapshotSketchMeshes)
@@ -83,15 +217,160 @@ namespace
       }
     }
   }
+
+  // Snapshots the meshes that are going to be replaced or deleted by resetting to `snapshot`
+  SceneSnapshot inverseSnapshot (const Scene& scene, const SceneSnapshot& snapshot)
+  {
+    return sceneSnapshot (scene, snapshot.config, [&snapshot](const DynamicMesh& mesh) {
+      return contains (snapshot.dynamicMeshes->ids, mesh.id ()) ||
+             contains (snapshot.dynamicMeshIds, mesh.id ()) == false;
+    });
+  }
+
+  // Applying tracked changes swaps them with the current state, i.e., the same snapshot serves
+  // both undo and redo
+  void applyChanges (SceneSnapshot& snapshot, State& state)
+  {
+    assert (snapshot.config.trackDynamicMeshes);
+
+    assert (snapshot.dynamicMeshIds.size () == snapshot.dynamicMeshChanges.size ());
+
+    for (unsigned int i = 0; i < snapshot.dynamicMeshIds.size (); i++)
+    {
+      DynamicMesh* mesh = state.scene ().dynamicMesh (snapshot.dynamicMeshIds[i]);
+      assert (mesh);
+
+      mesh->applyChanges (snapshot.dynamicMeshChanges[i]);
+      mesh->bufferData ();
+    }
+  }
 }
 
 struct History::Impl
 {
   unsigned int undoDepth;
+  std::size_t  maxNumBytes;
   Timeline     past;
   Timeline     future;
 
-  Impl (const Config& config) { this->runFromConfig (config); }
+  // Meshes whose changes are tracked by the most recent past snapshot, and their states before
+  // tracking started, which are only computed on demand
+  std::vector<DynamicMesh*> trackedMeshes;
+  std::list<DynamicMesh>    untrackedMeshes;
+
+  std::mutex                                         compressionMutex;
+  bool                                               quantizeCompressed;
+  std::condition_variable                            compressionCondition;
+  std::deque<std::shared_ptr<DynamicMeshesSnapshot>> compressionQueue;
+  bool                                               stopCompression;
+  std::thread                                        compressionThread;
+
+  Impl (const Config& config)
+    : quantizeCompressed (false)
+    , stopCompression (false)
+  {
+    this->runFromConfig (config);
+    this->compressionThread = std::thread ([this]() { this->runCompression (); });
+  }
+
+  ~Impl ()
+  {
+    {
+      std::lock_guard<std::mutex> lock (this->compressionMutex);
+      this->stopCompression = true;
+    }
+    this->compressionCondition.notify_one ();
+    this->compressionThread.join ();
+  }
+
+  void runCompression ()
+  {
+    std::unique_lock<std::mutex> lock (this->compressionMutex);
+
+    while (true)
+    {
+      this->compressionCondition.wait (lock, [this]() {
+        return this->stopCompression || this->compressionQueue.empty () == false;
+      });
+
+      if (this->stopCompression)
+      {
+        return;
+      }
+
+      std::shared_ptr<DynamicMeshesSnapshot> snapshot = this->compressionQueue.front ();
+      this->compressionQueue.pop_front ();
+
+      // Snapshots that have been dropped in the meantime are not worth compressing
+      if (snapshot.use_count () > 1)
+      {
+        const bool quantize = this->quantizeCompressed;
+        lock.unlock ();
+
+        std::list<CompressedMesh> compressedMeshes;
+        for (const DynamicMesh& mesh : snapshot->meshes)
+        {
+          compressedMeshes.emplace_back (mesh, quantize);
+        }
+
+        lock.lock ();
+        snapshot->compressedMeshes = std::move (compressedMeshes);
+        snapshot->isCompressed = true;
+      }
+    }
+  }
+
+  // Schedules all past snapshots but the most recent one for compression
+  void scheduleCompression ()
+  {
+    if (this->past.size () > 1)
+    {
+      std::lock_guard<std::mutex> lock (this->compressionMutex);
+
+      for (auto it = std::next (this->past.begin ()); it != this->past.end (); ++it)
+      {
+        if (it->dynamicMeshes && it->dynamicMeshes->isScheduled == false)
+        {
+          it->dynamicMeshes->isScheduled = true;
+          this->compressionQueue.push_back (it->dynamicMeshes);
+        }
+      }
+      this->compressionCondition.notify_one ();
+    }
+  }
+
+  // Releases the uncompressed meshes of all compressed snapshots
+  void collectCompressed ()
+  {
+    std::lock_guard<std::mutex> lock (this->compressionMutex);
+
+    for (Timeline* timeline : {&this->past, &this->future})
+    {
+      for (SceneSnapshot& snapshot : *timeline)
+      {
+        if (snapshot.dynamicMeshes && snapshot.dynamicMeshes->isCompressed &&
+            snapshot.dynamicMeshes->meshes.empty () == false)
+        {
+          snapshot.dynamicMeshes->meshes.clear ();
+          snapshot.numBytes = numBytes (snapshot);
+        }
+      }
+    }
+  }
+
+  std::size_t totalNumBytes () const
+  {
+    std::size_t n = 0;
+
+    for (const Timeline* timeline : {&this->past, &this->future})
+    {
+      for (const SceneSnapshot& snapshot : *timeline)
+      {
+        n += snapshot.numBytes;
+      }
+    }
+    return n;
+  }
 
   void snapshotAll (const Scene& scene) { this->snapshot (scene, SnapshotConfig (true, true)); }
 
@@ -100,26 +379,142 @@ struct History::Impl
     this->snapshot (scene, SnapshotConfig (true, false));
   }
 
+  void snapshotDynamicMeshes (const Scene& scene, const std::vector<const DynamicMesh*>& touched)
+  {
+    this->untrackDynamicMeshes ();
+    this->pushPast (
+      sceneSnapshot (scene, SnapshotConfig (true, false), [&touched](const DynamicMesh& mesh) {
+        return std::find (touched.begin (), touched.end (), &mesh) != touched.end ();
+      }));
+  }
+
   void snapshotSketchMeshes (const Scene& scene)
   {
     this->snapshot (scene, SnapshotConfig (false, true));
   }
 
   void snapshot (const Scene& scene, const SnapshotConfig& config)
+  {
+    this->untrackDynamicMeshes ();
+    this->pushPast (sceneSnapshot (scene, config, [](const DynamicMesh&) { return true; }));
+  }
+
+  void pushPast (SceneSnapshot&& snapshot)
   {
     assert (undoDepth > 0);
 
+    this->collectCompressed ();
     this->future.clear ();
 
     while (this->past.size () >= this->undoDepth)
     {
       this->past.pop_back ();
     }
-    this->past.push_front (sceneSnapshot (scene, config));
+    this->past.push_front (std::move (snapshot));
+
+    while (this->past.size () > 1 && this->totalNumBytes () > this->maxNumBytes)
+    {
+      this->past.pop_back ();
+    }
+    this->scheduleCompression ();
+  }
+
+  void trackDynamicMeshes (Scene& scene)
+  {
+    this->untrackDynamicMeshes ();
+    this->pushPast (SceneSnapshot (SnapshotConfig (false, false, true)));
+
+    scene.forEachMesh ([this](DynamicMesh& mesh) {
+      mesh.trackChanges ();
+      this->trackedMeshes.push_back (&mesh);
+    });
+  }
+
+  void untrackDynamicMeshes ()
+  {
+    if (this->trackedMeshes.empty () == false)
+    {
+      assert (this->past.empty () == false);
+      assert (this->past.front ().config.trackDynamicMeshes);
+
+      SceneSnapshot& snapshot = this->past.front ();
+
+      for (DynamicMesh* mesh : this->trackedMeshes)
+      {
+        DynamicMeshChanges changes = mesh->untrackChanges ();
+
+        if (changes.isEmpty () == false)
+        {
+          snapshot.dynamicMeshIds.push_back (mesh->id ());
+          snapshot.dynamicMeshChanges.push_back (std::move (changes));
+        }
+      }
+      snapshot.numBytes = numBytes (snapshot);
+
+      this->trackedMeshes.clear ();
+      this->untrackedMeshes.clear ();
+    }
+  }
+
+  void snapshotTrackedDynamicMeshes ()
+  {
+    if (this->trackedMeshes.empty () == false)
+    {
+      SceneSnapshot snapshot (SnapshotConfig (true, false));
+
+      this->computeUntrackedMeshes ();
+      snapshot.dynamicMeshes = std::make_shared<DynamicMeshesSnapshot> ();
+
+      auto untracked = this->untrackedMeshes.begin ();
+      for (DynamicMesh* mesh : this->trackedMeshes)
+      {
+        snapshot.dynamicMeshIds.push_back (mesh->id ());
+
+        if (mesh->untrackChanges ().isEmpty ())
+        {
+          ++untracked;
+        }
+        else
+        {
+          snapshot.dynamicMeshes->ids.push_back (mesh->id ());
+          snapshot.dynamicMeshes->meshes.splice (snapshot.dynamicMeshes->meshes.end (),
+                                                 this->untrackedMeshes, untracked++);
+        }
+      }
+      snapshot.numBytes = numBytes (snapshot);
+      this->trackedMeshes.clear ();
+      this->untrackedMeshes.clear ();
+
+      this->past.pop_front ();
+      this->past.push_front (std::move (snapshot));
+    }
+  }
+
+  void computeUntrackedMeshes ()
+  {
+    if (this->untrackedMeshes.empty ())
+    {
+      for (const DynamicMesh* mesh : this->trackedMeshes)
+      {
+        DynamicMeshChanges changes = mesh->trackedChanges ();
+
+        this->untrackedMeshes.emplace_back (*mesh);
+        this->untrackedMeshes.back ().applyChanges (changes);
+      }
+    }
   }
 
   void dropPastSnapshot ()
   {
+    if (this->trackedMeshes.empty () == false)
+    {
+      for (DynamicMesh* mesh : this->trackedMeshes)
+      {
+        mesh->untrackChanges ();
+      }
+      this->trackedMeshes.clear ();
+      this->untrackedMeshes.clear ();
+    }
     if (this->past.empty () == false)
     {
       this->past.pop_front ();
@@ -136,45 +531,99 @@ struct History::Impl
 
   void undo (State& state)
   {
+    this->untrackDynamicMeshes ();
+    this->collectCompressed ();
+
     if (this->past.empty () == false)
     {
       const SnapshotConfig& config = this->past.front ().config;
 
-      this->future.push_front (sceneSnapshot (state.scene (), config));
-      resetToSnapshot (this->past.front (), state);
-      this->past.pop_front ();
+      if (config.trackDynamicMeshes)
+      {
+        applyChanges (this->past.front (), state);
+        this->future.splice (this->future.begin (), this->past, this->past.begin ());
+      }
+      else
+      {
+        this->future.push_front (inverseSnapshot (state.scene (), this->past.front ()));
+        resetToSnapshot (this->past.front (), state);
+        this->past.pop_front ();
+      }
     }
   }
 
   void redo (State& state)
   {
+    this->untrackDynamicMeshes ();
+    this->collectCompressed ();
+
     if (this->future.empty () == false)
     {
       const SnapshotConfig& config = this->future.front ().config;
 
-      this->past.push_front (sceneSnapshot (state.scene (), config));
-      resetToSnapshot (this->future.front (), state);
-      this->future.pop_front ();
+      if (config.trackDynamicMeshes)
+      {
+        applyChanges (this->future.front (), state);
+        this->past.splice (this->past.begin (), this->future, this->future.begin ());
+      }
+      else
+      {
+        this->past.push_front (inverseSnapshot (state.scene (), this->future.front ()));
+        resetToSnapshot (this->future.front (), state);
+        this->future.pop_front ();
+      }
+      this->scheduleCompression ();
     }
   }
 
   bool hasRecentDynamicMesh () const
   {
-    return this->past.empty () == false && this->past.front ().config.snapshotDynamicMeshes;
+    if (this->past.empty ())
+    {
+      return false;
+    }
+    else if (this->past.front ().config.trackDynamicMeshes)
+    {
+      return this->trackedMeshes.empty () == false;
+    }
+    else if (this->past.front ().config.snapshotDynamicMeshes)
+    {
+      // By undoing, a compressed snapshot may have become the most recent one
+      return this->past.front ().dynamicMeshes->meshes.empty () == false;
+    }
+    else
+    {
+      return false;
+    }
   }
 
-  void forEachRecentDynamicMesh (const std::function<void(const DynamicMesh&)>& f) const
+  void forEachRecentDynamicMesh (const std::function<void(const DynamicMesh&)>& f)
   {
     assert (this->hasRecentDynamicMesh ());
 
-    for (const DynamicMesh& m : this->past.front ().dynamicMeshes)
+    if (this->past.front ().config.trackDynamicMeshes)
     {
-      f (m);
+      this->computeUntrackedMeshes ();
+
+      for (const DynamicMesh& m : this->untrackedMeshes)
+      {
+        f (m);
+      }
+    }
+    else
+    {
+      for (const DynamicMesh& m : this->past.front ().dynamicMeshes->meshes)
+      {
+        f (m);
+      }
     }
   }
 
   void reset ()
   {
+    // Tracked meshes may have been deleted already
+    this->trackedMeshes.clear ();
+    this->untrackedMeshes.clear ();
     this->past.clear ();
     this->future.clear ();
   }
@@ -182,19 +631,27 @@ struct History::Impl
   void runFromConfig (const Config& config)
   {
     this->undoDepth = config.get<int> ("editor/undo-depth");
+    this->maxNumBytes = std::size_t (config.get<int> ("editor/undo-memory")) * 1024 * 1024;
+
+    std::lock_guard<std::mutex> lock (this->compressionMutex);
+    this->quantizeCompressed = config.get<bool> ("editor/undo-quantization");
   }
 };
 
-DELEGATE1_BIG3 (History, const Config&)
+DELEGATE1_BIG2 (History, const Config&)
 DELEGATE1 (void, History, snapshotAll, const Scene&)
 DELEGATE1 (void, History, snapshotDynamicMeshes, const Scene&)
+DELEGATE2 (void, History, snapshotDynamicMeshes, const Scene&,
+           const std::vector<const DynamicMesh*>&)
 DELEGATE1 (void, History, snapshotSketchMeshes, const Scene&)
+DELEGATE1 (void, History, trackDynamicMeshes, Scene&)
+DELEGATE (void, History, untrackDynamicMeshes)
+DELEGATE (void, History, snapshotTrackedDynamicMeshes)
 DELEGATE (void, History, dropPastSnapshot)
 DELEGATE (void, History, dropFutureSnapshot)
 DELEGATE1 (void, History, undo, State&)
 DELEGATE1 (void, History, redo, State&)
 DELEGATE_CONST (bool, History, hasRecentDynamicMesh)
-DELEGATE1_CONST (void, History, forEachRecentDynamicMesh,
-                 const std::function<void(const DynamicMesh&)>&)
+DELEGATE1 (void, History, forEachRecentDynamicMesh, const std::function<void(const DynamicMesh&)>&)
 DELEGATE (void, History, reset)
 DELEGATE1 (void, History, runFromConfig, const Config&)
@@ -6,6 +6,7 @@
 #define DILAY_HISTORY
 
 #include <functional>
+#include <vector>
 #include "configurable.hpp"
 #include "macro.hpp"
 
@@ -16,17 +17,25 @@ class State;
 class History : public Configurable
 {
 public:
-  DECLARE_BIG3 (History, const Config&)
+  DECLARE_BIG2 (History, const Config&)
 
   void snapshotAll (const Scene&);
   void snapshotDynamicMeshes (const Scene&);
+  void snapshotDynamicMeshes (const Scene&, const std::vector<const DynamicMesh*>&);
   void snapshotSketchMeshes (const Scene&);
+
+  // Instead of copying all dynamic meshes up front, only their changes are recorded until
+  // `untrackDynamicMeshes` is called.  `snapshotTrackedDynamicMeshes` turns the recorded changes
+  // into a regular snapshot, e.g., before meshes are deleted from the scene.
+  void trackDynamicMeshes (Scene&);
+  void untrackDynamicMeshes ();
+  void snapshotTrackedDynamicMeshes ();
   void dropPastSnapshot ();
   void dropFutureSnapshot ();
   void undo (State&);
   void redo (State&);
   bool hasRecentDynamicMesh () const;
-  void forEachRecentDynamicMesh (const std::function<void(const DynamicMesh&)>&) const;
+  void forEachRecentDynamicMesh (const std::function<void(const DynamicMesh&)>&);
   void reset ();
 
 private:
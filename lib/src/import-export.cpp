@@ -2,11 +2,17 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <QFile>
 #include <algorithm>
+#include <cstring>
 #include <fstream>
-#include <sstream>
+#include <iterator>
+#include <list>
+#include "dly-parser.hpp"
+#include "dly-writer.hpp"
 #include "dynamic/mesh.hpp"
 #include "import-export.hpp"
+#include "mesh-formats.hpp"
 #include "mesh-util.hpp"
 #include "mesh.hpp"
 #include "scene.hpp"
@@ -17,77 +23,286 @@
 
 namespace
 {
-  std::ostream& operator<< (std::ostream& os, const glm::vec3& v)
+  /* Binary scene container (*.dlb)
+   *
+   * All fields are 4 bytes wide and stored in little-endian byte order, so that vertex, normal and
+   * index arrays can be copied in bulk from a memory-mapped file:
+   *
+   * header: "DLYB", version, number of meshes, number of sketches
+   * mesh:   number of vertices (nv), number of indices (ni), nv vertices, nv normals, ni indices
+   * sketch: number of nodes, number of paths, node table, path table, sphere table
+   *
+   * Nodes are stored in pre-order and refer to their parent's position in the node table.  Spheres
+   * of all paths are stored consecutively.
+   */
+  const char         dlbMagic[4] = {'D', 'L', 'Y', 'B'};
+  const unsigned int dlbVersion = 1;
+
+  struct DlbNode
   {
-    os << v.x << " " << v.y << " " << v.z;
-    return os;
+    unsigned int parent;
+    float        center[3];
+    float        radius;
+  };
+
+  struct DlbPath
+  {
+    float        intersectionFirst[3];
+    float        intersectionLast[3];
+    unsigned int numSpheres;
+  };
+
+  struct DlbSphere
+  {
+    float center[3];
+    float radius;
+  };
+
+  static_assert (sizeof (unsigned int) == 4 && sizeof (float) == 4, "Unexpected type sizes");
+  static_assert (sizeof (glm::vec3) == 12, "Unexpected memory layout");
+  static_assert (sizeof (DlbNode) == 20, "Unexpected memory layout");
+  static_assert (sizeof (DlbPath) == 28, "Unexpected memory layout");
+  static_assert (sizeof (DlbSphere) == 16, "Unexpected memory layout");
+
+  bool isLittleEndian ()
+  {
+    const unsigned int value = 1;
+    char               firstByte;
+
+    std::memcpy (&firstByte, &value, 1);
+    return firstByte == 1;
   }
 
-  std::istream& operator>> (std::istream& is, glm::vec3& v)
+  void toFloats (const glm::vec3& v, float* fs)
   {
-    is >> v.x >> v.y >> v.z;
-    return is;
+    fs[0] = v.x;
+    fs[1] = v.y;
+    fs[2] = v.z;
   }
 
-  void toDlyFile (std::ostream& stream, const Mesh& mesh)
+  glm::vec3 fromFloats (const float* fs) { return glm::vec3 (fs[0], fs[1], fs[2]); }
+
+  template <typename T> void writeDlb (std::ostream& stream, const T* data, std::size_t n)
   {
-    stream << "o\n";
-    for (unsigned int i = 0; i < mesh.numVertices (); i++)
-    {
-      stream << "v " << mesh.vertex (i) << std::endl;
-    }
-    for (unsigned int i = 0; i < mesh.numIndices (); i += 3)
+    if (n > 0)
     {
-      stream << "f " << mesh.index (i + 0) + 1 << " " << mesh.index (i + 1) + 1 << " "
-             << mesh.index (i + 2) + 1 << std::endl;
+      stream.write (reinterpret_cast<const char*> (data), n * sizeof (T));
     }
   }
 
-  unsigned int toDlyFile (std::ostream& stream, const SketchNode& node, unsigned int parentIndex,
-                          unsigned nodeIndex)
+  void writeDlb (std::ostream& stream, unsigned int value) { writeDlb (stream, &value, 1); }
+
+  void toDlbFile (std::ostream& stream, const Mesh& mesh)
   {
-    stream << "dly_sketch_node " << nodeIndex << " " << parentIndex << " " << node.data ().center ()
-           << " " << node.data ().radius () << std::endl;
+    writeDlb (stream, mesh.numVertices ());
+    writeDlb (stream, mesh.numIndices ());
+    writeDlb (stream, mesh.vertexData (), mesh.numVertices ());
+    writeDlb (stream, mesh.normalData (), mesh.numVertices ());
+    writeDlb (stream, mesh.indexData (), mesh.numIndices ());
+  }
 
-    unsigned int childIndex = nodeIndex;
+  void toDlbNodes (std::vector<DlbNode>& nodes, const SketchNode& node, unsigned int parentIndex)
+  {
+    const unsigned int nodeIndex = nodes.size ();
 
-    node.forEachConstChild ([&stream, nodeIndex, &childIndex](const SketchNode& child) {
-      childIndex = toDlyFile (stream, child, nodeIndex, childIndex + 1);
-    });
-    return childIndex;
+    nodes.push_back (DlbNode ());
+    nodes.back ().parent = parentIndex;
+    nodes.back ().radius = node.data ().radius ();
+    toFloats (node.data ().center (), nodes.back ().center);
+
+    node.forEachConstChild (
+      [&nodes, nodeIndex](const SketchNode& child) { toDlbNodes (nodes, child, nodeIndex); });
   }
 
-  void toDlyFile (std::ostream& stream, const SketchPath& path)
+  void toDlbFile (std::ostream& stream, const SketchTree& tree, const SketchPaths& paths)
   {
-    if (path.isEmpty () == false)
+    std::vector<DlbNode>   nodes;
+    std::vector<DlbPath>   dlbPaths;
+    std::vector<DlbSphere> spheres;
+
+    if (tree.hasRoot ())
     {
-      stream << "dly_sketch_path"
-             << " " << path.intersectionFirst () << " " << path.intersectionLast () << std::endl;
+      toDlbNodes (nodes, tree.root (), Util::invalidIndex ());
+    }
 
-      for (const PrimSphere& s : path.spheres ())
+    for (const SketchPath& p : paths)
+    {
+      if (p.isEmpty () == false)
       {
-        stream << "dly_sketch_sphere"
-               << " " << s.center () << " " << s.radius () << std::endl;
+        dlbPaths.push_back (DlbPath ());
+        dlbPaths.back ().numSpheres = p.spheres ().size ();
+        toFloats (p.intersectionFirst (), dlbPaths.back ().intersectionFirst);
+        toFloats (p.intersectionLast (), dlbPaths.back ().intersectionLast);
+
+        for (const PrimSphere& s : p.spheres ())
+        {
+          spheres.push_back (DlbSphere ());
+          spheres.back ().radius = s.radius ();
+          toFloats (s.center (), spheres.back ().center);
+        }
       }
     }
+    writeDlb (stream, nodes.size ());
+    writeDlb (stream, dlbPaths.size ());
+    writeDlb (stream, nodes.data (), nodes.size ());
+    writeDlb (stream, dlbPaths.data (), dlbPaths.size ());
+    writeDlb (stream, spheres.data (), spheres.size ());
   }
 
-  void toDlyFile (std::ostream& stream, const SketchMesh& mesh)
+  void toDlbHeader (std::ostream& stream, unsigned int numMeshes, unsigned int numSketches)
   {
-    if (mesh.isEmpty () == false)
-    {
-      stream << "dly_sketch_mesh\n";
+    writeDlb (stream, dlbMagic, 4);
+    writeDlb (stream, dlbVersion);
+    writeDlb (stream, numMeshes);
+    writeDlb (stream, numSketches);
+  }
+
+  bool isEmptySketch (const SketchTree& tree, const SketchPaths& paths)
+  {
+    return tree.hasRoot () == false && paths.empty ();
+  }
 
-      if (mesh.tree ().hasRoot ())
+  bool addToScene (ImportExport::SceneData& data, const Config& config, Scene& scene)
+  {
+    data.meshes.erase (std::remove_if (data.meshes.begin (), data.meshes.end (),
+                                       [](Mesh& m) { return m.numVertices () == 0; }),
+                       data.meshes.end ());
+
+    if (std::all_of (data.meshes.begin (), data.meshes.end (),
+                     [](Mesh& m) { return MeshUtil::checkConsistency (m); }))
+    {
+      for (Mesh& m : data.meshes)
       {
-        toDlyFile (stream, mesh.tree ().root (), Util::invalidIndex (), 0);
+        scene.newDeferredDynamicMesh (config, m);
       }
+      for (const ImportExport::SketchData& s : data.sketches)
+      {
+        SketchMesh& sketch = scene.newSketchMesh (config, s.tree);
 
-      for (const SketchPath& p : mesh.paths ())
+        for (const SketchPath& p : s.paths)
+        {
+          sketch.addPath (p);
+        }
+      }
+      scene.materializeInBackground ();
+      return true;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  bool mapFile (const std::string& fileName, const std::function<bool(const char*, std::size_t)>& f)
+  {
+    QFile file (fileName.c_str ());
+
+    if (file.open (QIODevice::ReadOnly))
+    {
+      bool         success = false;
+      const qint64 size = file.size ();
+
+      if (size == 0)
       {
-        toDlyFile (stream, p);
+        success = f (nullptr, 0);
       }
+      else
+      {
+        uchar* bytes = file.map (0, size);
+
+        if (bytes)
+        {
+          success = f (reinterpret_cast<const char*> (bytes), std::size_t (size));
+          file.unmap (bytes);
+        }
+      }
+      file.close ();
+      return success;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  typedef std::function<bool(std::ostream&, const std::vector<const Mesh*>&)> MeshWriter;
+  typedef std::function<bool(const char*, std::size_t, Mesh&)>                MeshReader;
+
+  std::vector<const Mesh*> meshPointers (const ImportExport::SceneData& data)
+  {
+    std::vector<const Mesh*> meshes;
+    for (const Mesh& m : data.meshes)
+    {
+      meshes.push_back (&m);
+    }
+    return meshes;
+  }
+
+  bool writeFile (const std::string& fileName, std::ios::openmode mode,
+                  const std::function<bool(std::ostream&)>& write)
+  {
+    std::ofstream file (fileName, mode);
+
+    if (file.is_open ())
+    {
+      const bool success = write (file);
+      file.close ();
+      return success;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  // Meshes are written from pruned copies: pruning them in place would invalidate the changes
+  // recorded by the history
+  const Mesh& prunedMesh (const DynamicMesh& mesh, std::list<Mesh>& copies)
+  {
+    if (mesh.isPruned ())
+    {
+      return mesh.mesh ();
     }
+    else
+    {
+      copies.push_back (mesh.prunedMesh ());
+      return copies.back ();
+    }
+  }
+
+  bool toMeshFile (const std::string& fileName, Scene& scene, const MeshWriter& write)
+  {
+    std::vector<const Mesh*> meshes;
+    std::list<Mesh>          copies;
+    scene.forEachConstMesh ([&meshes, &copies](const DynamicMesh& mesh) {
+      meshes.push_back (&prunedMesh (mesh, copies));
+    });
+
+    return writeFile (fileName, std::ios::binary,
+                      [&meshes, &write](std::ostream& stream) { return write (stream, meshes); });
+  }
+
+  bool fromMeshData (const char* bytes, std::size_t size, ImportExport::SceneData& data,
+                     const MeshReader& read)
+  {
+    data.meshes.emplace_back ();
+    if (read (bytes, size, data.meshes.back ()))
+    {
+      return true;
+    }
+    else
+    {
+      data.meshes.pop_back ();
+      return false;
+    }
+  }
+
+  bool fromMeshFile (const std::string& fileName, ImportExport::SceneData& data,
+                     const MeshReader& read)
+  {
+    return mapFile (fileName, [&data, &read](const char* bytes, std::size_t size) {
+      return fromMeshData (bytes, size, data, read);
+    });
   }
 };
 
@@ -95,19 +310,50 @@ namespace ImportExport
 {
   void toDlyFile (std::ostream& stream, Scene& scene, bool isObjFile)
   {
-    scene.forEachMesh ([&stream](DynamicMesh& mesh) {
-      mesh.prune ();
-      ::toDlyFile (stream, mesh.mesh ());
+    scene.forEachConstMesh ([&stream](const DynamicMesh& mesh) {
+      std::list<Mesh> copies;
+      DlyWriter::write (stream, prunedMesh (mesh, copies));
     });
 
     if (isObjFile == false)
     {
-      scene.forEachConstMesh ([&stream](const SketchMesh& mesh) { ::toDlyFile (stream, mesh); });
+      scene.forEachConstMesh ([&stream](const SketchMesh& mesh) {
+        DlyWriter::write (stream, mesh.tree (), mesh.paths ());
+      });
+    }
+  }
+
+  void toDlyFile (std::ostream& stream, const SceneData& data, bool isObjFile)
+  {
+    for (const Mesh& m : data.meshes)
+    {
+      DlyWriter::write (stream, m);
+    }
+
+    if (isObjFile == false)
+    {
+      for (const SketchData& s : data.sketches)
+      {
+        DlyWriter::write (stream, s.tree, s.paths);
+      }
     }
   }
 
   bool toDlyFile (const std::string& fileName, Scene& scene, bool isObjFile)
   {
+    if (ImportExport::isDlbFile (fileName))
+    {
+      return ImportExport::toDlbFile (fileName, scene);
+    }
+    else if (ImportExport::isStlFile (fileName))
+    {
+      return toMeshFile (fileName, scene, MeshFormats::writeStl);
+    }
+    else if (ImportExport::isPlyFile (fileName))
+    {
+      return toMeshFile (fileName, scene, MeshFormats::writePly);
+    }
+
     std::ofstream file (fileName);
 
     if (file.is_open ())
@@ -122,244 +368,316 @@ namespace ImportExport
     }
   }
 
+  bool toDlyFile (const std::string& fileName, const SceneData& data, bool isObjFile)
+  {
+    if (ImportExport::isDlbFile (fileName))
+    {
+      return writeFile (fileName, std::ios::binary, [&data](std::ostream& stream) {
+        return ImportExport::toDlbFile (stream, data);
+      });
+    }
+    else if (ImportExport::isStlFile (fileName))
+    {
+      return writeFile (fileName, std::ios::binary, [&data](std::ostream& stream) {
+        return ImportExport::toStlFile (stream, data);
+      });
+    }
+    else if (ImportExport::isPlyFile (fileName))
+    {
+      return writeFile (fileName, std::ios::binary, [&data](std::ostream& stream) {
+        return ImportExport::toPlyFile (stream, data);
+      });
+    }
+    return writeFile (fileName, std::ios::out, [&data, isObjFile](std::ostream& stream) {
+      ImportExport::toDlyFile (stream, data, isObjFile);
+      return true;
+    });
+  }
+
+  bool fromDlyFile (std::istream& stream, SceneData& data)
+  {
+    const std::string buffer ((std::istreambuf_iterator<char> (stream)),
+                              std::istreambuf_iterator<char> ());
+    return DlyParser::parse (buffer.data (), buffer.size (), data);
+  }
+
   bool fromDlyFile (std::istream& stream, const Config& config, Scene& scene)
   {
-    unsigned int       lineNumber = 0;
-    std::istringstream lineStream;
+    SceneData data;
+    return ImportExport::fromDlyFile (stream, data) && addToScene (data, config, scene);
+  }
 
-    std::vector<Mesh>        meshes;
-    std::vector<SketchNode*> nodes;
-    SketchMesh*              sketch = nullptr;
-    SketchPath*              sketchPath = nullptr;
-    glm::vec3                intersectionFirst, intersectionLast;
+  bool fromDlyFile (const std::string& fileName, const Config& config, Scene& scene,
+                    const std::function<bool(float)>& progress)
+  {
+    SceneData data;
+    return ImportExport::fromDlyFile (fileName, data, progress) &&
+           addToScene (data, config, scene);
+  }
 
-    auto extractFirst = [](const std::string& string, unsigned int& value) -> bool {
-      auto slashPos = string.find ('/');
-      return Util::fromString (string.substr (0, slashPos), value);
-    };
+  bool fromDlyFile (const std::string& fileName, SceneData& data,
+                    const std::function<bool(float)>& progress)
+  {
+    if (ImportExport::isDlbFile (fileName))
+    {
+      return mapFile (fileName, [&data](const char* bytes, std::size_t size) {
+        return ImportExport::fromDlbData (bytes, size, data);
+      });
+    }
+    else if (ImportExport::isStlFile (fileName))
+    {
+      return fromMeshFile (fileName, data, MeshFormats::readStl);
+    }
+    else if (ImportExport::isPlyFile (fileName))
+    {
+      return fromMeshFile (fileName, data, MeshFormats::readPly);
+    }
+    return mapFile (fileName, [&data, &progress](const char* bytes, std::size_t size) {
+      return DlyParser::parse (bytes, size, data, progress);
+    });
+  }
 
-    auto nextLine = [&stream, &lineNumber, &lineStream]() -> bool {
-      std::string line;
-      std::getline (stream, line);
+  bool isDlbFile (const std::string& fileName) { return Util::hasSuffix (fileName, ".dlb"); }
 
-      if (stream)
+  bool toDlbFile (std::ostream& stream, Scene& scene)
+  {
+    if (isLittleEndian () == false)
+    {
+      DILAY_WARN ("binary scene files are not supported on big-endian hosts")
+      return false;
+    }
+    unsigned int numSketches = 0;
+    scene.forEachConstMesh ([&numSketches](const SketchMesh& mesh) {
+      numSketches += isEmptySketch (mesh.tree (), mesh.paths ()) ? 0 : 1;
+    });
+
+    toDlbHeader (stream, scene.numDynamicMeshes (), numSketches);
+
+    scene.forEachConstMesh ([&stream](const DynamicMesh& mesh) {
+      std::list<Mesh> copies;
+      ::toDlbFile (stream, prunedMesh (mesh, copies));
+    });
+    scene.forEachConstMesh ([&stream](const SketchMesh& mesh) {
+      if (isEmptySketch (mesh.tree (), mesh.paths ()) == false)
       {
-        lineNumber++;
-        lineStream.clear ();
-        lineStream.str (line);
-        return true;
+        ::toDlbFile (stream, mesh.tree (), mesh.paths ());
       }
-      else
+    });
+    return bool(stream);
+  }
+
+  bool toDlbFile (std::ostream& stream, const SceneData& data)
+  {
+    if (isLittleEndian () == false)
+    {
+      DILAY_WARN ("binary scene files are not supported on big-endian hosts")
+      return false;
+    }
+    const unsigned int numSketches = std::count_if (
+      data.sketches.begin (), data.sketches.end (),
+      [](const SketchData& s) { return isEmptySketch (s.tree, s.paths) == false; });
+
+    toDlbHeader (stream, data.meshes.size (), numSketches);
+
+    for (const Mesh& m : data.meshes)
+    {
+      ::toDlbFile (stream, m);
+    }
+    for (const SketchData& s : data.sketches)
+    {
+      if (isEmptySketch (s.tree, s.paths) == false)
       {
-        return false;
+        ::toDlbFile (stream, s.tree, s.paths);
+      }
+    }
+    return bool(stream);
+  }
+
+  bool toDlbFile (const std::string& fileName, Scene& scene)
+  {
+    std::ofstream file (fileName, std::ios::binary);
+
+    if (file.is_open ())
+    {
+      const bool success = ImportExport::toDlbFile (file, scene);
+      file.close ();
+      return success;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  bool fromDlbData (const char* bytes, std::size_t size, SceneData& data)
+  {
+    std::size_t offset = 0;
+
+    auto view = [bytes, size, &offset](std::size_t n) -> const char* {
+      if (size - offset < n)
+      {
+        return nullptr;
       }
+      const char* v = bytes + offset;
+      offset += n;
+      return v;
     };
 
-    while (nextLine ())
+    auto read = [&view](void* value, std::size_t n) -> bool {
+      const char* v = view (n);
+      if (v)
+      {
+        std::memcpy (value, v, n);
+        return true;
+      }
+      return false;
+    };
+
+    if (isLittleEndian () == false)
     {
-      std::string keyword;
-      lineStream >> keyword;
+      DILAY_WARN ("binary scene files are not supported on big-endian hosts")
+      return false;
+    }
 
-      if (lineStream.fail () == false)
+    char         magic[4];
+    unsigned int version, numMeshes, numSketches;
+
+    if (read (magic, 4) == false || std::memcmp (magic, dlbMagic, 4) != 0 ||
+        read (&version, 4) == false || read (&numMeshes, 4) == false ||
+        read (&numSketches, 4) == false)
+    {
+      DILAY_WARN ("invalid binary scene header")
+      return false;
+    }
+    if (version != dlbVersion)
+    {
+      DILAY_WARN ("unsupported binary scene version %u", version)
+      return false;
+    }
+
+    for (unsigned int i = 0; i < numMeshes; i++)
+    {
+      unsigned int numVertices, numIndices;
+
+      if (read (&numVertices, 4) == false || read (&numIndices, 4) == false)
       {
-        if (keyword == "o")
-        {
-          meshes.push_back (Mesh ());
-        }
-        else if (keyword == "v")
-        {
-          glm::vec3 vertex;
-          lineStream >> vertex;
+        DILAY_WARN ("could not read mesh %u", i)
+        return false;
+      }
+      const char* vertices = view (std::size_t (numVertices) * sizeof (glm::vec3));
+      const char* normals = view (std::size_t (numVertices) * sizeof (glm::vec3));
+      const char* indices = view (std::size_t (numIndices) * sizeof (unsigned int));
 
-          if (lineStream.fail ())
-          {
-            DILAY_WARN ("could not parse vertex at line %u", lineNumber)
-            return false;
-          }
-          else
-          {
-            if (meshes.empty ())
-            {
-              meshes.push_back (Mesh ());
-            }
-            meshes.back ().addVertex (vertex);
-          }
-        }
-        else if (keyword == "f")
-        {
-          std::string  v1String, v2String, v3String;
-          unsigned int v1, v2, v3;
+      if (vertices == nullptr || normals == nullptr || indices == nullptr || numIndices % 3 != 0)
+      {
+        DILAY_WARN ("could not read mesh %u", i)
+        return false;
+      }
+      const unsigned int* indicesBegin = reinterpret_cast<const unsigned int*> (indices);
+      const unsigned int* indicesEnd = indicesBegin + numIndices;
 
-          lineStream >> v1String >> v2String >> v3String;
+      if (std::any_of (indicesBegin, indicesEnd,
+                       [numVertices](unsigned int index) { return index >= numVertices; }))
+      {
+        DILAY_WARN ("invalid vertex index in mesh %u", i)
+        return false;
+      }
+      data.meshes.emplace_back ();
+      data.meshes.back ().addVertices (reinterpret_cast<const glm::vec3*> (vertices),
+                                       reinterpret_cast<const glm::vec3*> (normals), numVertices);
+      data.meshes.back ().addIndices (indicesBegin, numIndices);
+    }
 
-          if (lineStream.fail () || extractFirst (v1String, v1) == false ||
-              extractFirst (v2String, v2) == false || extractFirst (v3String, v3) == false)
-          {
-            DILAY_WARN ("could not parse face at line %u", lineNumber)
-            return false;
-          }
-          else
-          {
-            std::string  v4String;
-            unsigned int v4;
-            lineStream >> v4String;
-
-            if (lineStream.fail ())
-            {
-              lineStream.clear ();
-
-              if (meshes.empty ())
-              {
-                meshes.push_back (Mesh ());
-              }
-              MeshUtil::addFace (meshes.back (), v1 - 1, v2 - 1, v3 - 1);
-            }
-            else if (extractFirst (v4String, v4) == false)
-            {
-              DILAY_WARN ("could not parse face at line %u", lineNumber)
-              return false;
-            }
-            else
-            {
-              if (meshes.empty ())
-              {
-                meshes.push_back (Mesh ());
-              }
-              MeshUtil::addFace (meshes.back (), v1 - 1, v2 - 1, v3 - 1, v4 - 1);
-            }
-          }
-        }
-        else if (keyword == "dly_sketch_mesh")
-        {
-          nodes.clear ();
-          sketch = &scene.newSketchMesh (config, SketchTree ());
-        }
-        else if (keyword == "dly_sketch_node")
-        {
-          if (sketch == nullptr)
-          {
-            DILAY_WARN ("could not parse sketch node: no sketch found at line %u", lineNumber)
-            return false;
-          }
-          unsigned int nodeIndex;
-          unsigned int parentIndex;
-          glm::vec3    center;
-          float        radius;
+    for (unsigned int i = 0; i < numSketches; i++)
+    {
+      unsigned int numNodes, numPaths;
 
-          lineStream >> nodeIndex >> parentIndex >> center >> radius;
+      if (read (&numNodes, 4) == false || read (&numPaths, 4) == false)
+      {
+        DILAY_WARN ("could not read sketch %u", i)
+        return false;
+      }
+      // Counts are checked against the remaining size before anything is allocated
+      const char* nodeBytes = view (std::size_t (numNodes) * sizeof (DlbNode));
+      const char* pathBytes = view (std::size_t (numPaths) * sizeof (DlbPath));
 
-          if (lineStream.fail ())
-          {
-            DILAY_WARN ("could not parse sketch node at line %u", lineNumber)
-            return false;
-          }
+      if (nodeBytes == nullptr || pathBytes == nullptr)
+      {
+        DILAY_WARN ("could not read sketch %u", i)
+        return false;
+      }
+      std::vector<DlbNode>     dlbNodes (numNodes);
+      std::vector<DlbPath>     dlbPaths (numPaths);
+      std::vector<SketchNode*> nodes;
 
-          if (nodeIndex == nodes.size ())
-          {
-            if (nodeIndex == 0)
-            {
-              nodes.push_back (&sketch->tree ().emplaceRoot (PrimSphere (center, radius)));
-            }
-            else if (parentIndex < nodes.size ())
-            {
-              nodes.push_back (&nodes.at (parentIndex)->emplaceChild (PrimSphere (center, radius)));
-            }
-            else
-            {
-              DILAY_WARN ("invalid parent index at line %u", lineNumber)
-              return false;
-            }
-          }
-          else
-          {
-            DILAY_WARN ("invalid node index at line %u", lineNumber)
-            return false;
-          }
+      std::memcpy (dlbNodes.data (), nodeBytes, std::size_t (numNodes) * sizeof (DlbNode));
+      std::memcpy (dlbPaths.data (), pathBytes, std::size_t (numPaths) * sizeof (DlbPath));
+      data.sketches.emplace_back ();
+      SketchData& sketch = data.sketches.back ();
+
+      for (const DlbNode& n : dlbNodes)
+      {
+        const PrimSphere sphere (fromFloats (n.center), n.radius);
+
+        if (nodes.empty ())
+        {
+          nodes.push_back (&sketch.tree.emplaceRoot (sphere));
         }
-        else if (keyword == "dly_sketch_path")
+        else if (n.parent < nodes.size ())
         {
-          lineStream >> intersectionFirst >> intersectionLast;
-
-          if (lineStream.fail ())
-          {
-            DILAY_WARN ("could not parse sketch path at line %u", lineNumber)
-            return false;
-          }
-          if (sketch)
-          {
-            sketchPath = &sketch->addPath (SketchPath ());
-          }
-          else
-          {
-            DILAY_WARN ("could not parse sketch path: no sketch found at line %u", lineNumber)
-            return false;
-          }
+          nodes.push_back (&nodes.at (n.parent)->emplaceChild (sphere));
         }
-        else if (keyword == "dly_sketch_sphere")
+        else
         {
-          glm::vec3 center;
-          float     radius;
+          DILAY_WARN ("invalid parent index in sketch %u", i)
+          return false;
+        }
+      }
 
-          lineStream >> center >> radius;
+      for (const DlbPath& p : dlbPaths)
+      {
+        const glm::vec3 intersectionFirst = fromFloats (p.intersectionFirst);
+        const glm::vec3 intersectionLast = fromFloats (p.intersectionLast);
 
-          if (lineStream.fail ())
-          {
-            DILAY_WARN ("could not parse sketch sphere at line %u", lineNumber)
-            return false;
-          }
+        sketch.paths.emplace_back ();
 
-          if (sketchPath)
-          {
-            if (sketchPath->isEmpty ())
-            {
-              sketchPath->addSphere (intersectionFirst, center, radius);
-            }
-            else
-            {
-              sketchPath->addSphere (intersectionLast, center, radius);
-            }
-          }
-          else
+        for (unsigned int j = 0; j < p.numSpheres; j++)
+        {
+          DlbSphere s;
+          if (read (&s, sizeof (DlbSphere)) == false)
           {
-            DILAY_WARN ("could not parse sketch sphere: no sketch path found at line %u",
-                        lineNumber)
+            DILAY_WARN ("could not read sketch %u", i)
             return false;
           }
+          sketch.paths.back ().addSphere (j == 0 ? intersectionFirst : intersectionLast,
+                                          fromFloats (s.center), s.radius);
         }
       }
     }
-    meshes.erase (std::remove_if (meshes.begin (), meshes.end (),
-                                  [](Mesh& m) { return m.numVertices () == 0; }),
-                  meshes.end ());
+    return true;
+  }
 
-    if (std::all_of (meshes.begin (), meshes.end (),
-                     [](Mesh& m) { return MeshUtil::checkConsistency (m); }))
-    {
-      for (Mesh& m : meshes)
-      {
-        scene.newDynamicMesh (config, m);
-      }
-      return true;
-    }
-    else
-    {
-      return false;
-    }
+  bool isStlFile (const std::string& fileName) { return Util::hasSuffix (fileName, ".stl"); }
+
+  bool isPlyFile (const std::string& fileName) { return Util::hasSuffix (fileName, ".ply"); }
+
+  bool toStlFile (std::ostream& stream, const SceneData& data)
+  {
+    return MeshFormats::writeStl (stream, meshPointers (data));
   }
 
-  bool fromDlyFile (const std::string& fileName, const Config& config, Scene& scene)
+  bool toPlyFile (std::ostream& stream, const SceneData& data)
   {
-    std::ifstream file (fileName);
+    return MeshFormats::writePly (stream, meshPointers (data));
+  }
 
-    if (file.is_open ())
-    {
-      const bool success = ImportExport::fromDlyFile (file, config, scene);
-      file.close ();
-      return success;
-    }
-    else
-    {
-      return false;
-    }
+  bool fromStlData (const char* bytes, std::size_t size, SceneData& data)
+  {
+    return fromMeshData (bytes, size, data, MeshFormats::readStl);
+  }
+
+  bool fromPlyData (const char* bytes, std::size_t size, SceneData& data)
+  {
+    return fromMeshData (bytes, size, data, MeshFormats::readPly);
   }
 };
@@ -5,18 +5,58 @@
 #ifndef DILAY_IMPORT_EXPORT
 #define DILAY_IMPORT_EXPORT
 
+#include <cstddef>
+#include <functional>
 #include <iosfwd>
 #include <string>
+#include <vector>
+#include "mesh.hpp"
+#include "sketch/fwd.hpp"
+#include "sketch/path.hpp"
 
 class Config;
 class Scene;
 
 namespace ImportExport
 {
+  struct SketchData
+  {
+    SketchTree  tree;
+    SketchPaths paths;
+  };
+
+  // Scene contents independent of any rendering context
+  struct SceneData
+  {
+    std::vector<Mesh>       meshes;
+    std::vector<SketchData> sketches;
+  };
+
   void toDlyFile (std::ostream&, Scene&, bool);
+  void toDlyFile (std::ostream&, const SceneData&, bool);
   bool toDlyFile (const std::string&, Scene&, bool);
+  bool toDlyFile (const std::string&, const SceneData&, bool);
+  bool fromDlyFile (std::istream&, SceneData&);
   bool fromDlyFile (std::istream&, const Config&, Scene&);
-  bool fromDlyFile (const std::string&, const Config&, Scene&);
+  bool fromDlyFile (const std::string&, const Config&, Scene&,
+                    const std::function<bool(float)>& = nullptr);
+  bool fromDlyFile (const std::string&, SceneData&, const std::function<bool(float)>& = nullptr);
+
+  // Binary scene container (*.dlb), see `import-export.cpp` for its layout
+  bool isDlbFile (const std::string&);
+  bool toDlbFile (std::ostream&, Scene&);
+  bool toDlbFile (std::ostream&, const SceneData&);
+  bool toDlbFile (const std::string&, Scene&);
+  bool fromDlbData (const char*, std::size_t, SceneData&);
+
+  // Binary STL and binary little-endian PLY files contain a single mesh without sketches, see
+  // `mesh-formats.hpp`
+  bool isStlFile (const std::string&);
+  bool isPlyFile (const std::string&);
+  bool toStlFile (std::ostream&, const SceneData&);
+  bool toPlyFile (std::ostream&, const SceneData&);
+  bool fromStlData (const char*, std::size_t, SceneData&);
+  bool fromPlyData (const char*, std::size_t, SceneData&);
 };
 
 #endif
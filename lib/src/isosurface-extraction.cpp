@@ -11,20 +11,25 @@
 #include "intersection.hpp"
 #include "isosurface-extraction.hpp"
 #include "isosurface-extraction/grid.hpp"
+#include "isosurface-extraction/octree.hpp"
 #include "mesh.hpp"
+#include "primitive/aabox.hpp"
 #include "primitive/ray.hpp"
 #include "util.hpp"
 
 namespace
 {
-  typedef IsosurfaceExtraction::DistanceCallback     DistanceCallback;
-  typedef IsosurfaceExtraction::IntersectionCallback IntersectionCallback;
+  typedef IsosurfaceExtraction::DistanceCallback      DistanceCallback;
+  typedef IsosurfaceExtraction::IntersectionCallback  IntersectionCallback;
+  typedef IsosurfaceExtraction::BrickDistanceCallback BrickDistanceCallback;
 
   static const float markInside = -0.5f;
   static const float markOutside = 0.5f;
   static const float markInsideToSample = -0.6f;
   static const float markOutsideToSample = 0.6f;
 
+  static const unsigned int brickSize = 8;
+
   struct Parameters
   {
     const DistanceCallback&     getDistance;
@@ -102,6 +107,70 @@ namespace
     }
   }
 
+  void sampleBricksThread (IsosurfaceExtractionGrid& grid, const BrickDistanceCallback& getDistance,
+                           unsigned int numThreads, unsigned int threadId)
+  {
+    std::vector<float>& samples = grid.samples ();
+    const glm::uvec3    numBricks = (grid.numSamples () + glm::uvec3 (brickSize - 1)) / brickSize;
+    unsigned int        brick = 0;
+
+    for (unsigned int bz = 0; bz < numBricks.z; bz++)
+    {
+      for (unsigned int by = 0; by < numBricks.y; by++)
+      {
+        for (unsigned int bx = 0; bx < numBricks.x; bx++, brick++)
+        {
+          if (brick % numThreads != threadId)
+          {
+            continue;
+          }
+          const glm::uvec3 from = brickSize * glm::uvec3 (bx, by, bz);
+          const glm::uvec3 to = glm::min (from + glm::uvec3 (brickSize), grid.numSamples ());
+
+          const DistanceCallback getBrickDistance = getDistance (
+            PrimAABox (grid.samplePos (from.x, from.y, from.z),
+                       grid.samplePos (to.x - 1, to.y - 1, to.z - 1)));
+
+          for (unsigned int z = from.z; z < to.z; z++)
+          {
+            for (unsigned int y = from.y; y < to.y; y++)
+            {
+              for (unsigned int x = from.x; x < to.x; x++)
+              {
+                const unsigned int index = grid.sampleIndex (x, y, z);
+
+                assert (samples[index] == Util::maxFloat ());
+                samples[index] = getBrickDistance (grid.samplePos (x, y, z));
+
+                assert (Util::isNaN (samples[index]) == false);
+                assert (samples[index] != Util::maxFloat ());
+                assert ((x > 0 && x < grid.numSamples ().x - 1) || samples[index] > 0.0f);
+                assert ((y > 0 && y < grid.numSamples ().y - 1) || samples[index] > 0.0f);
+                assert ((z > 0 && z < grid.numSamples ().z - 1) || samples[index] > 0.0f);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  void sampleBricks (IsosurfaceExtractionGrid& grid, const BrickDistanceCallback& getDistance)
+  {
+    const unsigned int       numThreads = std::thread::hardware_concurrency ();
+    std::vector<std::thread> threads;
+
+    for (unsigned int i = 0; i < numThreads; i++)
+    {
+      threads.emplace_back (sampleBricksThread, std::ref (grid), std::cref (getDistance),
+                            numThreads, i);
+    }
+    for (unsigned int i = 0; i < numThreads; i++)
+    {
+      threads.at (i).join ();
+    }
+  }
+
   void sampleIntersectionsThread (Parameters& params, unsigned int numThreads,
                                   unsigned int threadId)
   {
@@ -264,3 +333,34 @@ void IsosurfaceExtraction::extract (const DistanceCallback&     getDistance,
     grid.makeMesh (mesh);
   }
 }
+
+void IsosurfaceExtraction::extract (const BrickDistanceCallback& getDistance,
+                                    const PrimAABox& bounds, float resolution, DynamicMesh& mesh)
+{
+  IsosurfaceExtractionGrid grid (bounds, resolution);
+
+  if (grid.numSamples ().x > 0 && grid.numSamples ().y > 0 && grid.numSamples ().z > 0)
+  {
+    sampleBricks (grid, getDistance);
+    grid.makeMesh (mesh);
+  }
+}
+
+void IsosurfaceExtraction::extractAdaptive (const DistanceCallback&   getDistance,
+                                            const ResolutionCallback& getResolution,
+                                            const PrimAABox& bounds, float resolution,
+                                            DynamicMesh& mesh)
+{
+  IsosurfaceExtractionOctree octree (bounds, resolution);
+
+  octree.build (getDistance, getResolution);
+  octree.makeMesh (mesh);
+
+  // The uniform fallback samples at the requested resolution, not at the octree's finest one
+  if (mesh.isEmpty () == false && mesh.pruneAndCheckConsistency () == false)
+  {
+    DILAY_WARN ("adaptive extraction is not manifold: falling back to uniform resolution %f",
+                resolution)
+    IsosurfaceExtraction::extract (getDistance, bounds, resolution, mesh);
+  }
+}
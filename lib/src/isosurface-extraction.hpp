@@ -25,9 +25,21 @@ namespace IsosurfaceExtraction
   typedef std::function<float(const glm::vec3&)>                        DistanceCallback;
   typedef std::function<Intersection (const PrimRay&, ::Intersection&)> IntersectionCallback;
 
+  // Returns the distance callback of all samples within a brick of the sampling grid
+  typedef std::function<DistanceCallback (const PrimAABox&)> BrickDistanceCallback;
+
+  // Returns the maximal width of cells around a position
+  typedef std::function<float(const glm::vec3&)> ResolutionCallback;
+
   void extract (const DistanceCallback&, const IntersectionCallback&, const PrimAABox&, float,
                 DynamicMesh&);
   void extract (const DistanceCallback&, const PrimAABox&, float, DynamicMesh&);
+  void extract (const BrickDistanceCallback&, const PrimAABox&, float, DynamicMesh&);
+
+  // Samples adaptively down to the given minimal resolution. Falls back to a uniform grid of this
+  // resolution if the extracted mesh is not manifold.
+  void extractAdaptive (const DistanceCallback&, const ResolutionCallback&, const PrimAABox&,
+                        float, DynamicMesh&);
 };
 
 #endif
@@ -0,0 +1,763 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <glm/gtx/norm.hpp>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "dynamic/mesh.hpp"
+#include "isosurface-extraction/grid.hpp"
+#include "isosurface-extraction/octree.hpp"
+#include "primitive/aabox.hpp"
+#include "util.hpp"
+
+/* Cells are addressed on a lattice of half the resolution: cells of the resolution's width are
+ * only split further to resolve ambiguous or non-manifold topology. Children and the four cells
+ * around an edge are indexed by their side along each axis:
+ *
+ *  child index:  x | (y << 1) | (z << 2)
+ *  edge along e: side along (e + 1) % 3 | (side along (e + 2) % 3 << 1)
+ */
+namespace
+{
+  typedef IsosurfaceExtraction::DistanceCallback   DistanceCallback;
+  typedef IsosurfaceExtraction::ResolutionCallback ResolutionCallback;
+  typedef std::array<unsigned int, 2>              FaceCells;
+  typedef std::array<unsigned int, 4>              EdgeCells;
+
+  // Vertices are identified by their leaf and by their surface patch within this leaf
+  typedef std::array<unsigned int, 4> Polygon;
+
+  static const unsigned int maxPatches = 4;
+
+  // 21 bits per lattice coordinate
+  static const unsigned int maxDepth = 20;
+
+  struct Cell
+  {
+    glm::uvec3   min;
+    unsigned int size;
+    unsigned int firstChild;
+
+    Cell (const glm::uvec3& m, unsigned int s)
+      : min (m)
+      , size (s)
+      , firstChild (Util::invalidIndex ())
+    {
+    }
+
+    bool isLeaf () const { return this->firstChild == Util::invalidIndex (); }
+  };
+
+  struct Vertex
+  {
+    glm::vec3    sum;
+    unsigned int numCrossings;
+    unsigned int indexInMesh;
+
+    Vertex ()
+      : sum (0.0f)
+      , numCrossings (0)
+      , indexInMesh (Util::invalidIndex ())
+    {
+    }
+  };
+
+  unsigned int vertexId (unsigned int cell, unsigned int patch)
+  {
+    assert (patch < maxPatches);
+    return (cell * maxPatches) + patch;
+  }
+
+  uint64_t edgeKey (unsigned int v1, unsigned int v2)
+  {
+    return (uint64_t (glm::min (v1, v2)) << 32) | uint64_t (glm::max (v1, v2));
+  }
+
+  unsigned int cornerIndex (const glm::uvec3& bits)
+  {
+    return bits.x | (bits.y << 1) | (bits.z << 2);
+  }
+
+  glm::uvec3 childBits (unsigned int child)
+  {
+    assert (child < 8);
+    return glm::uvec3 (child & 1, (child >> 1) & 1, (child >> 2) & 1);
+  }
+
+  uint64_t sampleKey (const glm::uvec3& p)
+  {
+    return uint64_t (p.x) | (uint64_t (p.y) << 21) | (uint64_t (p.z) << 42);
+  }
+
+  bool isIntersecting (float s1, float s2)
+  {
+    return (s1 < 0.0f && s2 >= 0.0f) || (s1 >= 0.0f && s2 < 0.0f);
+  }
+
+  void parallel (unsigned int n, const std::function<void(unsigned int)>& f)
+  {
+    const unsigned int       numThreads = glm::max (1u, std::thread::hardware_concurrency ());
+    std::vector<std::thread> threads;
+
+    for (unsigned int t = 0; t < numThreads; t++)
+    {
+      threads.emplace_back ([&f, n, numThreads, t]() {
+        for (unsigned int i = t; i < n; i += numThreads)
+        {
+          f (i);
+        }
+      });
+    }
+    for (unsigned int t = 0; t < numThreads; t++)
+    {
+      threads.at (t).join ();
+    }
+  }
+}
+
+struct IsosurfaceExtractionOctree::Impl
+{
+  float                                    resolution;
+  float                                    unitWidth;
+  glm::vec3                                origin;
+  std::vector<Cell>                        cells;
+  std::unordered_map<uint64_t, float>      samples;
+  std::unordered_map<unsigned int, Vertex> vertices;
+  std::vector<Polygon>                     polygons;
+
+  Impl (const PrimAABox& bounds, float r)
+  {
+    const glm::vec3 min = bounds.minimum () - glm::vec3 (Util::epsilon () + r);
+    const glm::vec3 max = bounds.maximum () + glm::vec3 (Util::epsilon () + r);
+    const glm::vec3 extent = max - min;
+    const float     maxExtent = glm::max (extent.x, glm::max (extent.y, extent.z));
+
+    unsigned int size = 2;
+    while (float(size) * 0.5f * r < maxExtent && size < (1u << maxDepth))
+    {
+      size *= 2;
+    }
+    this->unitWidth = glm::max (0.5f * r, maxExtent / float(size));
+    this->resolution = 2.0f * this->unitWidth;
+    this->origin = min;
+    this->cells.emplace_back (glm::uvec3 (0), size);
+  }
+
+  unsigned int numLeaves () const
+  {
+    unsigned int n = 0;
+    for (const Cell& c : this->cells)
+    {
+      if (c.isLeaf ())
+      {
+        n++;
+      }
+    }
+    return n;
+  }
+
+  glm::vec3 samplePos (const glm::uvec3& p) const
+  {
+    return this->origin + (glm::vec3 (p) * this->unitWidth);
+  }
+
+  float sample (const glm::uvec3& p) const { return this->samples.at (sampleKey (p)); }
+
+  glm::uvec3 corner (const Cell& cell, unsigned int c) const
+  {
+    return cell.min + (cell.size * childBits (c));
+  }
+
+  unsigned int child (unsigned int cell, const glm::uvec3& bits) const
+  {
+    const Cell& c = this->cells[cell];
+    return c.isLeaf () ? cell : c.firstChild + cornerIndex (bits);
+  }
+
+  void split (unsigned int cell, std::vector<unsigned int>& children)
+  {
+    this->split (cell);
+    for (unsigned int c = 0; c < 8; c++)
+    {
+      children.push_back (this->cells[cell].firstChild + c);
+    }
+  }
+
+  void split (unsigned int cell)
+  {
+    assert (this->cells[cell].isLeaf ());
+    assert (this->cells[cell].size > 1);
+
+    const glm::uvec3   min = this->cells[cell].min;
+    const unsigned int size = this->cells[cell].size / 2;
+
+    this->cells[cell].firstChild = this->cells.size ();
+    for (unsigned int c = 0; c < 8; c++)
+    {
+      this->cells.emplace_back (min + (size * childBits (c)), size);
+    }
+  }
+
+  // Subdivides cells that might intersect the surface until they are fine enough, level by level.
+  // Returns all new leaves.
+  std::vector<unsigned int> subdivide (std::vector<unsigned int> level,
+                                       const DistanceCallback&   getDistance,
+                                       const ResolutionCallback& getResolution)
+  {
+    std::vector<unsigned int> leaves;
+
+    while (level.empty () == false)
+    {
+      std::vector<unsigned char> toSplit (level.size (), 0);
+
+      parallel (level.size (), [this, &level, &toSplit, &getDistance,
+                                &getResolution](unsigned int i) {
+        const Cell& cell = this->cells[level[i]];
+
+        if (cell.size > 2)
+        {
+          const float     width = float(cell.size) * this->unitWidth;
+          const glm::vec3 center = this->samplePos (cell.min) + glm::vec3 (0.5f * width);
+          const float     halfDiagonal = 0.5f * glm::sqrt (3.0f) * width;
+
+          toSplit[i] =
+            glm::abs (getDistance (center)) <= halfDiagonal && width > getResolution (center);
+        }
+      });
+
+      std::vector<unsigned int> next;
+      for (unsigned int i = 0; i < level.size (); i++)
+      {
+        if (toSplit[i])
+        {
+          this->split (level[i], next);
+        }
+        else
+        {
+          leaves.push_back (level[i]);
+        }
+      }
+      level = std::move (next);
+    }
+    return leaves;
+  }
+
+  void sampleCorners (const std::vector<unsigned int>& leaves, const DistanceCallback& getDistance)
+  {
+    std::vector<glm::uvec3> corners;
+
+    for (unsigned int l : leaves)
+    {
+      for (unsigned int c = 0; c < 8; c++)
+      {
+        const glm::uvec3 p = this->corner (this->cells[l], c);
+
+        if (this->samples.emplace (sampleKey (p), Util::maxFloat ()).second)
+        {
+          corners.push_back (p);
+        }
+      }
+    }
+
+    std::vector<float> distances (corners.size ());
+    parallel (corners.size (), [this, &corners, &distances, &getDistance](unsigned int i) {
+      distances[i] = getDistance (this->samplePos (corners[i]));
+      assert (Util::isNaN (distances[i]) == false);
+    });
+
+    for (unsigned int i = 0; i < corners.size (); i++)
+    {
+      this->samples[sampleKey (corners[i])] = distances[i];
+    }
+  }
+
+  // A leaf is ambiguous if its inside corners or its outside corners are not connected by its
+  // edges, i.e., if a single vertex can not represent the surface within the leaf
+  bool isAmbiguous (const Cell& cell) const
+  {
+    bool         inside[8];
+    unsigned int component[8];
+
+    for (unsigned int c = 0; c < 8; c++)
+    {
+      inside[c] = this->sample (this->corner (cell, c)) < 0.0f;
+      component[c] = c;
+    }
+
+    for (bool changed = true; changed;)
+    {
+      changed = false;
+      for (unsigned int edge = 0; edge < 12; edge++)
+      {
+        const unsigned char v1 = IsosurfaceExtractionGrid::vertexIndicesByEdge[edge][0];
+        const unsigned char v2 = IsosurfaceExtractionGrid::vertexIndicesByEdge[edge][1];
+
+        if (inside[v1] == inside[v2] && component[v1] != component[v2])
+        {
+          component[v1] = component[v2] = glm::min (component[v1], component[v2]);
+          changed = true;
+        }
+      }
+    }
+
+    unsigned int numComponents = 0;
+    for (unsigned int c = 0; c < 8; c++)
+    {
+      if (component[c] == c)
+      {
+        numComponents++;
+      }
+    }
+    return numComponents > 2;
+  }
+
+  void build (const DistanceCallback& getDistance, const ResolutionCallback& getResolution)
+  {
+    std::vector<unsigned int> level (1, 0);
+
+    while (level.empty () == false)
+    {
+      const std::vector<unsigned int> leaves = this->subdivide (level, getDistance, getResolution);
+      this->sampleCorners (leaves, getDistance);
+
+      level.clear ();
+      for (unsigned int l : leaves)
+      {
+        if (this->cells[l].size > 1 && this->isAmbiguous (this->cells[l]))
+        {
+          this->split (l, level);
+        }
+      }
+      if (level.empty ())
+      {
+        this->splitNonManifoldLeaves (level);
+      }
+    }
+  }
+
+  std::unordered_map<uint64_t, unsigned int> numAdjacentPolygons () const
+  {
+    std::unordered_map<uint64_t, unsigned int> numAdjacentPolygons;
+
+    for (const Polygon& polygon : this->polygons)
+    {
+      for (unsigned int i = 0; i < 4; i++)
+      {
+        const unsigned int v1 = polygon[i];
+        const unsigned int v2 = polygon[(i + 1) % 4];
+
+        if (v1 != v2)
+        {
+          numAdjacentPolygons[edgeKey (v1, v2)]++;
+        }
+      }
+    }
+    return numAdjacentPolygons;
+  }
+
+  // Splits leaves whose vertex would be shared by more than two polygons along an edge
+  void splitNonManifoldLeaves (std::vector<unsigned int>& newCells)
+  {
+    this->contour ();
+
+    for (const auto& pair : this->numAdjacentPolygons ())
+    {
+      if (pair.second != 2)
+      {
+        const unsigned int c1 = (unsigned int) (pair.first >> 32) / maxPatches;
+        const unsigned int c2 = (unsigned int) (pair.first & 0xffffffff) / maxPatches;
+
+        for (unsigned int c : {c1, c2})
+        {
+          if (this->cells[c].isLeaf () && this->cells[c].size > 1)
+          {
+            this->split (c, newCells);
+          }
+        }
+      }
+    }
+  }
+
+  // Inside corners are connected by edges. Outside corners are connected by edges and across faces
+  // whose inside corners are diagonal, which is consistent between neighboring leaves. Each pair
+  // of adjacent inside and outside components is separated by its own patch.
+  unsigned int patch (const Cell& cell, unsigned int corner1, unsigned int corner2) const
+  {
+    bool         inside[8];
+    unsigned int component[8];
+
+    for (unsigned int c = 0; c < 8; c++)
+    {
+      inside[c] = this->sample (this->corner (cell, c)) < 0.0f;
+      component[c] = c;
+    }
+
+    const auto join = [&component](unsigned int c1, unsigned int c2) {
+      if (component[c1] != component[c2])
+      {
+        const unsigned int from = glm::max (component[c1], component[c2]);
+        const unsigned int to = glm::min (component[c1], component[c2]);
+
+        for (unsigned int c = 0; c < 8; c++)
+        {
+          if (component[c] == from)
+          {
+            component[c] = to;
+          }
+        }
+      }
+    };
+
+    for (unsigned int edge = 0; edge < 12; edge++)
+    {
+      const unsigned char v1 = IsosurfaceExtractionGrid::vertexIndicesByEdge[edge][0];
+      const unsigned char v2 = IsosurfaceExtractionGrid::vertexIndicesByEdge[edge][1];
+
+      if (inside[v1] == inside[v2])
+      {
+        join (v1, v2);
+      }
+    }
+    for (unsigned int a = 0; a < 3; a++)
+    {
+      for (unsigned int side = 0; side < 2; side++)
+      {
+        glm::uvec3 bits;
+        bits[a] = side;
+
+        bits[(a + 1) % 3] = 0;
+        bits[(a + 2) % 3] = 0;
+        const unsigned int c00 = cornerIndex (bits);
+        bits[(a + 1) % 3] = 1;
+        const unsigned int c10 = cornerIndex (bits);
+        bits[(a + 2) % 3] = 1;
+        const unsigned int c11 = cornerIndex (bits);
+        bits[(a + 1) % 3] = 0;
+        const unsigned int c01 = cornerIndex (bits);
+
+        if (inside[c00] && inside[c11] && inside[c01] == false && inside[c10] == false)
+        {
+          join (c01, c10);
+        }
+        else if (inside[c01] && inside[c10] && inside[c00] == false && inside[c11] == false)
+        {
+          join (c00, c11);
+        }
+      }
+    }
+
+    const auto key = [&inside, &component](unsigned int c1, unsigned int c2) {
+      return inside[c1] ? (component[c1] * 8) + component[c2] : (component[c2] * 8) + component[c1];
+    };
+
+    unsigned int keys[12];
+    unsigned int numKeys = 0;
+    for (unsigned int edge = 0; edge < 12; edge++)
+    {
+      const unsigned char v1 = IsosurfaceExtractionGrid::vertexIndicesByEdge[edge][0];
+      const unsigned char v2 = IsosurfaceExtractionGrid::vertexIndicesByEdge[edge][1];
+
+      if (inside[v1] != inside[v2])
+      {
+        const unsigned int k = key (v1, v2);
+
+        if (std::find (keys, keys + numKeys, k) == keys + numKeys)
+        {
+          keys[numKeys++] = k;
+        }
+      }
+    }
+    const unsigned int patch = std::find (keys, keys + numKeys, key (corner1, corner2)) - keys;
+
+    assert (patch < numKeys);
+    assert (patch < maxPatches);
+    return patch;
+  }
+
+  void contourEdge (const EdgeCells& cells, unsigned int e)
+  {
+    const unsigned int e1 = (e + 1) % 3;
+    const unsigned int e2 = (e + 2) % 3;
+
+    unsigned int k = 0;
+    for (unsigned int i = 1; i < 4; i++)
+    {
+      if (this->cells[cells[i]].size < this->cells[cells[k]].size)
+      {
+        k = i;
+      }
+    }
+
+    const Cell& minCell = this->cells[cells[k]];
+    glm::uvec3  bits (0);
+    bits[e1] = 1 - (k & 1);
+    bits[e2] = 1 - ((k >> 1) & 1);
+
+    const glm::uvec3 p1 = minCell.min + (minCell.size * bits);
+    glm::uvec3       p2 = p1;
+    p2[e] += minCell.size;
+
+    const float s1 = this->sample (p1);
+    const float s2 = this->sample (p2);
+
+    if (isIntersecting (s1, s2))
+    {
+      const glm::vec3 pos1 = this->samplePos (p1);
+      const glm::vec3 pos2 = this->samplePos (p2);
+      const glm::vec3 crossing = pos1 + ((pos2 - pos1) * (s1 / (s1 - s2)));
+
+      // The minimal edge is an edge of all leaves of minimal size and lies inside a face or an
+      // edge of larger leaves, which are not ambiguous and thus have a single patch
+      Polygon ids;
+      for (unsigned int i = 0; i < 4; i++)
+      {
+        const Cell& cell = this->cells[cells[i]];
+
+        if (cell.size == minCell.size)
+        {
+          glm::uvec3 corner1 (0);
+          corner1[e1] = 1 - (i & 1);
+          corner1[e2] = 1 - ((i >> 1) & 1);
+          glm::uvec3 corner2 = corner1;
+          corner2[e] = 1;
+
+          ids[i] = vertexId (cells[i], this->patch (cell, cornerIndex (corner1),
+                                                    cornerIndex (corner2)));
+        }
+        else
+        {
+          ids[i] = vertexId (cells[i], 0);
+        }
+
+        if ((i < 1 || ids[i] != ids[0]) && (i < 2 || ids[i] != ids[1]) &&
+            (i < 3 || ids[i] != ids[2]))
+        {
+          Vertex& vertex = this->vertices[ids[i]];
+          vertex.sum += crossing;
+          vertex.numCrossings++;
+        }
+      }
+
+      if (s1 < 0.0f)
+      {
+        this->polygons.push_back ({{ids[3], ids[2], ids[0], ids[1]}});
+      }
+      else
+      {
+        this->polygons.push_back ({{ids[3], ids[1], ids[0], ids[2]}});
+      }
+    }
+  }
+
+  void contourEdgeCells (const EdgeCells& cells, unsigned int e)
+  {
+    const unsigned int e1 = (e + 1) % 3;
+    const unsigned int e2 = (e + 2) % 3;
+
+    if (this->cells[cells[0]].isLeaf () && this->cells[cells[1]].isLeaf () &&
+        this->cells[cells[2]].isLeaf () && this->cells[cells[3]].isLeaf ())
+    {
+      this->contourEdge (cells, e);
+    }
+    else
+    {
+      for (unsigned int h = 0; h < 2; h++)
+      {
+        EdgeCells subCells;
+        for (unsigned int k = 0; k < 4; k++)
+        {
+          glm::uvec3 bits;
+          bits[e] = h;
+          bits[e1] = 1 - (k & 1);
+          bits[e2] = 1 - ((k >> 1) & 1);
+          subCells[k] = this->child (cells[k], bits);
+        }
+        this->contourEdgeCells (subCells, e);
+      }
+    }
+  }
+
+  void contourFaceCells (const FaceCells& cells, unsigned int a)
+  {
+    if (this->cells[cells[0]].isLeaf () && this->cells[cells[1]].isLeaf ())
+    {
+      return;
+    }
+    const unsigned int u = (a + 1) % 3;
+    const unsigned int v = (a + 2) % 3;
+
+    for (unsigned int c = 0; c < 4; c++)
+    {
+      glm::uvec3 bits;
+      bits[u] = c & 1;
+      bits[v] = (c >> 1) & 1;
+
+      bits[a] = 1;
+      const unsigned int c0 = this->child (cells[0], bits);
+      bits[a] = 0;
+      const unsigned int c1 = this->child (cells[1], bits);
+
+      this->contourFaceCells ({{c0, c1}}, a);
+    }
+
+    for (unsigned int e : {u, v})
+    {
+      const unsigned int w = e == u ? v : u;
+      const bool         aFirst = (e + 1) % 3 == a;
+
+      for (unsigned int h = 0; h < 2; h++)
+      {
+        EdgeCells subCells;
+        for (unsigned int k = 0; k < 4; k++)
+        {
+          const unsigned int sideA = aFirst ? (k & 1) : ((k >> 1) & 1);
+          const unsigned int sideW = aFirst ? ((k >> 1) & 1) : (k & 1);
+
+          glm::uvec3 bits;
+          bits[e] = h;
+          bits[a] = 1 - sideA;
+          bits[w] = sideW;
+          subCells[k] = this->child (cells[sideA], bits);
+        }
+        this->contourEdgeCells (subCells, e);
+      }
+    }
+  }
+
+  void contourCell (unsigned int cell)
+  {
+    if (this->cells[cell].isLeaf ())
+    {
+      return;
+    }
+    for (unsigned int c = 0; c < 8; c++)
+    {
+      this->contourCell (this->cells[cell].firstChild + c);
+    }
+
+    for (unsigned int a = 0; a < 3; a++)
+    {
+      for (unsigned int c = 0; c < 4; c++)
+      {
+        glm::uvec3 bits;
+        bits[(a + 1) % 3] = c & 1;
+        bits[(a + 2) % 3] = (c >> 1) & 1;
+
+        bits[a] = 0;
+        const unsigned int c0 = this->child (cell, bits);
+        bits[a] = 1;
+        const unsigned int c1 = this->child (cell, bits);
+
+        this->contourFaceCells ({{c0, c1}}, a);
+      }
+    }
+
+    for (unsigned int e = 0; e < 3; e++)
+    {
+      for (unsigned int h = 0; h < 2; h++)
+      {
+        EdgeCells subCells;
+        for (unsigned int k = 0; k < 4; k++)
+        {
+          glm::uvec3 bits;
+          bits[e] = h;
+          bits[(e + 1) % 3] = k & 1;
+          bits[(e + 2) % 3] = (k >> 1) & 1;
+          subCells[k] = this->child (cell, bits);
+        }
+        this->contourEdgeCells (subCells, e);
+      }
+    }
+  }
+
+  // Polygons around edges between cells of different sizes degenerate to triangles. Quads are
+  // split along their shorter diagonal unless it is an edge of another polygon.
+  void addPolygonToMesh (DynamicMesh& mesh, const Polygon& polygon,
+                         const std::unordered_map<uint64_t, unsigned int>& edges)
+  {
+    unsigned int ids[4];
+    unsigned int n = 0;
+
+    for (unsigned int id : polygon)
+    {
+      if (n == 0 || ids[n - 1] != id)
+      {
+        ids[n++] = id;
+      }
+    }
+    if (n > 1 && ids[n - 1] == ids[0])
+    {
+      n--;
+    }
+
+    unsigned int indices[4];
+    for (unsigned int i = 0; i < n; i++)
+    {
+      indices[i] = this->vertices.at (ids[i]).indexInMesh;
+      assert (indices[i] != Util::invalidIndex ());
+    }
+
+    if (n == 3)
+    {
+      mesh.addFace (indices[0], indices[1], indices[2]);
+    }
+    else if (n == 4)
+    {
+      const bool isEdge02 = edges.find (edgeKey (ids[0], ids[2])) != edges.end ();
+      const bool isEdge13 = edges.find (edgeKey (ids[1], ids[3])) != edges.end ();
+      const bool isShorter02 =
+        glm::distance2 (mesh.vertex (indices[0]), mesh.vertex (indices[2])) <=
+        glm::distance2 (mesh.vertex (indices[1]), mesh.vertex (indices[3]));
+
+      if (isEdge13 || (isShorter02 && isEdge02 == false))
+      {
+        mesh.addFace (indices[0], indices[1], indices[2]);
+        mesh.addFace (indices[0], indices[2], indices[3]);
+      }
+      else
+      {
+        mesh.addFace (indices[1], indices[2], indices[3]);
+        mesh.addFace (indices[1], indices[3], indices[0]);
+      }
+    }
+  }
+
+  void contour ()
+  {
+    this->vertices.clear ();
+    this->polygons.clear ();
+    this->contourCell (0);
+  }
+
+  void makeMesh (DynamicMesh& mesh)
+  {
+    this->contour ();
+
+    mesh.reset ();
+    for (auto& pair : this->vertices)
+    {
+      Vertex& vertex = pair.second;
+      vertex.indexInMesh =
+        mesh.addVertex (vertex.sum / float(vertex.numCrossings), glm::vec3 (0.0f));
+    }
+    const std::unordered_map<uint64_t, unsigned int> edges = this->numAdjacentPolygons ();
+    for (const Polygon& polygon : this->polygons)
+    {
+      this->addPolygonToMesh (mesh, polygon, edges);
+    }
+    mesh.setAllNormals ();
+    mesh.bufferData ();
+  }
+};
+
+DELEGATE2_BIG3 (IsosurfaceExtractionOctree, const PrimAABox&, float)
+GETTER_CONST (float, IsosurfaceExtractionOctree, resolution)
+DELEGATE_CONST (unsigned int, IsosurfaceExtractionOctree, numLeaves)
+DELEGATE2 (void, IsosurfaceExtractionOctree, build, const IsosurfaceExtraction::DistanceCallback&,
+           const IsosurfaceExtraction::ResolutionCallback&)
+DELEGATE1 (void, IsosurfaceExtractionOctree, makeMesh, DynamicMesh&)
@@ -0,0 +1,33 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_ISOSURFACE_EXTRACTION_OCTREE
+#define DILAY_ISOSURFACE_EXTRACTION_OCTREE
+
+#include "isosurface-extraction.hpp"
+#include "macro.hpp"
+
+class DynamicMesh;
+class PrimAABox;
+
+// Adaptive sampling of a distance field: cells are only subdivided near the surface and only
+// until their width falls below the local resolution. Meshes are extracted by dual contouring,
+// i.e., with one vertex per surface patch of a leaf and one polygon per sign-changing edge.
+class IsosurfaceExtractionOctree
+{
+public:
+  DECLARE_BIG3 (IsosurfaceExtractionOctree, const PrimAABox&, float)
+
+  float        resolution () const;
+  unsigned int numLeaves () const;
+
+  void build (const IsosurfaceExtraction::DistanceCallback&,
+              const IsosurfaceExtraction::ResolutionCallback&);
+  void makeMesh (DynamicMesh&);
+
+private:
+  IMPLEMENTATION
+};
+
+#endif
@@ -0,0 +1,809 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <glm/glm.hpp>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "mesh-formats.hpp"
+#include "mesh.hpp"
+#include "util.hpp"
+
+namespace
+{
+  constexpr unsigned int blockSize = 1 << 16;
+  constexpr std::size_t  stlHeaderSize = 80;
+  constexpr std::size_t  stlTriangleSize = 50;
+  const char             stlHeader[] = "Binary STL written by Dilay";
+
+  static_assert (sizeof (float) == 4 && sizeof (unsigned int) == 4, "Unexpected type sizes");
+  static_assert (sizeof (glm::vec3) == 12, "Unexpected memory layout");
+
+  bool isLittleEndian ()
+  {
+    const unsigned int value = 1;
+    char               firstByte;
+
+    std::memcpy (&firstByte, &value, 1);
+    return firstByte == 1;
+  }
+
+  unsigned int numThreads (unsigned int numBlocks)
+  {
+    return glm::max (1u, glm::min (numBlocks, std::thread::hardware_concurrency ()));
+  }
+
+  unsigned int numBlocks (unsigned int begin, unsigned int end)
+  {
+    return (end - begin + blockSize - 1) / blockSize;
+  }
+
+  // Calls `f` for consecutive blocks of `[begin, end)`, which are distributed among all threads
+  void forEachBlock (unsigned int begin, unsigned int end,
+                     const std::function<void(unsigned int, unsigned int)>& f)
+  {
+    const unsigned int        n = numBlocks (begin, end);
+    std::atomic<unsigned int> nextBlock (0);
+    std::vector<std::thread>  threads;
+
+    auto run = [begin, end, n, &nextBlock, &f]() {
+      for (unsigned int b = nextBlock++; b < n; b = nextBlock++)
+      {
+        const unsigned int blockBegin = begin + (b * blockSize);
+        f (blockBegin, glm::min (end, blockBegin + blockSize));
+      }
+    };
+
+    for (unsigned int i = 1; i < numThreads (n); i++)
+    {
+      threads.emplace_back (run);
+    }
+    run ();
+
+    for (std::thread& thread : threads)
+    {
+      thread.join ();
+    }
+  }
+
+  // Formats items of a fixed size in parallel and writes them in order.  At most one block per
+  // thread is buffered at a time.
+  void writeBlocks (std::ostream& stream, unsigned int numItems, std::size_t itemSize,
+                    const std::function<void(unsigned int, char*)>& format)
+  {
+    const unsigned int batchSize = numThreads (numBlocks (0, numItems)) * blockSize;
+    std::vector<char>  buffer;
+
+    for (unsigned int batch = 0; batch < numItems; batch += batchSize)
+    {
+      const unsigned int end = glm::min (numItems, batch + batchSize);
+
+      buffer.resize ((end - batch) * itemSize);
+      forEachBlock (batch, end, [batch, itemSize, &buffer, &format](unsigned int b,
+                                                                     unsigned int e) {
+        for (unsigned int i = b; i < e; i++)
+        {
+          format (i, buffer.data () + ((i - batch) * itemSize));
+        }
+      });
+      stream.write (buffer.data (), buffer.size ());
+    }
+  }
+
+  struct PositionKey
+  {
+    std::uint32_t x, y, z;
+
+    // Adding zero turns negative zeros into positive ones
+    PositionKey (const glm::vec3& p)
+    {
+      const glm::vec3 q = p + glm::vec3 (0.0f);
+
+      std::memcpy (&this->x, &q.x, 4);
+      std::memcpy (&this->y, &q.y, 4);
+      std::memcpy (&this->z, &q.z, 4);
+    }
+
+    bool operator== (const PositionKey& o) const
+    {
+      return this->x == o.x && this->y == o.y && this->z == o.z;
+    }
+
+    std::uint32_t hash () const
+    {
+      std::uint32_t h = (this->x * 73856093u) ^ (this->y * 19349663u) ^ (this->z * 83492791u);
+      return h ^ (h >> 16);
+    }
+  };
+
+  struct PositionKeyHash
+  {
+    std::size_t operator() (const PositionKey& key) const { return key.hash (); }
+  };
+
+  // Welds the corners of a triangle soup into `mesh` and drops degenerate triangles.  Each thread
+  // owns a partition of the hash range, so that no synchronization is needed while welding.
+  bool fromTriangles (const std::vector<glm::vec3>& corners, Mesh& mesh)
+  {
+    assert (corners.size () % 3 == 0);
+
+    if (corners.size () > std::size_t (std::numeric_limits<unsigned int>::max ()))
+    {
+      return false;
+    }
+    const unsigned int         numCorners = corners.size ();
+    const unsigned int         numPartitions = numThreads (numBlocks (0, numCorners));
+    std::vector<std::uint32_t> partitions (numCorners);
+    std::vector<unsigned int>  welded (numCorners);
+
+    forEachBlock (0, numCorners, [&corners, &partitions, numPartitions](unsigned int b,
+                                                                         unsigned int e) {
+      for (unsigned int i = b; i < e; i++)
+      {
+        const std::uint64_t hash = PositionKey (corners[i]).hash ();
+        partitions[i] = std::uint32_t ((hash * numPartitions) >> 32);
+      }
+    });
+
+    std::vector<std::vector<glm::vec3>> vertices (numPartitions);
+    std::vector<std::thread>            threads;
+
+    auto weldPartition = [&corners, &partitions, &welded, &vertices](unsigned int p) {
+      std::unordered_map<PositionKey, unsigned int, PositionKeyHash> indices;
+
+      // Closed triangle meshes have about a sixth as many vertices as corners
+      indices.reserve ((corners.size () / (6 * vertices.size ())) + 1);
+
+      for (unsigned int i = 0; i < corners.size (); i++)
+      {
+        if (partitions[i] == p)
+        {
+          auto it = indices.emplace (PositionKey (corners[i]), vertices[p].size ());
+          if (it.second)
+          {
+            vertices[p].push_back (corners[i]);
+          }
+          welded[i] = it.first->second;
+        }
+      }
+    };
+
+    for (unsigned int p = 1; p < numPartitions; p++)
+    {
+      threads.emplace_back (weldPartition, p);
+    }
+    weldPartition (0);
+
+    for (std::thread& thread : threads)
+    {
+      thread.join ();
+    }
+
+    std::vector<unsigned int> offsets (numPartitions, 0);
+    std::size_t               numVertices = 0;
+
+    for (unsigned int p = 0; p < numPartitions; p++)
+    {
+      offsets[p] = numVertices;
+      numVertices += vertices[p].size ();
+    }
+
+    const std::vector<glm::vec3> normals (numVertices, glm::vec3 (0.0f));
+
+    mesh.reset ();
+    mesh.reserveVertices (numVertices);
+    for (unsigned int p = 0; p < numPartitions; p++)
+    {
+      mesh.addVertices (vertices[p].data (), normals.data () + offsets[p], vertices[p].size ());
+    }
+
+    mesh.reserveIndices (numCorners);
+    for (unsigned int i = 0; i < numCorners; i += 3)
+    {
+      const unsigned int i1 = offsets[partitions[i + 0]] + welded[i + 0];
+      const unsigned int i2 = offsets[partitions[i + 1]] + welded[i + 1];
+      const unsigned int i3 = offsets[partitions[i + 2]] + welded[i + 2];
+
+      if (i1 != i2 && i1 != i3 && i2 != i3)
+      {
+        mesh.addIndex (i1);
+        mesh.addIndex (i2);
+        mesh.addIndex (i3);
+      }
+    }
+    return true;
+  }
+
+  bool isFinite (const glm::vec3& v)
+  {
+    return std::isfinite (v.x) && std::isfinite (v.y) && std::isfinite (v.z);
+  }
+
+  enum class PlyType
+  {
+    Int8,
+    UInt8,
+    Int16,
+    UInt16,
+    Int32,
+    UInt32,
+    Float32,
+    Float64
+  };
+
+  bool fromString (const std::string& name, PlyType& type)
+  {
+    if (name == "char" || name == "int8")
+    {
+      type = PlyType::Int8;
+    }
+    else if (name == "uchar" || name == "uint8")
+    {
+      type = PlyType::UInt8;
+    }
+    else if (name == "short" || name == "int16")
+    {
+      type = PlyType::Int16;
+    }
+    else if (name == "ushort" || name == "uint16")
+    {
+      type = PlyType::UInt16;
+    }
+    else if (name == "int" || name == "int32")
+    {
+      type = PlyType::Int32;
+    }
+    else if (name == "uint" || name == "uint32")
+    {
+      type = PlyType::UInt32;
+    }
+    else if (name == "float" || name == "float32")
+    {
+      type = PlyType::Float32;
+    }
+    else if (name == "double" || name == "float64")
+    {
+      type = PlyType::Float64;
+    }
+    else
+    {
+      return false;
+    }
+    return true;
+  }
+
+  std::size_t sizeOf (PlyType type)
+  {
+    switch (type)
+    {
+      case PlyType::Int8:
+      case PlyType::UInt8:
+        return 1;
+      case PlyType::Int16:
+      case PlyType::UInt16:
+        return 2;
+      case PlyType::Int32:
+      case PlyType::UInt32:
+      case PlyType::Float32:
+        return 4;
+      case PlyType::Float64:
+        return 8;
+    }
+    DILAY_IMPOSSIBLE
+  }
+
+  template <typename T> double readAs (const char* bytes)
+  {
+    T value;
+    std::memcpy (&value, bytes, sizeof (T));
+    return double(value);
+  }
+
+  double read (PlyType type, const char* bytes)
+  {
+    switch (type)
+    {
+      case PlyType::Int8:
+        return readAs<std::int8_t> (bytes);
+      case PlyType::UInt8:
+        return readAs<std::uint8_t> (bytes);
+      case PlyType::Int16:
+        return readAs<std::int16_t> (bytes);
+      case PlyType::UInt16:
+        return readAs<std::uint16_t> (bytes);
+      case PlyType::Int32:
+        return readAs<std::int32_t> (bytes);
+      case PlyType::UInt32:
+        return readAs<std::uint32_t> (bytes);
+      case PlyType::Float32:
+        return readAs<float> (bytes);
+      case PlyType::Float64:
+        return readAs<double> (bytes);
+    }
+    DILAY_IMPOSSIBLE
+  }
+
+  struct PlyProperty
+  {
+    std::string name;
+    bool        isList;
+    PlyType     countType;
+    PlyType     type;
+  };
+
+  struct PlyElement
+  {
+    std::string              name;
+    unsigned int             count;
+    std::vector<PlyProperty> properties;
+
+    bool hasLists () const
+    {
+      for (const PlyProperty& p : this->properties)
+      {
+        if (p.isList)
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    std::size_t stride () const
+    {
+      std::size_t s = 0;
+      for (const PlyProperty& p : this->properties)
+      {
+        s += sizeOf (p.type);
+      }
+      return s;
+    }
+
+    // Lower bound of the size of a record, i.e., all lists are empty
+    std::size_t minStride () const
+    {
+      std::size_t s = 0;
+      for (const PlyProperty& p : this->properties)
+      {
+        s += sizeOf (p.isList ? p.countType : p.type);
+      }
+      return std::max (std::size_t (1), s);
+    }
+  };
+
+  // Parses the header up to and including `end_header`
+  bool readPlyHeader (const char* bytes, std::size_t size, std::vector<PlyElement>& elements,
+                      std::size_t& headerSize)
+  {
+    const std::string endHeader ("\nend_header");
+    const char*       end = std::search (bytes, bytes + size, endHeader.begin (), endHeader.end ());
+
+    if (end == bytes + size)
+    {
+      return false;
+    }
+    const char* newLine =
+      static_cast<const char*> (std::memchr (end + 1, '\n', (bytes + size) - (end + 1)));
+
+    if (newLine == nullptr)
+    {
+      return false;
+    }
+    headerSize = (newLine - bytes) + 1;
+
+    std::istringstream header (std::string (bytes, (end - bytes) + 1));
+    std::string        line;
+    bool               isBinaryLittleEndian = false;
+
+    std::getline (header, line);
+    if (line != "ply" && line != "ply\r")
+    {
+      return false;
+    }
+
+    while (std::getline (header, line))
+    {
+      std::istringstream tokens (line);
+      std::string        keyword;
+
+      tokens >> keyword;
+      if (keyword == "format")
+      {
+        std::string format;
+        tokens >> format;
+        isBinaryLittleEndian = format == "binary_little_endian";
+      }
+      else if (keyword == "element")
+      {
+        elements.emplace_back ();
+        if (bool(tokens >> elements.back ().name >> elements.back ().count) == false)
+        {
+          return false;
+        }
+      }
+      else if (keyword == "property")
+      {
+        PlyProperty property;
+        std::string type;
+
+        if (elements.empty () || bool(tokens >> type) == false)
+        {
+          return false;
+        }
+        property.isList = type == "list";
+
+        if (property.isList)
+        {
+          std::string countType;
+          if (bool(tokens >> countType >> type) == false ||
+              fromString (countType, property.countType) == false)
+          {
+            return false;
+          }
+        }
+        if (fromString (type, property.type) == false || bool(tokens >> property.name) == false)
+        {
+          return false;
+        }
+        elements.back ().properties.push_back (property);
+      }
+      else if (keyword != "comment" && keyword != "obj_info" && keyword.empty () == false)
+      {
+        return false;
+      }
+    }
+
+    if (isBinaryLittleEndian == false)
+    {
+      DILAY_WARN ("only binary little-endian PLY files are supported")
+    }
+    return isBinaryLittleEndian;
+  }
+
+  // Calls `f` for each list of an element, and returns the size of the element's data
+  bool forEachList (const char* bytes, std::size_t size, const PlyElement& element,
+                    const std::function<bool(const PlyProperty&, unsigned int, const char*)>& f,
+                    std::size_t& elementSize)
+  {
+    std::size_t offset = 0;
+
+    for (unsigned int i = 0; i < element.count; i++)
+    {
+      for (const PlyProperty& p : element.properties)
+      {
+        if (p.isList)
+        {
+          if (size - offset < sizeOf (p.countType))
+          {
+            return false;
+          }
+          const double count = read (p.countType, bytes + offset);
+          offset += sizeOf (p.countType);
+
+          if (count < 0.0 || double(size - offset) < count * double(sizeOf (p.type)))
+          {
+            return false;
+          }
+          else if (f (p, (unsigned int) (count), bytes + offset) == false)
+          {
+            return false;
+          }
+          offset += std::size_t (count) * sizeOf (p.type);
+        }
+        else if (size - offset < sizeOf (p.type))
+        {
+          return false;
+        }
+        else
+        {
+          offset += sizeOf (p.type);
+        }
+      }
+    }
+    elementSize = offset;
+    return true;
+  }
+}
+
+namespace MeshFormats
+{
+  bool readStl (const char* bytes, std::size_t size, Mesh& mesh)
+  {
+    if (isLittleEndian () == false)
+    {
+      DILAY_WARN ("STL files are not supported on big-endian hosts")
+      return false;
+    }
+    else if (size < stlHeaderSize + 4)
+    {
+      return false;
+    }
+
+    unsigned int numTriangles;
+    std::memcpy (&numTriangles, bytes + stlHeaderSize, 4);
+
+    if ((size - stlHeaderSize - 4) / stlTriangleSize < numTriangles ||
+        numTriangles > std::numeric_limits<unsigned int>::max () / 3)
+    {
+      if (size >= 5 && std::memcmp (bytes, "solid", 5) == 0)
+      {
+        DILAY_WARN ("ASCII STL files are not supported")
+      }
+      return false;
+    }
+
+    std::vector<glm::vec3> corners (3 * std::size_t (numTriangles));
+    std::atomic<bool>      isValid (true);
+
+    forEachBlock (0, numTriangles, [bytes, &corners, &isValid](unsigned int b, unsigned int e) {
+      for (unsigned int i = b; i < e; i++)
+      {
+        const char* triangle = bytes + stlHeaderSize + 4 + (i * stlTriangleSize);
+
+        // The facet normal is skipped, since normals are computed from the welded mesh
+        std::memcpy (&corners[3 * i], triangle + 12, 36);
+
+        if (isFinite (corners[(3 * i) + 0]) == false || isFinite (corners[(3 * i) + 1]) == false ||
+            isFinite (corners[(3 * i) + 2]) == false)
+        {
+          isValid = false;
+        }
+      }
+    });
+    return isValid && fromTriangles (corners, mesh);
+  }
+
+  bool readPly (const char* bytes, std::size_t size, Mesh& mesh)
+  {
+    std::vector<PlyElement> elements;
+    std::size_t             offset;
+
+    if (isLittleEndian () == false)
+    {
+      DILAY_WARN ("PLY files are not supported on big-endian hosts")
+      return false;
+    }
+    else if (readPlyHeader (bytes, size, elements, offset) == false)
+    {
+      return false;
+    }
+
+    std::vector<glm::vec3>    vertices;
+    std::vector<unsigned int> triangles;
+    bool                      hasVertices = false;
+    bool                      hasFaces = false;
+
+    for (const PlyElement& element : elements)
+    {
+      std::size_t elementSize = 0;
+
+      if (element.name == "vertex" && element.hasLists () == false)
+      {
+        const std::size_t  stride = element.stride ();
+        const PlyProperty* xyz[3] = {nullptr, nullptr, nullptr};
+        std::size_t        xyzOffsets[3];
+        std::size_t        propertyOffset = 0;
+
+        for (const PlyProperty& p : element.properties)
+        {
+          for (unsigned int i = 0; i < 3; i++)
+          {
+            if (p.name == std::string (1, char('x' + i)))
+            {
+              xyz[i] = &p;
+              xyzOffsets[i] = propertyOffset;
+            }
+          }
+          propertyOffset += sizeOf (p.type);
+        }
+
+        if (xyz[0] == nullptr || xyz[1] == nullptr || xyz[2] == nullptr ||
+            double(size - offset) < double(element.count) * double(stride))
+        {
+          return false;
+        }
+        elementSize = element.count * stride;
+        vertices.resize (element.count);
+
+        std::atomic<bool> isValid (true);
+        forEachBlock (0, element.count, [&](unsigned int b, unsigned int e) {
+          for (unsigned int i = b; i < e; i++)
+          {
+            const char* vertex = bytes + offset + (i * stride);
+
+            for (unsigned int j = 0; j < 3; j++)
+            {
+              vertices[i][j] = float(read (xyz[j]->type, vertex + xyzOffsets[j]));
+            }
+            if (isFinite (vertices[i]) == false)
+            {
+              isValid = false;
+            }
+          }
+        });
+        if (isValid == false)
+        {
+          return false;
+        }
+        hasVertices = true;
+      }
+      else if (element.name == "face" && hasFaces == false)
+      {
+        // The count of the header is only trusted as far as the remaining data can hold it
+        triangles.reserve (
+          3 * std::min (std::size_t (element.count), (size - offset) / element.minStride ()));
+
+        auto addPolygon = [&triangles](const PlyProperty& p, unsigned int n, const char* list) {
+          if (p.name != "vertex_indices" && p.name != "vertex_index")
+          {
+            return true;
+          }
+          for (unsigned int i = 1; i + 1 < n; i++)
+          {
+            for (unsigned int j : {0u, i, i + 1})
+            {
+              const double index = read (p.type, list + (j * sizeOf (p.type)));
+
+              if (index < 0.0 || index >= double(std::numeric_limits<unsigned int>::max ()))
+              {
+                return false;
+              }
+              triangles.push_back ((unsigned int) (index));
+            }
+          }
+          return true;
+        };
+
+        if (forEachList (bytes + offset, size - offset, element, addPolygon, elementSize) ==
+            false)
+        {
+          return false;
+        }
+        hasFaces = true;
+      }
+      else if (hasVertices && hasFaces)
+      {
+        break;
+      }
+      else if (forEachList (bytes + offset, size - offset, element,
+                            [](const PlyProperty&, unsigned int, const char*) { return true; },
+                            elementSize) == false)
+      {
+        return false;
+      }
+      offset += elementSize;
+    }
+
+    if (hasVertices == false ||
+        triangles.size () > std::size_t (std::numeric_limits<unsigned int>::max ()))
+    {
+      return false;
+    }
+
+    std::vector<glm::vec3> corners (triangles.size ());
+    std::atomic<bool>      isValid (true);
+
+    forEachBlock (0, triangles.size (), [&](unsigned int b, unsigned int e) {
+      for (unsigned int i = b; i < e; i++)
+      {
+        if (triangles[i] < vertices.size ())
+        {
+          corners[i] = vertices[triangles[i]];
+        }
+        else
+        {
+          isValid = false;
+        }
+      }
+    });
+    return isValid && fromTriangles (corners, mesh);
+  }
+
+  bool writeStl (std::ostream& stream, const std::vector<const Mesh*>& meshes)
+  {
+    std::size_t numTriangles = 0;
+    char        header[stlHeaderSize] = {};
+
+    for (const Mesh* m : meshes)
+    {
+      numTriangles += m->numIndices () / 3;
+    }
+
+    if (isLittleEndian () == false)
+    {
+      DILAY_WARN ("STL files are not supported on big-endian hosts")
+      return false;
+    }
+    else if (numTriangles > std::size_t (std::numeric_limits<unsigned int>::max ()))
+    {
+      return false;
+    }
+
+    const unsigned int n = numTriangles;
+
+    std::memcpy (header, stlHeader, sizeof (stlHeader));
+    stream.write (header, stlHeaderSize);
+    stream.write (reinterpret_cast<const char*> (&n), 4);
+
+    for (const Mesh* m : meshes)
+    {
+      writeBlocks (stream, m->numIndices () / 3, stlTriangleSize, [m](unsigned int i, char* t) {
+        const glm::vec3 v1 = m->vertex (m->index ((3 * i) + 0));
+        const glm::vec3 v2 = m->vertex (m->index ((3 * i) + 1));
+        const glm::vec3 v3 = m->vertex (m->index ((3 * i) + 2));
+        const glm::vec3 c = glm::cross (v2 - v1, v3 - v1);
+        const float     l = glm::length (c);
+        const glm::vec3 data[4] = {l > 0.0f ? c / l : glm::vec3 (0.0f), v1, v2, v3};
+
+        std::memcpy (t, data, 48);
+        t[48] = 0;
+        t[49] = 0;
+      });
+    }
+    return bool(stream);
+  }
+
+  bool writePly (std::ostream& stream, const std::vector<const Mesh*>& meshes)
+  {
+    std::size_t numVertices = 0;
+    std::size_t numFaces = 0;
+
+    for (const Mesh* m : meshes)
+    {
+      numVertices += m->numVertices ();
+      numFaces += m->numIndices () / 3;
+    }
+
+    if (isLittleEndian () == false)
+    {
+      DILAY_WARN ("PLY files are not supported on big-endian hosts")
+      return false;
+    }
+    else if (numVertices > std::size_t (std::numeric_limits<int>::max ()) ||
+             numFaces > std::size_t (std::numeric_limits<unsigned int>::max ()))
+    {
+      return false;
+    }
+
+    stream << "ply\n"
+           << "format binary_little_endian 1.0\n"
+           << "comment written by Dilay\n"
+           << "element vertex " << numVertices << "\n"
+           << "property float x\n"
+           << "property float y\n"
+           << "property float z\n"
+           << "element face " << numFaces << "\n"
+           << "property list uchar int vertex_indices\n"
+           << "end_header\n";
+
+    for (const Mesh* m : meshes)
+    {
+      writeBlocks (stream, m->numVertices (), 12,
+                   [m](unsigned int i, char* v) { std::memcpy (v, &m->vertex (i), 12); });
+    }
+
+    unsigned int offset = 0;
+    for (const Mesh* m : meshes)
+    {
+      writeBlocks (stream, m->numIndices () / 3, 13, [m, offset](unsigned int i, char* f) {
+        const unsigned int indices[3] = {offset + m->index ((3 * i) + 0),
+                                         offset + m->index ((3 * i) + 1),
+                                         offset + m->index ((3 * i) + 2)};
+        f[0] = 3;
+        std::memcpy (f + 1, indices, 12);
+      });
+      offset += m->numVertices ();
+    }
+    return bool(stream);
+  }
+}
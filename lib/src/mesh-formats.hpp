@@ -0,0 +1,25 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_MESH_FORMATS
+#define DILAY_MESH_FORMATS
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+class Mesh;
+
+// Binary STL and binary little-endian PLY files.  Triangles are streamed in fixed-size blocks that
+// are processed in parallel.  Coinciding vertices are welded on import, and all meshes are merged
+// into a single one on export.
+namespace MeshFormats
+{
+  bool readStl (const char*, std::size_t, Mesh&);
+  bool readPly (const char*, std::size_t, Mesh&);
+  bool writeStl (std::ostream&, const std::vector<const Mesh*>&);
+  bool writePly (std::ostream&, const std::vector<const Mesh*>&);
+}
+
+#endif
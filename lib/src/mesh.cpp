@@ -27,6 +27,7 @@ namespace
     unsigned int   dataLowerBound;
     unsigned int   dataUpperBound;
     unsigned int   bufferSize;
+    unsigned int   numBufferedElements;
 
     BufferedData () { this->reset (); }
 
@@ -36,6 +37,7 @@ namespace
       this->data.clear ();
       this->resetBounds ();
       this->bufferSize = 0;
+      this->numBufferedElements = 0;
     }
 
     void resetBounds ()
@@ -69,6 +71,16 @@ namespace
       return this->numElements () - 1;
     }
 
+    void add (const T* values, unsigned int n)
+    {
+      if (n > 0)
+      {
+        this->data.insert (this->data.end (), values, values + n);
+        this->updateBounds (this->numElements () - n);
+        this->updateBounds (this->numElements () - 1);
+      }
+    }
+
     void set (unsigned int index, const T& value)
     {
       assert (index < this->numElements ());
@@ -114,6 +126,7 @@ namespace
                                  &this->get (this->dataLowerBound));
       }
       this->resetBounds ();
+      this->numBufferedElements = this->numElements ();
     }
   };
 }
@@ -152,6 +165,12 @@ struct Mesh::Impl
 
   const glm::vec3& normal (unsigned int i) const { return this->normals.get (i); }
 
+  const glm::vec3* vertexData () const { return this->vertices.data.data (); }
+
+  const unsigned int* indexData () const { return this->indices.data.data (); }
+
+  const glm::vec3* normalData () const { return this->normals.data.data (); }
+
   void copyNonGeometry (const Mesh& source)
   {
     this->scalingMatrix = source.impl->scalingMatrix;
@@ -164,6 +183,8 @@ struct Mesh::Impl
 
   unsigned int addIndex (unsigned int i) { return this->indices.add (i); }
 
+  void addIndices (const unsigned int* is, unsigned int n) { this->indices.add (is, n); }
+
   void reserveIndices (unsigned int n) { this->indices.reserve (n); }
 
   void shrinkIndices (unsigned int n) { this->indices.shrink (n); }
@@ -180,6 +201,14 @@ struct Mesh::Impl
     return this->normals.add (n);
   }
 
+  void addVertices (const glm::vec3* vs, const glm::vec3* ns, unsigned int n)
+  {
+    assert (this->vertices.numElements () == this->normals.numElements ());
+
+    this->vertices.add (vs, n);
+    this->normals.add (ns, n);
+  }
+
   void reserveVertices (unsigned int n)
   {
     this->vertices.reserve (n);
@@ -208,6 +237,11 @@ struct Mesh::Impl
 
   void bufferData ()
   {
+    // Headless sessions edit meshes without a rendering context
+    if (OpenGL::isInitialized () == false)
+    {
+      return;
+    }
     this->vertices.bufferData (OpenGL::ArrayBuffer ());
     this->indices.bufferData (OpenGL::ElementArrayBuffer ());
     this->normals.bufferData (OpenGL::ArrayBuffer ());
@@ -238,12 +272,17 @@ struct Mesh::Impl
       RenderMode nonWireframeRenderMode (this->renderMode);
       nonWireframeRenderMode.renderWireframe (false);
 
-      camera.renderer ().setProgram (nonWireframeRenderMode);
+      this->renderBegin (camera, nonWireframeRenderMode);
     }
     else
     {
-      camera.renderer ().setProgram (this->renderMode);
+      this->renderBegin (camera, this->renderMode);
     }
+  }
+
+  void renderBegin (Camera& camera, const RenderMode& programRenderMode) const
+  {
+    camera.renderer ().setProgram (programRenderMode);
     camera.renderer ().setColor (this->color);
     camera.renderer ().setWireframeColor (this->wireframeColor);
 
@@ -282,16 +321,16 @@ struct Mesh::Impl
   {
     this->renderBegin (camera);
 
-    OpenGL::glDrawElements (OpenGL::Triangles (), this->numIndices (), OpenGL::UnsignedInt (),
-                            nullptr);
+    OpenGL::glDrawElements (OpenGL::Triangles (), this->indices.numBufferedElements,
+                            OpenGL::UnsignedInt (), nullptr);
 
     if (this->renderMode.renderWireframe () && OpenGL::hasGeometryShader () == false)
     {
       camera.renderer ().setColor (this->wireframeColor);
       OpenGL::glPolygonMode (OpenGL::FrontAndBack (), OpenGL::Line ());
 
-      OpenGL::glDrawElements (OpenGL::Triangles (), this->numIndices (), OpenGL::UnsignedInt (),
-                              nullptr);
+      OpenGL::glDrawElements (OpenGL::Triangles (), this->indices.numBufferedElements,
+                              OpenGL::UnsignedInt (), nullptr);
 
       OpenGL::glPolygonMode (OpenGL::FrontAndBack (), OpenGL::Fill ());
     }
@@ -302,7 +341,44 @@ struct Mesh::Impl
   void renderLines (Camera& camera) const
   {
     this->renderBegin (camera);
-    OpenGL::glDrawElements (OpenGL::Lines (), this->numIndices (), OpenGL::UnsignedInt (), nullptr);
+    OpenGL::glDrawElements (OpenGL::Lines (), this->indices.numBufferedElements,
+                            OpenGL::UnsignedInt (), nullptr);
+    this->renderEnd ();
+  }
+
+  // Smooth shaded meshes are instanced as spheres with one `glm::vec4` per instance, flat shaded
+  // meshes as bones with two `glm::vec4` per instance (cf. `SketchInstances`)
+  void renderInstances (Camera& camera, unsigned int bufferId, unsigned int numInstances) const
+  {
+    assert (OpenGL::hasInstancing ());
+
+    RenderMode instancingRenderMode (this->renderMode);
+    instancingRenderMode.renderWireframe (false);
+    instancingRenderMode.instancing (true);
+
+    this->renderBegin (camera, instancingRenderMode);
+
+    const unsigned int numAttributes = this->renderMode.flatShading () ? 2 : 1;
+    const unsigned int stride = numAttributes * sizeof (glm::vec4);
+
+    OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), bufferId);
+    for (unsigned int i = 0; i < numAttributes; i++)
+    {
+      OpenGL::glEnableVertexAttribArray (OpenGL::Instance1Index + i);
+      OpenGL::glVertexAttribPointer (OpenGL::Instance1Index + i, 4, OpenGL::Float (), false,
+                                     stride, (const void*) (i * sizeof (glm::vec4)));
+      OpenGL::glVertexAttribDivisor (OpenGL::Instance1Index + i, 1);
+    }
+    OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), 0);
+
+    OpenGL::glDrawElementsInstanced (OpenGL::Triangles (), this->indices.numBufferedElements,
+                                     OpenGL::UnsignedInt (), nullptr, numInstances);
+
+    for (unsigned int i = 0; i < numAttributes; i++)
+    {
+      OpenGL::glVertexAttribDivisor (OpenGL::Instance1Index + i, 0);
+      OpenGL::glDisableVertexAttribArray (OpenGL::Instance1Index + i);
+    }
     this->renderEnd ();
   }
 
@@ -409,13 +485,18 @@ DELEGATE_CONST (unsigned int, Mesh, numIndices)
 DELEGATE1_CONST (const glm::vec3&, Mesh, vertex, unsigned int)
 DELEGATE1_CONST (unsigned int, Mesh, index, unsigned int)
 DELEGATE1_CONST (const glm::vec3&, Mesh, normal, unsigned int)
+DELEGATE_CONST (const glm::vec3*, Mesh, vertexData)
+DELEGATE_CONST (const unsigned int*, Mesh, indexData)
+DELEGATE_CONST (const glm::vec3*, Mesh, normalData)
 
 DELEGATE1 (void, Mesh, copyNonGeometry, const Mesh&)
 DELEGATE1 (unsigned int, Mesh, addIndex, unsigned int)
+DELEGATE2 (void, Mesh, addIndices, const unsigned int*, unsigned int)
 DELEGATE1 (void, Mesh, reserveIndices, unsigned int)
 DELEGATE1 (void, Mesh, shrinkIndices, unsigned int)
 DELEGATE1 (unsigned int, Mesh, addVertex, const glm::vec3&)
 DELEGATE2 (unsigned int, Mesh, addVertex, const glm::vec3&, const glm::vec3&)
+DELEGATE3 (void, Mesh, addVertices, const glm::vec3*, const glm::vec3*, unsigned int)
 DELEGATE1 (void, Mesh, reserveVertices, unsigned int)
 DELEGATE1 (void, Mesh, shrinkVertices, unsigned int)
 DELEGATE2 (void, Mesh, index, unsigned int, unsigned int)
@@ -429,6 +510,7 @@ DELEGATE1_CONST (void, Mesh, renderBegin, Camera&)
 DELEGATE_CONST (void, Mesh, renderEnd)
 DELEGATE1_CONST (void, Mesh, render, Camera&)
 DELEGATE1_CONST (void, Mesh, renderLines, Camera&)
+DELEGATE3_CONST (void, Mesh, renderInstances, Camera&, unsigned int, unsigned int)
 DELEGATE (void, Mesh, reset)
 DELEGATE (void, Mesh, resetGeometry)
 GETTER_CONST (const RenderMode&, Mesh, renderMode)
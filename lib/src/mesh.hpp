@@ -26,16 +26,22 @@ public:
   const glm::vec3& normal (unsigned int) const;
   void             copyNonGeometry (const Mesh&);
   unsigned int     addIndex (unsigned int);
+  void             addIndices (const unsigned int*, unsigned int);
   void             reserveIndices (unsigned int);
   void             shrinkIndices (unsigned int);
   unsigned int     addVertex (const glm::vec3&);
   unsigned int     addVertex (const glm::vec3&, const glm::vec3&);
+  void             addVertices (const glm::vec3*, const glm::vec3*, unsigned int);
   void             reserveVertices (unsigned int);
   void             shrinkVertices (unsigned int);
   void             index (unsigned int, unsigned int);
   void             vertex (unsigned int, const glm::vec3&);
   void             normal (unsigned int, const glm::vec3&);
 
+  const glm::vec3*    vertexData () const;
+  const unsigned int* indexData () const;
+  const glm::vec3*    normalData () const;
+
   void              bufferData ();
   glm::mat4x4       modelMatrix () const;
   glm::mat3x3       modelNormalMatrix () const;
@@ -43,6 +49,7 @@ public:
   void              renderEnd () const;
   void              render (Camera&) const;
   void              renderLines (Camera&) const;
+  void              renderInstances (Camera&, unsigned int, unsigned int) const;
   void              reset ();
   void              resetGeometry ();
   const RenderMode& renderMode () const;
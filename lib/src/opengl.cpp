@@ -41,6 +41,8 @@ namespace OpenGL
 
   static QOpenGLFunctions_2_1*                                  fun = nullptr;
   static std::unique_ptr<QOpenGLExtension_EXT_geometry_shader4> gsFun;
+  static std::unique_ptr<QOpenGLExtension_ARB_instanced_arrays>  iaFun;
+  static std::unique_ptr<QOpenGLExtension_ARB_draw_instanced>    diFun;
 
   void setDefaultFormat ()
   {
@@ -79,13 +81,30 @@ namespace OpenGL
       }
     }
 
+    if (QOpenGLContext::currentContext ()->hasExtension (QByteArray ("GL_ARB_instanced_arrays")) &&
+        QOpenGLContext::currentContext ()->hasExtension (QByteArray ("GL_ARB_draw_instanced")))
+    {
+      iaFun = std::make_unique<QOpenGLExtension_ARB_instanced_arrays> ();
+      diFun = std::make_unique<QOpenGLExtension_ARB_draw_instanced> ();
+
+      if (iaFun->initializeOpenGLFunctions () == false ||
+          diFun->initializeOpenGLFunctions () == false)
+      {
+        iaFun.reset ();
+        diFun.reset ();
+      }
+    }
+
     DILAY_INFO ("OpenGL version: %s", fun->glGetString (GL_VERSION));
     DILAY_INFO ("OpenGL vendor: %s", fun->glGetString (GL_VENDOR));
     DILAY_INFO ("OpenGL renderer: %s", fun->glGetString (GL_RENDERER));
     DILAY_INFO ("OpenGL GLSL version: %s", fun->glGetString (GL_SHADING_LANGUAGE_VERSION));
     DILAY_INFO ("OpenGL supports GL_EXT_geometry_shader4: %i", gsFun != nullptr);
+    DILAY_INFO ("OpenGL supports GL_ARB_instanced_arrays: %i", iaFun != nullptr);
   }
 
+  bool isInitialized () { return fun != nullptr; }
+
   DELEGATE_GL_CONSTANT (Always, GL_ALWAYS);
   DELEGATE_GL_CONSTANT (ArrayBuffer, GL_ARRAY_BUFFER);
   DELEGATE_GL_CONSTANT (Back, GL_BACK);
@@ -162,6 +181,21 @@ namespace OpenGL
 
   bool hasGeometryShader () { return bool(gsFun); }
 
+  bool hasInstancing () { return bool(iaFun); }
+
+  void glDrawElementsInstanced (unsigned int mode, unsigned int count, unsigned int type,
+                                const void* indices, unsigned int numInstances)
+  {
+    assert (OpenGL::hasInstancing ());
+    diFun->glDrawElementsInstancedARB (mode, count, type, indices, numInstances);
+  }
+
+  void glVertexAttribDivisor (unsigned int index, unsigned int divisor)
+  {
+    assert (OpenGL::hasInstancing ());
+    iaFun->glVertexAttribDivisorARB (index, divisor);
+  }
+
   void glUniformVec3 (unsigned int id, const glm::vec3& v) { fun->glUniform3f (id, v.x, v.y, v.z); }
   void glUniformVec4 (unsigned int id, const glm::vec4& v)
   {
@@ -255,6 +289,8 @@ namespace OpenGL
 
     fun->glBindAttribLocation (programId, OpenGL::PositionIndex, "position");
     fun->glBindAttribLocation (programId, OpenGL::NormalIndex, "normal");
+    fun->glBindAttribLocation (programId, OpenGL::Instance1Index, "instance1");
+    fun->glBindAttribLocation (programId, OpenGL::Instance2Index, "instance2");
 
     fun->glLinkProgram (programId);
 
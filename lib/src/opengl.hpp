@@ -13,6 +13,7 @@ namespace OpenGL
   // QT related
   void setDefaultFormat ();
   void initializeFunctions (bool);
+  bool isInitialized ();
 
   // wrappers
   unsigned int Always ();
@@ -69,6 +70,8 @@ namespace OpenGL
   void glDisable (unsigned int);
   void glDisableVertexAttribArray (unsigned int);
   void glDrawElements (unsigned int, unsigned int, unsigned int, const void*);
+  void glDrawElementsInstanced (unsigned int, unsigned int, unsigned int, const void*,
+                                unsigned int);
   void glEnable (unsigned int);
   void glEnableVertexAttribArray (unsigned int);
   void glFrontFace (unsigned int);
@@ -85,6 +88,7 @@ namespace OpenGL
   void glUniformMatrix3fv (int, unsigned int, bool, const float*);
   void glUniformMatrix4fv (int, unsigned int, bool, const float*);
   void glUseProgram (unsigned int);
+  void glVertexAttribDivisor (unsigned int, unsigned int);
   void glVertexAttribPointer (unsigned int, int, unsigned int, bool, unsigned int, const void*);
   void glViewport (unsigned int, unsigned int, unsigned int, unsigned int);
 
@@ -92,10 +96,13 @@ namespace OpenGL
   enum VertexAttributIndex
   {
     PositionIndex = 0,
-    NormalIndex = 1
+    NormalIndex = 1,
+    Instance1Index = 2,
+    Instance2Index = 3
   };
 
   bool         hasGeometryShader ();
+  bool         hasInstancing ();
   void         glUniformVec3 (unsigned int, const glm::vec3&);
   void         glUniformVec4 (unsigned int, const glm::vec4&);
   void         safeDeleteBuffer (unsigned int&);
@@ -0,0 +1,815 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/gtx/norm.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "distance.hpp"
+#include "dynamic/faces.hpp"
+#include "dynamic/mesh.hpp"
+#include "dynamic/octree.hpp"
+#include "intersection.hpp"
+#include "isosurface-extraction.hpp"
+#include "mesh.hpp"
+#include "primitive/aabox.hpp"
+#include "primitive/cone-sphere.hpp"
+#include "primitive/ray.hpp"
+#include "primitive/sphere.hpp"
+#include "primitive/triangle.hpp"
+#include "remesh.hpp"
+#include "sketch/bvh.hpp"
+#include "sketch/mesh.hpp"
+#include "sketch/path.hpp"
+#include "util.hpp"
+
+namespace
+{
+  typedef IsosurfaceExtraction::Intersection Sampling;
+
+  bool isInside (Remesh::Operation operation, const std::vector<bool>& inside)
+  {
+    switch (operation)
+    {
+      case Remesh::Operation::Union:
+        return std::find (inside.begin (), inside.end (), true) != inside.end ();
+      case Remesh::Operation::Difference:
+        return inside[0] && std::find (inside.begin () + 1, inside.end (), true) == inside.end ();
+      case Remesh::Operation::Intersection:
+        return std::find (inside.begin (), inside.end (), false) == inside.end ();
+    }
+    DILAY_IMPOSSIBLE
+  }
+
+  // Takes the nearest hit of each operand along a ray. The nearest of all hits is part of the
+  // result's surface if it changes whether the ray is inside of the result.
+  Sampling sampleNearest (Remesh::Operation operation, const std::vector<Intersection>& nearest,
+                          const PrimRay& ray, Intersection& intersection)
+  {
+    unsigned int      first = Util::invalidIndex ();
+    std::vector<bool> inside (nearest.size (), false);
+
+    for (unsigned int o = 0; o < nearest.size (); o++)
+    {
+      if (nearest[o].isIntersection ())
+      {
+        inside[o] = glm::dot (ray.direction (), nearest[o].normal ()) > 0.0f;
+
+        if (first == Util::invalidIndex () || nearest[o].distance () < nearest[first].distance ())
+        {
+          first = o;
+        }
+      }
+    }
+
+    if (first == Util::invalidIndex ())
+    {
+      return Sampling::None;
+    }
+    intersection = nearest[first];
+
+    const bool insideBefore = isInside (operation, inside);
+    inside[first] = inside[first] == false;
+
+    return isInside (operation, inside) == insideBefore ? Sampling::Continue : Sampling::Sample;
+  }
+
+  // Faces of all operands of a boolean operation are kept in a single octree, so that rays and
+  // distances are evaluated by one traversal instead of one traversal per operand
+  class Operands
+  {
+  public:
+    Operands (Remesh::Operation operation, const std::vector<DynamicMesh*>& meshes)
+      : operation (operation)
+      , numOperands (meshes.size ())
+    {
+      for (unsigned int o = 0; o < meshes.size (); o++)
+      {
+        const DynamicMesh& mesh = *meshes[o];
+
+        mesh.forEachFace ([this, o, &mesh](unsigned int i) {
+          const PrimTriangle tri = mesh.face (i);
+
+          if (this->octree.hasRoot () == false)
+          {
+            this->octree.setupRoot (tri.center (), tri.maxDimExtent ());
+          }
+          this->octree.addElement (this->faces.size (), tri.center (), tri.maxDimExtent ());
+          this->faces.push_back (tri);
+          this->operands.push_back (o);
+        });
+      }
+    }
+
+    Sampling intersects (const PrimRay& ray, Intersection& intersection) const
+    {
+      std::vector<Intersection> nearest (this->numOperands);
+      unsigned int              numMissing = this->numOperands;
+
+      // Subtrees are only pruned once every operand has been hit, so that the nearest hit of
+      // each operand is found
+      this->octree.intersects (ray, [this, &ray, &nearest, &numMissing](unsigned int i) -> float {
+        const PrimTriangle& tri = this->faces[i];
+        Intersection&       operandNearest = nearest[this->operands[i]];
+        float               t;
+
+        if (IntersectionUtil::intersects (ray, tri, true, &t))
+        {
+          if (operandNearest.isIntersection () == false)
+          {
+            numMissing--;
+          }
+          operandNearest.update (t, ray.pointAt (t), tri.normal ());
+        }
+
+        if (numMissing > 0)
+        {
+          return Util::maxFloat ();
+        }
+        float farthest = 0.0f;
+        for (const Intersection& n : nearest)
+        {
+          farthest = glm::max (farthest, n.distance ());
+        }
+        return farthest;
+      });
+
+      return sampleNearest (this->operation, nearest, ray, intersection);
+    }
+
+    float distance (const glm::vec3& pos) const
+    {
+      return this->octree.distance (
+        pos, [this, &pos](unsigned int i) { return Distance::distance (this->faces[i], pos); });
+    }
+
+  private:
+    const Remesh::Operation   operation;
+    const unsigned int        numOperands;
+    std::vector<PrimTriangle> faces;
+    std::vector<unsigned int> operands;
+    DynamicOctree             octree;
+  };
+
+  typedef std::vector<unsigned int>                     BorderLoop;
+  typedef std::unordered_map<unsigned int, unsigned int> BorderEdges;
+
+  bool hasVertex (const DynamicMesh& mesh, unsigned int face, unsigned int i)
+  {
+    unsigned int i1, i2, i3;
+    mesh.vertexIndices (face, i1, i2, i3);
+    return i == i1 || i == i2 || i == i3;
+  }
+
+  // Returns the other face of the edge between `i1` and `i2` of `face`
+  unsigned int oppositeFace (const DynamicMesh& mesh, unsigned int face, unsigned int i1,
+                             unsigned int i2)
+  {
+    for (unsigned int f : mesh.adjacentFaces (i1))
+    {
+      if (f != face && hasVertex (mesh, f, i2))
+      {
+        return f;
+      }
+    }
+    return Util::invalidIndex ();
+  }
+
+  template <typename F> void forEachEdge (const DynamicMesh& mesh, unsigned int face, const F& f)
+  {
+    unsigned int i1, i2, i3;
+    mesh.vertexIndices (face, i1, i2, i3);
+
+    f (i1, i2);
+    f (i2, i3);
+    f (i3, i1);
+  }
+
+  // Fails if a vertex has several outgoing or incoming border edges
+  bool addBorderEdge (unsigned int from, unsigned int to, BorderEdges& edges,
+                      std::unordered_set<unsigned int>& targets)
+  {
+    return edges.emplace (from, to).second && targets.insert (to).second;
+  }
+
+  bool borderLoops (BorderEdges edges, std::vector<BorderLoop>& loops)
+  {
+    while (edges.empty () == false)
+    {
+      BorderLoop   loop;
+      unsigned int i = edges.begin ()->first;
+
+      do
+      {
+        const auto it = edges.find (i);
+        if (it == edges.end ())
+        {
+          return false;
+        }
+        loop.push_back (i);
+        i = it->second;
+        edges.erase (it);
+      } while (i != loop.front ());
+
+      if (loop.size () < 3)
+      {
+        return false;
+      }
+      loops.push_back (std::move (loop));
+    }
+    return true;
+  }
+
+  glm::vec3 loopCenter (const DynamicMesh& mesh, const BorderLoop& loop)
+  {
+    glm::vec3 center (0.0f);
+    for (unsigned int i : loop)
+    {
+      center += mesh.vertex (i);
+    }
+    return center / float(loop.size ());
+  }
+
+  // Pairs each loop of `loops1` with the loop of `loops2` with the closest center. Fails if the
+  // pairing is not one-to-one.
+  bool pairLoops (const DynamicMesh& mesh1, const std::vector<BorderLoop>& loops1,
+                  const DynamicMesh& mesh2, const std::vector<BorderLoop>& loops2,
+                  std::vector<unsigned int>& pairs)
+  {
+    if (loops1.size () != loops2.size ())
+    {
+      return false;
+    }
+
+    std::vector<bool> isPaired (loops2.size (), false);
+    for (const BorderLoop& loop1 : loops1)
+    {
+      const glm::vec3 center1 = loopCenter (mesh1, loop1);
+      unsigned int    closest = 0;
+      float           minDistance = Util::maxFloat ();
+
+      for (unsigned int j = 0; j < loops2.size (); j++)
+      {
+        const float d = glm::distance2 (center1, loopCenter (mesh2, loops2[j]));
+        if (d < minDistance)
+        {
+          minDistance = d;
+          closest = j;
+        }
+      }
+      if (isPaired[closest])
+      {
+        return false;
+      }
+      isPaired[closest] = true;
+      pairs.push_back (closest);
+    }
+    return true;
+  }
+
+  // Triangulates the band between the border loop of a hole of `mesh` and the border loop of a
+  // patch that fills it. Both loops are given in the orientation of their faces: they run in
+  // opposite directions, so the patch's loop is traversed backwards. At each step, the side
+  // whose new diagonal is shorter advances.
+  void stitch (DynamicMesh& mesh, const BorderLoop& hole, const BorderLoop& patch,
+               DynamicFaces& faces)
+  {
+    const unsigned int nH = hole.size ();
+    const unsigned int nP = patch.size ();
+
+    const auto h = [&hole, nH](unsigned int i) { return hole[i % nH]; };
+    const auto p = [&patch, nP](unsigned int j) { return patch[(nP - (j % nP)) % nP]; };
+
+    unsigned int offset = 0;
+    float        minDistance = Util::maxFloat ();
+
+    for (unsigned int j = 0; j < nP; j++)
+    {
+      const float d = glm::distance2 (mesh.vertex (h (0)), mesh.vertex (p (j)));
+      if (d < minDistance)
+      {
+        minDistance = d;
+        offset = j;
+      }
+    }
+
+    for (unsigned int i = 0, j = 0; i < nH || j < nP;)
+    {
+      const bool advanceHole =
+        j == nP ||
+        (i < nH && glm::distance2 (mesh.vertex (h (i + 1)), mesh.vertex (p (offset + j))) <
+                     glm::distance2 (mesh.vertex (h (i)), mesh.vertex (p (offset + j + 1))));
+
+      if (advanceHole)
+      {
+        faces.insert (mesh.addFace (h (i + 1), h (i), p (offset + j)));
+        i++;
+      }
+      else
+      {
+        faces.insert (mesh.addFace (p (offset + j), p (offset + j + 1), h (i)));
+        j++;
+      }
+    }
+  }
+
+  PrimSphere elementSphere (const SketchBvh::Element& element, const SketchPaths& paths)
+  {
+    assert (element.type != SketchBvh::ElementType::Bone);
+
+    if (element.type == SketchBvh::ElementType::Node)
+    {
+      return element.node->data ();
+    }
+    else
+    {
+      return paths.at (element.path).spheres ().at (element.sphere);
+    }
+  }
+
+  // Non-root nodes are covered by the bones to their parents
+  float elementDistance (const SketchBvh::Element& element, const SketchPaths& paths,
+                         const glm::vec3& pos)
+  {
+    switch (element.type)
+    {
+      case SketchBvh::ElementType::Node:
+        return element.node->parent () ? Util::maxFloat ()
+                                       : Distance::distance (element.node->data (), pos);
+      case SketchBvh::ElementType::Bone:
+        return Distance::distance (
+          PrimConeSphere (element.node->data (), element.node->parent ()->data ()), pos);
+      case SketchBvh::ElementType::Sphere:
+        return Distance::distance (elementSphere (element, paths), pos);
+    }
+    DILAY_IMPOSSIBLE
+  }
+
+  float elementRadius (const SketchBvh::Element& element, const SketchPaths& paths)
+  {
+    if (element.type == SketchBvh::ElementType::Bone)
+    {
+      return glm::min (element.node->data ().radius (), element.node->parent ()->data ().radius ());
+    }
+    else
+    {
+      return elementSphere (element, paths).radius ();
+    }
+  }
+
+  // Polynomial smooth minimum: equals `glm::min (a, b)` if both differ by at least `k`
+  float smoothMin (float a, float b, float k)
+  {
+    const float h = glm::max (k - glm::abs (a - b), 0.0f) / k;
+    return glm::min (a, b) - (h * h * k * 0.25f);
+  }
+
+  // Signed distances to regions of localized remeshes are negative within the region
+  float regionDistance (const PrimSphere& sphere, const glm::vec3& pos)
+  {
+    return glm::distance (pos, sphere.center ()) - sphere.radius ();
+  }
+
+  float regionDistance (const PrimAABox& box, const glm::vec3& pos)
+  {
+    const glm::vec3 d = glm::abs (pos - box.center ()) - box.halfWidth ();
+
+    return glm::length (glm::max (d, glm::vec3 (0.0f))) +
+           glm::min (glm::max (glm::max (d.x, d.y), d.z), 0.0f);
+  }
+
+  PrimAABox regionBounds (const PrimSphere& sphere)
+  {
+    return PrimAABox (sphere.center (), 2.0f * sphere.radius ());
+  }
+
+  PrimAABox regionBounds (const PrimAABox& box) { return box; }
+
+  // Rays starting within a region hit its surface when leaving it
+  void intersectsRegion (const PrimRay& ray, const PrimSphere& sphere, Intersection& intersection)
+  {
+    float t;
+    if (IntersectionUtil::intersects (ray, sphere, &t))
+    {
+      const glm::vec3 position = ray.pointAt (t);
+      intersection.update (t, position, glm::normalize (position - sphere.center ()));
+    }
+  }
+
+  void intersectsRegion (const PrimRay& ray, const PrimAABox& box, Intersection& intersection)
+  {
+    float        tMin = Util::minFloat ();
+    float        tMax = Util::maxFloat ();
+    unsigned int minAxis = 0;
+    unsigned int maxAxis = 0;
+
+    for (unsigned int a = 0; a < 3; a++)
+    {
+      const float origin = ray.origin ()[a];
+      const float direction = ray.direction ()[a];
+
+      if (direction == 0.0f)
+      {
+        if (origin < box.minimum ()[a] || origin > box.maximum ()[a])
+        {
+          return;
+        }
+      }
+      else
+      {
+        const float t1 = (box.minimum ()[a] - origin) / direction;
+        const float t2 = (box.maximum ()[a] - origin) / direction;
+
+        if (glm::min (t1, t2) > tMin)
+        {
+          tMin = glm::min (t1, t2);
+          minAxis = a;
+        }
+        if (glm::max (t1, t2) < tMax)
+        {
+          tMax = glm::max (t1, t2);
+          maxAxis = a;
+        }
+      }
+    }
+
+    if (tMin <= tMax && tMax >= 0.0f)
+    {
+      const bool         enters = tMin >= 0.0f;
+      const unsigned int axis = enters ? minAxis : maxAxis;
+      const float        t = enters ? tMin : tMax;
+      glm::vec3          normal (0.0f);
+
+      normal[axis] = (ray.direction ()[axis] > 0.0f) == enters ? -1.0f : 1.0f;
+      intersection.update (t, ray.pointAt (t), normal);
+    }
+  }
+
+  // Replaces the part of a mesh within a sphere or a box (see `Remesh::remesh`)
+  template <typename T>
+  bool remeshRegion (DynamicMesh& mesh, const T& region, float resolution, DynamicFaces& newFaces)
+  {
+    // The part of the mesh within the region is extracted as a closed surface, i.e., as the
+    // intersection of the mesh and the region
+    const IsosurfaceExtraction::IntersectionCallback getIntersection =
+      [&mesh, &region](const PrimRay& ray, Intersection& intersection) {
+        std::vector<Intersection> nearest (2);
+
+        mesh.intersects (ray, nearest[0], true);
+        intersectsRegion (ray, region, nearest[1]);
+
+        return sampleNearest (Remesh::Operation::Intersection, nearest, ray, intersection);
+      };
+
+    const IsosurfaceExtraction::DistanceCallback getDistance = [&mesh,
+                                                                &region](const glm::vec3& pos) {
+      return glm::min (mesh.unsignedDistance (pos), glm::abs (regionDistance (region, pos)));
+    };
+
+    const PrimAABox bounds = regionBounds (region);
+    const glm::vec3 margin (2.0f * resolution);
+    DynamicMesh     extractedMesh;
+
+    IsosurfaceExtraction::extract (getDistance, getIntersection,
+                                   PrimAABox (bounds.minimum () - margin,
+                                              bounds.maximum () + margin),
+                                   resolution, extractedMesh);
+
+    // The patch omits the region's surface and keeps a distance of `resolution` to it
+    std::unordered_set<unsigned int> patchFaces;
+
+    extractedMesh.forEachFace ([&extractedMesh, &region, resolution, &patchFaces](unsigned int f) {
+      unsigned int i1, i2, i3;
+      extractedMesh.vertexIndices (f, i1, i2, i3);
+
+      if (regionDistance (region, extractedMesh.vertex (i1)) < -resolution &&
+          regionDistance (region, extractedMesh.vertex (i2)) < -resolution &&
+          regionDistance (region, extractedMesh.vertex (i3)) < -resolution)
+      {
+        patchFaces.insert (f);
+      }
+    });
+
+    // Vertices of the mesh within the region are deleted along with their faces
+    std::unordered_set<unsigned int> vertices;
+    std::unordered_set<unsigned int> faces;
+    DynamicFaces                     regionFaces;
+
+    mesh.intersects (region, regionFaces);
+    for (unsigned int f : regionFaces)
+    {
+      forEachEdge (mesh, f, [&mesh, &region, &vertices](unsigned int i, unsigned int) {
+        if (regionDistance (region, mesh.vertex (i)) < 0.0f)
+        {
+          vertices.insert (i);
+        }
+      });
+    }
+    for (unsigned int i : vertices)
+    {
+      faces.insert (mesh.adjacentFaces (i).begin (), mesh.adjacentFaces (i).end ());
+    }
+
+    if (faces.empty () || patchFaces.empty ())
+    {
+      return false;
+    }
+
+    BorderEdges                      holeEdges, patchEdges;
+    std::unordered_set<unsigned int> holeTargets, patchTargets;
+    bool                             isManifold = true;
+
+    for (unsigned int f : faces)
+    {
+      forEachEdge (mesh, f, [&](unsigned int i1, unsigned int i2) {
+        const unsigned int o = oppositeFace (mesh, f, i1, i2);
+
+        if (o != Util::invalidIndex () && faces.count (o) == 0)
+        {
+          isManifold = addBorderEdge (i2, i1, holeEdges, holeTargets) && isManifold;
+        }
+      });
+    }
+    for (unsigned int f : patchFaces)
+    {
+      forEachEdge (extractedMesh, f, [&](unsigned int i1, unsigned int i2) {
+        const unsigned int o = oppositeFace (extractedMesh, f, i1, i2);
+
+        if (o == Util::invalidIndex () || patchFaces.count (o) == 0)
+        {
+          isManifold = addBorderEdge (i1, i2, patchEdges, patchTargets) && isManifold;
+        }
+      });
+    }
+
+    std::vector<BorderLoop>   holeLoops, patchLoops;
+    std::vector<unsigned int> pairs;
+
+    if (isManifold == false || borderLoops (holeEdges, holeLoops) == false ||
+        borderLoops (patchEdges, patchLoops) == false ||
+        pairLoops (mesh, holeLoops, extractedMesh, patchLoops, pairs) == false)
+    {
+      return false;
+    }
+
+    // Vertices whose faces are all deleted are not part of any border and are deleted as well
+    for (unsigned int f : faces)
+    {
+      forEachEdge (mesh, f, [&mesh, &faces, &vertices](unsigned int i, unsigned int) {
+        const std::vector<unsigned int>& adjacent = mesh.adjacentFaces (i);
+
+        if (std::all_of (adjacent.begin (), adjacent.end (),
+                         [&faces](unsigned int a) { return faces.count (a) > 0; }))
+        {
+          vertices.insert (i);
+        }
+      });
+    }
+    for (unsigned int i : vertices)
+    {
+      mesh.deleteVertex (i);
+    }
+
+    std::unordered_map<unsigned int, unsigned int> newIndices;
+    const auto newIndex = [&mesh, &extractedMesh, &newIndices](unsigned int i) {
+      const auto it = newIndices.find (i);
+
+      if (it == newIndices.end ())
+      {
+        const unsigned int n =
+          mesh.addVertex (extractedMesh.vertex (i), extractedMesh.vertexNormal (i));
+
+        newIndices.emplace (i, n);
+        return n;
+      }
+      return it->second;
+    };
+
+    for (unsigned int f : patchFaces)
+    {
+      unsigned int i1, i2, i3;
+      extractedMesh.vertexIndices (f, i1, i2, i3);
+      newFaces.insert (mesh.addFace (newIndex (i1), newIndex (i2), newIndex (i3)));
+    }
+
+    for (unsigned int l = 0; l < holeLoops.size (); l++)
+    {
+      BorderLoop patchLoop;
+      for (unsigned int i : patchLoops[pairs[l]])
+      {
+        patchLoop.push_back (newIndex (i));
+      }
+      stitch (mesh, holeLoops[l], patchLoop, newFaces);
+
+      for (unsigned int i : holeLoops[l])
+      {
+        mesh.setVertexNormal (i);
+      }
+    }
+    newFaces.commit ();
+    return true;
+  }
+}
+
+namespace Remesh
+{
+  void remesh (DynamicMesh& mesh, float resolution, DynamicMesh& extractedMesh)
+  {
+    const IsosurfaceExtraction::IntersectionCallback getIntersection =
+      [&mesh](const PrimRay& ray, Intersection& intersection) {
+        if (mesh.intersects (ray, intersection, true))
+        {
+          return Sampling::Sample;
+        }
+        else
+        {
+          return Sampling::None;
+        }
+      };
+
+    const IsosurfaceExtraction::DistanceCallback getDistance = [&mesh](const glm::vec3& pos) {
+      return mesh.unsignedDistance (pos);
+    };
+
+    IsosurfaceExtraction::extract (getDistance, getIntersection, mesh.mesh ().bounds (),
+                                   resolution, extractedMesh);
+  }
+
+  void remesh (const std::vector<DynamicMesh*>& meshes, Operation operation, float resolution,
+               DynamicMesh& extractedMesh)
+  {
+    assert (meshes.empty () == false);
+
+    const Operands operands (operation, meshes);
+
+    const IsosurfaceExtraction::IntersectionCallback getIntersection =
+      [&operands](const PrimRay& ray, Intersection& intersection) {
+        return operands.intersects (ray, intersection);
+      };
+
+    const IsosurfaceExtraction::DistanceCallback getDistance = [&operands](const glm::vec3& pos) {
+      return operands.distance (pos);
+    };
+
+    glm::vec3 min (Util::maxFloat ());
+    glm::vec3 max (Util::minFloat ());
+
+    for (const DynamicMesh* mesh : meshes)
+    {
+      const PrimAABox bounds = mesh->mesh ().bounds ();
+
+      min = glm::min (min, bounds.minimum ());
+      max = glm::max (max, bounds.maximum ());
+    }
+
+    IsosurfaceExtraction::extract (getDistance, getIntersection, PrimAABox (min, max), resolution,
+                                   extractedMesh);
+  }
+
+  bool remesh (DynamicMesh& mesh, const PrimSphere& region, float resolution,
+               DynamicFaces& newFaces)
+  {
+    return remeshRegion (mesh, region, resolution, newFaces);
+  }
+
+  bool remesh (DynamicMesh& mesh, const PrimAABox& region, float resolution,
+               DynamicFaces& newFaces)
+  {
+    return remeshRegion (mesh, region, resolution, newFaces);
+  }
+
+  void convert (SketchMesh& sketch, float resolution, DynamicMesh& extractedMesh)
+  {
+    sketch.optimizePaths ();
+
+    glm::vec3 min, max;
+    sketch.minMax (min, max);
+
+    const SketchBvh&   bvh = sketch.bvh ();
+    const SketchPaths& paths = sketch.paths ();
+
+    const IsosurfaceExtraction::BrickDistanceCallback getDistance =
+      [&bvh, &paths](const PrimAABox& brick) -> IsosurfaceExtraction::DistanceCallback {
+      const glm::vec3 center = brick.center ();
+      const float     centerDistance =
+        bvh.distance (center, [&paths, &center](const SketchBvh::Element& e) {
+          return elementDistance (e, paths, center);
+        });
+
+      if (centerDistance == Util::maxFloat ())
+      {
+        return [](const glm::vec3&) { return Util::maxFloat (); };
+      }
+
+      // Distances change by at most `radius` within the brick, so elements that are farther
+      // from the center than `maxDistance` never contribute to the minimum
+      const float radius = glm::length (brick.halfWidth ());
+      const float maxDistance = centerDistance + (2.0f * radius);
+
+      std::vector<PrimSphere>     spheres;
+      std::vector<PrimConeSphere> coneSpheres;
+
+      bvh.intersects (PrimSphere (center, glm::max (maxDistance, 0.0f)),
+                      [&paths, &center, maxDistance, &spheres,
+                       &coneSpheres](const SketchBvh::Element& e) {
+                        if (elementDistance (e, paths, center) <= maxDistance)
+                        {
+                          if (e.type == SketchBvh::ElementType::Bone)
+                          {
+                            coneSpheres.emplace_back (e.node->data (), e.node->parent ()->data ());
+                          }
+                          else
+                          {
+                            spheres.push_back (elementSphere (e, paths));
+                          }
+                        }
+                      });
+
+      return [spheres, coneSpheres](const glm::vec3& pos) {
+        float distance = Util::maxFloat ();
+
+        for (const PrimSphere& s : spheres)
+        {
+          distance = glm::min (distance, Distance::distance (s, pos));
+        }
+        for (const PrimConeSphere& c : coneSpheres)
+        {
+          distance = glm::min (distance, Distance::distance (c, pos));
+        }
+        return distance;
+      };
+    };
+
+    IsosurfaceExtraction::extract (getDistance, PrimAABox (min, max), resolution, extractedMesh);
+  }
+
+  void convertAdaptive (SketchMesh& sketch, float resolution, float blendRadius,
+                        DynamicMesh& extractedMesh)
+  {
+    // Cells around a primitive are at most a quarter of its radius wide
+    static const float resolutionPerRadius = 0.25f;
+
+    sketch.optimizePaths ();
+
+    glm::vec3 min, max;
+    sketch.minMax (min, max);
+
+    const SketchBvh&   bvh = sketch.bvh ();
+    const SketchPaths& paths = sketch.paths ();
+
+    const IsosurfaceExtraction::DistanceCallback getDistance =
+      [&bvh, &paths, blendRadius](const glm::vec3& pos) {
+        const float distance =
+          bvh.distance (pos, [&paths, &pos](const SketchBvh::Element& e) {
+            return elementDistance (e, paths, pos);
+          });
+
+        if (blendRadius <= 0.0f || distance == Util::maxFloat ())
+        {
+          return distance;
+        }
+
+        // Only elements within `blendRadius` of the closest one contribute to the smooth union
+        const float maxDistance = distance + blendRadius;
+        float       blended = Util::maxFloat ();
+
+        bvh.intersects (PrimSphere (pos, glm::max (maxDistance, 0.0f)),
+                        [&paths, &pos, maxDistance, blendRadius,
+                         &blended](const SketchBvh::Element& e) {
+                          const float d = elementDistance (e, paths, pos);
+
+                          if (d < maxDistance)
+                          {
+                            blended = smoothMin (blended, d, blendRadius);
+                          }
+                        });
+        return glm::min (blended, distance);
+      };
+
+    const IsosurfaceExtraction::ResolutionCallback getResolution =
+      [&bvh, &paths, resolution](const glm::vec3& pos) {
+        float minDistance = Util::maxFloat ();
+        float radius = 0.0f;
+
+        bvh.distance (pos, [&paths, &pos, &minDistance, &radius](const SketchBvh::Element& e) {
+          const float d = elementDistance (e, paths, pos);
+
+          if (d < minDistance)
+          {
+            minDistance = d;
+            radius = elementRadius (e, paths);
+          }
+          return d;
+        });
+        return glm::max (resolution, radius * resolutionPerRadius);
+      };
+
+    IsosurfaceExtraction::extractAdaptive (getDistance, getResolution,
+                                           PrimAABox (min - glm::vec3 (blendRadius),
+                                                      max + glm::vec3 (blendRadius)),
+                                           resolution, extractedMesh);
+  }
+}
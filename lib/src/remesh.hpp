@@ -0,0 +1,48 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_REMESH
+#define DILAY_REMESH
+
+#include <vector>
+
+class DynamicFaces;
+class DynamicMesh;
+class PrimAABox;
+class PrimSphere;
+class SketchMesh;
+
+// Isosurface extraction of meshes and sketches, independent of any scene or rendering context.
+// Extracted meshes are written to the last argument and are not smoothed.
+namespace Remesh
+{
+  enum class Operation
+  {
+    Union,
+    Difference,
+    Intersection
+  };
+
+  void remesh (DynamicMesh&, float, DynamicMesh&);
+
+  // Combines any number of meshes in a single pass. Differences subtract all other meshes from
+  // the first one.
+  void remesh (const std::vector<DynamicMesh*>&, Operation, float, DynamicMesh&);
+
+  // Replaces the part of a mesh within a sphere or a box by an extracted patch, which is stitched
+  // to the remaining surface. Only the region is sampled. The new faces are added to the last
+  // argument. Fails without changing the mesh if the borders of the hole and the patch do not
+  // match.
+  bool remesh (DynamicMesh&, const PrimSphere&, float, DynamicFaces&);
+  bool remesh (DynamicMesh&, const PrimAABox&, float, DynamicFaces&);
+
+  void convert (SketchMesh&, float, DynamicMesh&);
+
+  // Evaluates the sketch's distance analytically and samples adaptively: cells follow the radius
+  // of the closest primitive down to the given resolution. Primitives are blended by a smooth
+  // union of the given radius, which is disabled by a radius of zero.
+  void convertAdaptive (SketchMesh&, float, float, DynamicMesh&);
+};
+
+#endif
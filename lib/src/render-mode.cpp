@@ -13,6 +13,7 @@ RenderMode::RenderMode ()
   this->renderWireframe (false);
   this->cameraRotationOnly (false);
   this->noDepthTest (false);
+  this->instancing (false);
 }
 
 RenderMode::RenderMode (const RenderMode& other)
@@ -32,9 +33,28 @@ bool RenderMode::cameraRotationOnly () const { return this->flags.get<4> (); }
 
 bool RenderMode::noDepthTest () const { return this->flags.get<5> (); }
 
+bool RenderMode::instancing () const { return this->flags.get<6> (); }
+
 const char* RenderMode::vertexShader () const
 {
-  if (this->smoothShading ())
+  if (this->instancing ())
+  {
+    assert (this->renderWireframe () == false);
+
+    if (this->smoothShading ())
+    {
+      return Shader::sphereInstanceVertexShader ();
+    }
+    else if (this->flatShading ())
+    {
+      return Shader::boneInstanceVertexShader ();
+    }
+    else
+    {
+      DILAY_IMPOSSIBLE
+    }
+  }
+  else if (this->smoothShading ())
   {
     return Shader::smoothVertexShader ();
   }
@@ -110,3 +130,5 @@ void RenderMode::renderWireframe (bool v) { this->flags.set<3> (v); }
 void RenderMode::cameraRotationOnly (bool v) { this->flags.set<4> (v); }
 
 void RenderMode::noDepthTest (bool v) { this->flags.set<5> (v); }
+
+void RenderMode::instancing (bool v) { this->flags.set<6> (v); }
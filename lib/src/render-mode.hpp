@@ -19,6 +19,7 @@ public:
   bool        renderWireframe () const;
   bool        cameraRotationOnly () const;
   bool        noDepthTest () const;
+  bool        instancing () const;
   const char* vertexShader () const;
   const char* fragmentShader () const;
 
@@ -29,6 +30,10 @@ public:
   void cameraRotationOnly (bool);
   void noDepthTest (bool);
 
+  // Instanced smooth shading renders spheres, instanced flat shading renders bones (cf.
+  // `SketchInstances`)
+  void instancing (bool);
+
 private:
   Bitset<unsigned int> flags;
 };
@@ -71,7 +71,7 @@ namespace
 
 struct Renderer::Impl
 {
-  static const unsigned int numShaders = 6;
+  static const unsigned int numShaders = 8;
 
   ShaderIds      shaderIds[Impl::numShaders];
   ShaderIds*     activeShaderIndex;
@@ -113,7 +113,14 @@ struct Renderer::Impl
 
   unsigned int shaderIndex (const RenderMode& renderMode)
   {
-    if (renderMode.smoothShading ())
+    if (renderMode.instancing ())
+    {
+      assert (renderMode.renderWireframe () == false);
+      assert (renderMode.constantShading () == false);
+
+      return renderMode.smoothShading () ? 6 : 7;
+    }
+    else if (renderMode.smoothShading ())
     {
       return renderMode.renderWireframe () ? 0 : 1;
     }
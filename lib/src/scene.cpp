@@ -2,7 +2,12 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
+#include <atomic>
 #include <list>
+#include <memory>
+#include <thread>
+#include <vector>
 #include "config.hpp"
 #include "dynamic/mesh-intersection.hpp"
 #include "dynamic/mesh.hpp"
@@ -17,16 +22,72 @@
 #include "sketch/path-intersection.hpp"
 #include "util.hpp"
 
+namespace
+{
+  // Runs materialization tasks of deferred meshes on a background thread.  Tasks only share
+  // pending topologies with their meshes, so meshes may be edited or deleted meanwhile.
+  struct Materializer
+  {
+    std::unique_ptr<std::atomic<bool>> isStopped;
+    std::thread                        thread;
+
+    Materializer ()
+      : isStopped (new std::atomic<bool> (false))
+    {
+    }
+
+    Materializer (Materializer&&) = default;
+
+    ~Materializer () { this->stop (); }
+
+    void stop ()
+    {
+      if (this->thread.joinable ())
+      {
+        *this->isStopped = true;
+        this->thread.join ();
+        *this->isStopped = false;
+      }
+    }
+
+    void start (std::vector<std::function<void()>>&& tasks)
+    {
+      this->stop ();
+
+      if (tasks.empty () == false)
+      {
+        std::atomic<bool>* stopped = this->isStopped.get ();
+
+        this->thread = std::thread ([stopped, tasks]() {
+          for (const std::function<void()>& task : tasks)
+          {
+            if (*stopped)
+            {
+              return;
+            }
+            task ();
+          }
+        });
+      }
+    }
+  };
+}
+
 struct Scene::Impl
 {
   Scene*                 self;
   std::list<DynamicMesh> dynamicMeshes;
   std::list<SketchMesh>  sketchMeshes;
   RenderMode             commonRenderMode;
+  bool                   renderSketchPreviews;
   std::string            fileName;
+  unsigned int           nextDynamicMeshId;
+  Materializer           materializer;
 
   Impl (Scene* s, const Config& config)
     : self (s)
+    , renderSketchPreviews (false)
+    , nextDynamicMeshId (0)
   {
     this->runFromConfig (config);
 
@@ -36,6 +97,7 @@ struct Scene::Impl
   DynamicMesh& newDynamicMesh (const Config& config, const DynamicMesh& other)
   {
     this->dynamicMeshes.emplace_back (other);
+    this->dynamicMeshes.back ().id (this->nextDynamicMeshId++);
     this->setupMesh (config, this->dynamicMeshes.back ());
     return this->dynamicMeshes.back ();
   }
@@ -43,10 +105,73 @@ struct Scene::Impl
   DynamicMesh& newDynamicMesh (const Config& config, const Mesh& mesh)
   {
     this->dynamicMeshes.emplace_back (mesh);
+    this->dynamicMeshes.back ().id (this->nextDynamicMeshId++);
+    this->setupMesh (config, this->dynamicMeshes.back ());
+    return this->dynamicMeshes.back ();
+  }
+
+  DynamicMesh& newDeferredDynamicMesh (const Config& config, const Mesh& mesh)
+  {
+    this->dynamicMeshes.emplace_back ();
+    this->dynamicMeshes.back ().fromMeshDeferred (mesh);
+    this->dynamicMeshes.back ().id (this->nextDynamicMeshId++);
     this->setupMesh (config, this->dynamicMeshes.back ());
     return this->dynamicMeshes.back ();
   }
 
+  void materializeInBackground ()
+  {
+    std::vector<std::function<void()>> tasks;
+    for (const DynamicMesh& mesh : this->dynamicMeshes)
+    {
+      std::function<void()> task = mesh.materializationTask ();
+      if (task)
+      {
+        tasks.push_back (std::move (task));
+      }
+    }
+    this->materializer.start (std::move (tasks));
+  }
+
+  std::list<DynamicMesh>::iterator findDynamicMesh (unsigned int id)
+  {
+    return std::find_if (this->dynamicMeshes.begin (), this->dynamicMeshes.end (),
+                         [id](const DynamicMesh& m) { return m.id () == id; });
+  }
+
+  DynamicMesh* dynamicMesh (unsigned int id)
+  {
+    auto it = this->findDynamicMesh (id);
+    return it == this->dynamicMeshes.end () ? nullptr : &*it;
+  }
+
+  template <typename T>
+  DynamicMesh& restoreDynamicMeshT (const Config& config, const T& mesh, unsigned int id)
+  {
+    assert (id < this->nextDynamicMeshId);
+
+    auto it = this->findDynamicMesh (id);
+    auto restored = this->dynamicMeshes.emplace (it, mesh);
+
+    if (it != this->dynamicMeshes.end ())
+    {
+      this->dynamicMeshes.erase (it);
+    }
+    restored->id (id);
+    this->setupMesh (config, *restored);
+    return *restored;
+  }
+
+  DynamicMesh& restoreDynamicMesh (const Config& config, const DynamicMesh& mesh)
+  {
+    return this->restoreDynamicMeshT (config, mesh, mesh.id ());
+  }
+
+  DynamicMesh& restoreDynamicMesh (const Config& config, const Mesh& mesh, unsigned int id)
+  {
+    return this->restoreDynamicMeshT (config, mesh, id);
+  }
+
   SketchMesh& newSketchMesh (const Config& config, const SketchMesh& other)
   {
     this->sketchMeshes.emplace_back (other);
@@ -72,6 +197,7 @@ struct Scene::Impl
   void setupMesh (const Config& config, SketchMesh& mesh)
   {
     mesh.renderWireframe (this->commonRenderMode.renderWireframe ());
+    mesh.renderPreview (this->renderSketchPreviews);
     mesh.fromConfig (config);
   }
 
@@ -250,6 +376,7 @@ struct Scene::Impl
 
   void reset ()
   {
+    this->materializer.stop ();
     this->deleteDynamicMeshes ();
     this->deleteSketchMeshes ();
     this->fileName.clear ();
@@ -281,6 +408,14 @@ struct Scene::Impl
 
   void toggleWireframe () { this->renderWireframe (!this->commonRenderMode.renderWireframe ()); }
 
+  bool previewSketches () const { return this->renderSketchPreviews; }
+
+  void previewSketches (bool value)
+  {
+    this->renderSketchPreviews = value;
+    this->forEachMesh ([value](SketchMesh& mesh) { mesh.renderPreview (value); });
+  }
+
   void toggleShading ()
   {
     if (this->commonRenderMode.smoothShading ())
@@ -332,11 +467,12 @@ struct Scene::Impl
     return this->toDlyFile (isObjFile);
   }
 
-  bool fromDlyFile (const Config& config, const std::string& newFileName)
+  bool fromDlyFile (const Config& config, const std::string& newFileName,
+                    const std::function<bool(float)>& progress)
   {
     this->fileName = newFileName;
 
-    if (ImportExport::fromDlyFile (this->fileName, config, *this->self))
+    if (ImportExport::fromDlyFile (this->fileName, config, *this->self, progress))
     {
       return true;
     }
@@ -358,6 +494,11 @@ DELEGATE1_BIG3_SELF (Scene, const Config&)
 
 DELEGATE2 (DynamicMesh&, Scene, newDynamicMesh, const Config&, const DynamicMesh&)
 DELEGATE2 (DynamicMesh&, Scene, newDynamicMesh, const Config&, const Mesh&)
+DELEGATE2 (DynamicMesh&, Scene, newDeferredDynamicMesh, const Config&, const Mesh&)
+DELEGATE (void, Scene, materializeInBackground)
+DELEGATE1 (DynamicMesh*, Scene, dynamicMesh, unsigned int)
+DELEGATE2 (DynamicMesh&, Scene, restoreDynamicMesh, const Config&, const DynamicMesh&)
+DELEGATE3 (DynamicMesh&, Scene, restoreDynamicMesh, const Config&, const Mesh&, unsigned int)
 DELEGATE2 (SketchMesh&, Scene, newSketchMesh, const Config&, const SketchMesh&)
 DELEGATE2 (SketchMesh&, Scene, newSketchMesh, const Config&, const SketchTree&)
 DELEGATE2 (void, Scene, setupMesh, const Config&, DynamicMesh&)
@@ -386,6 +527,8 @@ GETTER_CONST (const RenderMode&, Scene, commonRenderMode)
 DELEGATE_CONST (bool, Scene, renderWireframe)
 DELEGATE1 (void, Scene, renderWireframe, bool)
 DELEGATE (void, Scene, toggleWireframe)
+DELEGATE_CONST (bool, Scene, previewSketches)
+DELEGATE1 (void, Scene, previewSketches, bool)
 DELEGATE (void, Scene, toggleShading)
 DELEGATE_CONST (bool, Scene, isEmpty)
 DELEGATE_CONST (unsigned int, Scene, numDynamicMeshes)
@@ -395,5 +538,6 @@ DELEGATE_CONST (bool, Scene, hasFileName)
 GETTER_CONST (const std::string&, Scene, fileName)
 DELEGATE1 (bool, Scene, toDlyFile, bool)
 DELEGATE2 (bool, Scene, toDlyFile, const std::string&, bool)
-DELEGATE2 (bool, Scene, fromDlyFile, const Config&, const std::string&)
+DELEGATE3 (bool, Scene, fromDlyFile, const Config&, const std::string&,
+           const std::function<bool(float)>&)
 DELEGATE1 (void, Scene, runFromConfig, const Config&)
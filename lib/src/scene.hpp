@@ -5,6 +5,7 @@
 #ifndef DILAY_SCENE
 #define DILAY_SCENE
 
+#include <functional>
 #include <string>
 #include "configurable.hpp"
 #include "macro.hpp"
@@ -25,6 +26,11 @@ public:
 
   DynamicMesh& newDynamicMesh (const Config&, const DynamicMesh&);
   DynamicMesh& newDynamicMesh (const Config&, const Mesh&);
+  DynamicMesh& newDeferredDynamicMesh (const Config&, const Mesh&);
+  void         materializeInBackground ();
+  DynamicMesh* dynamicMesh (unsigned int);
+  DynamicMesh& restoreDynamicMesh (const Config&, const DynamicMesh&);
+  DynamicMesh& restoreDynamicMesh (const Config&, const Mesh&, unsigned int);
   SketchMesh&  newSketchMesh (const Config&, const SketchMesh&);
   SketchMesh&  newSketchMesh (const Config&, const SketchTree&);
   void         setupMesh (const Config&, DynamicMesh&);
@@ -53,6 +59,8 @@ public:
   bool               renderWireframe () const;
   void               renderWireframe (bool);
   void               toggleWireframe ();
+  bool               previewSketches () const;
+  void               previewSketches (bool);
   void               toggleShading ();
   bool               isEmpty () const;
   unsigned int       numDynamicMeshes () const;
@@ -62,7 +70,8 @@ public:
   const std::string& fileName () const;
   bool               toDlyFile (bool);
   bool               toDlyFile (const std::string&, bool);
-  bool               fromDlyFile (const Config&, const std::string&);
+  bool               fromDlyFile (const Config&, const std::string&,
+                                  const std::function<bool(float)>& = nullptr);
 
 private:
   IMPLEMENTATION
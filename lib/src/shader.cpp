@@ -115,6 +115,59 @@
   "\n" FINAL                                                                                   \
   "}                                                                                       \n"
 
+#define SPHERE_INSTANCE_VERTEX_SHADER                                                          \
+  "#version 120                                                                            \n" \
+  "                                                                                        \n" \
+  "uniform   mat4  view;                                                                   \n" \
+  "uniform   mat4  projection;                                                             \n" \
+  "attribute vec3  position;                                                               \n" \
+  "attribute vec3  normal;                                                                 \n" \
+  "attribute vec4  instance1;                                                              \n" \
+  "uniform   vec3  color;                                                                  \n" \
+  "uniform   vec3  light1Direction;                                                        \n" \
+  "uniform   vec3  light1Color;                                                            \n" \
+  "uniform   float light1Irradiance;                                                       \n" \
+  "uniform   vec3  light2Direction;                                                        \n" \
+  "uniform   vec3  light2Color;                                                            \n" \
+  "uniform   float light2Irradiance;                                                       \n" \
+  "                                                                                        \n" \
+  "varying vec3 vsColor;                                                                   \n" \
+  "                                                                                        \n" \
+  "void main () {                                                                          \n" \
+  "  vec3  world      = instance1.xyz + (instance1.w * position);                          \n" \
+  "  gl_Position      = (projection * view) * vec4 (world, 1.0);                           \n" \
+  "  vec3  viewNormal = vec3 (view * vec4 (normalize (normal), 0.0));                      \n" \
+  "  float light1Diff = max (0.0, dot (-light1Direction, viewNormal));                     \n" \
+  "  float light2Diff = max (0.0, dot (-light2Direction, viewNormal));                     \n" \
+  "  vec3  light1     = light1Irradiance * light1Color * light1Diff;                       \n" \
+  "  vec3  light2     = light2Irradiance * light2Color * light2Diff;                       \n" \
+  "        vsColor    = color * (light1 + light2);                                         \n" \
+  "}                                                                                       \n"
+
+#define BONE_INSTANCE_VERTEX_SHADER                                                            \
+  "#version 120                                                                            \n" \
+  "                                                                                        \n" \
+  "uniform   mat4 view;                                                                    \n" \
+  "uniform   mat4 projection;                                                              \n" \
+  "attribute vec3 position;                                                                \n" \
+  "attribute vec4 instance1;                                                               \n" \
+  "attribute vec4 instance2;                                                               \n" \
+  "                                                                                        \n" \
+  "varying vec3 vsColor;                                                                   \n" \
+  "                                                                                        \n" \
+  "void main () {                                                                          \n" \
+  "  vec3 axis   = instance1.xyz - instance2.xyz;                                          \n" \
+  "  vec3 dir    = normalize (axis);                                                       \n" \
+  "  vec3 helper = abs (dir.y) < 0.99 ? vec3 (0.0, 1.0, 0.0) : vec3 (1.0, 0.0, 0.0);       \n" \
+  "  vec3 u      = normalize (cross (dir, helper));                                        \n" \
+  "  vec3 w      = cross (u, dir);                                                         \n" \
+  "  vec3 world  = instance2.xyz + (position.y * axis)                                     \n" \
+  "              + (instance2.w * ((position.x * u) + (position.z * w)));                  \n" \
+  "                                                                                        \n" \
+  "  gl_Position = (projection * view) * vec4 (world, 1.0);                                \n" \
+  "  vsColor     = world;                                                                  \n" \
+  "}                                                                                       \n"
+
 #define ADD_WIREFRAME                                                                          \
   "vec3 barycDelta = fwidth (barycentric);                                                 \n" \
   "                                                                                        \n" \
@@ -176,4 +229,8 @@ const char* Shader::constantWireframeFragmentShader ()
   return CONSTANT_FRAGMENT_SHADER (ADD_WIREFRAME);
 }
 
+const char* Shader::sphereInstanceVertexShader () { return SPHERE_INSTANCE_VERTEX_SHADER; }
+
+const char* Shader::boneInstanceVertexShader () { return BONE_INSTANCE_VERTEX_SHADER; }
+
 const char* Shader::geometryShader () { return GEOMETRY_SHADER; }
@@ -18,6 +18,10 @@ namespace Shader
   const char* constantVertexShader ();
   const char* constantFragmentShader ();
   const char* constantWireframeFragmentShader ();
+
+  const char* sphereInstanceVertexShader ();
+  const char* boneInstanceVertexShader ();
+
   const char* geometryShader ();
 };
 
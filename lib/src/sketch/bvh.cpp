@@ -0,0 +1,539 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+#include "intersection.hpp"
+#include "primitive/aabox.hpp"
+#include "primitive/ray.hpp"
+#include "primitive/sphere.hpp"
+#include "sketch/bvh.hpp"
+#include "sketch/path.hpp"
+#include "util.hpp"
+
+namespace
+{
+  constexpr unsigned int maxElementsPerLeaf = 4;
+
+  struct ElementData
+  {
+    SketchBvh::Element element;
+    glm::vec3          minimum;
+    glm::vec3          maximum;
+    unsigned int       leaf;
+
+    glm::vec3 center () const { return 0.5f * (this->minimum + this->maximum); }
+
+    float distance (const glm::vec3& p) const
+    {
+      return glm::length (glm::max (glm::max (this->minimum - p, p - this->maximum), 0.0f));
+    }
+  };
+
+  struct BvhNode
+  {
+    glm::vec3                 minimum;
+    glm::vec3                 maximum;
+    unsigned int              parent;
+    unsigned int              children[2];
+    std::vector<unsigned int> elements;
+
+    BvhNode (unsigned int p)
+      : minimum (Util::maxFloat ())
+      , maximum (Util::minFloat ())
+      , parent (p)
+      , children{Util::invalidIndex (), Util::invalidIndex ()}
+    {
+    }
+
+    bool isLeaf () const { return this->children[0] == Util::invalidIndex (); }
+
+    bool contains (const glm::vec3& p) const
+    {
+      return glm::all (glm::lessThanEqual (this->minimum, p)) &&
+             glm::all (glm::lessThanEqual (p, this->maximum));
+    }
+
+    float distance (const glm::vec3& p) const
+    {
+      return glm::length (glm::max (glm::max (this->minimum - p, p - this->maximum), 0.0f));
+    }
+
+    void extend (const glm::vec3& min, const glm::vec3& max)
+    {
+      this->minimum = glm::min (this->minimum, min);
+      this->maximum = glm::max (this->maximum, max);
+    }
+  };
+
+  float extentSum (const glm::vec3& min, const glm::vec3& max)
+  {
+    const glm::vec3 extent = max - min;
+    return extent.x + extent.y + extent.z;
+  }
+
+  void sphereBounds (const PrimSphere& sphere, glm::vec3& min, glm::vec3& max)
+  {
+    min = sphere.center () - glm::vec3 (sphere.radius ());
+    max = sphere.center () + glm::vec3 (sphere.radius ());
+  }
+}
+
+struct SketchBvh::Impl
+{
+  bool                                                isBuilt;
+  std::vector<ElementData>                            elements;
+  std::vector<BvhNode>                                nodes;
+  std::unordered_map<const SketchNode*, unsigned int> nodeElements;
+  std::vector<std::vector<unsigned int>>              pathElements;
+
+  Impl ()
+    : isBuilt (false)
+  {
+  }
+
+  bool hasRoot () const { return this->nodes.empty () == false; }
+
+  void reset ()
+  {
+    this->isBuilt = false;
+    this->elements.clear ();
+    this->nodes.clear ();
+    this->nodeElements.clear ();
+    this->pathElements.clear ();
+  }
+
+  void setBounds (ElementData& data, const SketchPaths* paths) const
+  {
+    switch (data.element.type)
+    {
+      case ElementType::Node:
+        sphereBounds (data.element.node->data (), data.minimum, data.maximum);
+        break;
+      case ElementType::Bone:
+      {
+        glm::vec3 parentMin, parentMax;
+        sphereBounds (data.element.node->data (), data.minimum, data.maximum);
+        sphereBounds (data.element.node->parent ()->data (), parentMin, parentMax);
+
+        data.minimum = glm::min (data.minimum, parentMin);
+        data.maximum = glm::max (data.maximum, parentMax);
+        break;
+      }
+      case ElementType::Sphere:
+        assert (paths);
+        sphereBounds (paths->at (data.element.path).spheres ().at (data.element.sphere),
+                      data.minimum, data.maximum);
+        break;
+    }
+  }
+
+  void addElement (const Element& element, const SketchPaths& paths)
+  {
+    ElementData data;
+    data.element = element;
+    data.leaf = Util::invalidIndex ();
+    this->setBounds (data, &paths);
+    this->elements.push_back (data);
+  }
+
+  void setNodeBounds (unsigned int n)
+  {
+    BvhNode& node = this->nodes[n];
+
+    node.minimum = glm::vec3 (Util::maxFloat ());
+    node.maximum = glm::vec3 (Util::minFloat ());
+
+    if (node.isLeaf ())
+    {
+      for (unsigned int e : node.elements)
+      {
+        node.extend (this->elements[e].minimum, this->elements[e].maximum);
+      }
+    }
+    else
+    {
+      for (unsigned int c : node.children)
+      {
+        node.extend (this->nodes[c].minimum, this->nodes[c].maximum);
+      }
+    }
+  }
+
+  // Splits the elements of a leaf at their median along the longest axis of their centers
+  void split (unsigned int n)
+  {
+    std::vector<unsigned int> es (std::move (this->nodes[n].elements));
+
+    glm::vec3 min (Util::maxFloat ());
+    glm::vec3 max (Util::minFloat ());
+    for (unsigned int e : es)
+    {
+      min = glm::min (min, this->elements[e].center ());
+      max = glm::max (max, this->elements[e].center ());
+    }
+    const glm::vec3    extent = max - min;
+    const unsigned int axis =
+      extent.x >= extent.y ? (extent.x >= extent.z ? 0 : 2) : (extent.y >= extent.z ? 1 : 2);
+    const auto median = es.begin () + (es.size () / 2);
+
+    std::nth_element (es.begin (), median, es.end (),
+                      [this, axis](unsigned int a, unsigned int b) {
+                        return this->elements[a].center ()[axis] <
+                               this->elements[b].center ()[axis];
+                      });
+
+    const unsigned int children[] = {(unsigned int) this->nodes.size (),
+                                     (unsigned int) this->nodes.size () + 1};
+
+    this->nodes.emplace_back (n);
+    this->nodes.emplace_back (n);
+    this->nodes[n].children[0] = children[0];
+    this->nodes[n].children[1] = children[1];
+    this->nodes[children[0]].elements.assign (es.begin (), median);
+    this->nodes[children[1]].elements.assign (median, es.end ());
+
+    for (unsigned int c : children)
+    {
+      for (unsigned int e : this->nodes[c].elements)
+      {
+        this->elements[e].leaf = c;
+      }
+      this->setNodeBounds (c);
+
+      if (this->nodes[c].elements.size () > maxElementsPerLeaf)
+      {
+        this->split (c);
+      }
+    }
+  }
+
+  void build (SketchTree& tree, const SketchPaths& paths)
+  {
+    this->reset ();
+
+    if (tree.hasRoot ())
+    {
+      tree.root ().forEachNode ([this, &paths](SketchNode& node) {
+        this->nodeElements.emplace (&node, this->elements.size ());
+        this->addElement (Element{ElementType::Node, &node, 0, 0}, paths);
+
+        if (node.parent ())
+        {
+          this->addElement (Element{ElementType::Bone, &node, 0, 0}, paths);
+        }
+      });
+    }
+    for (unsigned int p = 0; p < paths.size (); p++)
+    {
+      this->pathElements.emplace_back ();
+
+      for (unsigned int s = 0; s < paths[p].spheres ().size (); s++)
+      {
+        this->pathElements.back ().push_back (this->elements.size ());
+        this->addElement (Element{ElementType::Sphere, nullptr, p, s}, paths);
+      }
+    }
+
+    if (this->elements.empty () == false)
+    {
+      this->nodes.emplace_back (Util::invalidIndex ());
+      this->nodes[0].elements.resize (this->elements.size ());
+
+      for (unsigned int e = 0; e < this->elements.size (); e++)
+      {
+        this->nodes[0].elements[e] = e;
+        this->elements[e].leaf = 0;
+      }
+      this->setNodeBounds (0);
+
+      if (this->nodes[0].elements.size () > maxElementsPerLeaf)
+      {
+        this->split (0);
+      }
+    }
+    this->isBuilt = true;
+  }
+
+  void refitAncestors (unsigned int n)
+  {
+    for (; n != Util::invalidIndex (); n = this->nodes[n].parent)
+    {
+      this->setNodeBounds (n);
+    }
+  }
+
+  void refitElement (unsigned int e, const SketchPaths* paths)
+  {
+    this->setBounds (this->elements[e], paths);
+    this->refitAncestors (this->elements[e].leaf);
+  }
+
+  // Refits the node, its bone and the bones of its children
+  void refitNode (const SketchNode& node)
+  {
+    if (this->isBuilt)
+    {
+      auto it = this->nodeElements.find (&node);
+      assert (it != this->nodeElements.end ());
+
+      this->refitElement (it->second, nullptr);
+
+      if (node.parent ())
+      {
+        this->refitElement (it->second + 1, nullptr);
+      }
+      node.forEachConstChild ([this](const SketchNode& child) {
+        auto itC = this->nodeElements.find (&child);
+        assert (itC != this->nodeElements.end ());
+
+        this->refitElement (itC->second + 1, nullptr);
+      });
+    }
+  }
+
+  void refitPath (const SketchPaths& paths, unsigned int p)
+  {
+    if (this->isBuilt)
+    {
+      assert (p < this->pathElements.size ());
+      assert (this->pathElements[p].size () == paths.at (p).spheres ().size ());
+
+      for (unsigned int e : this->pathElements[p])
+      {
+        this->refitElement (e, &paths);
+      }
+    }
+  }
+
+  // Inserts the last sphere of a path into the leaf whose extent grows least
+  void addSphere (const SketchPaths& paths, unsigned int p)
+  {
+    if (this->isBuilt)
+    {
+      assert (p <= this->pathElements.size ());
+      assert (paths.at (p).isEmpty () == false);
+
+      if (p == this->pathElements.size ())
+      {
+        this->pathElements.emplace_back ();
+      }
+      assert (this->pathElements[p].size () + 1 == paths.at (p).spheres ().size ());
+
+      const unsigned int e = this->elements.size ();
+      this->pathElements[p].push_back (e);
+      this->addElement (Element{ElementType::Sphere, nullptr, p,
+                                (unsigned int) (paths.at (p).spheres ().size () - 1)},
+                        paths);
+
+      if (this->hasRoot () == false)
+      {
+        this->nodes.emplace_back (Util::invalidIndex ());
+      }
+
+      const glm::vec3& min = this->elements[e].minimum;
+      const glm::vec3& max = this->elements[e].maximum;
+
+      unsigned int n = 0;
+      while (this->nodes[n].isLeaf () == false)
+      {
+        const BvhNode& c0 = this->nodes[this->nodes[n].children[0]];
+        const BvhNode& c1 = this->nodes[this->nodes[n].children[1]];
+
+        const float growth0 = extentSum (glm::min (c0.minimum, min), glm::max (c0.maximum, max)) -
+                              extentSum (c0.minimum, c0.maximum);
+        const float growth1 = extentSum (glm::min (c1.minimum, min), glm::max (c1.maximum, max)) -
+                              extentSum (c1.minimum, c1.maximum);
+
+        n = this->nodes[n].children[growth0 <= growth1 ? 0 : 1];
+      }
+      this->nodes[n].elements.push_back (e);
+      this->elements[e].leaf = n;
+      this->refitAncestors (n);
+
+      if (this->nodes[n].elements.size () > 2 * maxElementsPerLeaf)
+      {
+        this->split (n);
+      }
+    }
+  }
+
+  void intersects (unsigned int n, const PrimRay& ray, float& distance,
+                   const RayIntersectionCallback& f) const
+  {
+    const BvhNode& node = this->nodes[n];
+
+    float t;
+    if (IntersectionUtil::intersects (ray, PrimAABox (node.minimum, node.maximum), &t) &&
+        t < distance)
+    {
+      if (node.isLeaf ())
+      {
+        for (unsigned int e : node.elements)
+        {
+          const ElementData& data = this->elements[e];
+
+          if (IntersectionUtil::intersects (ray, PrimAABox (data.minimum, data.maximum), &t) &&
+              t < distance)
+          {
+            distance = glm::min (f (data.element), distance);
+          }
+        }
+      }
+      else
+      {
+        this->intersects (node.children[0], ray, distance, f);
+        this->intersects (node.children[1], ray, distance, f);
+      }
+    }
+  }
+
+  void intersects (const PrimRay& ray, const RayIntersectionCallback& f) const
+  {
+    assert (this->isBuilt);
+
+    if (this->hasRoot ())
+    {
+      float distance = Util::maxFloat ();
+      this->intersects (0, ray, distance, f);
+    }
+  }
+
+  void contains (unsigned int n, const glm::vec3& p, const IntersectionCallback& f) const
+  {
+    const BvhNode& node = this->nodes[n];
+
+    if (node.contains (p))
+    {
+      if (node.isLeaf ())
+      {
+        for (unsigned int e : node.elements)
+        {
+          const ElementData& data = this->elements[e];
+
+          if (glm::all (glm::lessThanEqual (data.minimum, p)) &&
+              glm::all (glm::lessThanEqual (p, data.maximum)))
+          {
+            f (data.element);
+          }
+        }
+      }
+      else
+      {
+        this->contains (node.children[0], p, f);
+        this->contains (node.children[1], p, f);
+      }
+    }
+  }
+
+  void contains (const glm::vec3& p, const IntersectionCallback& f) const
+  {
+    assert (this->isBuilt);
+
+    if (this->hasRoot ())
+    {
+      this->contains (0, p, f);
+    }
+  }
+
+  void intersects (unsigned int n, const PrimSphere& sphere, const IntersectionCallback& f) const
+  {
+    const BvhNode& node = this->nodes[n];
+
+    if (node.distance (sphere.center ()) <= sphere.radius ())
+    {
+      if (node.isLeaf ())
+      {
+        for (unsigned int e : node.elements)
+        {
+          if (this->elements[e].distance (sphere.center ()) <= sphere.radius ())
+          {
+            f (this->elements[e].element);
+          }
+        }
+      }
+      else
+      {
+        this->intersects (node.children[0], sphere, f);
+        this->intersects (node.children[1], sphere, f);
+      }
+    }
+  }
+
+  void intersects (const PrimSphere& sphere, const IntersectionCallback& f) const
+  {
+    assert (this->isBuilt);
+
+    if (this->hasRoot ())
+    {
+      this->intersects (0, sphere, f);
+    }
+  }
+
+  // Elements are visited if their bounding box is nearer than the current distance, or if it
+  // contains the point, since distances may be negative
+  void distance (unsigned int n, const glm::vec3& p, float& distance,
+                 const DistanceCallback& f) const
+  {
+    const BvhNode& node = this->nodes[n];
+
+    if (node.isLeaf ())
+    {
+      for (unsigned int e : node.elements)
+      {
+        if (this->elements[e].distance (p) <= glm::max (distance, 0.0f))
+        {
+          distance = glm::min (f (this->elements[e].element), distance);
+        }
+      }
+    }
+    else
+    {
+      const float d0 = this->nodes[node.children[0]].distance (p);
+      const float d1 = this->nodes[node.children[1]].distance (p);
+      const bool  firstIsNearer = d0 <= d1;
+
+      const unsigned int near = node.children[firstIsNearer ? 0 : 1];
+      const unsigned int far = node.children[firstIsNearer ? 1 : 0];
+
+      if (glm::min (d0, d1) <= glm::max (distance, 0.0f))
+      {
+        this->distance (near, p, distance, f);
+      }
+      if (glm::max (d0, d1) <= glm::max (distance, 0.0f))
+      {
+        this->distance (far, p, distance, f);
+      }
+    }
+  }
+
+  float distance (const glm::vec3& p, const DistanceCallback& f) const
+  {
+    assert (this->isBuilt);
+
+    float distance = Util::maxFloat ();
+    if (this->hasRoot ())
+    {
+      this->distance (0, p, distance, f);
+    }
+    return distance;
+  }
+};
+
+DELEGATE_BIG3 (SketchBvh)
+GETTER_CONST (bool, SketchBvh, isBuilt)
+DELEGATE2 (void, SketchBvh, build, SketchTree&, const SketchPaths&)
+DELEGATE (void, SketchBvh, reset)
+DELEGATE1 (void, SketchBvh, refitNode, const SketchNode&)
+DELEGATE2 (void, SketchBvh, refitPath, const SketchPaths&, unsigned int)
+DELEGATE2 (void, SketchBvh, addSphere, const SketchPaths&, unsigned int)
+DELEGATE2_CONST (void, SketchBvh, intersects, const PrimRay&,
+                 const SketchBvh::RayIntersectionCallback&)
+DELEGATE2_CONST (void, SketchBvh, contains, const glm::vec3&,
+                 const SketchBvh::IntersectionCallback&)
+DELEGATE2_CONST (void, SketchBvh, intersects, const PrimSphere&,
+                 const SketchBvh::IntersectionCallback&)
+DELEGATE2_CONST (float, SketchBvh, distance, const glm::vec3&, const SketchBvh::DistanceCallback&)
@@ -0,0 +1,57 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_SKETCH_BVH
+#define DILAY_SKETCH_BVH
+
+#include <functional>
+#include <glm/fwd.hpp>
+#include "macro.hpp"
+#include "sketch/fwd.hpp"
+
+class PrimRay;
+
+// Bounding volume hierarchy over the nodes, bones and path spheres of a sketch
+class SketchBvh
+{
+public:
+  DECLARE_BIG3 (SketchBvh)
+
+  enum class ElementType
+  {
+    Node,
+    Bone,
+    Sphere
+  };
+
+  // Bones are represented by their child node, spheres by the indices of their path and of
+  // themselves within this path
+  struct Element
+  {
+    ElementType  type;
+    SketchNode*  node;
+    unsigned int path;
+    unsigned int sphere;
+  };
+
+  typedef std::function<float(const Element&)> RayIntersectionCallback;
+  typedef std::function<void(const Element&)>  IntersectionCallback;
+  typedef std::function<float(const Element&)> DistanceCallback;
+
+  bool  isBuilt () const;
+  void  build (SketchTree&, const SketchPaths&);
+  void  reset ();
+  void  refitNode (const SketchNode&);
+  void  refitPath (const SketchPaths&, unsigned int);
+  void  addSphere (const SketchPaths&, unsigned int);
+  void  intersects (const PrimRay&, const RayIntersectionCallback&) const;
+  void  contains (const glm::vec3&, const IntersectionCallback&) const;
+  void  intersects (const PrimSphere&, const IntersectionCallback&) const;
+  float distance (const glm::vec3&, const DistanceCallback&) const;
+
+private:
+  IMPLEMENTATION
+};
+
+#endif
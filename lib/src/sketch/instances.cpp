@@ -0,0 +1,219 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <glm/gtx/rotate_vector.hpp>
+#include "../mesh.hpp"
+#include "opengl-buffer-id.hpp"
+#include "opengl.hpp"
+#include "sketch/instances.hpp"
+#include "sketch/path.hpp"
+#include "util.hpp"
+
+namespace
+{
+  static_assert (sizeof (glm::vec4) == 4 * sizeof (float), "Unexpected memory layout");
+
+  constexpr unsigned int numTypes = 4;
+
+  struct InstanceData
+  {
+    std::vector<glm::vec4> data;
+    OpenGLBufferId         id;
+    bool                   isBuffered;
+
+    InstanceData ()
+      : isBuffered (false)
+    {
+    }
+
+    void reset ()
+    {
+      this->data.clear ();
+      this->isBuffered = false;
+    }
+
+    void add (const PrimSphere& sphere)
+    {
+      this->data.emplace_back (sphere.center (), sphere.radius ());
+    }
+
+    void bufferData ()
+    {
+      if (this->id.isValid () == false)
+      {
+        this->id.allocate ();
+      }
+      OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), this->id.id ());
+      OpenGL::glBufferData (OpenGL::ArrayBuffer (), this->data.size () * sizeof (glm::vec4),
+                            this->data.data (), OpenGL::StaticDraw ());
+      OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), 0);
+      this->isBuffered = true;
+    }
+  };
+
+  unsigned int typeIndex (SketchInstances::Type type)
+  {
+    switch (type)
+    {
+      case SketchInstances::Type::Node:
+        return 0;
+      case SketchInstances::Type::Bone:
+        return 1;
+      case SketchInstances::Type::Bubble:
+        return 2;
+      case SketchInstances::Type::Sphere:
+        return 3;
+    }
+    DILAY_IMPOSSIBLE
+  }
+
+  void renderBone (Camera& camera, Mesh& mesh, const glm::vec4& node, const glm::vec4& parent)
+  {
+    const glm::vec3 pos (node);
+    const glm::vec3 parPos (parent);
+    const float     distance = glm::distance (pos, parPos);
+    const glm::vec3 direction = (parPos - pos) / distance;
+    const glm::vec3 down = glm::vec3 (0.0f, -1.0f, 0.0f);
+
+    if (Util::colinearUnit (direction, down))
+    {
+      mesh.rotationMatrix (glm::mat4x4 (1.0f));
+
+      if (glm::dot (direction, down) < 0.0f)
+      {
+        mesh.rotateX (glm::pi<float> ());
+      }
+    }
+    else
+    {
+      mesh.rotationMatrix (glm::orientation (direction, down));
+    }
+    mesh.position (parPos);
+    mesh.scaling (glm::vec3 (parent.w, distance, parent.w));
+    mesh.render (camera);
+  }
+}
+
+struct SketchInstances::Impl
+{
+  bool         isPacked;
+  InstanceData instances[numTypes];
+
+  Impl ()
+    : isPacked (false)
+  {
+  }
+
+  void pack (const SketchTree& tree, const SketchPaths& paths)
+  {
+    this->reset ();
+
+    InstanceData& nodes = this->instances[typeIndex (Type::Node)];
+    InstanceData& bones = this->instances[typeIndex (Type::Bone)];
+    InstanceData& bubbles = this->instances[typeIndex (Type::Bubble)];
+    InstanceData& spheres = this->instances[typeIndex (Type::Sphere)];
+
+    if (tree.hasRoot ())
+    {
+      tree.root ().forEachConstNode ([&nodes, &bones, &bubbles](const SketchNode& node) {
+        nodes.add (node.data ());
+
+        if (node.parent ())
+        {
+          const glm::vec3& pos = node.data ().center ();
+          const float      radius = node.data ().radius ();
+          const glm::vec3& parPos = node.parent ()->data ().center ();
+          const float      parRadius = node.parent ()->data ().radius ();
+          const float      distance = glm::distance (pos, parPos);
+          const glm::vec3  direction = (parPos - pos) / distance;
+
+          bones.add (node.data ());
+          bones.add (node.parent ()->data ());
+
+          for (float d = radius * 0.5f; d < distance;)
+          {
+            const float bubbleRadius = glm::mix (radius, parRadius, d / distance);
+
+            bubbles.add (PrimSphere (pos + (d * direction), bubbleRadius));
+
+            d += bubbleRadius * 0.5f;
+          }
+        }
+      });
+    }
+    for (const SketchPath& p : paths)
+    {
+      for (const PrimSphere& s : p.spheres ())
+      {
+        spheres.add (s);
+      }
+    }
+    this->isPacked = true;
+  }
+
+  void reset ()
+  {
+    for (InstanceData& i : this->instances)
+    {
+      i.reset ();
+    }
+    this->isPacked = false;
+  }
+
+  const std::vector<glm::vec4>& data (Type type) const
+  {
+    return this->instances[typeIndex (type)].data;
+  }
+
+  unsigned int numInstances (Type type) const
+  {
+    const unsigned int n = this->data (type).size ();
+    return type == Type::Bone ? n / 2 : n;
+  }
+
+  void render (Camera& camera, Mesh& mesh, Type type)
+  {
+    assert (this->isPacked);
+
+    InstanceData&                 instance = this->instances[typeIndex (type)];
+    const std::vector<glm::vec4>& data = instance.data;
+
+    if (data.empty ())
+    {
+      return;
+    }
+    else if (OpenGL::hasInstancing ())
+    {
+      if (instance.isBuffered == false)
+      {
+        instance.bufferData ();
+      }
+      mesh.renderInstances (camera, instance.id.id (), this->numInstances (type));
+    }
+    else if (type == Type::Bone)
+    {
+      for (unsigned int i = 0; i + 1 < data.size (); i += 2)
+      {
+        renderBone (camera, mesh, data[i], data[i + 1]);
+      }
+    }
+    else
+    {
+      for (const glm::vec4& d : data)
+      {
+        mesh.position (glm::vec3 (d));
+        mesh.scaling (glm::vec3 (d.w));
+        mesh.render (camera);
+      }
+    }
+  }
+};
+
+DELEGATE_BIG3 (SketchInstances)
+GETTER_CONST (bool, SketchInstances, isPacked)
+DELEGATE2 (void, SketchInstances, pack, const SketchTree&, const SketchPaths&)
+DELEGATE (void, SketchInstances, reset)
+DELEGATE1_CONST (const std::vector<glm::vec4>&, SketchInstances, data, SketchInstances::Type)
+DELEGATE1_CONST (unsigned int, SketchInstances, numInstances, SketchInstances::Type)
+DELEGATE3 (void, SketchInstances, render, Camera&, Mesh&, SketchInstances::Type)
@@ -0,0 +1,43 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_SKETCH_INSTANCES
+#define DILAY_SKETCH_INSTANCES
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "macro.hpp"
+#include "sketch/fwd.hpp"
+
+class Camera;
+class Mesh;
+
+// Per-instance data for rendering a sketch with one draw call per type of instance: nodes, bubbles
+// and path spheres are packed as `(center, radius)`, bones as the spheres of their node and of
+// its parent.
+class SketchInstances
+{
+public:
+  DECLARE_BIG3 (SketchInstances)
+
+  enum class Type
+  {
+    Node,
+    Bone,
+    Bubble,
+    Sphere
+  };
+
+  bool                          isPacked () const;
+  void                          pack (const SketchTree&, const SketchPaths&);
+  void                          reset ();
+  const std::vector<glm::vec4>& data (Type) const;
+  unsigned int                  numInstances (Type) const;
+  void                          render (Camera&, Mesh&, Type);
+
+private:
+  IMPLEMENTATION
+};
+
+#endif
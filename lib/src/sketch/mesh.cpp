@@ -2,8 +2,8 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <glm/gtc/constants.hpp>
 #include <glm/gtx/norm.hpp>
-#include <glm/gtx/rotate_vector.hpp>
 #include "../mesh.hpp"
 #include "color.hpp"
 #include "config.hpp"
@@ -18,10 +18,13 @@
 #include "primitive/sphere.hpp"
 #include "render-mode.hpp"
 #include "sketch/bone-intersection.hpp"
+#include "sketch/bvh.hpp"
+#include "sketch/instances.hpp"
 #include "sketch/mesh.hpp"
 #include "sketch/node-intersection.hpp"
 #include "sketch/path-intersection.hpp"
 #include "sketch/path.hpp"
+#include "sketch/preview.hpp"
 #include "util.hpp"
 
 namespace
@@ -29,12 +32,14 @@ namespace
   struct RenderConfig
   {
     bool  renderWireframe;
+    bool  renderPreview;
     Color nodeColor;
     Color bubbleColor;
     Color sphereColor;
 
     RenderConfig ()
       : renderWireframe (false)
+      , renderPreview (false)
     {
     }
   };
@@ -78,15 +83,20 @@ namespace
 
 struct SketchMesh::Impl
 {
-  SketchMesh*  self;
-  SketchTree   tree;
-  SketchPaths  paths;
-  Mesh         sphereMesh;
-  Mesh         boneMesh;
-  RenderConfig renderConfig;
+  SketchMesh*     self;
+  SketchTree      tree;
+  SketchPaths     paths;
+  Mesh            sphereMesh;
+  Mesh            boneMesh;
+  RenderConfig    renderConfig;
+  SketchBvh       bvh;
+  SketchInstances instances;
+  SketchPreview   preview;
+  bool            isPreviewOutdated;
 
   Impl (SketchMesh* s)
     : self (s)
+    , isPreviewOutdated (true)
   {
     this->sphereMesh = MeshUtil::icosphere (3);
     this->sphereMesh.bufferData ();
@@ -105,60 +115,124 @@ struct SketchMesh::Impl
     , sphereMesh (other.sphereMesh)
     , boneMesh (other.boneMesh)
     , renderConfig (other.renderConfig)
+    , isPreviewOutdated (true)
   {
     this->sphereMesh.bufferData ();
     this->boneMesh.bufferData ();
+    this->preview.resolution (other.preview.resolution ());
   }
 
   bool isEmpty () const { return this->tree.hasRoot () == false && this->paths.empty (); }
 
-  void fromTree (const SketchTree& newTree) { this->tree = newTree; }
+  SketchTree& mutableTree ()
+  {
+    this->bvh.reset ();
+    this->instances.reset ();
+    return this->tree;
+  }
 
-  void reset () { this->tree.reset (); }
+  void fromTree (const SketchTree& newTree)
+  {
+    this->tree = newTree;
+    this->bvh.reset ();
+    this->instances.reset ();
+  }
 
-  bool intersects (const PrimRay& ray, SketchNodeIntersection& intersection,
-                   const SketchNode* exclude = nullptr)
+  void reset ()
   {
-    if (this->tree.hasRoot ())
+    this->tree.reset ();
+    this->bvh.reset ();
+    this->instances.reset ();
+  }
+
+  const SketchBvh& builtBvh ()
+  {
+    if (this->bvh.isBuilt () == false)
     {
-      this->tree.root ().forEachNode ([this, &ray, &intersection, exclude](SketchNode& node) {
-        float t;
-        if (&node != exclude && IntersectionUtil::intersects (ray, node.data (), &t))
-        {
-          const glm::vec3 p = ray.pointAt (t);
-          intersection.update (t, p, glm::normalize (p - node.data ().center ()), *this->self,
-                               node);
-        }
-      });
+      this->bvh.build (this->tree, this->paths);
+    }
+    return this->bvh;
+  }
+
+  void refitBvh (const SketchNode& node, bool all)
+  {
+    if (all)
+    {
+      node.forEachConstNode ([this](const SketchNode& n) { this->bvh.refitNode (n); });
+    }
+    else
+    {
+      this->bvh.refitNode (node);
     }
+  }
+
+  static float distance (const Intersection& intersection)
+  {
+    return intersection.isIntersection () ? intersection.distance () : Util::maxFloat ();
+  }
+
+  bool intersects (const PrimRay& ray, SketchNodeIntersection& intersection,
+                   const SketchNode* exclude = nullptr)
+  {
+    this->builtBvh ().intersects (ray, [this, &ray, &intersection,
+                                        exclude](const SketchBvh::Element& e) {
+      float t;
+      if (e.type == SketchBvh::ElementType::Node && e.node != exclude &&
+          IntersectionUtil::intersects (ray, e.node->data (), &t))
+      {
+        const glm::vec3 p = ray.pointAt (t);
+        intersection.update (t, p, glm::normalize (p - e.node->data ().center ()), *this->self,
+                             *e.node);
+      }
+      return distance (intersection);
+    });
     return intersection.isIntersection ();
   }
 
   bool intersects (const PrimRay& ray, SketchBoneIntersection& intersection)
   {
-    if (this->tree.hasRoot ())
-    {
-      this->tree.root ().forEachNode ([this, &ray, &intersection](SketchNode& node) {
-        if (node.parent ())
+    this->builtBvh ().intersects (ray, [this, &ray, &intersection](const SketchBvh::Element& e) {
+      if (e.type == SketchBvh::ElementType::Bone)
+      {
+        const PrimConeSphere coneSphere (e.node->data (), e.node->parent ()->data ());
+
+        if (coneSphere.hasCone ())
         {
-          const PrimConeSphere coneSphere (node.data (), node.parent ()->data ());
+          const PrimCone cone = coneSphere.toCone ();
 
-          if (coneSphere.hasCone ())
+          float tRay, tCone;
+          if (IntersectionUtil::intersects (ray, cone, &tRay, &tCone))
           {
-            const PrimCone cone = coneSphere.toCone ();
+            const glm::vec3 p = ray.pointAt (tRay);
 
-            float tRay, tCone;
-            if (IntersectionUtil::intersects (ray, cone, &tRay, &tCone))
-            {
-              const glm::vec3 p = ray.pointAt (tRay);
-
-              intersection.update (tRay, p, cone.projPointAt (tCone), cone.normalAt (p, tCone),
-                                   *this->self, node);
-            }
+            intersection.update (tRay, p, cone.projPointAt (tCone), cone.normalAt (p, tCone),
+                                 *this->self, *e.node);
           }
         }
-      });
-    }
+      }
+      return distance (intersection);
+    });
+    return intersection.isIntersection ();
+  }
+
+  // Only the first `numPaths` paths are considered
+  bool intersects (const PrimRay& ray, SketchPathIntersection& intersection, unsigned int numPaths)
+  {
+    this->builtBvh ().intersects (ray, [this, &ray, &intersection,
+                                        numPaths](const SketchBvh::Element& e) {
+      if (e.type == SketchBvh::ElementType::Sphere && e.path < numPaths)
+      {
+        const PrimSphere& s = this->paths[e.path].spheres ()[e.sphere];
+
+        float t;
+        if (IntersectionUtil::intersects (ray, s, &t))
+        {
+          intersection.update (t, ray.pointAt (t), glm::normalize (ray.pointAt (t) - s.center ()),
+                               *this->self, this->paths[e.path]);
+        }
+      }
+      return distance (intersection);
+    });
     return intersection.isIntersection ();
   }
 
@@ -179,37 +253,28 @@ struct SketchMesh::Impl
       intersection.update (sbIntersection.distance (), sbIntersection.position (),
                            sbIntersection.normal (), sbIntersection.mesh ());
     }
-    if (numExcludedLastPaths < this->paths.size ())
+    if (numExcludedLastPaths < this->paths.size () &&
+        this->intersects (ray, spIntersection, this->paths.size () - numExcludedLastPaths))
     {
-      for (unsigned int i = 0; i < this->paths.size () - numExcludedLastPaths; i++)
-      {
-        if (this->paths.at (i).intersects (ray, *this->self, spIntersection))
-        {
-          intersection.update (spIntersection.distance (), spIntersection.position (),
-                               spIntersection.normal (), spIntersection.mesh ());
-        }
-      }
+      intersection.update (spIntersection.distance (), spIntersection.position (),
+                           spIntersection.normal (), spIntersection.mesh ());
     }
     return intersection.isIntersection ();
   }
 
   bool intersects (const PrimRay& ray, SketchPathIntersection& intersection)
   {
-    for (unsigned int i = 0; i < this->paths.size (); i++)
-    {
-      this->paths.at (i).intersects (ray, *this->self, intersection);
-    }
-    return intersection.isIntersection ();
+    return this->intersects (ray, intersection, this->paths.size ());
   }
 
   bool intersects (const glm::vec3& point, PrimSphereIntersection& intersection,
                    const SketchPath& excluded)
   {
-    auto checkSphere = [&point, &intersection](const SketchNode& node) {
-      const float d2 = glm::distance2 (point, node.data ().center ());
-      if (d2 <= node.data ().radius () * node.data ().radius ())
+    auto checkSphere = [&point, &intersection](const PrimSphere& sphere) {
+      const float d2 = glm::distance2 (point, sphere.center ());
+      if (d2 <= sphere.radius () * sphere.radius ())
       {
-        intersection.update (glm::sqrt (d2), node.data ());
+        intersection.update (glm::sqrt (d2), sphere);
       }
     };
 
@@ -267,114 +332,83 @@ struct SketchMesh::Impl
       }
       else
       {
-        checkSphere (node);
+        checkSphere (node.data ());
       }
     };
 
-    if (this->tree.hasRoot ())
-    {
-      this->tree.root ().forEachNode ([&checkBone](SketchNode& node) { checkBone (node); });
-    }
-
-    for (const SketchPath& p : this->paths)
-    {
-      if (&p != &excluded)
+    this->builtBvh ().contains (point, [this, &excluded, &checkSphere,
+                                        &checkBone](const SketchBvh::Element& e) {
+      switch (e.type)
       {
-        for (const PrimSphere& s : p.spheres ())
-        {
-          checkSphere (s);
-        }
+        case SketchBvh::ElementType::Node:
+          if (e.node->parent () == nullptr)
+          {
+            checkSphere (e.node->data ());
+          }
+          break;
+        case SketchBvh::ElementType::Bone:
+          checkBone (*e.node);
+          break;
+        case SketchBvh::ElementType::Sphere:
+          if (&this->paths[e.path] != &excluded)
+          {
+            checkSphere (this->paths[e.path].spheres ()[e.sphere]);
+          }
+          break;
       }
-    }
+    });
     return intersection.isIntersection ();
   }
 
-  void renderTree (Camera& camera)
+  void render (Camera& camera)
   {
-    if (this->tree.hasRoot ())
+    // Instances are reset by every edit
+    if (this->instances.isPacked () == false)
     {
-      this->tree.root ().forEachConstNode ([this, &camera](const SketchNode& node) {
-        const glm::vec3& pos = node.data ().center ();
-        const float      radius = node.data ().radius ();
-
-        this->sphereMesh.position (pos);
-        this->sphereMesh.scaling (glm::vec3 (radius));
-        this->sphereMesh.color (this->renderConfig.nodeColor);
-        this->sphereMesh.render (camera);
-
-        if (node.parent ())
-        {
-          const glm::vec3& parPos = node.parent ()->data ().center ();
-          const float      parRadius = node.parent ()->data ().radius ();
-          const float      distance = glm::distance (pos, parPos);
-          const glm::vec3  direction = (parPos - pos) / distance;
-
-          if (this->renderConfig.renderWireframe)
-          {
-            const glm::vec3 down = glm::vec3 (0.0f, -1.0f, 0.0f);
-
-            if (Util::colinearUnit (direction, down))
-            {
-              this->boneMesh.rotationMatrix (glm::mat4x4 (1.0f));
-
-              if (glm::dot (direction, down) < 0.0f)
-              {
-                this->boneMesh.rotateX (glm::pi<float> ());
-              }
-            }
-            else
-            {
-              this->boneMesh.rotationMatrix (glm::orientation (direction, down));
-            }
-
-            this->boneMesh.color (this->renderConfig.nodeColor);
-            this->boneMesh.position (parPos);
-            this->boneMesh.scaling (glm::vec3 (parRadius, distance, parRadius));
-            this->boneMesh.render (camera);
-          }
-          else
-          {
-            this->sphereMesh.color (this->renderConfig.bubbleColor);
-
-            for (float d = radius * 0.5f; d < distance;)
-            {
-              const glm::vec3 bubblePos = pos + (d * direction);
-              const float     bubbleRadius = glm::mix (radius, parRadius, d / distance);
-
-              this->sphereMesh.position (bubblePos);
-              this->sphereMesh.scaling (glm::vec3 (bubbleRadius));
-              this->sphereMesh.render (camera);
-
-              d += bubbleRadius * 0.5f;
-            }
-          }
-        }
-      });
+      this->instances.pack (this->tree, this->paths);
+      this->isPreviewOutdated = true;
     }
-  }
 
-  void renderPaths (Camera& camera)
-  {
-    this->sphereMesh.color (this->renderConfig.sphereColor);
+    this->sphereMesh.color (this->renderConfig.nodeColor);
+    this->instances.render (camera, this->sphereMesh, SketchInstances::Type::Node);
 
-    for (const SketchPath& p : this->paths)
+    if (this->renderConfig.renderWireframe)
     {
-      p.render (camera, this->sphereMesh);
+      this->boneMesh.color (this->renderConfig.nodeColor);
+      this->instances.render (camera, this->boneMesh, SketchInstances::Type::Bone);
+    }
+    else if (this->renderConfig.renderPreview)
+    {
+      if (this->isPreviewOutdated)
+      {
+        this->preview.update (this->tree, this->paths);
+        this->isPreviewOutdated = false;
+      }
+      this->preview.render (camera, this->renderConfig.bubbleColor);
+    }
+    else
+    {
+      this->sphereMesh.color (this->renderConfig.bubbleColor);
+      this->instances.render (camera, this->sphereMesh, SketchInstances::Type::Bubble);
+
+      this->sphereMesh.color (this->renderConfig.sphereColor);
+      this->instances.render (camera, this->sphereMesh, SketchInstances::Type::Sphere);
     }
   }
 
-  void render (Camera& camera)
+  void renderWireframe (bool v) { this->renderConfig.renderWireframe = v; }
+
+  void renderPreview (bool v)
   {
-    this->renderTree (camera);
+    this->renderConfig.renderPreview = v;
+    this->isPreviewOutdated = true;
 
-    if (this->renderConfig.renderWireframe == false)
+    if (v == false)
     {
-      this->renderPaths (camera);
+      this->preview.reset ();
     }
   }
 
-  void renderWireframe (bool v) { this->renderConfig.renderWireframe = v; }
-
   PrimPlane mirrorPlane (Dimension dim) const
   {
     if (this->tree.hasRoot ())
@@ -457,6 +491,8 @@ struct SketchMesh::Impl
     {
       this->addMirroredNode (newNode, this->mirrorPlane (*dim));
     }
+    this->bvh.reset ();
+    this->instances.reset ();
     return newNode;
   }
 
@@ -484,12 +520,16 @@ struct SketchMesh::Impl
       }
     }
     child.parent ()->deleteChild (child);
+    this->bvh.reset ();
+    this->instances.reset ();
     return newNode;
   }
 
   SketchPath& addPath (const SketchPath& path)
   {
     this->paths.push_back (path);
+    this->bvh.reset ();
+    this->instances.reset ();
     return this->paths.back ();
   }
 
@@ -512,11 +552,16 @@ struct SketchMesh::Impl
 
       this->paths.at (this->paths.size () - 2)
         .addSphere (mirrorPlane.mirror (intersection), mirrorPlane.mirror (position), radius);
+      this->bvh.addSphere (this->paths, this->paths.size () - 2);
     }
+    this->bvh.addSphere (this->paths, this->paths.size () - 1);
+    this->instances.reset ();
   }
 
   void move (SketchNode& node, const glm::vec3& delta, bool all, const Dimension* dim)
   {
+    this->instances.reset ();
+
     const auto moveNodes = [all](SketchNode& node, const glm::vec3& delta) {
       if (all)
       {
@@ -535,20 +580,25 @@ struct SketchMesh::Impl
       SketchNode*     nodeM = this->mirrored (node, mirrorPlane, node);
 
       moveNodes (node, delta);
+      this->refitBvh (node, all);
 
       if (nodeM)
       {
         moveNodes (*nodeM, mirrorPlane.mirrorDirection (delta));
+        this->refitBvh (*nodeM, all);
       }
     }
     else
     {
       moveNodes (node, delta);
+      this->refitBvh (node, all);
     }
   }
 
   void scale (SketchNode& node, float factor, bool all, const Dimension* dim)
   {
+    this->instances.reset ();
+
     const auto scaleNodes = [factor, all](SketchNode& node) {
       if (all)
       {
@@ -566,20 +616,25 @@ struct SketchMesh::Impl
       SketchNode* nodeM = this->mirrored (node, this->mirrorPlane (*dim), node);
 
       scaleNodes (node);
+      this->refitBvh (node, all);
 
       if (nodeM)
       {
         scaleNodes (*nodeM);
+        this->refitBvh (*nodeM, all);
       }
     }
     else
     {
       scaleNodes (node);
+      this->refitBvh (node, all);
     }
   }
 
   void rotate (SketchNode& node, const glm::vec3& axis, float angle, const Dimension* dim)
   {
+    this->instances.reset ();
+
     const auto rotateNodes = [](SketchNode& node, const glm::vec3& axis, float angle) {
       const glm::mat4x4 matrix = Util::rotation (node.data ().center (), axis, angle);
 
@@ -594,20 +649,25 @@ struct SketchMesh::Impl
       SketchNode*     nodeM = this->mirrored (node, mirrorPlane, node);
 
       rotateNodes (node, axis, angle);
+      this->refitBvh (node, true);
 
       if (nodeM)
       {
         rotateNodes (*nodeM, mirrorPlane.mirrorDirection (axis), -angle);
+        this->refitBvh (*nodeM, true);
       }
     }
     else
     {
       rotateNodes (node, axis, angle);
+      this->refitBvh (node, true);
     }
   }
 
   void deleteNode (SketchNode& node, bool deleteChildren, const Dimension* dim)
   {
+    this->bvh.reset ();
+    this->instances.reset ();
     assert (this->tree.hasRoot ());
 
     if (node.parent () == nullptr)
@@ -647,6 +707,8 @@ struct SketchMesh::Impl
 
   void deletePath (SketchPath& path, const Dimension* dim)
   {
+    this->bvh.reset ();
+    this->instances.reset ();
     assert (this->paths.empty () == false);
 
     if (dim && this->paths.size () >= 2)
@@ -744,18 +806,24 @@ struct SketchMesh::Impl
 
   void mirrorPositive (Dimension dim)
   {
+    this->bvh.reset ();
+    this->instances.reset ();
     this->mirrorPositiveTree (dim);
     this->mirrorPositivePaths (dim);
   }
 
   void rebalance (SketchNode& newRoot)
   {
+    this->bvh.reset ();
+    this->instances.reset ();
     assert (this->tree.hasRoot ());
     this->tree.rebalance (newRoot);
   }
 
   SketchNode& snap (SketchNode& node, Dimension dim)
   {
+    this->bvh.reset ();
+    this->instances.reset ();
     assert (this->tree.hasRoot ());
     const PrimPlane mPlane = this->mirrorPlane (dim);
 
@@ -831,79 +899,71 @@ struct SketchMesh::Impl
             PrimSphere (this->mirrorPlane (*dim).mirror (range.center ()), range.radius ()),
             halfWidth, effect, intersection3.isIntersection () ? &intersection3.sphere () : nullptr,
             intersection4.isIntersection () ? &intersection4.sphere () : nullptr);
+          this->bvh.refitPath (this->paths, Util::findIndexByReference (this->paths, *mPath));
         }
       }
       path.smooth (range, halfWidth, effect,
                    intersection1.isIntersection () ? &intersection1.sphere () : nullptr,
                    intersection2.isIntersection () ? &intersection2.sphere () : nullptr);
+      this->bvh.refitPath (this->paths, Util::findIndexByReference (this->paths, path));
+      this->instances.reset ();
     }
   }
 
+  // A path sphere is deleted if it is contained in a bone or in a sphere of another path. Spheres
+  // are marked first and deleted afterwards, so that the BVH stays valid while being queried.
   void optimizePaths ()
   {
-    for (SketchPath& p1 : this->paths)
+    const SketchBvh&               bvh = this->builtBvh ();
+    std::vector<std::vector<bool>> marked;
+
+    marked.reserve (this->paths.size ());
+    for (unsigned int i = 0; i < this->paths.size (); i++)
     {
-      for (SketchPath& p2 : this->paths)
-      {
-        if (&p1 < &p2)
-        {
-          for (auto it1 = p1.spheres ().begin (); it1 != p1.spheres ().end ();)
-          {
-            bool deletedP1Sphere = false;
+      const SketchPath::Spheres& spheres = this->paths[i].spheres ();
 
-            for (auto it2 = p2.spheres ().begin (); it2 != p2.spheres ().end ();)
-            {
-              const PrimSphere& s1 = *it1;
-              const PrimSphere& s2 = *it2;
-              const float       d = glm::distance (s1.center (), s2.center ());
+      marked.emplace_back (spheres.size (), false);
 
-              if (s2.radius () > d + s1.radius ())
-              {
-                it1 = p1.deleteSphere (it1);
-                deletedP1Sphere = true;
-                break;
-              }
-              else if (s1.radius () > d + s2.radius ())
-              {
-                it2 = p2.deleteSphere (it2);
-              }
-              else
-              {
-                ++it2;
-              }
-            }
-            if (deletedP1Sphere == false)
-            {
-              ++it1;
-            }
-          }
-        }
-      }
-      if (this->tree.hasRoot ())
+      for (unsigned int j = 0; j < spheres.size (); j++)
       {
-        this->tree.root ().forEachNode ([&p1](SketchNode& node) {
-          if (node.parent ())
+        const PrimSphere& s1 = spheres[j];
+        bool              isContained = false;
+
+        bvh.intersects (s1, [this, i, &s1, &isContained](const SketchBvh::Element& e) {
+          if (isContained)
+          {
+            return;
+          }
+          else if (e.type == SketchBvh::ElementType::Bone)
           {
-            const PrimConeSphere coneSphere (node.data (), node.parent ()->data ());
+            const PrimConeSphere coneSphere (e.node->data (), e.node->parent ()->data ());
 
-            for (auto it1 = p1.spheres ().begin (); it1 != p1.spheres ().end ();)
-            {
-              const PrimSphere& s1 = *it1;
-              const float       d = Distance::distance (coneSphere, s1.center ());
+            isContained = Distance::distance (coneSphere, s1.center ()) < -s1.radius ();
+          }
+          else if (e.type == SketchBvh::ElementType::Sphere && e.path != i)
+          {
+            const PrimSphere& s2 = this->paths[e.path].spheres ()[e.sphere];
+            const float       d = glm::distance (s1.center (), s2.center ());
 
-              if (d < -s1.radius ())
-              {
-                it1 = p1.deleteSphere (it1);
-              }
-              else
-              {
-                ++it1;
-              }
-            }
+            isContained = s2.radius () > d + s1.radius ();
           }
         });
+        marked[i][j] = isContained;
       }
     }
+    for (unsigned int i = 0; i < this->paths.size (); i++)
+    {
+      this->paths[i].deleteSpheres (marked[i]);
+    }
+    this->bvh.reset ();
+    this->instances.reset ();
+  }
+
+  void join (SketchNode& node, const SketchNode& other)
+  {
+    other.forEachConstChild ([&node](const SketchNode& child) { node.addChild (child); });
+    this->bvh.reset ();
+    this->instances.reset ();
   }
 
   void runFromConfig (const Config& config)
@@ -911,12 +971,13 @@ struct SketchMesh::Impl
     this->renderConfig.nodeColor = config.get<Color> ("editor/sketch/node/color");
     this->renderConfig.bubbleColor = config.get<Color> ("editor/sketch/bubble/color");
     this->renderConfig.sphereColor = config.get<Color> ("editor/sketch/sphere/color");
+    this->preview.resolution (config.get<float> ("editor/sketch/preview/resolution"));
+    this->isPreviewOutdated = true;
   }
 };
 
 DELEGATE_BIG4_COPY_SELF (SketchMesh);
 GETTER_CONST (const SketchTree&, SketchMesh, tree)
-GETTER (SketchTree&, SketchMesh, tree)
 GETTER_CONST (const SketchPaths&, SketchMesh, paths)
 DELEGATE_CONST (bool, SketchMesh, isEmpty)
 DELEGATE1 (void, SketchMesh, fromTree, const SketchTree&)
@@ -927,6 +988,7 @@ DELEGATE3 (bool, SketchMesh, intersects, const PrimRay&, SketchMeshIntersection&
 DELEGATE2 (bool, SketchMesh, intersects, const PrimRay&, SketchPathIntersection&)
 DELEGATE1 (void, SketchMesh, render, Camera&)
 DELEGATE1 (void, SketchMesh, renderWireframe, bool)
+DELEGATE1 (void, SketchMesh, renderPreview, bool)
 DELEGATE1 (PrimPlane, SketchMesh, mirrorPlane, Dimension)
 DELEGATE4 (SketchNode&, SketchMesh, addChild, SketchNode&, const glm::vec3&, float,
            const Dimension*)
@@ -947,4 +1009,9 @@ DELEGATE2_CONST (void, SketchMesh, minMax, glm::vec3&, glm::vec3&)
 DELEGATE5 (void, SketchMesh, smoothPath, SketchPath&, const PrimSphere&, unsigned int,
            SketchPathSmoothEffect, const Dimension*)
 DELEGATE (void, SketchMesh, optimizePaths)
+DELEGATE2 (void, SketchMesh, join, SketchNode&, const SketchNode&)
 DELEGATE1 (void, SketchMesh, runFromConfig, const Config&)
+
+SketchTree& SketchMesh::tree () { return this->impl->mutableTree (); }
+
+const SketchBvh& SketchMesh::bvh () { return this->impl->builtBvh (); }
@@ -15,6 +15,7 @@ enum class Dimension;
 class PrimPlane;
 class PrimRay;
 class PrimSphere;
+class SketchBvh;
 enum class SketchPathSmoothEffect;
 
 class SketchMesh : public Configurable
@@ -23,8 +24,10 @@ public:
   DECLARE_BIG4_EXPLICIT_COPY (SketchMesh);
 
   const SketchTree&  tree () const;
+  // Mutable access invalidates all acceleration structures of the sketch
   SketchTree&        tree ();
   const SketchPaths& paths () const;
+  const SketchBvh&   bvh ();
   bool               isEmpty () const;
   void               fromTree (const SketchTree&);
   void               reset ();
@@ -34,6 +37,8 @@ public:
   bool        intersects (const PrimRay&, SketchPathIntersection&);
   void        render (Camera&);
   void        renderWireframe (bool);
+  // Renders a coarse mesh instead of bubbles and path spheres, which is extracted in the background
+  void        renderPreview (bool);
   PrimPlane   mirrorPlane (Dimension);
   SketchNode& addChild (SketchNode&, const glm::vec3&, float, const Dimension*);
   SketchNode& addParent (SketchNode&, const glm::vec3&, float, const Dimension*);
@@ -51,6 +56,7 @@ public:
   void        smoothPath (SketchPath&, const PrimSphere&, unsigned int, SketchPathSmoothEffect,
                           const Dimension*);
   void        optimizePaths ();
+  void        join (SketchNode&, const SketchNode&);
 
 private:
   IMPLEMENTATION
@@ -1,4 +1,3 @@
-#include "../mesh.hpp"
 #include "intersection.hpp"
 #include "primitive/aabox.hpp"
 #include "primitive/plane.hpp"
@@ -7,6 +6,55 @@
 #include "sketch/path.hpp"
 #include "util.hpp"
 
+namespace
+{
+  // Terms that an effect adds to the spheres at one end of a path when smoothing
+  struct EndTerms
+  {
+    glm::vec3    center;
+    float        radius;
+    unsigned int numCenters;
+    unsigned int numRadii;
+
+    EndTerms (SketchPathSmoothEffect effect, const PrimSphere* nearest,
+              const glm::vec3& intersection)
+      : center (0.0f)
+      , radius (0.0f)
+      , numCenters (0)
+      , numRadii (0)
+    {
+      const bool effectEmbeds = effect == SketchPathSmoothEffect::Embed ||
+                                effect == SketchPathSmoothEffect::EmbedAndAdjust;
+
+      if (nearest && effectEmbeds)
+      {
+        this->numCenters++;
+        this->center += nearest->center ();
+      }
+
+      if (nearest && effect == SketchPathSmoothEffect::EmbedAndAdjust)
+      {
+        this->numRadii++;
+        this->radius += nearest->radius ();
+      }
+      else if (effect == SketchPathSmoothEffect::Pinch)
+      {
+        this->numRadii++;
+        this->numCenters++;
+        this->center += intersection;
+      }
+    }
+
+    void addTo (glm::vec3& c, float& r, unsigned int& nC, unsigned int& nR) const
+    {
+      c += this->center;
+      r += this->radius;
+      nC += this->numCenters;
+      nR += this->numRadii;
+    }
+  };
+}
+
 struct SketchPath::Impl
 {
   SketchPath*         self;
@@ -70,19 +118,23 @@ struct SketchPath::Impl
     this->spheres.emplace_back (position, radius);
   }
 
-  SketchPath::Spheres::iterator deleteSphere (SketchPath::Spheres::const_iterator it)
+  void deleteSpheres (const std::vector<bool>& marked)
   {
-    return this->spheres.erase (it);
-  }
+    assert (marked.size () == this->spheres.size ());
 
-  void render (Camera& camera, Mesh& mesh) const
-  {
-    for (const PrimSphere& s : this->spheres)
+    unsigned int n = 0;
+    for (unsigned int i = 0; i < this->spheres.size (); i++)
     {
-      mesh.position (s.center ());
-      mesh.scaling (glm::vec3 (s.radius ()));
-      mesh.render (camera);
+      if (marked[i] == false)
+      {
+        if (n != i)
+        {
+          this->spheres[n] = this->spheres[i];
+        }
+        n++;
+      }
     }
+    this->spheres.erase (this->spheres.begin () + n, this->spheres.end ());
   }
 
   bool intersects (const PrimRay& ray, SketchMesh& mesh, SketchPathIntersection& intersection)
@@ -142,76 +194,46 @@ struct SketchPath::Impl
     return mirrored;
   }
 
+  // Spheres are averaged with the unsmoothed spheres of their window, whose sums are taken from
+  // prefix sums, so that the costs do not depend on `halfWidth`
   void smooth (const PrimSphere& range, unsigned int halfWidth, SketchPathSmoothEffect effect,
                const PrimSphere* nearestToFirst, const PrimSphere* nearestToLast)
   {
     const unsigned int numS = this->spheres.size ();
 
+    std::vector<glm::dvec3> centerSums (numS + 1, glm::dvec3 (0.0));
+    std::vector<double>     radiusSums (numS + 1, 0.0);
+
+    for (unsigned int i = 0; i < numS; i++)
+    {
+      centerSums[i + 1] = centerSums[i] + glm::dvec3 (this->spheres[i].center ());
+      radiusSums[i + 1] = radiusSums[i] + double(this->spheres[i].radius ());
+    }
+
+    const EndTerms first (effect, nearestToFirst, this->intersectionFirst);
+    const EndTerms last (effect, nearestToLast, this->intersectionLast);
+
     for (unsigned int i = 0; i < numS; i++)
     {
-      if (IntersectionUtil::intersects (range, this->spheres.at (i)))
+      if (IntersectionUtil::intersects (range, this->spheres[i]))
       {
-        const unsigned int hW =
-          i < halfWidth ? i : (i >= numS - halfWidth ? numS - i - 1 : halfWidth);
-        glm::vec3 center (0.0f);
-        float     radius (0.0f);
-        for (unsigned int j = i - hW; j <= i + hW; j++)
-        {
-          center += this->spheres.at (j).center ();
-          radius += this->spheres.at (j).radius ();
-        }
+        const unsigned int hW = glm::min (halfWidth, glm::min (i, numS - i - 1));
 
-        const bool effectEmbeds = effect == SketchPathSmoothEffect::Embed ||
-                                  effect == SketchPathSmoothEffect::EmbedAndAdjust;
-        unsigned int numAffectedCenter = 0;
-        unsigned int numAffectedRadius = 0;
+        glm::vec3    center (centerSums[i + hW + 1] - centerSums[i - hW]);
+        float        radius (radiusSums[i + hW + 1] - radiusSums[i - hW]);
+        unsigned int numCenters = (2 * hW) + 1;
+        unsigned int numRadii = (2 * hW) + 1;
 
-        if (effect != SketchPathSmoothEffect::None)
+        if (i < halfWidth)
         {
-          if (i < halfWidth)
-          {
-            if (nearestToFirst && effectEmbeds)
-            {
-              numAffectedCenter++;
-              center += nearestToFirst->center ();
-            }
-
-            if (nearestToFirst && effect == SketchPathSmoothEffect::EmbedAndAdjust)
-            {
-              numAffectedRadius++;
-              radius += nearestToFirst->radius ();
-            }
-            else if (effect == SketchPathSmoothEffect::Pinch)
-            {
-              numAffectedRadius++;
-              numAffectedCenter++;
-              center += this->intersectionFirst;
-            }
-          }
-
-          if (i >= numS - halfWidth)
-          {
-            if (nearestToLast && effectEmbeds)
-            {
-              numAffectedCenter++;
-              center += nearestToLast->center ();
-            }
-
-            if (nearestToLast && effect == SketchPathSmoothEffect::EmbedAndAdjust)
-            {
-              numAffectedRadius++;
-              radius += nearestToLast->radius ();
-            }
-            else if (effect == SketchPathSmoothEffect::Pinch)
-            {
-              numAffectedRadius++;
-              numAffectedCenter++;
-              center += this->intersectionLast;
-            }
-          }
+          first.addTo (center, radius, numCenters, numRadii);
+        }
+        if (i + halfWidth >= numS)
+        {
+          last.addTo (center, radius, numCenters, numRadii);
         }
-        this->spheres.at (i).center (center / float((2 * hW) + 1 + numAffectedCenter));
-        this->spheres.at (i).radius (radius / float((2 * hW) + 1 + numAffectedRadius));
+        this->spheres[i].center (center / float(numCenters));
+        this->spheres[i].radius (radius / float(numRadii));
       }
     }
     this->setMinMax ();
@@ -230,9 +252,7 @@ DELEGATE (void, SketchPath, reset)
 DELEGATE_CONST (bool, SketchPath, isEmpty)
 DELEGATE_CONST (PrimAABox, SketchPath, aabox)
 DELEGATE3 (void, SketchPath, addSphere, const glm::vec3&, const glm::vec3&, float)
-DELEGATE1 (SketchPath::Spheres::iterator, SketchPath, deleteSphere,
-           SketchPath::Spheres::const_iterator)
-DELEGATE2_CONST (void, SketchPath, render, Camera&, Mesh&)
+DELEGATE1 (void, SketchPath, deleteSpheres, const std::vector<bool>&)
 DELEGATE3 (bool, SketchPath, intersects, const PrimRay&, SketchMesh&, SketchPathIntersection&)
 DELEGATE1 (SketchPath, SketchPath, mirrorPositive, const PrimPlane&)
 DELEGATE5 (void, SketchPath, smooth, const PrimSphere&, unsigned int, SketchPathSmoothEffect,
@@ -9,9 +9,7 @@
 #include "macro.hpp"
 #include "sketch/fwd.hpp"
 
-class Camera;
 class Intersection;
-class Mesh;
 class PrimAABox;
 class PrimPlane;
 class PrimRay;
@@ -42,8 +40,7 @@ public:
   bool              isEmpty () const;
   PrimAABox         aabox () const;
   void              addSphere (const glm::vec3&, const glm::vec3&, float);
-  Spheres::iterator deleteSphere (Spheres::const_iterator);
-  void              render (Camera&, Mesh&) const;
+  void              deleteSpheres (const std::vector<bool>&);
   bool              intersects (const PrimRay&, SketchMesh&, SketchPathIntersection&);
   SketchPath        mirrorPositive (const PrimPlane&);
   void smooth (const PrimSphere&, unsigned int, SketchPathSmoothEffect, const PrimSphere*,
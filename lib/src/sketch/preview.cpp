@@ -0,0 +1,818 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <glm/gtx/norm.hpp>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "../mesh.hpp"
+#include "color.hpp"
+#include "distance.hpp"
+#include "primitive/cone-sphere.hpp"
+#include "sketch/path.hpp"
+#include "sketch/preview.hpp"
+#include "util.hpp"
+
+/* Samples lie on the lattice `index * resolution`. A brick owns the cubes and edges of
+ * `brickSize` samples per axis and additionally stores the samples next to its sides, so that
+ * it can place the vertices of all cubes around its edges:
+ *
+ *  samples of brick b:  b * brickSize - 1 ... (b + 1) * brickSize
+ *  edges of brick b:    b * brickSize     ... (b + 1) * brickSize - 1
+ *
+ * Neighboring bricks compute the same cube vertices from the same samples.
+ */
+namespace
+{
+  static const int brickSize = 8;
+  static const int numBrickSamples = brickSize + 2;
+  static const int numBrickCubes = brickSize + 1;
+
+  // A sample that is at least this many cells away from a primitive is not affected by the
+  // primitive or is too far away from the surface to affect any vertex
+  static const float marginPerResolution = 2.0f;
+
+  // 21 bits per brick coordinate
+  static const int keyOffset = 1 << 20;
+
+  // Bones are stored as cone-spheres, all other primitives as two equal spheres
+  struct Primitive
+  {
+    glm::vec4 sphere1;
+    glm::vec4 sphere2;
+
+    Primitive (const PrimSphere& s1, const PrimSphere& s2)
+      : sphere1 (s1.center (), s1.radius ())
+      , sphere2 (s2.center (), s2.radius ())
+    {
+    }
+
+    bool isSphere () const { return this->sphere1 == this->sphere2; }
+
+    PrimSphere primSphere1 () const
+    {
+      return PrimSphere (glm::vec3 (this->sphere1), this->sphere1.w);
+    }
+
+    PrimSphere primSphere2 () const
+    {
+      return PrimSphere (glm::vec3 (this->sphere2), this->sphere2.w);
+    }
+
+    glm::vec3 minimum () const
+    {
+      return glm::min (glm::vec3 (this->sphere1) - this->sphere1.w,
+                       glm::vec3 (this->sphere2) - this->sphere2.w);
+    }
+
+    glm::vec3 maximum () const
+    {
+      return glm::max (glm::vec3 (this->sphere1) + this->sphere1.w,
+                       glm::vec3 (this->sphere2) + this->sphere2.w);
+    }
+  };
+
+  bool operator< (const Primitive& a, const Primitive& b)
+  {
+    for (unsigned int i = 0; i < 8; i++)
+    {
+      const float va = i < 4 ? a.sphere1[i] : a.sphere2[i - 4];
+      const float vb = i < 4 ? b.sphere1[i] : b.sphere2[i - 4];
+
+      if (va != vb)
+      {
+        return va < vb;
+      }
+    }
+    return false;
+  }
+
+  // Non-root nodes are covered by the bones to their parents
+  std::vector<Primitive> primitives (const SketchTree& tree, const SketchPaths& paths)
+  {
+    std::vector<Primitive> result;
+
+    if (tree.hasRoot ())
+    {
+      tree.root ().forEachConstNode ([&result](const SketchNode& node) {
+        if (node.parent ())
+        {
+          result.emplace_back (node.data (), node.parent ()->data ());
+        }
+        else
+        {
+          result.emplace_back (node.data (), node.data ());
+        }
+      });
+    }
+    for (const SketchPath& p : paths)
+    {
+      for (const PrimSphere& s : p.spheres ())
+      {
+        result.emplace_back (s, s);
+      }
+    }
+    std::sort (result.begin (), result.end ());
+    return result;
+  }
+
+  uint64_t brickKey (const glm::ivec3& brick)
+  {
+    const glm::uvec3 k (brick + glm::ivec3 (keyOffset));
+    return uint64_t (k.x) | (uint64_t (k.y) << 21) | (uint64_t (k.z) << 42);
+  }
+
+  glm::ivec3 brickCoordinates (uint64_t key)
+  {
+    const uint64_t mask = (uint64_t (1) << 21) - 1;
+    const int      x = int(key & mask);
+    const int      y = int((key >> 21) & mask);
+    const int      z = int((key >> 42) & mask);
+
+    return glm::ivec3 (x, y, z) - glm::ivec3 (keyOffset);
+  }
+
+  bool isIntersecting (float s1, float s2)
+  {
+    return (s1 < 0.0f && s2 >= 0.0f) || (s1 >= 0.0f && s2 < 0.0f);
+  }
+
+  struct BrickMesh
+  {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+  };
+
+  // A brick either samples all primitives, or extends the cached samples of a previous extraction
+  // by primitives that have been added since
+  class Brick
+  {
+  public:
+    Brick (const glm::ivec3& brick, float r, std::vector<float>&& s)
+      : first ((brick * brickSize) - glm::ivec3 (1))
+      , resolution (r)
+      , isExtending (s.empty () == false)
+      , samples (std::move (s))
+      , cubeVertices (numBrickCubes * numBrickCubes * numBrickCubes)
+      , cubeNormals (numBrickCubes * numBrickCubes * numBrickCubes)
+    {
+      if (this->samples.empty ())
+      {
+        this->samples.resize (numBrickSamples * numBrickSamples * numBrickSamples,
+                              Util::maxFloat ());
+      }
+    }
+
+    // Samples of a brick that is too far away from all primitives are not kept
+    BrickMesh extract (const std::vector<Primitive>& primitives, std::vector<float>& keptSamples)
+    {
+      BrickMesh mesh;
+
+      if (this->sample (primitives))
+      {
+        if (this->hasSurface ())
+        {
+          this->placeVertices ();
+          this->addPolygons (mesh);
+        }
+        keptSamples = std::move (this->samples);
+      }
+      return mesh;
+    }
+
+  private:
+    glm::vec3 position (const glm::ivec3& s) const
+    {
+      return glm::vec3 (this->first + s) * this->resolution;
+    }
+
+    unsigned int sampleIndex (const glm::ivec3& s) const
+    {
+      return s.x + (numBrickSamples * (s.y + (numBrickSamples * s.z)));
+    }
+
+    unsigned int cubeIndex (const glm::ivec3& c) const
+    {
+      return c.x + (numBrickCubes * (c.y + (numBrickCubes * c.z)));
+    }
+
+    // Only primitives that may be closest to some sample of the brick are evaluated. Returns
+    // `false` if all primitives are too far away from the brick to affect its surface.
+    bool sample (const std::vector<Primitive>& primitives)
+    {
+      if (primitives.empty ())
+      {
+        return this->isExtending;
+      }
+
+      const glm::vec3 min = this->position (glm::ivec3 (0));
+      const glm::vec3 max = this->position (glm::ivec3 (numBrickSamples - 1));
+      const glm::vec3 center = 0.5f * (min + max);
+      const float     radius = 0.5f * glm::distance (min, max);
+
+      std::vector<PrimSphere>     spheres;
+      std::vector<PrimConeSphere> coneSpheres;
+      std::vector<float>          centerDistances;
+      float                       minCenterDistance = Util::maxFloat ();
+
+      centerDistances.reserve (primitives.size ());
+      for (const Primitive& p : primitives)
+      {
+        const float d = p.isSphere ()
+                          ? Distance::distance (p.primSphere1 (), center)
+                          : Distance::distance (PrimConeSphere (p.primSphere1 (), p.primSphere2 ()),
+                                                center);
+        centerDistances.push_back (d);
+        minCenterDistance = glm::min (minCenterDistance, d);
+      }
+      if (minCenterDistance - radius > marginPerResolution * this->resolution)
+      {
+        return this->isExtending;
+      }
+
+      for (unsigned int i = 0; i < primitives.size (); i++)
+      {
+        if (centerDistances[i] <= minCenterDistance + (2.0f * radius))
+        {
+          if (primitives[i].isSphere ())
+          {
+            spheres.push_back (primitives[i].primSphere1 ());
+          }
+          else
+          {
+            coneSpheres.emplace_back (primitives[i].primSphere1 (), primitives[i].primSphere2 ());
+          }
+        }
+      }
+
+      for (int z = 0; z < numBrickSamples; z++)
+      {
+        for (int y = 0; y < numBrickSamples; y++)
+        {
+          for (int x = 0; x < numBrickSamples; x++)
+          {
+            const glm::ivec3 s (x, y, z);
+            const glm::vec3  pos = this->position (s);
+            float&           distance = this->samples[this->sampleIndex (s)];
+
+            for (const PrimSphere& sphere : spheres)
+            {
+              distance = glm::min (distance, Distance::distance (sphere, pos));
+            }
+            for (const PrimConeSphere& coneSphere : coneSpheres)
+            {
+              distance = glm::min (distance, Distance::distance (coneSphere, pos));
+            }
+          }
+        }
+      }
+      return true;
+    }
+
+    bool hasSurface () const
+    {
+      bool hasInside = false;
+      bool hasOutside = false;
+
+      for (float s : this->samples)
+      {
+        hasInside = hasInside || s < 0.0f;
+        hasOutside = hasOutside || s >= 0.0f;
+      }
+      return hasInside && hasOutside;
+    }
+
+    // Vertices are mass points of the edge crossings of their cube, normals are gradients of the
+    // cube's samples
+    void placeVertices ()
+    {
+      for (int z = 0; z < numBrickCubes; z++)
+      {
+        for (int y = 0; y < numBrickCubes; y++)
+        {
+          for (int x = 0; x < numBrickCubes; x++)
+          {
+            const glm::ivec3 cube (x, y, z);
+            float            s[8];
+            glm::vec3        p[8];
+
+            for (int c = 0; c < 8; c++)
+            {
+              const glm::ivec3 corner = cube + glm::ivec3 (c & 1, (c >> 1) & 1, (c >> 2) & 1);
+
+              s[c] = this->samples[this->sampleIndex (corner)];
+              p[c] = this->position (corner);
+            }
+
+            glm::vec3    sum (0.0f);
+            unsigned int numCrossings = 0;
+
+            for (int c1 = 0; c1 < 8; c1++)
+            {
+              for (int axis = 0; axis < 3; axis++)
+              {
+                const int c2 = c1 | (1 << axis);
+
+                if (c1 != c2 && isIntersecting (s[c1], s[c2]))
+                {
+                  sum += glm::mix (p[c1], p[c2], s[c1] / (s[c1] - s[c2]));
+                  numCrossings++;
+                }
+              }
+            }
+
+            if (numCrossings > 0)
+            {
+              const glm::vec3 gradient (s[1] + s[3] + s[5] + s[7] - s[0] - s[2] - s[4] - s[6],
+                                        s[2] + s[3] + s[6] + s[7] - s[0] - s[1] - s[4] - s[5],
+                                        s[4] + s[5] + s[6] + s[7] - s[0] - s[1] - s[2] - s[3]);
+
+              const unsigned int index = this->cubeIndex (cube);
+
+              this->cubeVertices[index] = sum / float(numCrossings);
+              this->cubeNormals[index] = glm::length2 (gradient) > 0.0f
+                                           ? glm::normalize (gradient)
+                                           : glm::vec3 (0.0f, 1.0f, 0.0f);
+            }
+          }
+        }
+      }
+    }
+
+    void addVertex (BrickMesh& mesh, unsigned int cube) const
+    {
+      mesh.vertices.push_back (this->cubeVertices[cube]);
+      mesh.normals.push_back (this->cubeNormals[cube]);
+    }
+
+    // Quads are split along their shorter diagonal
+    void addQuad (BrickMesh& mesh, const std::array<unsigned int, 4>& q) const
+    {
+      const float d02 = glm::distance2 (this->cubeVertices[q[0]], this->cubeVertices[q[2]]);
+      const float d13 = glm::distance2 (this->cubeVertices[q[1]], this->cubeVertices[q[3]]);
+
+      const std::array<unsigned int, 6> triangles =
+        d02 <= d13 ? std::array<unsigned int, 6>{{q[0], q[1], q[2], q[0], q[2], q[3]}}
+                   : std::array<unsigned int, 6>{{q[0], q[1], q[3], q[1], q[2], q[3]}};
+
+      for (unsigned int cube : triangles)
+      {
+        this->addVertex (mesh, cube);
+      }
+    }
+
+    // The cubes around an edge along `axis` are ordered counter-clockwise when looking against
+    // the axis. Quads face from inside to outside.
+    void addPolygons (BrickMesh& mesh) const
+    {
+      for (int z = 1; z <= brickSize; z++)
+      {
+        for (int y = 1; y <= brickSize; y++)
+        {
+          for (int x = 1; x <= brickSize; x++)
+          {
+            const glm::ivec3 s (x, y, z);
+            const float      s1 = this->samples[this->sampleIndex (s)];
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+              glm::ivec3 e (0), u (0), v (0);
+              e[axis] = 1;
+              u[(axis + 1) % 3] = 1;
+              v[(axis + 2) % 3] = 1;
+
+              const float s2 = this->samples[this->sampleIndex (s + e)];
+
+              if (isIntersecting (s1, s2))
+              {
+                const unsigned int c0 = this->cubeIndex (s - u - v);
+                const unsigned int c1 = this->cubeIndex (s - v);
+                const unsigned int c2 = this->cubeIndex (s);
+                const unsigned int c3 = this->cubeIndex (s - u);
+
+                if (s1 < 0.0f)
+                {
+                  this->addQuad (mesh, {{c0, c1, c2, c3}});
+                }
+                else
+                {
+                  this->addQuad (mesh, {{c3, c2, c1, c0}});
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+
+    const glm::ivec3       first;
+    const float            resolution;
+    const bool             isExtending;
+    std::vector<float>     samples;
+    std::vector<glm::vec3> cubeVertices;
+    std::vector<glm::vec3> cubeNormals;
+  };
+
+  // Bricks to extract in the background. Bricks without samples sample all primitives, bricks
+  // with cached samples only the added ones. Jobs only work on copies, so sketches may be edited
+  // meanwhile. A cancelled job is abandoned by the workers after their current brick.
+  struct Job
+  {
+    const float                     resolution;
+    const std::vector<Primitive>    primitives;
+    const std::vector<Primitive>    addedPrimitives;
+    const std::vector<uint64_t>     keys;
+    std::vector<std::vector<float>> samples;
+    std::vector<BrickMesh>          meshes;
+    std::atomic<unsigned int>       nextBrick;
+    std::atomic<unsigned int>       numFinished;
+    std::atomic<bool>               isDone;
+    std::atomic<bool>               isCancelled;
+
+    Job (float r, const std::vector<Primitive>& ps, std::vector<Primitive>&& as,
+         std::vector<uint64_t>&& ks, std::vector<std::vector<float>>&& ss)
+      : resolution (r)
+      , primitives (ps)
+      , addedPrimitives (std::move (as))
+      , keys (std::move (ks))
+      , samples (std::move (ss))
+      , nextBrick (0)
+      , numFinished (0)
+      , isDone (false)
+      , isCancelled (false)
+    {
+      this->meshes.resize (this->keys.size ());
+    }
+  };
+
+  // Workers that are shared by all previews and process jobs in the order they were pushed
+  class Workers
+  {
+  public:
+    Workers ()
+      : isStopped (false)
+    {
+      const unsigned int numThreads = glm::max (1u, std::thread::hardware_concurrency ());
+
+      for (unsigned int t = 0; t < numThreads; t++)
+      {
+        this->threads.emplace_back ([this]() { this->run (); });
+      }
+    }
+
+    ~Workers ()
+    {
+      {
+        std::lock_guard<std::mutex> lock (this->mutex);
+        this->isStopped = true;
+      }
+      this->pushed.notify_all ();
+
+      for (std::thread& thread : this->threads)
+      {
+        thread.join ();
+      }
+    }
+
+    void push (const std::shared_ptr<Job>& job)
+    {
+      {
+        std::lock_guard<std::mutex> lock (this->mutex);
+        this->jobs.push_back (job);
+      }
+      this->pushed.notify_all ();
+    }
+
+    void onFinishedJob (const std::function<void()>& f)
+    {
+      std::lock_guard<std::mutex> lock (this->mutex);
+      this->finishedJob = f;
+    }
+
+  private:
+    void run ()
+    {
+      std::unique_lock<std::mutex> lock (this->mutex);
+
+      while (true)
+      {
+        this->pushed.wait (lock,
+                           [this]() { return this->isStopped || this->jobs.empty () == false; });
+
+        if (this->isStopped)
+        {
+          return;
+        }
+        const std::shared_ptr<Job> job = this->jobs.front ();
+        const unsigned int         i = job->nextBrick++;
+
+        if (i >= job->keys.size () || job->isCancelled)
+        {
+          this->jobs.pop_front ();
+          continue;
+        }
+        lock.unlock ();
+
+        const bool isCached = job->samples[i].empty () == false;
+        Brick      brick (brickCoordinates (job->keys[i]), job->resolution,
+                         std::move (job->samples[i]));
+
+        job->meshes[i] =
+          brick.extract (isCached ? job->addedPrimitives : job->primitives, job->samples[i]);
+
+        const bool isDone = ++job->numFinished == job->keys.size ();
+        if (isDone)
+        {
+          job->isDone = true;
+        }
+        lock.lock ();
+
+        if (isDone && job->isCancelled == false && this->finishedJob)
+        {
+          this->finishedJob ();
+        }
+      }
+    }
+
+    std::mutex                       mutex;
+    std::condition_variable          pushed;
+    std::deque<std::shared_ptr<Job>> jobs;
+    bool                             isStopped;
+    std::function<void()>            finishedJob;
+    std::vector<std::thread>         threads;
+  };
+
+  Workers& workers ()
+  {
+    static Workers workers;
+    return workers;
+  }
+}
+
+struct SketchPreview::Impl
+{
+  float                                            resolution;
+  std::vector<Primitive>                           primitives;
+  std::vector<Primitive>                           addedPrimitives;
+  std::unordered_set<uint64_t>                     dirtyBricks;
+  std::unordered_set<uint64_t>                     extendedBricks;
+  std::unordered_map<uint64_t, std::vector<float>> samples;
+  std::unordered_map<uint64_t, BrickMesh>          bricks;
+  std::shared_ptr<Job>                             job;
+  Mesh                                             mesh;
+  bool                                             isMeshOutdated;
+
+  Impl ()
+    : resolution (0.0f)
+    , isMeshOutdated (false)
+  {
+  }
+
+  ~Impl () { this->cancelJob (); }
+
+  void setResolution (float r)
+  {
+    if (r != this->resolution)
+    {
+      this->reset ();
+      this->resolution = r;
+    }
+  }
+
+  bool isPending () const
+  {
+    return this->job || this->dirtyBricks.empty () == false ||
+           this->extendedBricks.empty () == false;
+  }
+
+  void markBricks (const Primitive& primitive, std::unordered_set<uint64_t>& marked)
+  {
+    const float      margin = marginPerResolution * this->resolution;
+    const glm::vec3  min = (primitive.minimum () - margin) / this->resolution;
+    const glm::vec3  max = (primitive.maximum () + margin) / this->resolution;
+    const glm::ivec3 minBrick (glm::ceil ((min - float(brickSize)) / float(brickSize)));
+    const glm::ivec3 maxBrick (glm::floor ((max + 1.0f) / float(brickSize)));
+
+    for (int z = minBrick.z; z <= maxBrick.z; z++)
+    {
+      for (int y = minBrick.y; y <= maxBrick.y; y++)
+      {
+        for (int x = minBrick.x; x <= maxBrick.x; x++)
+        {
+          marked.insert (brickKey (glm::ivec3 (x, y, z)));
+        }
+      }
+    }
+  }
+
+  void update (const SketchTree& tree, const SketchPaths& paths)
+  {
+    assert (this->resolution > 0.0f);
+
+    std::vector<Primitive> newPrimitives = ::primitives (tree, paths);
+    std::vector<Primitive> removed;
+    std::vector<Primitive> added;
+
+    std::set_difference (this->primitives.begin (), this->primitives.end (),
+                         newPrimitives.begin (), newPrimitives.end (),
+                         std::back_inserter (removed));
+    std::set_difference (newPrimitives.begin (), newPrimitives.end (),
+                         this->primitives.begin (), this->primitives.end (),
+                         std::back_inserter (added));
+
+    for (const Primitive& p : removed)
+    {
+      this->markBricks (p, this->dirtyBricks);
+    }
+    for (const Primitive& p : added)
+    {
+      this->markBricks (p, this->extendedBricks);
+    }
+    this->addedPrimitives.insert (this->addedPrimitives.end (), added.begin (), added.end ());
+    this->primitives = std::move (newPrimitives);
+    this->startJob ();
+  }
+
+  // Bricks around removed primitives are sampled anew. Bricks around added primitives extend
+  // their cached samples, unless they have none.
+  void startJob ()
+  {
+    if (this->job == nullptr && this->isPending ())
+    {
+      std::vector<uint64_t>           keys;
+      std::vector<std::vector<float>> keySamples;
+      std::vector<Primitive>          added;
+
+      for (uint64_t key : this->dirtyBricks)
+      {
+        keys.push_back (key);
+        keySamples.emplace_back ();
+        this->samples.erase (key);
+      }
+      for (uint64_t key : this->extendedBricks)
+      {
+        if (this->dirtyBricks.count (key) == 0)
+        {
+          auto cached = this->samples.find (key);
+
+          keys.push_back (key);
+          keySamples.emplace_back ();
+
+          if (cached != this->samples.end ())
+          {
+            keySamples.back () = std::move (cached->second);
+            this->samples.erase (cached);
+          }
+        }
+      }
+
+      // Primitives that have been added and removed again have marked their bricks dirty
+      for (const Primitive& p : this->addedPrimitives)
+      {
+        if (std::binary_search (this->primitives.begin (), this->primitives.end (), p))
+        {
+          added.push_back (p);
+        }
+      }
+
+      this->dirtyBricks.clear ();
+      this->extendedBricks.clear ();
+      this->addedPrimitives.clear ();
+      this->job = std::make_shared<Job> (this->resolution, this->primitives, std::move (added),
+                                         std::move (keys), std::move (keySamples));
+      workers ().push (this->job);
+    }
+  }
+
+  // Does not wait for the workers, which drop the job after their current brick
+  void cancelJob ()
+  {
+    if (this->job)
+    {
+      this->job->isCancelled = true;
+      this->job.reset ();
+    }
+  }
+
+  unsigned int numPendingBricks () const
+  {
+    return (this->job ? this->job->keys.size () : 0) + this->dirtyBricks.size () +
+           this->extendedBricks.size ();
+  }
+
+  unsigned int numVertices () const
+  {
+    unsigned int n = 0;
+    for (const auto& b : this->bricks)
+    {
+      n += b.second.vertices.size ();
+    }
+    return n;
+  }
+
+  // Bricks of a finished job are current unless they were marked again, in which case the next
+  // job extracts them anew
+  bool finishJob ()
+  {
+    if (this->job && this->job->isDone)
+    {
+      for (unsigned int i = 0; i < this->job->keys.size (); i++)
+      {
+        BrickMesh& brickMesh = this->job->meshes[i];
+
+        if (this->job->samples[i].empty () == false)
+        {
+          this->samples[this->job->keys[i]] = std::move (this->job->samples[i]);
+        }
+
+        if (brickMesh.vertices.empty ())
+        {
+          this->bricks.erase (this->job->keys[i]);
+        }
+        else
+        {
+          this->bricks[this->job->keys[i]] = std::move (brickMesh);
+        }
+      }
+      this->job.reset ();
+      this->isMeshOutdated = true;
+      this->startJob ();
+      return true;
+    }
+    return false;
+  }
+
+  void updateMesh ()
+  {
+    const unsigned int numVertices = this->numVertices ();
+
+    this->mesh.resetGeometry ();
+    this->mesh.reserveVertices (numVertices);
+    this->mesh.reserveIndices (numVertices);
+
+    for (const auto& b : this->bricks)
+    {
+      this->mesh.addVertices (b.second.vertices.data (), b.second.normals.data (),
+                              b.second.vertices.size ());
+    }
+    for (unsigned int i = 0; i < numVertices; i++)
+    {
+      this->mesh.addIndex (i);
+    }
+    this->mesh.bufferData ();
+    this->isMeshOutdated = false;
+  }
+
+  void reset ()
+  {
+    this->cancelJob ();
+    this->primitives.clear ();
+    this->addedPrimitives.clear ();
+    this->dirtyBricks.clear ();
+    this->extendedBricks.clear ();
+    this->samples.clear ();
+    this->bricks.clear ();
+    this->isMeshOutdated = true;
+  }
+
+  void render (Camera& camera, const Color& color)
+  {
+    this->finishJob ();
+
+    if (this->isMeshOutdated)
+    {
+      this->updateMesh ();
+    }
+    if (this->mesh.numIndices () > 0)
+    {
+      this->mesh.color (color);
+      this->mesh.render (camera);
+    }
+  }
+};
+
+DELEGATE_BIG3 (SketchPreview)
+GETTER_CONST (float, SketchPreview, resolution)
+DELEGATE_CONST (bool, SketchPreview, isPending)
+DELEGATE_CONST (unsigned int, SketchPreview, numPendingBricks)
+DELEGATE_CONST (unsigned int, SketchPreview, numVertices)
+DELEGATE2 (void, SketchPreview, update, const SketchTree&, const SketchPaths&)
+DELEGATE (bool, SketchPreview, finishJob)
+DELEGATE (void, SketchPreview, reset)
+DELEGATE2 (void, SketchPreview, render, Camera&, const Color&)
+
+void SketchPreview::resolution (float r) { this->impl->setResolution (r); }
+
+void SketchPreview::onFinishedJob (const std::function<void()>& f) { workers ().onFinishedJob (f); }
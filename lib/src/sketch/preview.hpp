@@ -0,0 +1,42 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_SKETCH_PREVIEW
+#define DILAY_SKETCH_PREVIEW
+
+#include <functional>
+#include "macro.hpp"
+#include "sketch/fwd.hpp"
+
+class Camera;
+class Color;
+
+// Coarse mesh of a sketch that follows its edits. Distances are cached in bricks of a fixed
+// lattice: an update only resamples the bricks around primitives that were deleted since the last
+// update, and only evaluates added primitives in the bricks around them. This is done on a
+// background thread. Bricks share their border samples, so their meshes fit together without
+// being merged.
+class SketchPreview
+{
+public:
+  DECLARE_BIG3 (SketchPreview)
+
+  float        resolution () const;
+  void         resolution (float);
+  bool         isPending () const;
+  unsigned int numPendingBricks () const;
+  unsigned int numVertices () const;
+  void         update (const SketchTree&, const SketchPaths&);
+  bool         finishJob ();
+  void         reset ();
+  void         render (Camera&, const Color&);
+
+  // Called on a worker thread whenever a job has been finished, e.g., to schedule a repaint
+  static void onFinishedJob (const std::function<void()>&);
+
+private:
+  IMPLEMENTATION
+};
+
+#endif
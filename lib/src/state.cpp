@@ -3,7 +3,9 @@
  * Use and redistribute under the terms of the GNU General Public License
  */
 #include <QShortcut>
+#include <QTimer>
 #include <memory>
+#include "autosave.hpp"
 #include "cache.hpp"
 #include "camera.hpp"
 #include "config.hpp"
@@ -36,6 +38,8 @@ struct State::Impl
   Camera                  camera;
   History                 history;
   Scene                   scene;
+  Autosave                autosave;
+  QTimer                  autosaveTimer;
   std::unique_ptr<Tool>   toolPtr;
   Maybe<ToolKey>          previousToolKey;
   std::vector<QShortcut*> shortcuts;
@@ -48,8 +52,12 @@ struct State::Impl
     , camera (this->config)
     , history (this->config)
     , scene (this->config)
+    , autosave (this->config, Autosave::journalFileName ())
   {
     this->resetTool ();
+
+    QObject::connect (&this->autosaveTimer, &QTimer::timeout, [this]() { this->checkpoint (); });
+    this->startAutosave ();
   }
 
   bool hasTool () const { return bool(this->toolPtr); }
@@ -301,11 +309,50 @@ struct State::Impl
     this->camera.fromConfig (this->config);
     this->history.fromConfig (this->config);
     this->scene.fromConfig (this->config);
+    this->autosave.fromConfig (this->config);
 
     if (this->hasTool ())
     {
       this->toolPtr->fromConfig ();
     }
+    this->startAutosave ();
+  }
+
+  void startAutosave ()
+  {
+    if (this->autosave.interval () > 0)
+    {
+      this->autosaveTimer.start (this->autosave.interval ());
+    }
+    else
+    {
+      this->autosaveTimer.stop ();
+    }
+  }
+
+  // Complete captures of meshes are spread over several checkpoints in short succession
+  void checkpoint ()
+  {
+    bool isCapturing = false;
+
+    if (this->hasTool ())
+    {
+      this->toolPtr->synchronize (
+        [this, &isCapturing]() { isCapturing = this->autosave.checkpoint (this->scene); });
+    }
+    else
+    {
+      isCapturing = this->autosave.checkpoint (this->scene);
+    }
+
+    if (isCapturing)
+    {
+      this->autosaveTimer.start (Autosave::captureInterval ());
+    }
+    else if (this->autosaveTimer.interval () != this->autosave.interval ())
+    {
+      this->startAutosave ();
+    }
   }
 
   void undo ()
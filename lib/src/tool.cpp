@@ -12,6 +12,7 @@
 #include "dynamic/mesh.hpp"
 #include "history.hpp"
 #include "intersection.hpp"
+#include "maybe.hpp"
 #include "mesh.hpp"
 #include "mirror.hpp"
 #include "primitive/ray.hpp"
@@ -101,6 +102,32 @@ struct Tool::Impl
     return response;
   }
 
+  ToolResponse pointingEvents (const std::vector<ViewPointingEvent>& events)
+  {
+    std::vector<ViewPointingEvent> eventsWithDelta;
+    bool                           hasRelease = false;
+
+    eventsWithDelta.reserve (events.size ());
+    for (const ViewPointingEvent& e : events)
+    {
+      if (e.pressEvent ())
+      {
+        this->prevPointingEventPosition = e.position ();
+      }
+      eventsWithDelta.emplace_back (e, this->prevPointingEventPosition);
+      this->prevPointingEventPosition = e.position ();
+      hasRelease = hasRelease || e.releaseEvent ();
+    }
+
+    const ToolResponse response = this->self->runPointingEvents (eventsWithDelta);
+
+    if (hasRelease)
+    {
+      this->state.scene ().sanitizeMeshes ();
+    }
+    return response;
+  }
+
   ToolResponse cursorUpdate (const glm::ivec2& pos) { return this->self->runCursorUpdate (pos); }
 
   ToolResponse commit () { return this->self->runCommit (); }
@@ -114,6 +141,8 @@ struct Tool::Impl
     this->self->runFromConfig ();
   }
 
+  void synchronize (const std::function<void()>& f) { this->self->runSynchronize (f); }
+
   void updateGlWidget () { this->state.mainWindow ().glWidget ().update (); }
 
   ViewTwoColumnGrid& properties () const
@@ -139,11 +168,18 @@ struct Tool::Impl
     this->state.history ().snapshotDynamicMeshes (this->state.scene ());
   }
 
+  void snapshotDynamicMeshes (const std::vector<const DynamicMesh*>& touched)
+  {
+    this->state.history ().snapshotDynamicMeshes (this->state.scene (), touched);
+  }
+
   void snapshotSketchMeshes ()
   {
     this->state.history ().snapshotSketchMeshes (this->state.scene ());
   }
 
+  void trackDynamicMeshes () { this->state.history ().trackDynamicMeshes (this->state.scene ()); }
+
   bool intersectsRecentDynamicMesh (const PrimRay& ray, Intersection& intersection) const
   {
     assert (this->state.history ().hasRecentDynamicMesh ());
@@ -334,6 +370,27 @@ struct Tool::Impl
     }
     return ToolResponse::None;
   }
+
+  // Stops at the first terminating response, otherwise redraws if any event requires it
+  ToolResponse runPointingEvents (const std::vector<ViewPointingEvent>& events)
+  {
+    ToolResponse response = ToolResponse::None;
+
+    for (const ViewPointingEvent& e : events)
+    {
+      switch (this->self->runPointingEvent (e))
+      {
+        case ToolResponse::None:
+          break;
+        case ToolResponse::Terminate:
+          return ToolResponse::Terminate;
+        case ToolResponse::Redraw:
+          response = ToolResponse::Redraw;
+          break;
+      }
+    }
+    return response;
+  }
 };
 
 DELEGATE2_BIG3_SELF (Tool, State&, const char*)
@@ -342,9 +399,11 @@ DELEGATE_CONST (void, Tool, render)
 DELEGATE1_CONST (void, Tool, paint, QPainter&)
 DELEGATE1 (void, Tool, keyEvent, const ViewKeyEvent&)
 DELEGATE1 (ToolResponse, Tool, pointingEvent, const ViewPointingEvent&)
+DELEGATE1 (ToolResponse, Tool, pointingEvents, const std::vector<ViewPointingEvent>&)
 DELEGATE1 (ToolResponse, Tool, cursorUpdate, const glm::ivec2&)
 DELEGATE (ToolResponse, Tool, commit)
 DELEGATE (void, Tool, fromConfig)
+DELEGATE1 (void, Tool, synchronize, const std::function<void()>&)
 GETTER_CONST (State&, Tool, state)
 DELEGATE (void, Tool, updateGlWidget)
 DELEGATE_CONST (ViewTwoColumnGrid&, Tool, properties)
@@ -354,7 +413,9 @@ DELEGATE1_CONST (CacheProxy, Tool, cache, const char*)
 DELEGATE_CONST (glm::ivec2, Tool, cursorPosition)
 DELEGATE (void, Tool, snapshotAll)
 DELEGATE (void, Tool, snapshotDynamicMeshes)
+DELEGATE1 (void, Tool, snapshotDynamicMeshes, const std::vector<const DynamicMesh*>&)
 DELEGATE (void, Tool, snapshotSketchMeshes)
+DELEGATE (void, Tool, trackDynamicMeshes)
 DELEGATE2_CONST (bool, Tool, intersectsRecentDynamicMesh, const PrimRay&, Intersection&)
 DELEGATE2_CONST (bool, Tool, intersectsRecentDynamicMesh, const glm::ivec2&, Intersection&)
 DELEGATE (void, Tool, supportsMirror)
@@ -368,6 +429,7 @@ DELEGATE1 (void, Tool, enableMirrorProperties, bool)
 DELEGATE1 (void, Tool, addMoveOnPrimaryPlaneProperties, ToolUtilMovement&)
 DELEGATE1_CONST (bool, Tool, onKeymap, char)
 DELEGATE1 (ToolResponse, Tool, runPointingEvent, const ViewPointingEvent&)
+DELEGATE1 (ToolResponse, Tool, runPointingEvents, const std::vector<ViewPointingEvent>&)
 
 template <typename T, typename... Ts>
 bool Tool::intersectsScene (const PrimRay& ray, T& intersection, Ts... args)
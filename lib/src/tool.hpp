@@ -5,7 +5,9 @@
 #ifndef DILAY_TOOL
 #define DILAY_TOOL
 
+#include <functional>
 #include <glm/fwd.hpp>
+#include <vector>
 #include "macro.hpp"
 #include "sketch/fwd.hpp"
 #include "tool/key.hpp"
@@ -13,6 +15,7 @@
 class CacheProxy;
 class Config;
 enum class Dimension;
+class DynamicMesh;
 class Intersection;
 class Mirror;
 class PrimRay;
@@ -44,10 +47,14 @@ public:
   void         paint (QPainter&) const;
   void         keyEvent (const ViewKeyEvent&);
   ToolResponse pointingEvent (const ViewPointingEvent&);
+  ToolResponse pointingEvents (const std::vector<ViewPointingEvent>&);
   ToolResponse cursorUpdate (const glm::ivec2&);
   ToolResponse commit ();
   void         fromConfig ();
 
+  // Runs a function while the tool does not modify the scene in the background
+  void synchronize (const std::function<void()>&);
+
 protected:
   State&             state () const;
   void               updateGlWidget ();
@@ -58,7 +65,9 @@ protected:
   glm::ivec2         cursorPosition () const;
   void               snapshotAll ();
   void               snapshotDynamicMeshes ();
+  void               snapshotDynamicMeshes (const std::vector<const DynamicMesh*>&);
   void               snapshotSketchMeshes ();
+  void               trackDynamicMeshes ();
   bool               intersectsRecentDynamicMesh (const PrimRay&, Intersection&) const;
   bool               intersectsRecentDynamicMesh (const glm::ivec2&, Intersection&) const;
   void               supportsMirror ();
@@ -87,6 +96,8 @@ private:
 
   virtual ToolResponse runPointingEvent (const ViewPointingEvent&);
 
+  virtual ToolResponse runPointingEvents (const std::vector<ViewPointingEvent>&);
+
   virtual ToolResponse runPressEvent (const ViewPointingEvent&) { return ToolResponse::None; }
 
   virtual ToolResponse runMoveEvent (const ViewPointingEvent&) { return ToolResponse::None; }
@@ -98,6 +109,8 @@ private:
   virtual ToolResponse runCommit () { return ToolResponse::None; }
 
   virtual void runFromConfig () {}
+
+  virtual void runSynchronize (const std::function<void()>& f) { f (); }
 };
 
 #define DECLARE_TOOL(keyName, otherMethods)              \
@@ -117,6 +130,8 @@ private:
 #define DECLARE_TOOL_RUN_RENDER void runRender () const;
 #define DECLARE_TOOL_RUN_PAINT void runPaint (QPainter&) const;
 #define DECLARE_TOOL_RUN_POINTING_EVENT ToolResponse runPointingEvent (const ViewPointingEvent&);
+#define DECLARE_TOOL_RUN_POINTING_EVENTS \
+  ToolResponse runPointingEvents (const std::vector<ViewPointingEvent>&);
 #define DECLARE_TOOL_RUN_PRESS_EVENT ToolResponse runPressEvent (const ViewPointingEvent&);
 #define DECLARE_TOOL_RUN_MOVE_EVENT ToolResponse runMoveEvent (const ViewPointingEvent&);
 #define DECLARE_TOOL_RUN_RELEASE_EVENT ToolResponse runReleaseEvent (const ViewPointingEvent&);
@@ -132,6 +147,8 @@ private:
 #define DELEGATE_TOOL_RUN_PAINT(n) DELEGATE1_CONST (void, n, runPaint, QPainter&)
 #define DELEGATE_TOOL_RUN_POINTING_EVENT(n) \
   DELEGATE1 (ToolResponse, n, runPointingEvent, const ViewPointingEvent&)
+#define DELEGATE_TOOL_RUN_POINTING_EVENTS(n) \
+  DELEGATE1 (ToolResponse, n, runPointingEvents, const std::vector<ViewPointingEvent>&)
 #define DELEGATE_TOOL_RUN_PRESS_EVENT(n) \
   DELEGATE1 (ToolResponse, n, runPressEvent, const ViewPointingEvent&)
 #define DELEGATE_TOOL_RUN_MOVE_EVENT(n) \
@@ -4,19 +4,15 @@
  */
 #include <QCheckBox>
 #include "cache.hpp"
-#include "distance.hpp"
 #include "dynamic/mesh.hpp"
-#include "isosurface-extraction.hpp"
-#include "mesh.hpp"
-#include "primitive/aabox.hpp"
-#include "primitive/cone-sphere.hpp"
+#include "remesh.hpp"
 #include "scene.hpp"
 #include "sketch/mesh-intersection.hpp"
 #include "sketch/mesh.hpp"
-#include "sketch/path.hpp"
 #include "state.hpp"
 #include "tool/sculpt/util/action.hpp"
 #include "tools.hpp"
+#include "view/double-slider.hpp"
 #include "view/pointing-event.hpp"
 #include "view/resolution-slider.hpp"
 #include "view/tool-tip.hpp"
@@ -27,10 +23,14 @@ struct ToolConvertSketch::Impl
 {
   ToolConvertSketch* self;
   float              resolution;
+  bool               adaptive;
+  float              blendRadius;
 
   Impl (ToolConvertSketch* s)
     : self (s)
     , resolution (s->cache ().get<float> ("resolution", 0.06))
+    , adaptive (s->cache ().get<bool> ("adaptive", false))
+    , blendRadius (s->cache ().get<float> ("blend-radius", 0.0f))
   {
   }
 
@@ -53,6 +53,22 @@ struct ToolConvertSketch::Impl
       this->self->cache ().set ("resolution", r);
     });
     properties.addStacked (QObject::tr ("Resolution"), resolutionEdit);
+
+    ViewDoubleSlider& blendRadiusEdit = ViewUtil::slider (2, 0.0f, this->blendRadius, 0.5f);
+    ViewUtil::connect (blendRadiusEdit, [this](float r) {
+      this->blendRadius = r;
+      this->self->cache ().set ("blend-radius", r);
+    });
+    blendRadiusEdit.setEnabled (this->adaptive);
+
+    QCheckBox& adaptiveEdit = ViewUtil::checkBox (QObject::tr ("Adaptive"), this->adaptive);
+    ViewUtil::connect (adaptiveEdit, [this, &blendRadiusEdit](bool a) {
+      this->adaptive = a;
+      blendRadiusEdit.setEnabled (a);
+      this->self->cache ().set ("adaptive", a);
+    });
+    properties.add (adaptiveEdit);
+    properties.addStacked (QObject::tr ("Blend radius"), blendRadiusEdit);
   }
 
   void setupToolTip ()
@@ -64,36 +80,16 @@ struct ToolConvertSketch::Impl
 
   DynamicMesh& convert (SketchMesh& sketch)
   {
-    glm::vec3 min, max;
-    sketch.minMax (min, max);
-
-    const IsosurfaceExtraction::DistanceCallback getDistance = [&sketch](const glm::vec3& pos) {
-      float distance = Util::maxFloat ();
-
-      if (sketch.tree ().hasRoot ())
-      {
-        sketch.tree ().root ().forEachConstNode ([&pos, &distance](const SketchNode& node) {
-          const float d =
-            node.parent ()
-              ? Distance::distance (PrimConeSphere (node.data (), node.parent ()->data ()), pos)
-              : Distance::distance (node.data (), pos);
-
-          distance = glm::min (distance, d);
-        });
-      }
-      for (const SketchPath& p : sketch.paths ())
-      {
-        for (const PrimSphere& s : p.spheres ())
-        {
-          distance = glm::min (distance, Distance::distance (s, pos));
-        }
-      }
-      return distance;
-    };
-
-    sketch.optimizePaths ();
     DynamicMesh mesh;
-    IsosurfaceExtraction::extract (getDistance, PrimAABox (min, max), this->resolution, mesh);
+
+    if (this->adaptive)
+    {
+      Remesh::convertAdaptive (sketch, this->resolution, this->blendRadius, mesh);
+    }
+    else
+    {
+      Remesh::convert (sketch, this->resolution, mesh);
+    }
 
     State& state = this->self->state ();
     return state.scene ().newDynamicMesh (state.config (), mesh);
@@ -36,7 +36,7 @@ struct ToolDeleteMesh::Impl
       if (this->self->intersectsScene (e, intersection))
       {
         Scene& scene = this->self->state ().scene ();
-        this->self->snapshotDynamicMeshes ();
+        this->self->snapshotDynamicMeshes ({&intersection.mesh ()});
         scene.deleteMesh (intersection.mesh ());
         return ToolResponse::Redraw;
       }
@@ -290,8 +290,7 @@ struct ToolEditSketch::Impl
         {
           this->self->snapshotSketchMeshes ();
 
-          this->node->forEachChild (
-            [&nodeIntersection](SketchNode& child) { nodeIntersection.node ().addChild (child); });
+          nodeIntersection.mesh ().join (nodeIntersection.node (), *this->node);
           this->self->state ().scene ().deleteMesh (*this->mesh);
           this->node = &nodeIntersection.node ();
           this->mesh = &nodeIntersection.mesh ();
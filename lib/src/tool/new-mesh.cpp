@@ -57,7 +57,7 @@ struct ToolNewMesh::Impl
   {
     if (this->mesh)
     {
-      this->self->snapshotDynamicMeshes ();
+      this->self->snapshotDynamicMeshes ({});
       this->self->state ().scene ().newDynamicMesh (this->self->state ().config (), *this->mesh);
     }
     return ToolResponse::None;
@@ -2,21 +2,28 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <QCheckBox>
 #include <QPainter>
+#include <algorithm>
+#include <vector>
 #include "cache.hpp"
+#include "camera.hpp"
 #include "color.hpp"
 #include "config.hpp"
+#include "dynamic/faces.hpp"
 #include "dynamic/mesh-intersection.hpp"
 #include "dynamic/mesh.hpp"
-#include "isosurface-extraction.hpp"
+#include "history.hpp"
 #include "maybe.hpp"
-#include "mesh.hpp"
 #include "primitive/aabox.hpp"
-#include "primitive/ray.hpp"
+#include "primitive/sphere.hpp"
+#include "remesh.hpp"
 #include "scene.hpp"
 #include "state.hpp"
 #include "tool/sculpt/util/action.hpp"
 #include "tools.hpp"
+#include "view/cursor.hpp"
+#include "view/double-slider.hpp"
 #include "view/pointing-event.hpp"
 #include "view/resolution-slider.hpp"
 #include "view/tool-tip.hpp"
@@ -30,7 +37,8 @@ namespace
     Normal,
     Union,
     Difference,
-    Intersection
+    Intersection,
+    Region
   };
 }
 
@@ -40,23 +48,44 @@ struct ToolRemesh::Impl
   float             resolution;
   Mode              mode;
   Maybe<glm::ivec2> pressPoint;
+  ViewCursor        cursor;
+  ViewDoubleSlider& radiusEdit;
+  bool              boxRegion;
+
+  // Ids of additional operands of the next boolean operation
+  std::vector<unsigned int> operandIds;
 
   Impl (ToolRemesh* s)
     : self (s)
     , resolution (s->cache ().get<float> ("resolution", 0.06))
     , mode (Mode (s->cache ().get<int> ("mode", int(Mode::Normal))))
+    , radiusEdit (ViewUtil::slider (2, 0.01f, s->cache ().get<float> ("radius", 0.2f), 1.0f))
+    , boxRegion (s->cache ().get<bool> ("box-region", false))
   {
   }
 
+  bool isBooleanMode () const
+  {
+    return this->mode == Mode::Union || this->mode == Mode::Difference ||
+           this->mode == Mode::Intersection;
+  }
+
   void setupProperties ()
   {
     ViewTwoColumnGrid& properties = this->self->properties ();
 
+    QCheckBox& boxRegionEdit = ViewUtil::checkBox (QObject::tr ("Box region"), this->boxRegion);
+
     QButtonGroup& modeEdit =
       ViewUtil::buttonGroup ({QObject::tr ("Normal"), QObject::tr ("Union"),
-                              QObject::tr ("Difference"), QObject::tr ("Intersection")});
-    ViewUtil::connect (modeEdit, int(this->mode), [this](int id) {
+                              QObject::tr ("Difference"), QObject::tr ("Intersection"),
+                              QObject::tr ("Region")});
+    ViewUtil::connect (modeEdit, int(this->mode), [this, &boxRegionEdit](int id) {
       this->mode = Mode (id);
+      this->operandIds.clear ();
+      this->radiusEdit.setEnabled (this->mode == Mode::Region);
+      boxRegionEdit.setEnabled (this->mode == Mode::Region);
+      this->cursor.disable ();
       this->self->cache ().set ("mode", id);
     });
     properties.add (modeEdit);
@@ -68,12 +97,29 @@ struct ToolRemesh::Impl
       this->self->cache ().set ("resolution", r);
     });
     properties.addStacked (QObject::tr ("Resolution"), resolutionEdit);
+
+    ViewUtil::connect (this->radiusEdit, [this](float r) {
+      this->cursor.radius (r);
+      this->self->cache ().set ("radius", r);
+    });
+    this->radiusEdit.setEnabled (this->mode == Mode::Region);
+    properties.addStacked (QObject::tr ("Region radius"), this->radiusEdit);
+
+    // The region's radius is the half width of a box region
+    ViewUtil::connect (boxRegionEdit, [this](bool b) {
+      this->boxRegion = b;
+      this->self->cache ().set ("box-region", b);
+    });
+    boxRegionEdit.setEnabled (this->mode == Mode::Region);
+    properties.add (boxRegionEdit);
   }
 
   void setupToolTip ()
   {
     ViewToolTip toolTip;
     toolTip.add (ViewInputEvent::MouseLeft, QObject::tr ("Remesh selection"));
+    toolTip.add (ViewInputEvent::MouseLeft, ViewInputModifier::Shift,
+                 QObject::tr ("Select additional operand"));
     this->self->state ().setToolTip (&toolTip);
   }
 
@@ -82,36 +128,53 @@ struct ToolRemesh::Impl
     this->setupProperties ();
     this->setupToolTip ();
 
+    this->cursor.disable ();
+    this->cursor.radius (this->radiusEdit.doubleValue ());
+
     return ToolResponse::None;
   }
 
-  ToolResponse runMoveEvent (const ViewPointingEvent&)
+  void runRender () const
   {
-    return this->mode == Mode::Normal ? ToolResponse::None : ToolResponse::Redraw;
+    Camera& camera = this->self->state ().camera ();
+
+    if (this->cursor.isEnabled ())
+    {
+      this->cursor.render (camera);
+    }
   }
 
-  void remesh (DynamicMesh& mesh)
+  ToolResponse runMoveEvent (const ViewPointingEvent& e)
   {
-    const IsosurfaceExtraction::IntersectionCallback getIntersection =
-      [&mesh](const PrimRay& ray, Intersection& intersection) {
-        if (mesh.intersects (ray, intersection, true))
-        {
-          return IsosurfaceExtraction::Intersection::Sample;
-        }
-        else
-        {
-          return IsosurfaceExtraction::Intersection::None;
-        }
-      };
+    if (this->mode == Mode::Region)
+    {
+      return this->runCursorUpdate (e.position ());
+    }
+    else
+    {
+      return this->isBooleanMode () ? ToolResponse::Redraw : ToolResponse::None;
+    }
+  }
 
-    const IsosurfaceExtraction::DistanceCallback getDistance = [&mesh](const glm::vec3& pos) {
-      return mesh.unsignedDistance (pos);
-    };
+  ToolResponse runCursorUpdate (const glm::ivec2& pos)
+  {
+    DynamicMeshIntersection intersection;
+    if (this->mode == Mode::Region && this->self->intersectsScene (pos, intersection))
+    {
+      this->cursor.enable ();
+      this->cursor.position (intersection.position ());
+    }
+    else
+    {
+      this->cursor.disable ();
+    }
+    return ToolResponse::Redraw;
+  }
 
-    const PrimAABox bounds = mesh.mesh ().bounds ();
-    DynamicMesh     extractedMesh;
-    IsosurfaceExtraction::extract (getDistance, getIntersection, bounds, this->resolution,
-                                   extractedMesh);
+  void remesh (DynamicMesh& mesh)
+  {
+    DynamicMesh extractedMesh;
+    Remesh::remesh (mesh, this->resolution, extractedMesh);
 
     State& state = this->self->state ();
     state.scene ().deleteMesh (mesh);
@@ -119,226 +182,102 @@ struct ToolRemesh::Impl
     ToolSculptAction::smoothMesh (dMesh);
   }
 
-  void remesh (DynamicMesh& meshA, DynamicMesh& meshB)
+  void remesh (const std::vector<DynamicMesh*>& meshes)
   {
-    const IsosurfaceExtraction::IntersectionCallback getCommutativeIntersection =
-      [this, &meshA, &meshB](const PrimRay& ray, Intersection& intersection) {
-        assert (this->mode == Mode::Union || this->mode == Mode::Intersection);
-
-        Intersection intersectionA, intersectionB;
-        meshA.intersects (ray, intersectionA, true);
-        meshB.intersects (ray, intersectionB, true);
-
-        Intersection::sort (intersectionA, intersectionB);
-        intersection = intersectionA;
+    const Remesh::Operation operation =
+      this->mode == Mode::Union
+        ? Remesh::Operation::Union
+        : (this->mode == Mode::Difference ? Remesh::Operation::Difference
+                                          : Remesh::Operation::Intersection);
 
-        const bool intersectsA = intersectionA.isIntersection ();
-        const bool intersectsB = intersectionB.isIntersection ();
-
-        if (intersectsA && intersectsB)
-        {
-          const bool insideA = glm::dot (ray.direction (), intersectionA.normal ()) > 0.0f;
-          const bool insideB = glm::dot (ray.direction (), intersectionB.normal ()) > 0.0f;
-
-          if (insideA && insideB)
-          {
-            // (B (A o-> A) B)
-            // (A (B o-> A) B)
-            if (this->mode == Mode::Union)
-            {
-              return IsosurfaceExtraction::Intersection::Continue;
-            }
-            else
-            {
-              assert (this->mode == Mode::Intersection);
-              return IsosurfaceExtraction::Intersection::Sample;
-            }
-          }
-          else if (insideA && insideB == false)
-          {
-            // (A o-> A) (B B)
-            if (this->mode == Mode::Union)
-            {
-              return IsosurfaceExtraction::Intersection::Sample;
-            }
-            else
-            {
-              assert (this->mode == Mode::Intersection);
-              return IsosurfaceExtraction::Intersection::Continue;
-            }
-          }
-          else if (insideA == false && insideB)
-          {
-            // (B o-> (A A) B)
-            // (B o-> (A B) A)
-            if (this->mode == Mode::Union)
-            {
-              return IsosurfaceExtraction::Intersection::Continue;
-            }
-            else
-            {
-              assert (this->mode == Mode::Intersection);
-              return IsosurfaceExtraction::Intersection::Sample;
-            }
-          }
-          else if (insideA == false && insideB == false)
-          {
-            // o-> (A (B B) A)
-            // o-> (A (B A) B)
-            // o-> (A A) (B B)
-            if (this->mode == Mode::Union)
-            {
-              return IsosurfaceExtraction::Intersection::Sample;
-            }
-            else
-            {
-              assert (this->mode == Mode::Intersection);
-              return IsosurfaceExtraction::Intersection::Continue;
-            }
-          }
-          DILAY_IMPOSSIBLE
-        }
-        else if (intersectsA)
-        {
-          if (this->mode == Mode::Union)
-          {
-            return IsosurfaceExtraction::Intersection::Sample;
-          }
-          else
-          {
-            assert (this->mode == Mode::Intersection);
-            return IsosurfaceExtraction::Intersection::Continue;
-          }
-        }
-        else
-        {
-          assert (intersectsB == false);
-          return IsosurfaceExtraction::Intersection::None;
-        }
-        DILAY_IMPOSSIBLE
-      };
-
-    const IsosurfaceExtraction::IntersectionCallback getDifferenceIntersection =
-      [this, &meshA, &meshB](const PrimRay& ray, Intersection& intersection) {
-        assert (this->mode == Mode::Difference);
-
-        Intersection intersectionA, intersectionB;
-        const bool   intersectsA = meshA.intersects (ray, intersectionA, true);
-        const bool   intersectsB = meshB.intersects (ray, intersectionB, true);
-
-        if (intersectsA && intersectsB)
-        {
-          const bool insideA = glm::dot (ray.direction (), intersectionA.normal ()) > 0.0f;
-          const bool insideB = glm::dot (ray.direction (), intersectionB.normal ()) > 0.0f;
-          const bool aBeforeB = intersectionA.distance () < intersectionB.distance ();
-
-          intersection = aBeforeB ? intersectionA : intersectionB;
-
-          if (insideA && insideB)
-          {
-            if (aBeforeB)
-            {
-              // (B (A o-> A) B)
-              // (A (B o-> A) B)
-              return IsosurfaceExtraction::Intersection::Continue;
-            }
-            else
-            {
-              // (A (B o-> B) A)
-              // (B (A o-> B) A)
-              return IsosurfaceExtraction::Intersection::Sample;
-            }
-          }
-          else if (insideA && insideB == false)
-          {
-            // (A o-> A) (B B)
-            // (A o-> (B B) A)
-            // (A o-> (B A) B)
-            return IsosurfaceExtraction::Intersection::Sample;
-          }
-          else if (insideA == false && insideB)
-          {
-            // (B o-> B) (A A)
-            // (B o-> (A A) B)
-            // (B o-> (A B) A)
-            return IsosurfaceExtraction::Intersection::Continue;
-          }
-          else if (insideA == false && insideB == false)
-          {
-            if (aBeforeB)
-            {
-              // o-> (A (B B) A)
-              // o-> (A (B A) B)
-              // o-> (A A) (B B)
-              return IsosurfaceExtraction::Intersection::Sample;
-            }
-            else
-            {
-              // o-> (B (A A) B)
-              // o-> (B (A B) A)
-              // o-> (B B) (A A)
-              return IsosurfaceExtraction::Intersection::Continue;
-            }
-          }
-          DILAY_IMPOSSIBLE
-        }
-        else if (intersectsA)
-        {
-          intersection = intersectionA;
-          return IsosurfaceExtraction::Intersection::Sample;
-        }
-        else if (intersectsB)
-        {
-          intersection = intersectionB;
-          return IsosurfaceExtraction::Intersection::Continue;
-        }
-        else
-        {
-          return IsosurfaceExtraction::Intersection::None;
-        }
-        DILAY_IMPOSSIBLE
-      };
+    DynamicMesh extractedMesh;
+    Remesh::remesh (meshes, operation, this->resolution, extractedMesh);
 
-    const IsosurfaceExtraction::DistanceCallback getDistance = [&meshA,
-                                                                &meshB](const glm::vec3& pos) {
-      return glm::min (meshA.unsignedDistance (pos), meshB.unsignedDistance (pos));
-    };
+    State& state = this->self->state ();
+    for (DynamicMesh* mesh : meshes)
+    {
+      state.scene ().deleteMesh (*mesh);
+    }
 
-    const PrimAABox boundsA = meshA.mesh ().bounds ();
-    const PrimAABox boundsB = meshB.mesh ().bounds ();
-    const glm::vec3 min = glm::min (boundsA.minimum (), boundsB.minimum ());
-    const glm::vec3 max = glm::max (boundsA.maximum (), boundsB.maximum ());
-    const PrimAABox bounds (min, max);
+    if (extractedMesh.isEmpty () == false)
+    {
+      DynamicMesh& dMesh = state.scene ().newDynamicMesh (state.config (), extractedMesh);
+      ToolSculptAction::smoothMesh (dMesh);
+    }
+  }
 
-    DynamicMesh extractedMesh;
-    if (this->mode == Mode::Difference)
+  // Fails without changing the mesh if the region's border could not be stitched
+  bool remeshRegion (DynamicMesh& mesh, const glm::vec3& center)
+  {
+    const float  radius = this->radiusEdit.doubleValue ();
+    DynamicFaces faces;
+    const bool   success =
+      this->boxRegion
+        ? Remesh::remesh (mesh, PrimAABox (center, 2.0f * radius), this->resolution, faces)
+        : Remesh::remesh (mesh, PrimSphere (center, radius), this->resolution, faces);
+
+    if (success)
     {
-      IsosurfaceExtraction::extract (getDistance, getDifferenceIntersection, bounds,
-                                     this->resolution, extractedMesh);
+      ToolSculptAction::smoothMesh (mesh, faces);
+      return true;
     }
     else
     {
-      IsosurfaceExtraction::extract (getDistance, getCommutativeIntersection, bounds,
-                                     this->resolution, extractedMesh);
+      return false;
     }
+  }
 
-    State& state = this->self->state ();
-    state.scene ().deleteMesh (meshA);
-    state.scene ().deleteMesh (meshB);
+  // The first operand is the mesh at the press point, followed by all selected meshes and the
+  // mesh at the release point
+  std::vector<DynamicMesh*> operands (DynamicMesh& first, DynamicMesh& last)
+  {
+    std::vector<DynamicMesh*> meshes = {&first};
 
-    if (extractedMesh.isEmpty () == false)
+    const auto addOperand = [&meshes](DynamicMesh* mesh) {
+      if (mesh && std::find (meshes.begin (), meshes.end (), mesh) == meshes.end ())
+      {
+        meshes.push_back (mesh);
+      }
+    };
+
+    for (unsigned int id : this->operandIds)
     {
-      DynamicMesh& dMesh = state.scene ().newDynamicMesh (state.config (), extractedMesh);
-      ToolSculptAction::smoothMesh (dMesh);
+      addOperand (this->self->state ().scene ().dynamicMesh (id));
+    }
+    addOperand (&last);
+    return meshes;
+  }
+
+  ToolResponse selectOperand (const ViewPointingEvent& e)
+  {
+    DynamicMeshIntersection intersection;
+    if (this->self->intersectsScene (e, intersection))
+    {
+      const unsigned int id = intersection.mesh ().id ();
+      const auto         it = std::find (this->operandIds.begin (), this->operandIds.end (), id);
+
+      if (it == this->operandIds.end ())
+      {
+        this->operandIds.push_back (id);
+      }
+      else
+      {
+        this->operandIds.erase (it);
+      }
     }
+    return ToolResponse::None;
   }
 
   ToolResponse runPressEvent (const ViewPointingEvent& e)
   {
-    if (e.leftButton () == false || this->mode == Mode::Normal)
+    if (e.leftButton () == false || this->isBooleanMode () == false)
     {
       return ToolResponse::None;
     }
+    else if (e.modifiers () == Qt::ShiftModifier)
+    {
+      return this->selectOperand (e);
+    }
     else
     {
       this->pressPoint = e.position ();
@@ -359,7 +298,7 @@ struct ToolRemesh::Impl
         DynamicMeshIntersection intersection;
         if (this->self->intersectsScene (e.position (), intersection))
         {
-          this->self->snapshotDynamicMeshes ();
+          this->self->snapshotDynamicMeshes ({&intersection.mesh ()});
           this->remesh (intersection.mesh ());
           return ToolResponse::Redraw;
         }
@@ -368,6 +307,26 @@ struct ToolRemesh::Impl
           return ToolResponse::None;
         }
       }
+      else if (this->mode == Mode::Region)
+      {
+        DynamicMeshIntersection intersection;
+        if (this->self->intersectsScene (e.position (), intersection))
+        {
+          this->self->snapshotDynamicMeshes ({&intersection.mesh ()});
+
+          if (this->remeshRegion (intersection.mesh (), intersection.position ()) == false)
+          {
+            this->self->state ().history ().dropPastSnapshot ();
+            ViewUtil::error (this->self->state ().mainWindow (),
+                             QObject::tr ("Could not remesh region."));
+          }
+          return ToolResponse::Redraw;
+        }
+        else
+        {
+          return ToolResponse::None;
+        }
+      }
       else if (this->pressPoint)
       {
         DynamicMeshIntersection intersectionA;
@@ -379,14 +338,20 @@ struct ToolRemesh::Impl
 
         if (intersectsA && intersectsB)
         {
-          this->self->snapshotDynamicMeshes ();
-          if (&intersectionA.mesh () == &intersectionB.mesh ())
+          const std::vector<DynamicMesh*> meshes =
+            this->operands (intersectionA.mesh (), intersectionB.mesh ());
+
+          this->self->snapshotDynamicMeshes (
+            std::vector<const DynamicMesh*> (meshes.begin (), meshes.end ()));
+          this->operandIds.clear ();
+
+          if (meshes.size () == 1)
           {
             this->remesh (intersectionA.mesh ());
           }
           else
           {
-            this->remesh (intersectionA.mesh (), intersectionB.mesh ());
+            this->remesh (meshes);
           }
           return ToolResponse::Redraw;
         }
@@ -404,11 +369,11 @@ struct ToolRemesh::Impl
 
   void runPaint (QPainter& painter) const
   {
-    if (this->mode != Mode::Normal && this->pressPoint)
+    if (this->isBooleanMode () && this->pressPoint)
     {
       const QPoint cursorPos (ViewUtil::toQPoint (this->self->cursorPosition ()));
 
-      QPen pen (this->self->config ().get<Color> ("editor/on-screen-color").qColor ());
+      QPen pen (ViewUtil::toQColor (this->self->config ().get<Color> ("editor/on-screen-color")));
       pen.setCapStyle (Qt::FlatCap);
       pen.setWidth (2);
 
@@ -418,11 +383,19 @@ struct ToolRemesh::Impl
   }
 
   ToolResponse runCommit () { return ToolResponse::Redraw; }
+
+  void runFromConfig ()
+  {
+    this->cursor.color (this->self->config ().get<Color> ("editor/tool/cursor-color"));
+  }
 };
 
 DELEGATE_TOOL (ToolRemesh)
+DELEGATE_TOOL_RUN_RENDER (ToolRemesh)
 DELEGATE_TOOL_RUN_MOVE_EVENT (ToolRemesh)
 DELEGATE_TOOL_RUN_PRESS_EVENT (ToolRemesh)
 DELEGATE_TOOL_RUN_RELEASE_EVENT (ToolRemesh)
+DELEGATE_TOOL_RUN_CURSOR_UPDATE (ToolRemesh)
 DELEGATE_TOOL_RUN_PAINT (ToolRemesh)
 DELEGATE_TOOL_RUN_COMMIT (ToolRemesh)
+DELEGATE_TOOL_RUN_FROM_CONFIG (ToolRemesh)
@@ -4,7 +4,11 @@
  */
 #include <QCheckBox>
 #include <QFrame>
+#include <QSpinBox>
+#include <QTimer>
 #include <QWheelEvent>
+#include <algorithm>
+#include <vector>
 #include "cache.hpp"
 #include "camera.hpp"
 #include "config.hpp"
@@ -19,6 +23,7 @@
 #include "tool/sculpt.hpp"
 #include "tool/sculpt/util/action.hpp"
 #include "tool/sculpt/util/brush.hpp"
+#include "tool/sculpt/util/worker.hpp"
 #include "tool/util/movement.hpp"
 #include "tool/util/step.hpp"
 #include "view/cursor.hpp"
@@ -37,6 +42,9 @@ namespace
     Sculpted,
     Ended
   };
+
+  // Maximum number of pointing events that are queued while the worker is busy
+  constexpr unsigned int maxPendingStrokes = 4;
 }
 
 struct ToolSculpt::Impl
@@ -51,6 +59,15 @@ struct ToolSculpt::Impl
   SculptState       sculptState;
   ToolUtilStep      step;
 
+  // Written by sculpt jobs, read by `publish`: both run mutually exclusive
+  std::vector<DynamicMesh*> unpublishedMeshes;
+  bool                      hasEmptyMesh;
+
+  // Finished jobs start this timer on the GUI thread, which publishes their results and
+  // redraws. Declared before `worker`, so that the worker's thread is joined first.
+  QTimer           publishTimer;
+  ToolSculptWorker worker;
+
   Impl (ToolSculpt* s)
     : self (s)
     , commonCache (this->self->cache ("sculpt"))
@@ -59,7 +76,16 @@ struct ToolSculpt::Impl
     , secondarySlider (nullptr)
     , absoluteRadius (this->commonCache.get<bool> ("absolute-radius", true))
     , sculptState (SculptState::None)
+    , hasEmptyMesh (false)
+    , worker (maxPendingStrokes)
   {
+    this->publishTimer.setSingleShot (true);
+    this->publishTimer.setInterval (0);
+
+    QObject::connect (&this->publishTimer, &QTimer::timeout, [this]() {
+      this->worker.synchronize ([this]() { this->publish (); });
+      this->self->updateGlWidget ();
+    });
   }
 
   ToolResponse runInitialize ()
@@ -77,6 +103,7 @@ struct ToolSculpt::Impl
   void setupBrush ()
   {
     this->brush.subdivide (this->commonCache.get<bool> ("subdivide", true));
+    this->brush.subdivBudget ((unsigned int) (this->commonCache.get<int> ("subdiv-budget", 0)));
 
     if (this->absoluteRadius)
     {
@@ -113,14 +140,16 @@ struct ToolSculpt::Impl
     ViewTwoColumnGrid& properties = this->self->properties ();
 
     ViewUtil::connect (this->radiusEdit, [this](float r) {
-      if (this->absoluteRadius)
-      {
-        this->setAbsoluteRadius ();
-      }
-      else
-      {
-        this->setRelativeRadius ();
-      }
+      this->worker.synchronize ([this]() {
+        if (this->absoluteRadius)
+        {
+          this->setAbsoluteRadius ();
+        }
+        else
+        {
+          this->setRelativeRadius ();
+        }
+      });
       this->commonCache.set ("radius", r);
       this->self->updateGlWidget ();
     });
@@ -142,6 +171,18 @@ struct ToolSculpt::Impl
     });
     properties.add (absRadiusEdit);
 
+    if (this->brush.subdivide ())
+    {
+      QSpinBox& budgetEdit =
+        ViewUtil::spinBox (0, int(this->brush.subdivBudget ()), 1000000, 1000);
+      budgetEdit.setSpecialValueText (QObject::tr ("Unlimited"));
+      ViewUtil::connect (budgetEdit, [this](int b) {
+        this->worker.synchronize ([this, b]() { this->brush.subdivBudget ((unsigned int) (b)); });
+        this->commonCache.set ("subdiv-budget", b);
+      });
+      properties.add (QObject::tr ("Subdivision budget"), budgetEdit);
+    }
+
     this->self->addMirrorProperties ();
     properties.add (ViewUtil::horizontalLine ());
 
@@ -176,13 +217,15 @@ struct ToolSculpt::Impl
     }
     else if (this->secondarySlider && this->self->onKeymap ('i') && e.moveEvent ())
     {
-      this->secondarySlider->setIntValue (this->secondarySlider->intValue () + e.delta ().x);
+      this->worker.synchronize ([this, &e]() {
+        this->secondarySlider->setIntValue (this->secondarySlider->intValue () + e.delta ().x);
+      });
     }
     else if (e.leftButton ())
     {
       if (e.pressEvent ())
       {
-        this->self->snapshotDynamicMeshes ();
+        this->self->trackDynamicMeshes ();
         this->sculptState = SculptState::Started;
       }
 
@@ -207,19 +250,28 @@ struct ToolSculpt::Impl
 
   ToolResponse runCursorUpdate (const glm::ivec2& pos)
   {
-    DynamicMeshIntersection cursorIntersection;
-    this->setCursorByIntersection (pos, cursorIntersection);
+    this->worker.synchronize ([this, &pos]() {
+      DynamicMeshIntersection cursorIntersection;
+      this->setCursorByIntersection (pos, cursorIntersection);
+      this->publish ();
+    });
     return ToolResponse::Redraw;
   }
 
   ToolResponse runCommit ()
   {
+    this->worker.finish ();
+    this->publish ();
     this->brush.resetPointOfAction ();
 
     if (this->sculptState == SculptState::Started)
     {
       this->self->state ().history ().dropPastSnapshot ();
     }
+    else
+    {
+      this->self->state ().history ().untrackDynamicMeshes ();
+    }
     this->sculptState = SculptState::None;
     return ToolResponse::None;
   }
@@ -234,6 +286,8 @@ struct ToolSculpt::Impl
     this->cursor.color (this->self->config ().get<Color> ("editor/tool/cursor-color"));
   }
 
+  void runSynchronize (const std::function<void()>& f) { this->worker.synchronize (f); }
+
   void addDefaultToolTip (ViewToolTip& toolTip, bool hasInvertedMode, bool hasIntensity)
   {
     toolTip.add (ViewInputEvent::MouseLeft, QObject::tr ("Drag to sculpt"));
@@ -264,11 +318,40 @@ struct ToolSculpt::Impl
 
     if (this->brush.mesh ().isEmpty ())
     {
-      this->self->state ().scene ().deleteEmptyMeshes ();
+      this->hasEmptyMesh = true;
       this->brush.resetPointOfAction ();
     }
   }
 
+  void unpublish (DynamicMesh& mesh)
+  {
+    if (std::find (this->unpublishedMeshes.begin (), this->unpublishedMeshes.end (), &mesh) ==
+        this->unpublishedMeshes.end ())
+    {
+      this->unpublishedMeshes.push_back (&mesh);
+    }
+  }
+
+  // Uploads the changes of sculpt jobs. Must not run concurrently to a job.
+  void publish ()
+  {
+    for (DynamicMesh* mesh : this->unpublishedMeshes)
+    {
+      if (mesh->isEmpty () == false)
+      {
+        mesh->bufferData ();
+      }
+    }
+    this->unpublishedMeshes.clear ();
+
+    if (this->hasEmptyMesh)
+    {
+      this->self->state ().history ().snapshotTrackedDynamicMeshes ();
+      this->self->state ().scene ().deleteEmptyMeshes ();
+      this->hasEmptyMesh = false;
+    }
+  }
+
   bool setCursorByIntersection (const glm::ivec2& pos, DynamicMeshIntersection& intersection)
   {
     if (this->self->intersectsScene (pos, intersection))
@@ -288,10 +371,10 @@ struct ToolSculpt::Impl
     }
   }
 
-  bool updateBrushByIntersection (bool useRecentMesh, const glm::vec3& cursorStep)
+  bool updateBrushByIntersection (bool useRecentMesh, const glm::vec3& from,
+                                  const glm::vec3& cursorStep)
   {
-    const glm::vec3 from = this->self->state ().camera ().position ();
-    const PrimRay   ray = PrimRay (from, cursorStep - from);
+    const PrimRay ray = PrimRay (from, cursorStep - from);
 
     DynamicMeshIntersection intersection;
 
@@ -299,7 +382,7 @@ struct ToolSculpt::Impl
     {
       if (this->brush.hasPointOfAction () && (&this->brush.mesh () != &intersection.mesh ()))
       {
-        this->brush.mesh ().bufferData ();
+        this->unpublish (this->brush.mesh ());
       }
 
       if (useRecentMesh)
@@ -312,7 +395,7 @@ struct ToolSculpt::Impl
         }
         else
         {
-          this->brush.mesh ().bufferData ();
+          this->unpublish (this->brush.mesh ());
           this->brush.resetPointOfAction ();
           return false;
         }
@@ -326,7 +409,7 @@ struct ToolSculpt::Impl
     }
     else
     {
-      this->brush.mesh ().bufferData ();
+      this->unpublish (this->brush.mesh ());
       this->brush.resetPointOfAction ();
       return false;
     }
@@ -336,65 +419,103 @@ struct ToolSculpt::Impl
                        const std::function<void()>* toggle)
   {
     DynamicMeshIntersection cursorIntersection;
+    bool                    hasIntersection = false;
 
-    if (this->setCursorByIntersection (e.position (), cursorIntersection) && e.leftButton ())
-    {
-      SBParameters& parameters = this->brush.parameters<SBParameters> ();
-      const float   defaultIntesity = parameters.intensity ();
-      const bool    doToggle = toggle && e.modifiers () == Qt::ShiftModifier;
+    this->worker.synchronize ([this, &e, &cursorIntersection, &hasIntersection]() {
+      hasIntersection = this->setCursorByIntersection (e.position (), cursorIntersection);
+      this->publish ();
+    });
 
-      parameters.intensity (defaultIntesity * e.intensity ());
+    if (hasIntersection && e.leftButton ())
+    {
+      const float                 intensity = e.intensity ();
+      const std::function<void()> doToggle =
+        toggle && e.modifiers () == Qt::ShiftModifier ? *toggle : std::function<void()> ();
+      const glm::vec3 from = this->self->state ().camera ().position ();
+      const glm::vec3 to = cursorIntersection.position ();
+
+      this->worker.push ([this, useRecentMesh, intensity, doToggle, from, to]() {
+        this->sculptStroke (useRecentMesh, intensity, doToggle, from, to);
+      });
+      return true;
+    }
+    else
+    {
+      return false;
+    }
+  }
 
-      if (doToggle)
-      {
-        (*toggle) ();
-      }
+  // Runs as job of `worker`: each dab is an exclusive section, so that cursor queries of the GUI
+  // thread only wait for the current dab
+  void sculptStroke (bool useRecentMesh, float intensity, const std::function<void()>& toggle,
+                     const glm::vec3& from, const glm::vec3& to)
+  {
+    bool doStep = false;
 
-      if (this->brush.hasPointOfAction ())
+    this->worker.exclusive ([this, &doStep]() {
+      doStep = this->brush.hasPointOfAction ();
+      if (doStep)
       {
         this->step.stepWidth (this->brush.stepWidth ());
         this->step.position (this->brush.position ());
-        this->step.step (cursorIntersection.position (),
-                         [this, useRecentMesh](const glm::vec3& brushStep) {
-                           if (this->brush.hasPointOfAction ())
-                           {
-                             if (this->updateBrushByIntersection (useRecentMesh, brushStep))
-                             {
-                               this->sculpt ();
-                             }
-                             return true;
-                           }
-                           else
-                           {
-                             return false;
-                           }
-                         });
-      }
-      else
-      {
-        if (this->updateBrushByIntersection (useRecentMesh, cursorIntersection.position ()))
-        {
-          this->sculpt ();
-        }
-      }
-
-      if (this->brush.hasPointOfAction ())
-      {
-        assert (this->brush.mesh ().isEmpty () == false);
-        this->brush.mesh ().bufferData ();
       }
+    });
 
-      if (doToggle)
-      {
-        (*toggle) ();
-      }
-      parameters.intensity (defaultIntesity);
-      return true;
+    if (doStep)
+    {
+      this->step.step (to, [this, useRecentMesh, intensity, &toggle,
+                            &from](const glm::vec3& brushStep) {
+        bool hasPointOfAction = false;
+
+        this->worker.exclusive ([this, useRecentMesh, intensity, &toggle, &from, &brushStep,
+                                 &hasPointOfAction]() {
+          hasPointOfAction = this->brush.hasPointOfAction ();
+          if (hasPointOfAction)
+          {
+            this->sculptDab (useRecentMesh, intensity, toggle, from, brushStep);
+          }
+        });
+        return hasPointOfAction;
+      });
     }
     else
     {
-      return false;
+      this->worker.exclusive ([this, useRecentMesh, intensity, &toggle, &from, &to]() {
+        this->sculptDab (useRecentMesh, intensity, toggle, from, to);
+      });
+    }
+    QMetaObject::invokeMethod (&this->publishTimer, "start", Qt::QueuedConnection);
+  }
+
+  void sculptDab (bool useRecentMesh, float intensity, const std::function<void()>& toggle,
+                  const glm::vec3& from, const glm::vec3& to)
+  {
+    SBParameters& parameters = this->brush.parameters<SBParameters> ();
+    const float   defaultIntesity = parameters.intensity ();
+
+    parameters.intensity (defaultIntesity * intensity);
+
+    if (toggle)
+    {
+      toggle ();
+    }
+
+    if (this->updateBrushByIntersection (useRecentMesh, from, to))
+    {
+      this->sculpt ();
+    }
+
+    if (this->brush.hasPointOfAction ())
+    {
+      assert (this->brush.mesh ().isEmpty () == false);
+      this->unpublish (this->brush.mesh ());
+    }
+
+    if (toggle)
+    {
+      toggle ();
     }
+    parameters.intensity (defaultIntesity);
   }
 
   bool grablikeStroke (const ViewPointingEvent& e, ToolUtilMovement& movement)
@@ -443,8 +564,9 @@ struct ToolSculpt::Impl
           if (this->brush.hasPointOfAction ())
           {
             assert (this->brush.mesh ().isEmpty () == false);
-            this->brush.mesh ().bufferData ();
+            this->unpublish (this->brush.mesh ());
           }
+          this->publish ();
           return true;
         }
         else
@@ -504,3 +626,4 @@ DELEGATE1 (ToolResponse, ToolSculpt, runPointingEvent, const ViewPointingEvent&)
 DELEGATE1 (ToolResponse, ToolSculpt, runCursorUpdate, const glm::ivec2&)
 DELEGATE (ToolResponse, ToolSculpt, runCommit)
 DELEGATE (void, ToolSculpt, runFromConfig)
+DELEGATE1 (void, ToolSculpt, runSynchronize, const std::function<void()>&)
@@ -37,6 +37,7 @@ private:
   ToolResponse runCursorUpdate (const glm::ivec2&);
   ToolResponse runCommit ();
   void         runFromConfig ();
+  void         runSynchronize (const std::function<void()>&);
 
   virtual void runSetupBrush (SculptBrush&) = 0;
   virtual void runSetupCursor (ViewCursor&) = 0;
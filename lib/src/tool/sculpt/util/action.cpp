@@ -2,9 +2,13 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
 #include <functional>
 #include <glm/glm.hpp>
 #include <glm/gtx/norm.hpp>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
 #include "dynamic/faces.hpp"
 #include "dynamic/mesh.hpp"
 #include "intersection.hpp"
@@ -62,11 +66,10 @@ namespace
     }
   };
 
-  void extendAndFilterDomain (const SculptBrush& brush, DynamicFaces& faces, unsigned int numRings)
+  void extendAndFilterDomain (const DynamicMesh& mesh, const PrimSphere& sphere,
+                              DynamicFaces& faces, unsigned int numRings)
   {
     assert (faces.hasUncomitted () == false);
-    const DynamicMesh& mesh = brush.mesh ();
-    const PrimSphere   sphere = brush.sphere ();
 
     std::unordered_set<unsigned int> frontier;
 
@@ -173,16 +176,23 @@ namespace
     }
   }
 
-  void splitEdges (DynamicMesh& mesh, ToolSculptEdgeMap& newE, float maxLength, DynamicFaces& faces)
+  // Splits at most `maxNumSplits` edges
+  void splitEdges (DynamicMesh& mesh, ToolSculptEdgeMap& newE, float maxLength,
+                   unsigned int maxNumSplits, DynamicFaces& faces)
   {
     assert (faces.hasUncomitted () == false);
 
-    const auto split = [&mesh, &newE, maxLength](unsigned int i1, unsigned int i2) {
-      if (glm::distance2 (mesh.vertex (i1), mesh.vertex (i2)) > maxLength * maxLength)
+    unsigned int numSplits = 0;
+
+    const auto split = [&mesh, &newE, maxLength, maxNumSplits, &numSplits](unsigned int i1,
+                                                                           unsigned int i2) {
+      if (numSplits < maxNumSplits &&
+          glm::distance2 (mesh.vertex (i1), mesh.vertex (i2)) > maxLength * maxLength)
       {
         const glm::vec3 normal = glm::normalize (mesh.vertexNormal (i1) + mesh.vertexNormal (i2));
         const unsigned int i3 = mesh.addVertex (getSplitPosition (mesh, i1, i2), normal);
         newE.insert (i1, i2, i3);
+        numSplits++;
         return true;
       }
       else
@@ -345,17 +355,42 @@ namespace
       return (vE1 > 3) && (vE2 > 3) && (post < pre);
     };
 
-    ToolSculptEdgeSet edgeSet;
-    mesh.forEachVertex (faces, [&mesh, &edgeSet](unsigned int i) {
+    // The scratch buffer first holds the sorted vertices of high valence within the domain,
+    // followed by edges as consecutive pairs of vertex indices. An edge between two of these
+    // vertices is visited from both of them but stored only once. Captures are kept small
+    // enough for std::function to not allocate.
+    std::vector<unsigned int>& edges = mesh.scratchIndices ();
+    edges.clear ();
+
+    mesh.forEachVertex (faces, [&mesh](unsigned int i) {
       if (mesh.valence (i) > 6)
       {
-        mesh.forEachVertexAdjacentToVertex (
-          i, [i, &edgeSet](unsigned int j) { edgeSet.insert (i, j); });
+        mesh.scratchIndices ().push_back (i);
       }
     });
+    std::sort (edges.begin (), edges.end ());
+
+    const unsigned int numVertices = edges.size ();
 
-    for (const ui_pair& edge : edgeSet)
+    for (unsigned int v = 0; v < numVertices; v++)
     {
+      const unsigned int i = edges[v];
+
+      mesh.forEachVertexAdjacentToVertex (i, [&mesh, i, numVertices](unsigned int j) {
+        std::vector<unsigned int>& es = mesh.scratchIndices ();
+
+        if (i < j || std::binary_search (es.begin (), es.begin () + numVertices, j) == false)
+        {
+          es.push_back (i);
+          es.push_back (j);
+        }
+      });
+    }
+
+    for (unsigned int e = numVertices; e < edges.size (); e += 2)
+    {
+      const ui_pair edge (edges[e], edges[e + 1]);
+
       unsigned int leftFace, leftVertex, rightFace, rightVertex;
       mesh.findAdjacent (edge.first, edge.second, leftFace, leftVertex, rightFace, rightVertex);
 
@@ -377,9 +412,13 @@ namespace
 
   void smooth (DynamicMesh& mesh, DynamicFaces& faces)
   {
-    std::unordered_map<unsigned int, glm::vec3> newPosition;
+    std::vector<unsigned int>& indices = mesh.scratchIndices ();
+    std::vector<glm::vec3>&    newPosition = mesh.scratchPositions ();
 
-    mesh.forEachVertex (faces, [&mesh, &newPosition](unsigned int i) {
+    indices.clear ();
+    newPosition.clear ();
+
+    mesh.forEachVertex (faces, [&mesh](unsigned int i) {
       const glm::vec3  avgPos = mesh.averagePosition (i);
       const glm::vec3& normal = mesh.vertexNormal (i);
       const glm::vec3  delta = avgPos - mesh.vertex (i);
@@ -421,19 +460,21 @@ namespace
           }
         }
       }
+      mesh.scratchIndices ().push_back (i);
+
       if (minDistance != Util::maxFloat ())
       {
-        newPosition.emplace (i, projectedPos);
+        mesh.scratchPositions ().push_back (projectedPos);
       }
       else
       {
-        newPosition.emplace (i, tangentialPos);
+        mesh.scratchPositions ().push_back (tangentialPos);
       }
     });
 
-    for (const auto& it : newPosition)
+    for (unsigned int j = 0; j < indices.size (); j++)
     {
-      mesh.vertex (it.first, it.second);
+      mesh.vertex (indices[j], newPosition[j]);
     }
   }
 
@@ -511,7 +552,8 @@ namespace
     }
   };
 
-  bool collapseEdge (DynamicMesh& mesh, unsigned int i1, unsigned int i2, DynamicFaces faces)
+  bool collapseEdge (DynamicMesh& mesh, unsigned int i1, unsigned int i2, const glm::vec3& newPos,
+                     DynamicFaces faces, unsigned int* survivor = nullptr)
   {
     const unsigned int v1 = mesh.valence (i1);
     const unsigned int v2 = mesh.valence (i2);
@@ -613,13 +655,12 @@ namespace
       return n;
     };
 
-    const glm::vec3 newPos = Util::midpoint (mesh.vertex (i1), mesh.vertex (i2));
-
     if (v1 == 3)
     {
       if (deleteValence3Vertex (mesh, i1, faces))
       {
         mesh.vertex (i2, newPos);
+        Util::setIfNotNull (survivor, i2);
         return true;
       }
       else
@@ -632,6 +673,7 @@ namespace
       if (deleteValence3Vertex (mesh, i2, faces))
       {
         mesh.vertex (i1, newPos);
+        Util::setIfNotNull (survivor, i1);
         return true;
       }
       else
@@ -676,6 +718,7 @@ namespace
       assert (mesh.isFreeVertex (i2));
       assert (mesh.valence (newI) == v1 + v2 - 4);
 
+      Util::setIfNotNull (survivor, newI);
       return true;
     }
     else
@@ -684,6 +727,11 @@ namespace
     }
   }
 
+  bool collapseEdge (DynamicMesh& mesh, unsigned int i1, unsigned int i2, DynamicFaces faces)
+  {
+    return collapseEdge (mesh, i1, i2, Util::midpoint (mesh.vertex (i1), mesh.vertex (i2)), faces);
+  }
+
   typedef std::function<bool(unsigned int, unsigned int)> CollapsePredicate;
   bool collapseEdges (DynamicMesh& mesh, const CollapsePredicate& doCollapse, DynamicFaces& faces)
   {
@@ -740,6 +788,265 @@ namespace
     return collapseEdges (mesh, [](unsigned int, unsigned int) { return true; }, faces);
   }
 
+  struct Quadric
+  {
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+    Quadric ()
+      : a2 (0.0), ab (0.0), ac (0.0), ad (0.0), b2 (0.0), bc (0.0), bd (0.0), c2 (0.0), cd (0.0),
+        d2 (0.0)
+    {
+    }
+
+    Quadric (const glm::vec3& n, float d)
+      : a2 (n.x * n.x), ab (n.x * n.y), ac (n.x * n.z), ad (n.x * d), b2 (n.y * n.y),
+        bc (n.y * n.z), bd (n.y * d), c2 (n.z * n.z), cd (n.z * d), d2 (d * d)
+    {
+    }
+
+    Quadric operator+ (const Quadric& o) const
+    {
+      Quadric q (*this);
+      q.a2 += o.a2;
+      q.ab += o.ab;
+      q.ac += o.ac;
+      q.ad += o.ad;
+      q.b2 += o.b2;
+      q.bc += o.bc;
+      q.bd += o.bd;
+      q.c2 += o.c2;
+      q.cd += o.cd;
+      q.d2 += o.d2;
+      return q;
+    }
+
+    float error (const glm::vec3& p) const
+    {
+      const double x = p.x;
+      const double y = p.y;
+      const double z = p.z;
+
+      return float((this->a2 * x * x) + (2.0 * this->ab * x * y) + (2.0 * this->ac * x * z) +
+                   (2.0 * this->ad * x) + (this->b2 * y * y) + (2.0 * this->bc * y * z) +
+                   (2.0 * this->bd * y) + (this->c2 * z * z) + (2.0 * this->cd * z) + this->d2);
+    }
+  };
+
+  struct QuadricEdge
+  {
+    float        error;
+    unsigned int i1;
+    unsigned int i2;
+    unsigned int stamp1;
+    unsigned int stamp2;
+    glm::vec3    position;
+
+    bool operator< (const QuadricEdge& o) const { return this->error > o.error; }
+  };
+
+  struct QuadricVertex
+  {
+    Quadric      quadric;
+    unsigned int stamp;
+  };
+
+  // Collapses edges in order of their quadric error. Queued edges are invalidated lazily: each
+  // collapse assigns a new stamp to the surviving vertex, so that outdated entries are skipped
+  // when they reach the top of the queue. Only edges between vertices of inserted faces, or of
+  // survivors of their collapses, are queued.
+  class QuadricCollapse
+  {
+  public:
+    QuadricCollapse (DynamicMesh& m, float maxLengthSqr)
+      : mesh (m)
+      , maxEdgeLengthSqr (maxLengthSqr)
+      , nextStamp (1)
+    {
+    }
+
+    void insertFace (unsigned int f)
+    {
+      unsigned int i1, i2, i3;
+      this->mesh.vertexIndices (f, i1, i2, i3);
+
+      this->domain.insert (i1);
+      this->domain.insert (i2);
+      this->domain.insert (i3);
+
+      // Each edge of a closed mesh is shared by two faces with opposite orientation
+      if (i1 < i2)
+      {
+        this->insertEdge (i1, i2);
+      }
+      if (i2 < i3)
+      {
+        this->insertEdge (i2, i3);
+      }
+      if (i3 < i1)
+      {
+        this->insertEdge (i3, i1);
+      }
+    }
+
+    bool collapse (const std::function<bool()>& proceed)
+    {
+      bool collapsed = false;
+
+      while (this->queue.empty () == false && proceed ())
+      {
+        const QuadricEdge edge = this->queue.top ();
+        this->queue.pop ();
+
+        if (this->isValid (edge))
+        {
+          const Quadric quadric = this->vertices.at (edge.i1).quadric +
+                                  this->vertices.at (edge.i2).quadric;
+          unsigned int survivor = Util::invalidIndex ();
+
+          if (collapseEdge (this->mesh, edge.i1, edge.i2, edge.position, DynamicFaces (),
+                            &survivor))
+          {
+            assert (survivor != Util::invalidIndex ());
+
+            this->vertices.erase (edge.i1);
+            this->vertices.erase (edge.i2);
+            this->vertices[survivor] = QuadricVertex{quadric, this->nextStamp++};
+            this->survivors.push_back (survivor);
+            this->domain.insert (survivor);
+
+            this->mesh.forEachVertexAdjacentToVertex (survivor, [this, survivor](unsigned int a) {
+              if (this->domain.count (a) > 0)
+              {
+                this->insertEdge (survivor, a);
+              }
+            });
+            collapsed = true;
+          }
+        }
+      }
+      return collapsed;
+    }
+
+    void insertSurvivingFaces (DynamicFaces& faces) const
+    {
+      for (unsigned int s : this->survivors)
+      {
+        if (this->mesh.isFreeVertex (s) == false)
+        {
+          for (unsigned int a : this->mesh.adjacentFaces (s))
+          {
+            faces.insert (a);
+          }
+        }
+      }
+    }
+
+  private:
+    DynamicMesh&                                    mesh;
+    const float                                     maxEdgeLengthSqr;
+    unsigned int                                    nextStamp;
+    std::unordered_map<unsigned int, QuadricVertex> vertices;
+    std::priority_queue<QuadricEdge>                queue;
+    std::vector<unsigned int>                       survivors;
+    std::unordered_set<unsigned int>                domain;
+
+    const QuadricVertex& vertex (unsigned int i)
+    {
+      auto it = this->vertices.find (i);
+
+      if (it == this->vertices.end ())
+      {
+        Quadric quadric;
+        for (unsigned int a : this->mesh.adjacentFaces (i))
+        {
+          const glm::vec3 normal = this->mesh.faceNormal (a);
+
+          if (Util::isNaN (normal) == false)
+          {
+            quadric = quadric + Quadric (normal, -glm::dot (normal, this->mesh.vertex (i)));
+          }
+        }
+        it = this->vertices.emplace (i, QuadricVertex{quadric, 0}).first;
+      }
+      return it->second;
+    }
+
+    void insertEdge (unsigned int i1, unsigned int i2)
+    {
+      const glm::vec3& p1 = this->mesh.vertex (i1);
+      const glm::vec3& p2 = this->mesh.vertex (i2);
+      const float      lengthSqr = glm::distance2 (p1, p2);
+
+      if (lengthSqr < this->maxEdgeLengthSqr)
+      {
+        const QuadricVertex& v1 = this->vertex (i1);
+        const QuadricVertex& v2 = this->vertex (i2);
+        const Quadric        quadric = v1.quadric + v2.quadric;
+        const glm::vec3      candidates[] = {Util::midpoint (p1, p2), p1, p2};
+
+        QuadricEdge edge{Util::maxFloat (), i1, i2, v1.stamp, v2.stamp, candidates[0]};
+
+        for (const glm::vec3& c : candidates)
+        {
+          const float error = quadric.error (c);
+          if (error < edge.error)
+          {
+            edge.error = error;
+            edge.position = c;
+          }
+        }
+        // Prefer short edges on planar regions, where all candidates have no error
+        edge.error += Util::epsilon () * lengthSqr;
+        this->queue.push (edge);
+      }
+    }
+
+    bool isValid (const QuadricEdge& edge) const
+    {
+      if (this->mesh.isFreeVertex (edge.i1) || this->mesh.isFreeVertex (edge.i2))
+      {
+        return false;
+      }
+      const auto it1 = this->vertices.find (edge.i1);
+      const auto it2 = this->vertices.find (edge.i2);
+
+      if (it1 == this->vertices.end () || it1->second.stamp != edge.stamp1 ||
+          it2 == this->vertices.end () || it2->second.stamp != edge.stamp2)
+      {
+        return false;
+      }
+      for (unsigned int a : this->mesh.adjacentFaces (edge.i1))
+      {
+        unsigned int a1, a2, a3;
+        this->mesh.vertexIndices (a, a1, a2, a3);
+
+        if (edge.i2 == a1 || edge.i2 == a2 || edge.i2 == a3)
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+  };
+
+  bool collapseEdgesByQuadric (DynamicMesh& mesh, float maxEdgeLengthSqr, DynamicFaces& faces)
+  {
+    assert (faces.hasUncomitted () == false);
+
+    QuadricCollapse collapse (mesh, maxEdgeLengthSqr);
+
+    for (unsigned int f : faces)
+    {
+      collapse.insertFace (f);
+    }
+    const bool collapsed = collapse.collapse ([&mesh]() { return mesh.isEmpty () == false; });
+
+    faces.filter ([&mesh](unsigned int f) { return mesh.isFreeFace (f) == false; });
+    collapse.insertSurvivingFaces (faces);
+    faces.commit ();
+    return collapsed;
+  }
+
   void finalize (DynamicMesh& mesh, const DynamicFaces& faces)
   {
     mesh.forEachVertex (faces, [&mesh](unsigned int i) { mesh.setVertexNormal (i); });
@@ -749,11 +1056,46 @@ namespace
       mesh.realignFace (i);
     }
   }
+
+  // Returns `true` if all edges of the domain are shorter than `maxLength`, or `false` if the
+  // mesh reached `maxNumFaces` before.
+  bool subdivide (DynamicMesh& mesh, const PrimSphere& sphere, float maxLength,
+                  unsigned int maxNumFaces, DynamicFaces& faces)
+  {
+    ToolSculptEdgeMap newEdges;
+    do
+    {
+      // Each split adds two faces
+      const unsigned int maxNumSplits =
+        mesh.numFaces () < maxNumFaces ? (maxNumFaces - mesh.numFaces ()) / 2 : 0;
+
+      if (maxNumSplits == 0)
+      {
+        return false;
+      }
+      newEdges.reset ();
+
+      extendAndFilterDomain (mesh, sphere, faces, 1);
+      extendDomainByPoles (mesh, faces);
+      splitEdges (mesh, newEdges, maxLength, maxNumSplits, faces);
+
+      if (newEdges.isEmpty () == false)
+      {
+        triangulate (mesh, newEdges, faces);
+      }
+      extendDomain (mesh, faces, 1);
+      relaxEdges (mesh, faces);
+      smooth (mesh, faces);
+      finalize (mesh, faces);
+    } while (faces.numElements () > 0 && newEdges.isEmpty () == false);
+
+    return true;
+  }
 }
 
 namespace ToolSculptAction
 {
-  void sculpt (const SculptBrush& brush)
+  void sculpt (SculptBrush& brush)
   {
     DynamicFaces faces = brush.getAffectedFaces ();
 
@@ -765,11 +1107,11 @@ namespace ToolSculptAction
       {
         const float maxEdgeLengthSqr =
           mesh.averageEdgeLengthSqr (faces) * brush.parameters ().intensity ();
-        collapseEdgesByLength (mesh, maxEdgeLengthSqr, faces);
+        collapseEdgesByQuadric (mesh, maxEdgeLengthSqr, faces);
 
         if (mesh.isEmpty ())
         {
-          mesh.reset ();
+          // Empty meshes are deleted by the caller, which also owns their buffers
           return;
         }
         else
@@ -778,32 +1120,33 @@ namespace ToolSculptAction
           smooth (mesh, faces);
           finalize (mesh, faces);
         }
-        assert (mesh.pruneAndCheckConsistency ());
+        assert (mesh.checkPrunedConsistency ());
       }
       else
       {
         if (brush.subdivide ())
         {
-          ToolSculptEdgeMap newEdges;
-          do
-          {
-            newEdges.reset ();
-
-            extendAndFilterDomain (brush, faces, 1);
-            extendDomainByPoles (mesh, faces);
-
-            const float maxLength = glm::max (brush.subdivThreshold (), 2.0f * minEdgeLength);
-            splitEdges (mesh, newEdges, maxLength, faces);
-
-            if (newEdges.isEmpty () == false)
+          const float        maxLength = glm::max (brush.subdivThreshold (), 2.0f * minEdgeLength);
+          const unsigned int maxNumFaces = brush.subdivBudget () == 0
+                                             ? Util::invalidIndex ()
+                                             : mesh.numFaces () + brush.subdivBudget ();
+
+          // Refinement that exceeded the budget of previous dabs is continued first. Once the
+          // budget is exhausted, the remaining refinement is kept for subsequent dabs.
+          brush.filterPendingSubdivisions ([&mesh, maxLength, maxNumFaces](const PrimSphere& s) {
+            if (mesh.numFaces () >= maxNumFaces)
             {
-              triangulate (mesh, newEdges, faces);
+              return true;
             }
-            extendDomain (mesh, faces, 1);
-            relaxEdges (mesh, faces);
-            smooth (mesh, faces);
-            finalize (mesh, faces);
-          } while (faces.numElements () > 0 && newEdges.isEmpty () == false);
+            DynamicFaces pendingFaces;
+            return mesh.intersects (s, pendingFaces) &&
+                   subdivide (mesh, s, maxLength, maxNumFaces, pendingFaces) == false;
+          });
+
+          if (subdivide (mesh, brush.sphere (), maxLength, maxNumFaces, faces) == false)
+          {
+            brush.addPendingSubdivision (brush.sphere ());
+          }
         }
         faces = brush.getAffectedFaces ();
         brush.sculpt (faces);
@@ -819,12 +1162,33 @@ namespace ToolSculptAction
 
     mesh.forEachFace ([&faces](unsigned int i) { faces.insert (i); });
     faces.commit ();
+    smoothMesh (mesh, faces);
+  }
+
+  void smoothMesh (DynamicMesh& mesh, DynamicFaces& faces)
+  {
     relaxEdges (mesh, faces);
     smooth (mesh, faces);
     finalize (mesh, faces);
     mesh.bufferData ();
   }
 
+  void decimate (DynamicMesh& mesh, unsigned int targetFaces)
+  {
+    QuadricCollapse collapse (mesh, Util::maxFloat ());
+
+    mesh.forEachFace ([&collapse](unsigned int f) { collapse.insertFace (f); });
+
+    if (collapse.collapse ([&mesh, targetFaces]() { return mesh.numFaces () > targetFaces; }))
+    {
+      mesh.setAllNormals ();
+      mesh.realignAllFaces ();
+      mesh.sanitize ();
+      mesh.bufferData ();
+    }
+    assert (mesh.checkPrunedConsistency ());
+  }
+
   bool deleteFaces (DynamicMesh& mesh, DynamicFaces& faces)
   {
     bool collapsed = collapseAllEdges (mesh, faces);
@@ -5,13 +5,16 @@
 #ifndef DILAY_TOOL_SCULPT_ACTION
 #define DILAY_TOOL_SCULPT_ACTION
 
+class DynamicFaces;
 class DynamicMesh;
 class SculptBrush;
 
 namespace ToolSculptAction
 {
-  void sculpt (const SculptBrush&);
+  void sculpt (SculptBrush&);
   void smoothMesh (DynamicMesh&);
+  void smoothMesh (DynamicMesh&, DynamicFaces&);
+  void decimate (DynamicMesh&, unsigned int);
   bool deleteFaces (DynamicMesh&, DynamicFaces&);
 };
 
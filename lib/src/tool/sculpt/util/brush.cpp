@@ -2,7 +2,9 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
 #include <memory>
+#include <vector>
 #include "dynamic/faces.hpp"
 #include "dynamic/mesh.hpp"
 #include "primitive/plane.hpp"
@@ -11,6 +13,33 @@
 #include "tool/sculpt/util/brush.hpp"
 #include "util.hpp"
 
+namespace
+{
+  // Pending subdivisions beyond this number replace the oldest ones
+  constexpr unsigned int maxPendingSubdivisions = 16;
+
+  // Returns the smallest sphere that encloses both spheres
+  PrimSphere enclosingSphere (const PrimSphere& s1, const PrimSphere& s2)
+  {
+    const float d = glm::distance (s1.center (), s2.center ());
+
+    if (d + s2.radius () <= s1.radius ())
+    {
+      return s1;
+    }
+    else if (d + s1.radius () <= s2.radius ())
+    {
+      return s2;
+    }
+    else
+    {
+      const float r = 0.5f * (d + s1.radius () + s2.radius ());
+      return PrimSphere (s1.center () + ((s2.center () - s1.center ()) * ((r - s1.radius ()) / d)),
+                         r);
+    }
+  }
+}
+
 SBFlattenParameters::SBFlattenParameters ()
   : _lockPlane (false)
 {
@@ -158,12 +187,14 @@ struct SculptBrush::Impl
   float        detailFactor;
   float        stepWidthFactor;
   bool         subdivide;
+  unsigned int subdivBudget;
   DynamicMesh* _mesh;
   bool         hasPointOfAction;
   glm::vec3    _prevPosition;
   glm::vec3    _position;
   glm::vec3    _normal;
 
+  std::vector<PrimSphere>       pendingSubdivisions;
   std::unique_ptr<SBParameters> _parameters;
 
   Impl (SculptBrush* s)
@@ -172,6 +203,7 @@ struct SculptBrush::Impl
     , detailFactor (0.0f)
     , stepWidthFactor (0.0f)
     , subdivide (true)
+    , subdivBudget (0)
     , _mesh (nullptr)
     , hasPointOfAction (false)
   {
@@ -242,6 +274,7 @@ struct SculptBrush::Impl
   {
     this->hasPointOfAction = false;
     this->_mesh = nullptr;
+    this->pendingSubdivisions.clear ();
   }
 
   void mirror (const PrimPlane& plane)
@@ -259,6 +292,44 @@ struct SculptBrush::Impl
     }
   }
 
+  // Consecutive dabs overlap, so that a new sphere is usually merged with a pending one. Merged
+  // spheres grow to at most twice the radius of the brush.
+  void addPendingSubdivision (const PrimSphere& sphere)
+  {
+    assert (this->hasPointOfAction);
+
+    for (PrimSphere& pending : this->pendingSubdivisions)
+    {
+      const float d = glm::distance (pending.center (), sphere.center ());
+
+      if (d < pending.radius () + sphere.radius ())
+      {
+        const PrimSphere merged = enclosingSphere (pending, sphere);
+
+        if (merged.radius () <= 2.0f * sphere.radius ())
+        {
+          pending = merged;
+          return;
+        }
+      }
+    }
+
+    if (this->pendingSubdivisions.size () == maxPendingSubdivisions)
+    {
+      this->pendingSubdivisions.erase (this->pendingSubdivisions.begin ());
+    }
+    this->pendingSubdivisions.push_back (sphere);
+  }
+
+  void filterPendingSubdivisions (const std::function<bool(const PrimSphere&)>& f)
+  {
+    const auto isDone = [&f](const PrimSphere& s) { return f (s) == false; };
+
+    this->pendingSubdivisions.erase (std::remove_if (this->pendingSubdivisions.begin (),
+                                                     this->pendingSubdivisions.end (), isDone),
+                                     this->pendingSubdivisions.end ());
+  }
+
   DynamicFaces getAffectedFaces () const
   {
     assert (this->hasPointOfAction);
@@ -293,11 +364,13 @@ GETTER_CONST (float, SculptBrush, radius)
 GETTER_CONST (float, SculptBrush, detailFactor)
 GETTER_CONST (float, SculptBrush, stepWidthFactor)
 GETTER_CONST (bool, SculptBrush, subdivide)
+GETTER_CONST (unsigned int, SculptBrush, subdivBudget)
 DELEGATE_CONST (DynamicMesh&, SculptBrush, mesh)
 SETTER (float, SculptBrush, radius)
 SETTER (float, SculptBrush, detailFactor)
 SETTER (float, SculptBrush, stepWidthFactor)
 SETTER (bool, SculptBrush, subdivide)
+SETTER (unsigned int, SculptBrush, subdivBudget)
 DELEGATE_CONST (float, SculptBrush, subdivThreshold)
 DELEGATE_CONST (const glm::vec3&, SculptBrush, lastPosition)
 DELEGATE_CONST (const glm::vec3&, SculptBrush, position)
@@ -309,6 +382,9 @@ GETTER_CONST (bool, SculptBrush, hasPointOfAction)
 DELEGATE3 (void, SculptBrush, setPointOfAction, DynamicMesh&, const glm::vec3&, const glm::vec3&)
 DELEGATE (void, SculptBrush, resetPointOfAction)
 DELEGATE1 (void, SculptBrush, mirror, const PrimPlane&)
+DELEGATE1 (void, SculptBrush, addPendingSubdivision, const PrimSphere&)
+DELEGATE1 (void, SculptBrush, filterPendingSubdivisions,
+           const std::function<bool(const PrimSphere&)>&)
 DELEGATE_CONST (DynamicFaces, SculptBrush, getAffectedFaces)
 DELEGATE1_CONST (void, SculptBrush, sculpt, const DynamicFaces&)
 DELEGATE_CONST (SBParameters*, SculptBrush, parametersPointer)
@@ -5,6 +5,7 @@
 #ifndef DILAY_TOOL_SCULPT_BRUSH
 #define DILAY_TOOL_SCULPT_BRUSH
 
+#include <functional>
 #include <glm/glm.hpp>
 #include "macro.hpp"
 #include "maybe.hpp"
@@ -151,6 +152,7 @@ public:
   float        detailFactor () const;
   float        stepWidthFactor () const;
   bool         subdivide () const;
+  unsigned int subdivBudget () const;
   bool         hasMesh () const;
   DynamicMesh& mesh () const;
 
@@ -158,6 +160,7 @@ public:
   void detailFactor (float);
   void stepWidthFactor (float);
   void subdivide (bool);
+  void subdivBudget (unsigned int);
 
   float            subdivThreshold () const;
   const glm::vec3& lastPosition () const;
@@ -170,6 +173,8 @@ public:
   void             setPointOfAction (DynamicMesh&, const glm::vec3&, const glm::vec3&);
   void             resetPointOfAction ();
   void             mirror (const PrimPlane&);
+  void             addPendingSubdivision (const PrimSphere&);
+  void             filterPendingSubdivisions (const std::function<bool(const PrimSphere&)>&);
 
   DynamicFaces getAffectedFaces () const;
   void         sculpt (const DynamicFaces&) const;
@@ -0,0 +1,109 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "tool/sculpt/util/worker.hpp"
+
+struct ToolSculptWorker::Impl
+{
+  const unsigned int                maxPendingJobs;
+  std::deque<std::function<void()>> jobs;
+  std::mutex                        jobsMutex;
+  std::mutex                        runMutex;
+  std::condition_variable           pushed;
+  std::condition_variable           popped;
+  std::condition_variable           synchronized;
+  std::atomic<unsigned int>         numSynchronizing;
+  bool                              isRunning;
+  bool                              isStopped;
+  std::thread                       thread;
+
+  Impl (unsigned int m)
+    : maxPendingJobs (m)
+    , numSynchronizing (0)
+    , isRunning (false)
+    , isStopped (false)
+    , thread ([this]() { this->run (); })
+  {
+    assert (this->maxPendingJobs > 0);
+  }
+
+  ~Impl ()
+  {
+    {
+      std::lock_guard<std::mutex> lock (this->jobsMutex);
+      this->isStopped = true;
+    }
+    this->pushed.notify_one ();
+    this->thread.join ();
+  }
+
+  void run ()
+  {
+    std::unique_lock<std::mutex> lock (this->jobsMutex);
+
+    while (true)
+    {
+      this->pushed.wait (lock,
+                         [this]() { return this->isStopped || this->jobs.empty () == false; });
+
+      if (this->jobs.empty ())
+      {
+        return;
+      }
+      const std::function<void()> job = std::move (this->jobs.front ());
+      this->jobs.pop_front ();
+      this->isRunning = true;
+      lock.unlock ();
+      job ();
+      lock.lock ();
+      this->isRunning = false;
+      this->popped.notify_all ();
+    }
+  }
+
+  void push (const std::function<void()>& job)
+  {
+    {
+      std::unique_lock<std::mutex> lock (this->jobsMutex);
+      this->popped.wait (lock, [this]() { return this->jobs.size () < this->maxPendingJobs; });
+      this->jobs.push_back (job);
+    }
+    this->pushed.notify_one ();
+  }
+
+  void synchronize (const std::function<void()>& f)
+  {
+    this->numSynchronizing++;
+    {
+      std::lock_guard<std::mutex> lock (this->runMutex);
+      this->numSynchronizing--;
+      f ();
+    }
+    this->synchronized.notify_all ();
+  }
+
+  void exclusive (const std::function<void()>& f)
+  {
+    std::unique_lock<std::mutex> lock (this->runMutex);
+    this->synchronized.wait (lock, [this]() { return this->numSynchronizing == 0; });
+    f ();
+  }
+
+  void finish ()
+  {
+    std::unique_lock<std::mutex> lock (this->jobsMutex);
+    this->popped.wait (lock, [this]() { return this->jobs.empty () && this->isRunning == false; });
+  }
+};
+
+DELEGATE1_BIG2 (ToolSculptWorker, unsigned int)
+DELEGATE1 (void, ToolSculptWorker, push, const std::function<void()>&)
+DELEGATE1 (void, ToolSculptWorker, synchronize, const std::function<void()>&)
+DELEGATE1 (void, ToolSculptWorker, exclusive, const std::function<void()>&)
+DELEGATE (void, ToolSculptWorker, finish)
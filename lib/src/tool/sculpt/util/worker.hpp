@@ -0,0 +1,35 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_TOOL_SCULPT_WORKER
+#define DILAY_TOOL_SCULPT_WORKER
+
+#include <functional>
+#include "macro.hpp"
+
+// Runs sculpt jobs on a dedicated thread in the order they were pushed. Jobs access the sculpted
+// mesh in short sections via `exclusive` (e.g. one per dab), other threads access it via
+// `synchronize`, which therefore waits for at most one section instead of a whole job.
+class ToolSculptWorker
+{
+public:
+  DECLARE_BIG2 (ToolSculptWorker, unsigned int)
+
+  // Blocks while the maximum number of pending jobs is reached
+  void push (const std::function<void()>&);
+
+  // Runs a function on the calling thread between two exclusive sections of jobs
+  void synchronize (const std::function<void()>&);
+
+  // Runs a section of the current job. Pending calls of `synchronize` are served first.
+  void exclusive (const std::function<void()>&);
+
+  // Blocks until all pending jobs have been run
+  void finish ();
+
+private:
+  IMPLEMENTATION
+};
+
+#endif
@@ -198,14 +198,14 @@ struct ToolTransformMesh::Impl
         this->mesh = &intersection.mesh ();
         if (e.modifiers () == Qt::NoModifier)
         {
-          this->self->snapshotDynamicMeshes ();
+          this->self->snapshotDynamicMeshes ({this->mesh});
 
           this->movement.reset (intersection.position ());
           this->mode = Mode::Move;
         }
         else if (e.modifiers () == Qt::ShiftModifier)
         {
-          this->self->snapshotDynamicMeshes ();
+          this->self->snapshotDynamicMeshes ({this->mesh});
 
           const PrimAABox bounds = this->mesh->mesh ().bounds ();
           this->scalingSize = bounds.maximum () - bounds.minimum ();
@@ -220,7 +220,7 @@ struct ToolTransformMesh::Impl
         }
         else if (e.modifiers () == Qt::ControlModifier)
         {
-          this->self->snapshotDynamicMeshes ();
+          this->self->snapshotDynamicMeshes ({this->mesh});
 
           switch (this->rotationOrigin)
           {
@@ -277,7 +277,7 @@ struct ToolTrimMesh::Impl
   {
     const QPoint cursorPos (ViewUtil::toQPoint (this->self->cursorPosition ()));
 
-    QPen pen (this->self->config ().get<Color> ("editor/on-screen-color").qColor ());
+    QPen pen (ViewUtil::toQColor (this->self->config ().get<Color> ("editor/on-screen-color")));
     pen.setCapStyle (Qt::FlatCap);
     pen.setWidth (this->trimMode == TrimMode::Normal ? 2 : this->widthEdit.value ());
 
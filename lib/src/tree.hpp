@@ -5,118 +5,117 @@
 #ifndef DILAY_TREE
 #define DILAY_TREE
 
-#include <list>
-#include "maybe.hpp"
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include "util.hpp"
 
+template <typename T> class Tree;
+template <typename T> class TreeNodePool;
+
 template <typename T> class TreeNode
 {
 public:
-  TreeNode (const T& d, TreeNode* p = nullptr)
-    : _data (d)
-    , _parent (p)
+  static constexpr unsigned int invalidIndex = Util::maxUnsignedInt ();
+
+  TreeNode (TreeNodePool<T>& pool, unsigned int index, T&& d)
+    : _pool (&pool)
+    , _index (index)
+    , _parent (invalidIndex)
+    , _firstChild (invalidIndex)
+    , _lastChild (invalidIndex)
+    , _previousSibling (invalidIndex)
+    , _nextSibling (invalidIndex)
+    , _numChildren (0)
+    , _data (std::move (d))
   {
   }
 
-  TreeNode (T&& d, TreeNode* p = nullptr)
-    : _data (std::move (d))
-    , _parent (p)
-  {
-  }
-
-  TreeNode (const TreeNode& o)
-    : _data (o._data)
-    , _parent (nullptr)
-    , _children (o._children)
-  {
-    this->forEachChild ([this](TreeNode& c) { c._parent = this; });
-  }
-
-  template <typename... Args> static TreeNode make (Args&&... args)
-  {
-    return TreeNode (T (std::forward<Args> (args)...));
-  }
-
   T& data () { return this->_data; }
 
   const T& data () const { return this->_data; }
 
   void data (const T& d) { this->_data = d; }
 
-  TreeNode* parent () const { return this->_parent; }
+  TreeNode* parent () const
+  {
+    return this->_parent == invalidIndex ? nullptr : &this->_pool->node (this->_parent);
+  }
 
   template <typename... Args> TreeNode& emplaceChild (Args&&... args)
   {
-    this->_children.emplace_back (make (std::forward<Args> (args)...));
-    this->_children.back ()._parent = this;
-
-    return this->_children.back ();
+    return this->_pool->node (
+      this->_pool->emplace (T (std::forward<Args> (args)...), this->_index));
   }
 
   TreeNode& addChild (const TreeNode& node)
   {
-    this->_children.emplace_back (node);
-    this->_children.back ()._parent = this;
-
-    return this->_children.back ();
+    return this->_pool->node (this->_pool->copy (node, this->_index));
   }
 
   void deleteChild (TreeNode& child)
   {
-    for (auto it = this->_children.begin (); it != this->_children.end (); ++it)
-    {
-      if (&*it == &child)
-      {
-        this->_children.erase (it);
-        return;
-      }
-    }
-    DILAY_IMPOSSIBLE
+    assert (child._pool == this->_pool);
+    assert (child._parent == this->_index);
+
+    this->_pool->erase (child._index);
   }
 
   void forEachChild (const std::function<void(TreeNode&)>& f)
   {
-    for (TreeNode& c : this->_children)
+    for (unsigned int i = this->_firstChild; i != invalidIndex;)
     {
+      TreeNode& c = this->_pool->node (i);
+
       f (c);
+      i = c._nextSibling;
     }
   }
 
   void forEachConstChild (const std::function<void(const TreeNode&)>& f) const
   {
-    for (const TreeNode& c : this->_children)
+    for (unsigned int i = this->_firstChild; i != invalidIndex;)
     {
+      const TreeNode& c = this->_pool->node (i);
+
       f (c);
+      i = c._nextSibling;
     }
   }
 
+  // Depth-first pre-order traversal without recursion: links are followed after `f` returns, so
+  // `f` may add or delete children of the visited node
   void forEachNode (const std::function<void(TreeNode&)>& f)
   {
-    f (*this);
-
-    this->forEachChild ([&f](TreeNode& c) { c.forEachNode (f); });
+    for (TreeNode* n = this; n != nullptr; n = n->nextNode (*this))
+    {
+      f (*n);
+    }
   }
 
   void forEachConstNode (const std::function<void(const TreeNode&)>& f) const
   {
-    f (*this);
-
-    this->forEachConstChild ([&f](const TreeNode& c) { c.forEachConstNode (f); });
+    for (const TreeNode* n = this; n != nullptr; n = n->nextNode (*this))
+    {
+      f (*n);
+    }
   }
 
   TreeNode& lastChild ()
   {
     assert (this->numChildren () > 0);
-    return this->_children.back ();
+    return this->_pool->node (this->_lastChild);
   }
 
   const TreeNode& lastChild () const
   {
     assert (this->numChildren () > 0);
-    return this->_children.back ();
+    return this->_pool->node (this->_lastChild);
   }
 
-  unsigned int numChildren () const { return this->_children.size (); }
+  unsigned int numChildren () const { return this->_numChildren; }
 
   unsigned int numNodes () const
   {
@@ -127,84 +126,287 @@ public:
 
   void deleteChildIf (const std::function<bool(const TreeNode&)>& f)
   {
-    for (auto it = this->_children.begin (); it != this->_children.end ();)
+    for (unsigned int i = this->_firstChild; i != invalidIndex;)
     {
-      if (f (*it))
+      const TreeNode&    c = this->_pool->node (i);
+      const unsigned int next = c._nextSibling;
+
+      if (f (c))
       {
-        it = this->_children.erase (it);
+        this->_pool->erase (i);
       }
-      else
+      i = next;
+    }
+  }
+
+private:
+  friend class Tree<T>;
+  friend class TreeNodePool<T>;
+
+  TreeNode* nextNode (const TreeNode& root) const
+  {
+    if (this->_firstChild != invalidIndex)
+    {
+      return &this->_pool->node (this->_firstChild);
+    }
+    for (const TreeNode* n = this; n != &root; n = n->parent ())
+    {
+      if (n->_nextSibling != invalidIndex)
       {
-        ++it;
+        return &this->_pool->node (n->_nextSibling);
       }
     }
+    return nullptr;
+  }
+
+  void appendChild (TreeNode& child)
+  {
+    assert (child._parent == invalidIndex);
+
+    child._parent = this->_index;
+    child._previousSibling = this->_lastChild;
+    child._nextSibling = invalidIndex;
+
+    if (this->_lastChild == invalidIndex)
+    {
+      this->_firstChild = child._index;
+    }
+    else
+    {
+      this->_pool->node (this->_lastChild)._nextSibling = child._index;
+    }
+    this->_lastChild = child._index;
+    this->_numChildren++;
+  }
+
+  void unlinkChild (TreeNode& child)
+  {
+    assert (child._parent == this->_index);
+
+    if (child._previousSibling == invalidIndex)
+    {
+      this->_firstChild = child._nextSibling;
+    }
+    else
+    {
+      this->_pool->node (child._previousSibling)._nextSibling = child._nextSibling;
+    }
+
+    if (child._nextSibling == invalidIndex)
+    {
+      this->_lastChild = child._previousSibling;
+    }
+    else
+    {
+      this->_pool->node (child._nextSibling)._previousSibling = child._previousSibling;
+    }
+    child._parent = invalidIndex;
+    child._previousSibling = invalidIndex;
+    child._nextSibling = invalidIndex;
+    this->_numChildren--;
+  }
+
+  TreeNodePool<T>* _pool;
+  unsigned int     _index;
+  unsigned int     _parent;
+  unsigned int     _firstChild;
+  unsigned int     _lastChild;
+  unsigned int     _previousSibling;
+  unsigned int     _nextSibling;
+  unsigned int     _numChildren;
+  T                _data;
+};
+
+// Storage of all nodes of a tree. Nodes are allocated in contiguous blocks that never move, so
+// references to nodes stay valid until the nodes are deleted. Slots of deleted nodes are reused.
+template <typename T> class TreeNodePool
+{
+public:
+  static constexpr unsigned int invalidIndex = TreeNode<T>::invalidIndex;
+
+  TreeNodePool ()
+    : _root (invalidIndex)
+  {
+  }
+
+  // Copies all slots as they are: links are indices and thus remain valid
+  TreeNodePool (const TreeNodePool& other)
+    : _nodes (other._nodes)
+    , _free (other._free)
+    , _root (other._root)
+  {
+    for (TreeNode<T>& n : this->_nodes)
+    {
+      n._pool = this;
+    }
+  }
+
+  TreeNodePool (TreeNodePool&&) = delete;
+  const TreeNodePool& operator= (const TreeNodePool&) = delete;
+  const TreeNodePool& operator= (TreeNodePool&&) = delete;
+
+  TreeNode<T>& node (unsigned int i) { return this->_nodes[i]; }
+
+  const TreeNode<T>& node (unsigned int i) const { return this->_nodes[i]; }
+
+  unsigned int root () const { return this->_root; }
+
+  void root (unsigned int i)
+  {
+    assert (i == invalidIndex || this->node (i)._parent == invalidIndex);
+    this->_root = i;
+  }
+
+  // Adds a new node as last child of `parent` or as a detached node if `parent` is invalid
+  unsigned int emplace (T&& data, unsigned int parent)
+  {
+    unsigned int index;
+
+    if (this->_free.empty ())
+    {
+      index = this->_nodes.size ();
+      this->_nodes.emplace_back (*this, index, std::move (data));
+    }
+    else
+    {
+      index = this->_free.back ();
+      this->_free.pop_back ();
+      this->_nodes[index] = TreeNode<T> (*this, index, std::move (data));
+    }
+
+    if (parent != invalidIndex)
+    {
+      this->node (parent).appendChild (this->node (index));
+    }
+    return index;
+  }
+
+  // Copies the subtree of `source`, which may be part of this pool, in depth-first order
+  unsigned int copy (const TreeNode<T>& source, unsigned int parent)
+  {
+    std::vector<const TreeNode<T>*> sources;
+    source.forEachConstNode ([&sources](const TreeNode<T>& n) { sources.push_back (&n); });
+
+    std::unordered_map<const TreeNode<T>*, unsigned int> copies;
+    copies.reserve (sources.size ());
+
+    for (const TreeNode<T>* n : sources)
+    {
+      const unsigned int copyParent = n == &source ? parent : copies.at (n->parent ());
+
+      copies.emplace (n, this->emplace (T (n->data ()), copyParent));
+    }
+    return copies.at (&source);
+  }
+
+  // Deletes the subtree of node `i`
+  void erase (unsigned int i)
+  {
+    TreeNode<T>& n = this->node (i);
+
+    if (n._parent != invalidIndex)
+    {
+      this->node (n._parent).unlinkChild (n);
+    }
+    else if (i == this->_root)
+    {
+      this->_root = invalidIndex;
+    }
+    n.forEachConstNode ([this](const TreeNode<T>& d) { this->_free.push_back (d._index); });
+  }
+
+  // Makes `i` the new root by reversing the links from `i` to the current root
+  void reroot (unsigned int i)
+  {
+    std::vector<unsigned int> path;
+
+    for (unsigned int n = i; n != invalidIndex; n = this->node (n)._parent)
+    {
+      path.push_back (n);
+    }
+    for (unsigned int j = 0; j + 1 < path.size (); j++)
+    {
+      this->node (path[j + 1]).unlinkChild (this->node (path[j]));
+    }
+    for (unsigned int j = 0; j + 1 < path.size (); j++)
+    {
+      this->node (path[j]).appendChild (this->node (path[j + 1]));
+    }
+    this->_root = i;
   }
 
 private:
-  T                   _data;
-  TreeNode*           _parent;
-  std::list<TreeNode> _children;
+  std::deque<TreeNode<T>>   _nodes;
+  std::vector<unsigned int> _free;
+  unsigned int              _root;
 };
 
 template <typename T> class Tree
 {
 public:
-  bool hasRoot () const { return bool(this->_root); }
+  Tree () = default;
+
+  Tree (const Tree& other)
+    : _pool (other._pool ? std::make_unique<TreeNodePool<T>> (*other._pool) : nullptr)
+  {
+  }
+
+  Tree (Tree&&) = default;
+
+  Tree& operator= (const Tree& other)
+  {
+    Tree copy (other);
+    this->_pool = std::move (copy._pool);
+    return *this;
+  }
+
+  Tree& operator= (Tree&&) = default;
+
+  bool hasRoot () const { return this->_pool && this->_pool->root () != TreeNode<T>::invalidIndex; }
 
   TreeNode<T>& root ()
   {
     assert (this->hasRoot ());
-    return *this->_root;
+    return this->_pool->node (this->_pool->root ());
   }
 
   const TreeNode<T>& root () const
   {
     assert (this->hasRoot ());
-    return *this->_root;
+    return this->_pool->node (this->_pool->root ());
   }
 
   template <typename... Args> TreeNode<T>& emplaceRoot (Args&&... args)
   {
-    this->_root = Maybe<TreeNode<T>>::make (TreeNode<T>::make (std::forward<Args> (args)...));
+    T data (std::forward<Args> (args)...);
+
+    this->_pool = std::make_unique<TreeNodePool<T>> ();
+    this->_pool->root (this->_pool->emplace (std::move (data), TreeNode<T>::invalidIndex));
     return this->root ();
   }
 
-  void reset () { this->_root.reset (); }
+  void reset () { this->_pool.reset (); }
 
+  // References to all nodes stay valid
   void rebalance (TreeNode<T>& node)
   {
-    const std::function<void(const TreeNode<T>&, TreeNode<T>&)> go = [&go](const auto& child,
-                                                                           auto& rebalancedChild) {
-      if (child.parent ())
-      {
-        const auto& parent = *child.parent ();
-        auto&       rebalancedParent = rebalancedChild.emplaceChild (parent.data ());
-
-        parent.forEachConstChild ([&rebalancedParent, &child](const auto& c) {
-          if (&c != &child)
-          {
-            rebalancedParent.addChild (c);
-          }
-        });
-        go (parent, rebalancedParent);
-      }
-    };
+    assert (this->hasRoot ());
+    assert (&this->_pool->node (node._index) == &node);
 
-    TreeNode<T>& newRoot (node);
-    go (node, newRoot);
-    this->_root = std::move (newRoot);
+    this->_pool->reroot (node._index);
   }
 
   Tree<T> split (TreeNode<T>& node)
   {
     Tree<T> tree;
-    tree._root = node;
+    tree._pool = std::make_unique<TreeNodePool<T>> ();
+    tree._pool->root (tree._pool->copy (node, TreeNode<T>::invalidIndex));
 
     if (node.parent ())
     {
       node.parent ()->deleteChild (node);
     }
-    else if (&node == this->_root.get ())
+    else if (this->hasRoot () && &node == &this->root ())
     {
       this->reset ();
     }
@@ -212,7 +414,7 @@ public:
   }
 
 private:
-  Maybe<TreeNode<T>> _root;
+  std::unique_ptr<TreeNodePool<T>> _pool;
 };
 
 #endif
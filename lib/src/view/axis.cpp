@@ -14,6 +14,7 @@
 #include "opengl.hpp"
 #include "render-mode.hpp"
 #include "view/axis.hpp"
+#include "view/util.hpp"
 
 struct ViewAxis::Impl
 {
@@ -158,7 +159,7 @@ struct ViewAxis::Impl
       painter.drawText (rect, Qt::AlignCenter, l);
     };
 
-    painter.setPen (this->axisLabelColor.qColor ());
+    painter.setPen (ViewUtil::toQColor (this->axisLabelColor));
     painter.setFont (font);
 
     const float labelPosition = this->axisScaling.y + (this->axisArrowScaling.y * 0.5f);
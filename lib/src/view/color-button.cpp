@@ -26,11 +26,12 @@ struct ViewColorButton::Impl
         options.setFlag (QColorDialog::ShowAlphaChannel);
       }
 
-      QColor selected = QColorDialog::getColor (this->color.qColor (), this->self->parentWidget (),
-                                                QObject::tr ("Select color"), options);
+      QColor selected =
+        QColorDialog::getColor (ViewUtil::toQColor (this->color), this->self->parentWidget (),
+                                QObject::tr ("Select color"), options);
       if (selected.isValid ())
       {
-        this->color = Color (selected);
+        this->color = ViewUtil::toColor (selected);
         this->self->update ();
         emit this->self->colorChanged (this->color);
       }
@@ -52,7 +53,7 @@ struct ViewColorButton::Impl
     rect.setTop (rect.top () + dh);
     rect.setBottom (rect.bottom () - dh);
 
-    painter.fillRect (rect, this->color.qColor ());
+    painter.fillRect (rect, ViewUtil::toQColor (this->color));
   }
 };
 
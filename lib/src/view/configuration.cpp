@@ -200,6 +200,8 @@ namespace
     gridSketch->addCenter (QObject::tr ("Sketch"));
     addFloatEdit (data, *gridSketch, "editor/tool/sketch-spheres/step-width-factor",
                   QObject::tr ("Step width factor"), Util::epsilon (), 1.0f);
+    addFloatEdit (data, *gridSketch, "editor/sketch/preview/resolution",
+                  QObject::tr ("Preview resolution"), 0.01f, 1.0f);
     gridSketch->addStretcher ();
 
     layout->addWidget (gridSculpt);
@@ -213,6 +215,12 @@ namespace
     ViewTwoColumnGrid* grid = new ViewTwoColumnGrid;
 
     addIntEdit (data, *grid, "editor/undo-depth", QObject::tr ("Undo depth"), 1, Util::maxInt ());
+    addIntEdit (data, *grid, "editor/undo-memory", QObject::tr ("Undo memory (MiB)"), 1,
+                Util::maxInt ());
+    addBoolEdit (data, *grid, "editor/undo-quantization",
+                 QObject::tr ("Quantize undo snapshots (lossy)"));
+    addIntEdit (data, *grid, "editor/autosave-interval", QObject::tr ("Autosave interval (s)"), 0,
+                Util::maxInt ());
     addIntEdit (data, *grid, "window/initial-width", QObject::tr ("Initial window width"), 1,
                 Util::maxInt ());
     addIntEdit (data, *grid, "window/initial-height", QObject::tr ("Initial window height"), 1,
@@ -6,6 +6,7 @@
 #include "dimension.hpp"
 #include "dynamic/mesh-intersection.hpp"
 #include "dynamic/mesh.hpp"
+#include "history.hpp"
 #include "mesh.hpp"
 #include "primitive/aabox.hpp"
 #include "primitive/plane.hpp"
@@ -22,37 +23,53 @@ namespace
 {
   void addActions (QMenu& menu, ViewMainWindow& mainWindow, DynamicMesh& mesh)
   {
-    Scene&  scene = mainWindow.glWidget ().state ().scene ();
-    Config& config = mainWindow.glWidget ().state ().config ();
+    Scene&   scene = mainWindow.glWidget ().state ().scene ();
+    Config&  config = mainWindow.glWidget ().state ().config ();
+    History& history = mainWindow.glWidget ().state ().history ();
+
+    // Actions are snapshotted, so that changes recorded before remain applicable when undoing
+    const auto snapshot = [&scene, &history, &mesh](bool touched) {
+      std::vector<const DynamicMesh*> meshes;
+      if (touched)
+      {
+        meshes.push_back (&mesh);
+      }
+      history.snapshotDynamicMeshes (scene, meshes);
+    };
 
     ViewUtil::addAction (menu, QObject::tr ("Copy mesh"), QKeySequence (),
-                         [&mainWindow, &scene, &config, &mesh]() {
+                         [&mainWindow, &scene, &config, &mesh, snapshot]() {
+                           snapshot (false);
                            scene.newDynamicMesh (config, mesh);
                            mainWindow.update ();
                          });
 
     ViewUtil::addAction (
-      menu, QObject::tr ("Mirror mesh"), QKeySequence (), [&mainWindow, &mesh]() {
+      menu, QObject::tr ("Mirror mesh"), QKeySequence (), [&mainWindow, &mesh, snapshot]() {
         const PrimAABox bounds = mesh.mesh ().bounds ();
         const PrimPlane plane (bounds.center (), DimensionUtil::vector (Dimension::X));
+        snapshot (true);
         mesh.mirror (plane);
         mainWindow.update ();
       });
 
     ViewUtil::addAction (menu, QObject::tr ("Move mesh to center"), QKeySequence (),
-                         [&mainWindow, &mesh]() {
+                         [&mainWindow, &mesh, snapshot]() {
+                           snapshot (true);
                            mesh.moveToCenter ();
                            mainWindow.update ();
                          });
 
     ViewUtil::addAction (menu, QObject::tr ("Normalize mesh scaling"), QKeySequence (),
-                         [&mainWindow, &mesh]() {
+                         [&mainWindow, &mesh, snapshot]() {
+                           snapshot (true);
                            mesh.normalizeScaling ();
                            mainWindow.update ();
                          });
 
     ViewUtil::addAction (menu, QObject::tr ("Delete mesh"), QKeySequence (),
-                         [&mainWindow, &scene, &mesh]() {
+                         [&mainWindow, &scene, &mesh, snapshot]() {
+                           snapshot (true);
                            scene.deleteMesh (mesh);
                            mainWindow.update ();
                          });
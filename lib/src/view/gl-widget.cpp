@@ -3,9 +3,13 @@
  * Use and redistribute under the terms of the GNU General Public License
  */
 #include <QCoreApplication>
+#include <QFile>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QTimer>
 #include <glm/glm.hpp>
+#include <vector>
+#include "autosave.hpp"
 #include "camera.hpp"
 #include "config.hpp"
 #include "mesh-util.hpp"
@@ -13,6 +17,7 @@
 #include "opengl.hpp"
 #include "renderer.hpp"
 #include "scene.hpp"
+#include "sketch/preview.hpp"
 #include "state.hpp"
 #include "tool/move-camera.hpp"
 #include "view/axis.hpp"
@@ -27,6 +32,18 @@
 #include "view/tool-pane.hpp"
 #include "view/util.hpp"
 
+namespace
+{
+  // Pending move events are dispatched about once per frame
+  constexpr int coalescingInterval = 16;
+
+  bool haveSameButtons (const ViewPointingEvent& a, const ViewPointingEvent& b)
+  {
+    return a.leftButton () == b.leftButton () && a.middleButton () == b.middleButton () &&
+           a.rightButton () == b.rightButton () && a.modifiers () == b.modifiers ();
+  }
+}
+
 struct ViewGlWidget::Impl
 {
   typedef std::unique_ptr<ToolMoveCamera> ToolMoveCameraPtr;
@@ -44,18 +61,34 @@ struct ViewGlWidget::Impl
   FloorPlanePtr     _floorPlane;
   bool              tabletPressed;
 
+  std::vector<ViewPointingEvent> pendingMoveEvents;
+  glm::ivec2                     lastPosition;
+  QTimer                         coalescingTimer;
+
   Impl (ViewGlWidget* s, ViewMainWindow& mW, Config& cfg, Cache& cch)
     : self (s)
     , mainWindow (mW)
     , config (cfg)
     , cache (cch)
     , tabletPressed (false)
+    , lastPosition (0)
   {
     this->self->setAutoFillBackground (false);
+
+    this->coalescingTimer.setSingleShot (true);
+    this->coalescingTimer.setInterval (coalescingInterval);
+    QObject::connect (&this->coalescingTimer, &QTimer::timeout,
+                      [this]() { this->dispatchMoveEvents (); });
+
+    // Sketch previews are extracted in the background and shown as soon as they are finished
+    SketchPreview::onFinishedJob (
+      [this]() { QMetaObject::invokeMethod (this->self, "update", Qt::QueuedConnection); });
   }
 
   ~Impl ()
   {
+    SketchPreview::onFinishedJob (nullptr);
+
     this->self->makeCurrent ();
 
     this->_state.reset (nullptr);
@@ -129,13 +162,37 @@ struct ViewGlWidget::Impl
         ViewUtil::error (this->mainWindow, QObject::tr ("Could not open file."));
       }
     }
-    else
+    else if (this->recoverScene () == false)
     {
       this->state ().scene ().newDynamicMesh (this->config, MeshUtil::icosphere (4));
     }
     this->mainWindow.update ();
   }
 
+  // Journals are only claimed if no file is opened, so that they are kept for a later start
+  bool recoverScene ()
+  {
+    const std::string fileName = Autosave::recoveryFileName ();
+    bool              recovered = false;
+
+    if (Autosave::claimJournal ())
+    {
+      if (ViewUtil::question (this->mainWindow,
+                              QObject::tr ("Dilay did not exit properly. Recover the last "
+                                           "autosaved scene?")))
+      {
+        recovered = Autosave::recover (fileName, this->config, this->state ().scene ()) &&
+                    this->state ().scene ().isEmpty () == false;
+        if (recovered == false)
+        {
+          ViewUtil::error (this->mainWindow, QObject::tr ("Could not recover scene."));
+        }
+      }
+      QFile::remove (fileName.c_str ());
+    }
+    return recovered;
+  }
+
   void paintGL ()
   {
     QPainter painter (this->self);
@@ -163,23 +220,132 @@ struct ViewGlWidget::Impl
 
   void resizeGL (int w, int h) { this->state ().camera ().updateResolution (glm::uvec2 (w, h)); }
 
+  // The first move event after a pause is dispatched immediately, subsequent move events are
+  // collected and dispatched once per frame
   void pointingEvent (const ViewPointingEvent& e)
   {
+    if (e.moveEvent ())
+    {
+      this->pendingMoveEvents.push_back (e);
+
+      if (this->coalescingTimer.isActive () == false)
+      {
+        this->dispatchMoveEvents ();
+      }
+    }
+    else
+    {
+      this->dispatchMoveEvents ();
+      this->coalescingTimer.stop ();
+      this->dispatchPointingEvent (e);
+    }
+  }
+
+  // Dispatches pending move events. Events that are closer than a configurable distance to the
+  // previously dispatched event are dropped, unless the buttons or modifiers change afterwards.
+  // The remaining events are handed to the active tool as a single batch, and the widget is
+  // redrawn and the cursor is updated only once per batch.
+  void dispatchMoveEvents ()
+  {
+    if (this->pendingMoveEvents.empty ())
+    {
+      return;
+    }
+    this->coalescingTimer.start ();
+
+    std::vector<ViewPointingEvent> events;
+    events.swap (this->pendingMoveEvents);
+
+    const int minDistance = this->config.get<int> ("editor/pointing-event-coalescing-distance");
+    const int minDistanceSqr = minDistance * minDistance;
+    bool      redraw = false;
+    bool      cameraMoved = false;
+
+    std::vector<ViewPointingEvent> batch;
+    batch.reserve (events.size ());
+
+    for (unsigned int i = 0; i < events.size (); i++)
+    {
+      const ViewPointingEvent& e = events[i];
+      const glm::ivec2         d = e.position () - this->lastPosition;
+
+      if (i + 1 == events.size () || haveSameButtons (e, events[i + 1]) == false ||
+          (d.x * d.x) + (d.y * d.y) >= minDistanceSqr)
+      {
+        this->lastPosition = e.position ();
+
+        if (e.valid ())
+        {
+          if (this->_immediateMoveCamera->pointingEvent (e) == ToolResponse::Redraw)
+          {
+            redraw = true;
+            cameraMoved = true;
+          }
+          batch.push_back (e);
+        }
+      }
+    }
+
+    if (batch.empty () == false && this->state ().hasTool ())
+    {
+      this->handleToolResponse (this->state ().tool ().pointingEvents (batch), redraw);
+    }
+    this->handleDispatchedEvents (redraw, cameraMoved);
+  }
+
+  void dispatchPointingEvent (const ViewPointingEvent& e)
+  {
+    bool redraw = false;
+    bool cameraMoved = false;
+
+    this->dispatchPointingEvent (e, redraw, cameraMoved);
+    this->handleDispatchedEvents (redraw, cameraMoved);
+  }
+
+  void dispatchPointingEvent (const ViewPointingEvent& e, bool& redraw, bool& cameraMoved)
+  {
+    this->lastPosition = e.position ();
+
     if (e.valid ())
     {
       if (this->_immediateMoveCamera->pointingEvent (e) == ToolResponse::Redraw)
       {
-        this->state ().handleToolResponse (ToolResponse::Redraw);
-        this->updateCursorInTool ();
+        redraw = true;
+        cameraMoved = true;
       }
 
       if (this->state ().hasTool ())
       {
-        this->state ().handleToolResponse (this->state ().tool ().pointingEvent (e));
+        this->handleToolResponse (this->state ().tool ().pointingEvent (e), redraw);
       }
     }
   }
 
+  // Terminating responses are handled immediately, redraws are deferred to the caller
+  void handleToolResponse (ToolResponse response, bool& redraw)
+  {
+    if (response == ToolResponse::Redraw)
+    {
+      redraw = true;
+    }
+    else
+    {
+      this->state ().handleToolResponse (response);
+    }
+  }
+
+  void handleDispatchedEvents (bool redraw, bool cameraMoved)
+  {
+    if (redraw)
+    {
+      this->state ().handleToolResponse (ToolResponse::Redraw);
+    }
+    if (cameraMoved)
+    {
+      this->updateCursorInTool ();
+    }
+  }
+
   void mouseMoveEvent (QMouseEvent* e)
   {
     if (this->tabletPressed == false)
@@ -5,6 +5,7 @@
 #include <QDesktopServices>
 #include <QFileDialog>
 #include <QMenuBar>
+#include <QProgressDialog>
 #include "../util.hpp"
 #include "history.hpp"
 #include "scene.hpp"
@@ -33,11 +34,18 @@ namespace
 
   QString filterDlyFiles () { return QObject::tr ("Dilay files (*.dly)"); }
 
+  QString filterDlbFiles () { return QObject::tr ("Dilay binary files (*.dlb)"); }
+
   QString filterObjFiles () { return QObject::tr ("Wavefront files (*.obj)"); }
 
+  QString filterStlFiles () { return QObject::tr ("Binary STL files (*.stl)"); }
+
+  QString filterPlyFiles () { return QObject::tr ("Binary PLY files (*.ply)"); }
+
   QString fileDialogFilters ()
   {
-    return filterAllFiles () + ";;" + filterDlyFiles () + ";;" + filterObjFiles ();
+    return filterAllFiles () + ";;" + filterDlyFiles () + ";;" + filterDlbFiles () + ";;" +
+           filterObjFiles () + ";;" + filterStlFiles () + ";;" + filterPlyFiles ();
   }
 
   QString selectedFilter (const Scene& scene)
@@ -48,10 +56,22 @@ namespace
       {
         return filterDlyFiles ();
       }
+      else if (Util::hasSuffix (scene.fileName (), ".dlb"))
+      {
+        return filterDlbFiles ();
+      }
       else if (Util::hasSuffix (scene.fileName (), ".obj"))
       {
         return filterObjFiles ();
       }
+      else if (Util::hasSuffix (scene.fileName (), ".stl"))
+      {
+        return filterStlFiles ();
+      }
+      else if (Util::hasSuffix (scene.fileName (), ".ply"))
+      {
+        return filterPlyFiles ();
+      }
     }
     return filterAllFiles ();
   }
@@ -90,7 +110,17 @@ void ViewMenuBar::setup (ViewMainWindow& mainWindow, ViewGlWidget& glWidget)
         }
       }
 #endif
-        if (scene.fromDlyFile (glWidget.state ().config (), fileName) == false)
+        QProgressDialog progressDialog (QObject::tr ("Opening file..."), QObject::tr ("Cancel"), 0,
+                                        100, &mainWindow);
+        progressDialog.setWindowModality (Qt::WindowModal);
+
+        const auto progress = [&progressDialog](float p) {
+          progressDialog.setValue (int(p * 100.0f));
+          return progressDialog.wasCanceled () == false;
+        };
+
+        if (scene.fromDlyFile (glWidget.state ().config (), fileName, progress) == false &&
+            progressDialog.wasCanceled () == false)
         {
           ViewUtil::error (mainWindow, QObject::tr ("Could not open file."));
         }
@@ -100,16 +130,30 @@ void ViewMenuBar::setup (ViewMainWindow& mainWindow, ViewGlWidget& glWidget)
 
   QAction& saveAsAction = ViewUtil::addAction (
     fileMenu, QObject::tr ("Save &as..."), QKeySequence::SaveAs, [&mainWindow, &glWidget]() {
-      Scene&            scene = glWidget.state ().scene ();
-      QString           filter = selectedFilter (scene);
-      const std::string fileName =
+      Scene&      scene = glWidget.state ().scene ();
+      QString     filter = selectedFilter (scene);
+      std::string fileName =
         QFileDialog::getSaveFileName (&mainWindow, QObject::tr ("Save as"),
                                       getFileDialogPath (scene), fileDialogFilters (), &filter,
                                       QFileDialog::DontUseNativeDialog)
           .toStdString ();
       if (fileName.empty () == false)
       {
+        if (filter == filterDlbFiles () && Util::hasSuffix (fileName, ".dlb") == false)
+        {
+          fileName += ".dlb";
+        }
+        else if (filter == filterStlFiles () && Util::hasSuffix (fileName, ".stl") == false)
+        {
+          fileName += ".stl";
+        }
+        else if (filter == filterPlyFiles () && Util::hasSuffix (fileName, ".ply") == false)
+        {
+          fileName += ".ply";
+        }
         const bool saveAsObj = Util::hasSuffix (fileName, ".obj") || filter == filterObjFiles ();
+        const bool saveAsMesh = Util::hasSuffix (fileName, ".stl") ||
+                                Util::hasSuffix (fileName, ".ply");
 
         if (scene.toDlyFile (fileName, saveAsObj) == false)
         {
@@ -120,6 +164,11 @@ void ViewMenuBar::setup (ViewMainWindow& mainWindow, ViewGlWidget& glWidget)
           ViewUtil::info (mainWindow,
                           QObject::tr ("Sketches are omitted when saving Wavefront files."));
         }
+        else if (saveAsMesh && scene.numSketchMeshes () > 0)
+        {
+          ViewUtil::info (mainWindow,
+                          QObject::tr ("Sketches are omitted when saving STL or PLY files."));
+        }
       }
     });
 
@@ -190,6 +239,12 @@ void ViewMenuBar::setup (ViewMainWindow& mainWindow, ViewGlWidget& glWidget)
                          mainWindow.update ();
                        });
 
+  ViewUtil::addCheckableAction (viewMenu, QObject::tr ("&Preview sketches"), QKeySequence (), false,
+                                [&mainWindow, &glWidget](bool a) {
+                                  glWidget.state ().scene ().previewSketches (a);
+                                  mainWindow.update ();
+                                });
+
   ViewUtil::addCheckableAction (viewMenu, QObject::tr ("Show &floor plane"), QKeySequence (), false,
                                 [&mainWindow, &glWidget](bool a) {
                                   glWidget.floorPlane ().isActive (a);
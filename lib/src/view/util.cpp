@@ -5,6 +5,7 @@
 #include <QAction>
 #include <QButtonGroup>
 #include <QCheckBox>
+#include <QColor>
 #include <QDoubleSpinBox>
 #include <QDoubleValidator>
 #include <QIntValidator>
@@ -18,6 +19,7 @@
 #include <QToolButton>
 #include <glm/glm.hpp>
 #include "../util.hpp"
+#include "color.hpp"
 #include "view/double-slider.hpp"
 #include "view/resolution-slider.hpp"
 #include "view/util.hpp"
@@ -183,6 +185,17 @@ QPoint ViewUtil::toQPoint (const glm::uvec2& p) { return QPoint (int(p.x), int(p
 
 QPoint ViewUtil::toQPoint (const glm::ivec2& p) { return QPoint (p.x, p.y); }
 
+QColor ViewUtil::toQColor (const Color& c)
+{
+  return QColor (glm::min (255, int(255.0f * c.r ())), glm::min (255, int(255.0f * c.g ())),
+                 glm::min (255, int(255.0f * c.b ())), glm::min (255, int(255.0f * c.opacity ())));
+}
+
+Color ViewUtil::toColor (const QColor& c)
+{
+  return Color (c.redF (), c.greenF (), c.blueF (), c.alphaF ());
+}
+
 void ViewUtil::connect (const QSpinBox& s, const std::function<void(int)>& f)
 {
   void (QSpinBox::*ptr) (int) = &QSpinBox::valueChanged;
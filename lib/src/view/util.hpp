@@ -9,12 +9,14 @@
 #include <glm/fwd.hpp>
 #include <vector>
 
+class Color;
 class ViewDoubleSlider;
 class ViewResolutionSlider;
 class QAbstractSpinBox;
 class QAction;
 class QButtonGroup;
 class QCheckBox;
+class QColor;
 class QDoubleSpinBox;
 class QFrame;
 class QKeySequence;
@@ -52,6 +54,8 @@ namespace ViewUtil
   glm::ivec2            toIVec2 (const QPoint&);
   QPoint                toQPoint (const glm::uvec2&);
   QPoint                toQPoint (const glm::ivec2&);
+  QColor                toQColor (const Color&);
+  Color                 toColor (const QColor&);
   void                  connect (const QSpinBox&, const std::function<void(int)>&);
   void                  connect (const QDoubleSpinBox&, const std::function<void(double)>&);
   void                  connect (const QPushButton&, const std::function<void()>&);
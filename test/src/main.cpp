@@ -4,13 +4,18 @@
  */
 #include <QCoreApplication>
 #include <iostream>
+#include "test-autosave.hpp"
 #include "test-bitset.hpp"
 #include "test-distance.hpp"
+#include "test-import-export.hpp"
 #include "test-intersection.hpp"
 #include "test-maybe.hpp"
+#include "test-mesh-changes.hpp"
 #include "test-misc.hpp"
 #include "test-octree.hpp"
 #include "test-prune.hpp"
+#include "test-remesh.hpp"
+#include "test-sketch.hpp"
 #include "test-tree.hpp"
 
 int main ()
@@ -27,9 +32,18 @@ int main ()
   TestTree::test1 ();
   TestTree::test2 ();
   TestTree::test3 ();
+  TestTree::test4 ();
   TestMisc::test ();
   TestDistance::test ();
   TestPrune::test ();
+  TestSketch::test1 ();
+  TestSketch::test2 ();
+  TestSketch::test3 ();
+  TestImportExport::test ();
+  TestMeshChanges::test ();
+  TestRemesh::test1 ();
+  TestRemesh::test2 ();
+  TestAutosave::test ();
 
   std::cout << "all tests ran successfully\n";
   return 0;
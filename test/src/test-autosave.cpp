@@ -0,0 +1,193 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <cassert>
+#include <glm/glm.hpp>
+#include <sstream>
+#include "autosave.hpp"
+#include "test-autosave.hpp"
+#include "util.hpp"
+
+namespace
+{
+  using AutosaveJournal::Checkpoint;
+  using AutosaveJournal::MeshDelta;
+
+  MeshDelta makeDelta (unsigned int id, unsigned int numVertexSlots, unsigned int numFaceSlots)
+  {
+    MeshDelta delta;
+
+    delta.id = id;
+    delta.beginsCapture = false;
+    delta.endsCapture = false;
+    delta.numVertexSlots = numVertexSlots;
+    delta.numFaceSlots = numFaceSlots;
+    delta.position = glm::vec3 (0.0f);
+    delta.scaling = glm::vec3 (1.0f);
+    delta.rotation = glm::mat4x4 (1.0f);
+    return delta;
+  }
+
+  // A tetrahedron with an additional free vertex slot
+  MeshDelta makeTetrahedron (unsigned int id)
+  {
+    MeshDelta delta = makeDelta (id, 5, 4);
+
+    delta.beginsCapture = true;
+    delta.endsCapture = true;
+    delta.vertices.push_back ({0, false, glm::vec3 (0.0f, 0.0f, 0.0f)});
+    delta.vertices.push_back ({1, false, glm::vec3 (1.0f, 0.0f, 0.0f)});
+    delta.vertices.push_back ({2, true, glm::vec3 (0.0f)});
+    delta.vertices.push_back ({3, false, glm::vec3 (0.0f, -1.0f, 0.0f)});
+    delta.vertices.push_back ({4, false, glm::vec3 (0.0f, 0.0f, 1.0f)});
+    delta.faces.push_back ({0, false, 0, 3, 1});
+    delta.faces.push_back ({1, false, 0, 1, 4});
+    delta.faces.push_back ({2, false, 0, 4, 3});
+    delta.faces.push_back ({3, false, 1, 3, 4});
+    return delta;
+  }
+
+  Checkpoint makeInitialCheckpoint ()
+  {
+    Checkpoint checkpoint;
+
+    checkpoint.meshes.push_back (makeTetrahedron (1));
+    checkpoint.meshes.push_back (makeTetrahedron (2));
+    checkpoint.meshes.back ().position = glm::vec3 (2.0f, 0.0f, 0.0f);
+
+    checkpoint.sketches.emplace_back ();
+    checkpoint.sketches.back ().tree.emplaceRoot (PrimSphere (glm::vec3 (0.0f), 1.0f));
+    return checkpoint;
+  }
+
+  // Moves the fourth vertex of the first mesh and deletes the second mesh
+  Checkpoint makeIncrementalCheckpoint (unsigned int numMovedVertices)
+  {
+    Checkpoint checkpoint = makeInitialCheckpoint ();
+
+    checkpoint.meshes.pop_back ();
+    checkpoint.meshes.back ().beginsCapture = false;
+    checkpoint.meshes.back ().endsCapture = false;
+    checkpoint.meshes.back ().vertices.clear ();
+    checkpoint.meshes.back ().faces.clear ();
+
+    for (unsigned int i = 0; i < numMovedVertices; i++)
+    {
+      checkpoint.meshes.back ().vertices.push_back ({4, false, glm::vec3 (0.0f, 0.0f, 2.0f)});
+    }
+    return checkpoint;
+  }
+
+  ImportExport::SceneData replay (const std::string& bytes)
+  {
+    ImportExport::SceneData data;
+
+    const bool success = AutosaveJournal::replay (bytes.data (), bytes.size (), data);
+    assert (success);
+    unused (success);
+    return data;
+  }
+}
+
+void TestAutosave::test ()
+{
+  std::stringstream stream;
+  std::string       sketches;
+
+  AutosaveJournal::writeHeader (stream);
+
+  const std::size_t headerSize = stream.str ().size ();
+  const std::size_t initialSize =
+    AutosaveJournal::write (stream, makeInitialCheckpoint (), sketches);
+  const std::string initialBytes = stream.str ();
+
+  // Unchanged meshes and sketches are not written
+  Checkpoint unchanged = makeInitialCheckpoint ();
+  unchanged.meshesChanged = false;
+  assert (AutosaveJournal::write (stream, unchanged, sketches) == 0);
+
+  const std::size_t incrementalSize =
+    AutosaveJournal::write (stream, makeIncrementalCheckpoint (1), sketches);
+  const std::string incrementalBytes = stream.str ();
+
+  assert (initialBytes.size () == headerSize + initialSize);
+  assert (incrementalBytes.size () == initialBytes.size () + incrementalSize);
+
+  // Records only grow with the number of modifications
+  {
+    std::stringstream s;
+    std::string       previous = sketches;
+
+    assert (AutosaveJournal::write (s, makeIncrementalCheckpoint (2), previous) ==
+            incrementalSize + 20);
+    assert (incrementalSize < initialSize);
+  }
+
+  const ImportExport::SceneData initial = replay (initialBytes);
+  assert (initial.meshes.size () == 2);
+  assert (initial.meshes[0].numVertices () == 4);
+  assert (initial.meshes[0].numIndices () == 12);
+  assert (initial.meshes[1].position () == glm::vec3 (2.0f, 0.0f, 0.0f));
+  assert (initial.sketches.size () == 1);
+  assert (initial.sketches[0].tree.hasRoot ());
+
+  const ImportExport::SceneData incremental = replay (incrementalBytes);
+  assert (incremental.meshes.size () == 1);
+  assert (incremental.meshes[0].numVertices () == 4);
+  assert (incremental.meshes[0].vertex (3) == glm::vec3 (0.0f, 0.0f, 2.0f));
+  assert (incremental.sketches.size () == 1);
+
+  // A mesh keeps its previous state until its capture has ended
+  {
+    std::stringstream chunked;
+    std::string       chunkedSketches;
+    Checkpoint        first = makeInitialCheckpoint ();
+    Checkpoint        second = makeInitialCheckpoint ();
+
+    first.meshes[0].endsCapture = false;
+    first.meshes[0].vertices[4].position = glm::vec3 (0.0f, 0.0f, 3.0f);
+    first.meshes[0].faces.clear ();
+
+    second.meshes[0].beginsCapture = false;
+    second.meshes[0].vertices.clear ();
+    second.meshes[1] = makeDelta (2, 5, 4);
+    second.meshes[1].position = glm::vec3 (2.0f, 0.0f, 0.0f);
+
+    AutosaveJournal::writeHeader (chunked);
+    AutosaveJournal::write (chunked, makeInitialCheckpoint (), chunkedSketches);
+    AutosaveJournal::write (chunked, first, chunkedSketches);
+
+    const ImportExport::SceneData pending = replay (chunked.str ());
+    assert (pending.meshes.size () == 2);
+    assert (pending.meshes[0].vertex (3) == glm::vec3 (0.0f, 0.0f, 1.0f));
+
+    AutosaveJournal::write (chunked, second, chunkedSketches);
+
+    const ImportExport::SceneData captured = replay (chunked.str ());
+    assert (captured.meshes.size () == 2);
+    assert (captured.meshes[0].numIndices () == 12);
+    assert (captured.meshes[0].vertex (3) == glm::vec3 (0.0f, 0.0f, 3.0f));
+    assert (captured.meshes[1].position () == glm::vec3 (2.0f, 0.0f, 0.0f));
+  }
+
+  // Torn or corrupt records end the replay
+  const ImportExport::SceneData torn =
+    replay (incrementalBytes.substr (0, incrementalBytes.size () - 1));
+  assert (torn.meshes.size () == 2);
+
+  std::string corrupt = incrementalBytes;
+  corrupt.back () = char(corrupt.back () + 1);
+  assert (replay (corrupt).meshes.size () == 2);
+
+  // Incremental changes require a complete state to start from
+  std::stringstream orphaned;
+  std::string       orphanedSketches;
+  AutosaveJournal::writeHeader (orphaned);
+  AutosaveJournal::write (orphaned, makeIncrementalCheckpoint (1), orphanedSketches);
+  assert (replay (orphaned.str ()).meshes.empty ());
+
+  ImportExport::SceneData invalid;
+  assert (AutosaveJournal::replay (incrementalBytes.data (), 4, invalid) == false);
+  unused (invalid);
+}
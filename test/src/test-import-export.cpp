@@ -0,0 +1,223 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <cassert>
+#include <glm/glm.hpp>
+#include <sstream>
+#include "import-export.hpp"
+#include "test-import-export.hpp"
+#include "util.hpp"
+
+namespace
+{
+  ImportExport::SceneData makeSceneData ()
+  {
+    ImportExport::SceneData data;
+
+    data.meshes.emplace_back ();
+    Mesh& mesh = data.meshes.back ();
+    mesh.addVertex (glm::vec3 (0.0f, 0.0f, 0.0f), glm::vec3 (0.0f, 0.0f, -1.0f));
+    mesh.addVertex (glm::vec3 (1.5f, 0.0f, 0.0f), glm::vec3 (1.0f, 0.0f, 0.0f));
+    mesh.addVertex (glm::vec3 (0.0f, -2.25f, 0.0f), glm::vec3 (0.0f, -1.0f, 0.0f));
+    mesh.addVertex (glm::vec3 (0.0f, 0.0f, 0.125f), glm::vec3 (0.0f, 0.0f, 1.0f));
+
+    const unsigned int indices[] = {0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3};
+    mesh.addIndices (indices, 12);
+
+    data.sketches.emplace_back ();
+    ImportExport::SketchData& sketch = data.sketches.back ();
+
+    SketchNode& root = sketch.tree.emplaceRoot (PrimSphere (glm::vec3 (0.0f), 1.0f));
+    SketchNode& child = root.emplaceChild (PrimSphere (glm::vec3 (0.0f, 2.0f, 0.0f), 0.5f));
+    child.emplaceChild (PrimSphere (glm::vec3 (0.5f, 3.0f, 0.0f), 0.25f));
+    root.emplaceChild (PrimSphere (glm::vec3 (0.0f, -2.0f, 0.0f), 0.75f));
+
+    sketch.paths.emplace_back ();
+    sketch.paths.back ().addSphere (glm::vec3 (1.0f), glm::vec3 (1.0f, 0.0f, 0.0f), 0.5f);
+    sketch.paths.back ().addSphere (glm::vec3 (2.0f), glm::vec3 (1.5f, 0.5f, 0.0f), 0.25f);
+    sketch.paths.back ().addSphere (glm::vec3 (2.0f), glm::vec3 (2.0f, 1.0f, -0.5f), 0.125f);
+
+    data.sketches.emplace_back ();
+    data.sketches.back ().paths.emplace_back ();
+    data.sketches.back ().paths.back ().addSphere (glm::vec3 (-1.0f), glm::vec3 (-1.0f), 0.5f);
+    return data;
+  }
+
+  bool equals (const PrimSphere& a, const PrimSphere& b)
+  {
+    return a.center () == b.center () && a.radius () == b.radius ();
+  }
+
+  bool equals (const SketchNode& a, const SketchNode& b)
+  {
+    if (equals (a.data (), b.data ()) == false || a.numChildren () != b.numChildren ())
+    {
+      return false;
+    }
+    std::vector<const SketchNode*> children;
+    a.forEachConstChild ([&children](const SketchNode& c) { children.push_back (&c); });
+
+    bool         equal = true;
+    unsigned int i = 0;
+    b.forEachConstChild ([&children, &equal, &i](const SketchNode& c) {
+      equal = equal && equals (*children[i++], c);
+    });
+    return equal;
+  }
+
+  bool equals (const SketchPath& a, const SketchPath& b)
+  {
+    return a.intersectionFirst () == b.intersectionFirst () &&
+           a.intersectionLast () == b.intersectionLast () &&
+           std::equal (a.spheres ().begin (), a.spheres ().end (), b.spheres ().begin (),
+                       b.spheres ().end (),
+                       [](const PrimSphere& s, const PrimSphere& t) { return equals (s, t); });
+  }
+
+  bool equals (const Mesh& a, const Mesh& b, bool compareNormals)
+  {
+    if (a.numVertices () != b.numVertices () || a.numIndices () != b.numIndices ())
+    {
+      return false;
+    }
+    for (unsigned int i = 0; i < a.numVertices (); i++)
+    {
+      if (a.vertex (i) != b.vertex (i) || (compareNormals && a.normal (i) != b.normal (i)))
+      {
+        return false;
+      }
+    }
+    for (unsigned int i = 0; i < a.numIndices (); i++)
+    {
+      if (a.index (i) != b.index (i))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool equalScenes (const ImportExport::SceneData& a, const ImportExport::SceneData& b,
+                    bool compareNormals)
+  {
+    if (a.meshes.size () != b.meshes.size () || a.sketches.size () != b.sketches.size ())
+    {
+      return false;
+    }
+    for (unsigned int i = 0; i < a.meshes.size (); i++)
+    {
+      if (equals (a.meshes[i], b.meshes[i], compareNormals) == false)
+      {
+        return false;
+      }
+    }
+    for (unsigned int i = 0; i < a.sketches.size (); i++)
+    {
+      const ImportExport::SketchData& s = a.sketches[i];
+      const ImportExport::SketchData& t = b.sketches[i];
+
+      if (s.tree.hasRoot () != t.tree.hasRoot () ||
+          (s.tree.hasRoot () && equals (s.tree.root (), t.tree.root ()) == false) ||
+          std::equal (s.paths.begin (), s.paths.end (), t.paths.begin (), t.paths.end (),
+                      [](const SketchPath& p, const SketchPath& q) { return equals (p, q); }) ==
+            false)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  ImportExport::SceneData viaDlyFile (const ImportExport::SceneData& data)
+  {
+    ImportExport::SceneData result;
+
+    Util::withCLocale<void> ([&data, &result]() {
+      std::stringstream stream;
+
+      ImportExport::toDlyFile (stream, data, false);
+      const bool success = ImportExport::fromDlyFile (stream, result);
+      assert (success);
+      unused (success);
+    });
+    return result;
+  }
+
+  ImportExport::SceneData viaDlbFile (const ImportExport::SceneData& data)
+  {
+    std::ostringstream      stream;
+    ImportExport::SceneData result;
+
+    const bool written = ImportExport::toDlbFile (stream, data);
+    assert (written);
+
+    const std::string bytes = stream.str ();
+    const bool        read = ImportExport::fromDlbData (bytes.data (), bytes.size (), result);
+    assert (read);
+
+    ImportExport::SceneData truncated;
+    assert (ImportExport::fromDlbData (bytes.data (), bytes.size () - 1, truncated) == false);
+
+    unused (written);
+    unused (read);
+    return result;
+  }
+
+  // Welding may reorder vertices, so triangles are compared by their corners' positions
+  bool equalTriangles (const Mesh& a, const Mesh& b)
+  {
+    if (a.numVertices () != b.numVertices () || a.numIndices () != b.numIndices ())
+    {
+      return false;
+    }
+    for (unsigned int i = 0; i < a.numIndices (); i++)
+    {
+      if (a.vertex (a.index (i)) != b.vertex (b.index (i)))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  ImportExport::SceneData viaMeshFile (const ImportExport::SceneData& data, bool asStl)
+  {
+    std::ostringstream      stream;
+    ImportExport::SceneData result;
+
+    const bool written = asStl ? ImportExport::toStlFile (stream, data)
+                               : ImportExport::toPlyFile (stream, data);
+    assert (written);
+
+    const std::string bytes = stream.str ();
+    const auto        fromData = asStl ? ImportExport::fromStlData : ImportExport::fromPlyData;
+    const bool        read = fromData (bytes.data (), bytes.size (), result);
+    assert (read);
+    assert (result.meshes.size () == 1 && result.sketches.empty ());
+
+    ImportExport::SceneData truncated;
+    assert (fromData (bytes.data (), bytes.size () - 1, truncated) == false);
+
+    unused (written);
+    unused (read);
+    return result;
+  }
+}
+
+void TestImportExport::test ()
+{
+  const ImportExport::SceneData data = makeSceneData ();
+  const ImportExport::SceneData fromDly = viaDlyFile (data);
+  const ImportExport::SceneData fromDlb = viaDlbFile (fromDly);
+
+  assert (equalScenes (data, fromDly, false));
+  assert (equalScenes (fromDly, fromDlb, true));
+  assert (equalScenes (data, viaDlbFile (data), true));
+  assert (equalScenes (fromDly, viaDlyFile (fromDlb), false));
+  assert (equalTriangles (data.meshes[0], viaMeshFile (data, true).meshes[0]));
+  assert (equalTriangles (data.meshes[0], viaMeshFile (data, false).meshes[0]));
+
+  unused (equalScenes);
+  unused (equalTriangles);
+}
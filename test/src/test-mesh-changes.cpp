@@ -0,0 +1,115 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <glm/glm.hpp>
+#include <vector>
+#include "dynamic/faces.hpp"
+#include "dynamic/mesh-changes.hpp"
+#include "dynamic/mesh.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "primitive/sphere.hpp"
+#include "test-mesh-changes.hpp"
+#include "tool/sculpt/util/action.hpp"
+#include "util.hpp"
+
+namespace
+{
+  std::vector<unsigned int> sorted (std::vector<unsigned int> v)
+  {
+    std::sort (v.begin (), v.end ());
+    return v;
+  }
+
+  // Compares slot by slot, since recorded changes refer to slots
+  bool equals (const DynamicMesh& a, const DynamicMesh& b)
+  {
+    if (a.mesh ().numVertices () != b.mesh ().numVertices () ||
+        a.mesh ().numIndices () != b.mesh ().numIndices ())
+    {
+      return false;
+    }
+    for (unsigned int i = 0; i < a.mesh ().numVertices (); i++)
+    {
+      if (a.isFreeVertex (i) != b.isFreeVertex (i))
+      {
+        return false;
+      }
+      else if (a.isFreeVertex (i) == false &&
+               (a.vertex (i) != b.vertex (i) || a.vertexNormal (i) != b.vertexNormal (i) ||
+                sorted (a.adjacentFaces (i)) != sorted (b.adjacentFaces (i))))
+      {
+        return false;
+      }
+    }
+    for (unsigned int i = 0; i < a.mesh ().numIndices () / 3; i++)
+    {
+      if (a.isFreeFace (i) != b.isFreeFace (i))
+      {
+        return false;
+      }
+      else if (a.isFreeFace (i) == false)
+      {
+        unsigned int a1, a2, a3, b1, b2, b3;
+        a.vertexIndices (i, a1, a2, a3);
+        b.vertexIndices (i, b1, b2, b3);
+
+        if (a1 != b1 || a2 != b2 || a3 != b3)
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // Applying recorded changes must undo the edit, and applying them again must redo it
+  void checkRoundTrip (DynamicMesh& mesh, const std::function<void()>& edit)
+  {
+    const DynamicMesh before (mesh);
+
+    mesh.trackChanges ();
+    edit ();
+    DynamicMeshChanges changes = mesh.untrackChanges ();
+
+    const DynamicMesh after (mesh);
+    assert (equals (before, after) == false);
+
+    mesh.applyChanges (changes);
+    assert (equals (mesh, before));
+    assert (mesh.checkPrunedConsistency ());
+
+    mesh.applyChanges (changes);
+    assert (equals (mesh, after));
+    assert (mesh.checkPrunedConsistency ());
+    unused (equals);
+  }
+}
+
+void TestMeshChanges::test ()
+{
+  DynamicMesh mesh (MeshUtil::icosphere (3));
+
+  // Collapses free slots, which later edits reuse
+  checkRoundTrip (mesh, [&mesh]() { ToolSculptAction::decimate (mesh, mesh.numFaces () / 2); });
+
+  checkRoundTrip (mesh, [&mesh]() {
+    DynamicFaces faces;
+    mesh.intersects (PrimSphere (glm::vec3 (0.0f, 0.0f, 1.0f), 0.5f), faces);
+    assert (faces.isEmpty () == false);
+
+    ToolSculptAction::smoothMesh (mesh, faces);
+  });
+
+  checkRoundTrip (mesh, [&mesh]() {
+    DynamicFaces faces;
+    mesh.intersects (PrimSphere (glm::vec3 (1.0f, 0.0f, 0.0f), 0.3f), faces);
+    assert (faces.isEmpty () == false);
+
+    ToolSculptAction::deleteFaces (mesh, faces);
+  });
+}
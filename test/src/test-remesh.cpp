@@ -0,0 +1,267 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <cassert>
+#include <functional>
+#include <glm/glm.hpp>
+#include <vector>
+#include "dynamic/faces.hpp"
+#include "dynamic/mesh.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "primitive/aabox.hpp"
+#include "primitive/sphere.hpp"
+#include "remesh.hpp"
+#include "test-remesh.hpp"
+#include "util.hpp"
+
+namespace
+{
+  Mesh sphere (const glm::vec3& center, float radius)
+  {
+    Mesh mesh = MeshUtil::icosphere (3);
+
+    for (unsigned int i = 0; i < mesh.numVertices (); i++)
+    {
+      mesh.vertex (i, center + (radius * mesh.vertex (i)));
+    }
+    return mesh;
+  }
+
+  // Faces are oriented away from the opposite vertex
+  void addTetrahedron (DynamicMesh& mesh, const glm::vec3& v1, const glm::vec3& v2,
+                       const glm::vec3& v3, const glm::vec3& v4)
+  {
+    const unsigned int i[] = {mesh.addVertex (v1, glm::vec3 (0.0f)),
+                              mesh.addVertex (v2, glm::vec3 (0.0f)),
+                              mesh.addVertex (v3, glm::vec3 (0.0f)),
+                              mesh.addVertex (v4, glm::vec3 (0.0f))};
+
+    const auto addFace = [&mesh](unsigned int i1, unsigned int i2, unsigned int i3,
+                                 unsigned int opposite) {
+      const glm::vec3& p1 = mesh.vertex (i1);
+      const glm::vec3  normal = glm::cross (mesh.vertex (i2) - p1, mesh.vertex (i3) - p1);
+
+      if (glm::dot (normal, p1 - mesh.vertex (opposite)) > 0.0f)
+      {
+        mesh.addFace (i1, i2, i3);
+      }
+      else
+      {
+        mesh.addFace (i1, i3, i2);
+      }
+    };
+
+    addFace (i[0], i[1], i[2], i[3]);
+    addFace (i[0], i[1], i[3], i[2]);
+    addFace (i[0], i[2], i[3], i[1]);
+    addFace (i[1], i[2], i[3], i[0]);
+  }
+
+  // Compares slot by slot, since a failed remesh must not touch any slot
+  bool equals (const DynamicMesh& a, const DynamicMesh& b)
+  {
+    if (a.mesh ().numVertices () != b.mesh ().numVertices () ||
+        a.mesh ().numIndices () != b.mesh ().numIndices ())
+    {
+      return false;
+    }
+    for (unsigned int i = 0; i < a.mesh ().numVertices (); i++)
+    {
+      if (a.isFreeVertex (i) != b.isFreeVertex (i) ||
+          (a.isFreeVertex (i) == false && a.vertex (i) != b.vertex (i)))
+      {
+        return false;
+      }
+    }
+    for (unsigned int i = 0; i < a.mesh ().numIndices (); i++)
+    {
+      if (a.mesh ().index (i) != b.mesh ().index (i))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  float maxEdgeLength (const DynamicMesh& mesh)
+  {
+    float maxLength = 0.0f;
+
+    mesh.forEachFace ([&mesh, &maxLength](unsigned int f) {
+      unsigned int i1, i2, i3;
+      mesh.vertexIndices (f, i1, i2, i3);
+
+      maxLength = glm::max (maxLength, glm::distance (mesh.vertex (i1), mesh.vertex (i2)));
+      maxLength = glm::max (maxLength, glm::distance (mesh.vertex (i2), mesh.vertex (i3)));
+      maxLength = glm::max (maxLength, glm::distance (mesh.vertex (i3), mesh.vertex (i1)));
+    });
+    return maxLength;
+  }
+
+  bool contains (const PrimSphere& sphere, const glm::vec3& v)
+  {
+    return glm::distance (v, sphere.center ()) <= sphere.radius ();
+  }
+
+  bool contains (const PrimAABox& box, const glm::vec3& v)
+  {
+    return glm::all (glm::greaterThanEqual (v, box.minimum ())) &&
+           glm::all (glm::lessThanEqual (v, box.maximum ()));
+  }
+
+  // New faces either belong to the patch, which lies within the region, or stitch the patch to
+  // the border of the hole, whose vertices are at most one edge away from the region. Thus,
+  // all new faces lie within `band`.
+  template <typename T>
+  void checkRegion (DynamicMesh& mesh, const T& region, const T& band, float resolution)
+  {
+    DynamicFaces faces;
+
+    assert (Remesh::remesh (mesh, region, resolution, faces));
+    assert (faces.isEmpty () == false);
+    assert (mesh.checkPrunedConsistency ());
+
+    for (unsigned int f : faces)
+    {
+      unsigned int i1, i2, i3;
+      mesh.vertexIndices (f, i1, i2, i3);
+
+      assert (mesh.isFreeFace (f) == false);
+      assert (contains (band, mesh.vertex (i1)));
+      assert (contains (band, mesh.vertex (i2)));
+      assert (contains (band, mesh.vertex (i3)));
+      unused (i1);
+      unused (i2);
+      unused (i3);
+    }
+    unused (region);
+    unused (band);
+    unused (resolution);
+  }
+
+  void checkRegionFails (DynamicMesh& mesh, const PrimSphere& region, float resolution)
+  {
+    const DynamicMesh before (mesh);
+    DynamicFaces      faces;
+
+    assert (Remesh::remesh (mesh, region, resolution, faces) == false);
+    assert (faces.isEmpty ());
+    assert (equals (mesh, before));
+    unused (equals);
+    unused (region);
+    unused (resolution);
+  }
+
+  // Every vertex of an extracted mesh lies on the surface of the combined spheres, whose
+  // signed distance is bounded by the minimum or maximum of the spheres' signed distances
+  void checkOperation (Remesh::Operation operation, const std::vector<glm::vec3>& centers,
+                       float radius, float resolution)
+  {
+    std::vector<DynamicMesh>  meshes;
+    std::vector<DynamicMesh*> operands;
+
+    meshes.reserve (centers.size ());
+    for (const glm::vec3& center : centers)
+    {
+      meshes.emplace_back (sphere (center, radius));
+      operands.push_back (&meshes.back ());
+    }
+
+    DynamicMesh extractedMesh;
+    Remesh::remesh (operands, operation, resolution, extractedMesh);
+
+    assert (extractedMesh.isEmpty () == false);
+    assert (extractedMesh.checkPrunedConsistency ());
+
+    extractedMesh.forEachVertex ([&extractedMesh, operation, &centers, radius,
+                                  resolution](unsigned int i) {
+      const glm::vec3& v = extractedMesh.vertex (i);
+      float            d = glm::distance (v, centers[0]) - radius;
+
+      for (unsigned int o = 1; o < centers.size (); o++)
+      {
+        const float dO = glm::distance (v, centers[o]) - radius;
+
+        switch (operation)
+        {
+          case Remesh::Operation::Union:
+            d = glm::min (d, dO);
+            break;
+          case Remesh::Operation::Difference:
+            d = glm::max (d, -dO);
+            break;
+          case Remesh::Operation::Intersection:
+            d = glm::max (d, dO);
+            break;
+        }
+      }
+      assert (glm::abs (d) < 2.0f * resolution);
+      unused (d);
+    });
+  }
+}
+
+void TestRemesh::test1 ()
+{
+  const float resolution = 0.05f;
+
+  // Remeshing a spherical region of an icosphere
+  {
+    DynamicMesh      mesh (sphere (glm::vec3 (0.0f), 1.0f));
+    const float      maxEdge = maxEdgeLength (mesh);
+    const PrimSphere region (glm::vec3 (0.0f, 0.0f, 1.0f), 0.4f);
+
+    checkRegion (mesh, region, PrimSphere (region.center (), region.radius () + maxEdge),
+                 resolution);
+  }
+
+  // Remeshing a box region of an icosphere
+  {
+    DynamicMesh     mesh (sphere (glm::vec3 (0.0f), 1.0f));
+    const float     maxEdge = maxEdgeLength (mesh);
+    const PrimAABox region (glm::vec3 (0.0f, 0.0f, 1.0f), 0.6f);
+
+    checkRegion (mesh, region,
+                 PrimAABox (region.minimum () - glm::vec3 (maxEdge),
+                            region.maximum () + glm::vec3 (maxEdge)),
+                 resolution);
+  }
+
+  // The border of the hole is non-manifold: two tetrahedra share a vertex outside of the region,
+  // and each of them has a vertex within the region
+  {
+    DynamicMesh mesh;
+
+    addTetrahedron (mesh, glm::vec3 (0.0f), glm::vec3 (-0.3f, 1.0f, 0.0f),
+                    glm::vec3 (-1.5f, 0.0f, 1.0f), glm::vec3 (-1.5f, 0.0f, -1.0f));
+    addTetrahedron (mesh, glm::vec3 (0.0f), glm::vec3 (0.3f, 1.0f, 0.0f),
+                    glm::vec3 (1.5f, 0.0f, -1.0f), glm::vec3 (1.5f, 0.0f, 1.0f));
+    mesh.setAllNormals ();
+
+    checkRegionFails (mesh, PrimSphere (glm::vec3 (0.0f, 1.0f, 0.0f), 0.5f), resolution);
+  }
+
+  // The hole has an unpaired loop: a tetrahedron that only touches the region with one vertex is
+  // too small to be part of the patch
+  {
+    DynamicMesh mesh (sphere (glm::vec3 (0.0f), 1.0f));
+
+    addTetrahedron (mesh, glm::vec3 (0.0f, 0.0f, 1.39f), glm::vec3 (0.02f, 0.0f, 1.45f),
+                    glm::vec3 (-0.01f, 0.02f, 1.45f), glm::vec3 (-0.01f, -0.02f, 1.45f));
+    mesh.setAllNormals ();
+
+    checkRegionFails (mesh, PrimSphere (glm::vec3 (0.0f, 0.0f, 1.0f), 0.4f), resolution);
+  }
+}
+
+void TestRemesh::test2 ()
+{
+  const std::vector<glm::vec3> centers = {glm::vec3 (0.0f), glm::vec3 (0.5f, 0.0f, 0.0f),
+                                          glm::vec3 (0.0f, 0.5f, 0.0f)};
+
+  checkOperation (Remesh::Operation::Union, centers, 0.6f, 0.05f);
+  checkOperation (Remesh::Operation::Difference, centers, 0.6f, 0.05f);
+  checkOperation (Remesh::Operation::Intersection, centers, 0.6f, 0.05f);
+}
@@ -0,0 +1,291 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <atomic>
+#include <cassert>
+#include <glm/glm.hpp>
+#include <glm/gtx/norm.hpp>
+#include <random>
+#include <thread>
+#include <vector>
+#include "intersection.hpp"
+#include "primitive/ray.hpp"
+#include "sketch/bvh.hpp"
+#include "sketch/instances.hpp"
+#include "sketch/path.hpp"
+#include "sketch/preview.hpp"
+#include "test-sketch.hpp"
+#include "util.hpp"
+
+namespace
+{
+  bool contains (const PrimSphere& sphere, const glm::vec3& p)
+  {
+    return glm::distance2 (sphere.center (), p) <= sphere.radius () * sphere.radius ();
+  }
+
+  // Every node and path sphere that contains a point must be reported, and the nearest node hit
+  // by a ray must be found
+  void checkQueries (const SketchBvh& bvh, SketchTree& tree, const SketchPaths& paths,
+                     std::default_random_engine& gen)
+  {
+    std::uniform_real_distribution<float> posD (-12.0f, 12.0f);
+
+    for (unsigned int i = 0; i < 200; i++)
+    {
+      const glm::vec3 p (posD (gen), posD (gen), posD (gen));
+
+      unsigned int numNodes = 0;
+      unsigned int numSpheres = 0;
+
+      tree.root ().forEachConstNode ([&p, &numNodes](const SketchNode& node) {
+        numNodes += contains (node.data (), p) ? 1 : 0;
+      });
+      for (const SketchPath& path : paths)
+      {
+        for (const PrimSphere& s : path.spheres ())
+        {
+          numSpheres += contains (s, p) ? 1 : 0;
+        }
+      }
+
+      bvh.contains (p, [&p, &paths, &numNodes, &numSpheres](const SketchBvh::Element& e) {
+        if (e.type == SketchBvh::ElementType::Node && contains (e.node->data (), p))
+        {
+          numNodes--;
+        }
+        else if (e.type == SketchBvh::ElementType::Sphere &&
+                 contains (paths[e.path].spheres ()[e.sphere], p))
+        {
+          numSpheres--;
+        }
+      });
+      assert (numNodes == 0);
+      assert (numSpheres == 0);
+
+      const PrimRay ray (p, glm::normalize (glm::vec3 (posD (gen), posD (gen), posD (gen))));
+
+      float nearest = Util::maxFloat ();
+      tree.root ().forEachConstNode ([&ray, &nearest](const SketchNode& node) {
+        float t;
+        if (IntersectionUtil::intersects (ray, node.data (), &t))
+        {
+          nearest = glm::min (nearest, t);
+        }
+      });
+
+      float nearestBvh = Util::maxFloat ();
+      bvh.intersects (ray, [&ray, &nearestBvh](const SketchBvh::Element& e) {
+        float t;
+        if (e.type == SketchBvh::ElementType::Node &&
+            IntersectionUtil::intersects (ray, e.node->data (), &t))
+        {
+          nearestBvh = glm::min (nearestBvh, t);
+        }
+        return nearestBvh;
+      });
+      assert (nearest == nearestBvh);
+    }
+  }
+
+  SketchPaths pathOfSphere (const glm::vec3& center, float radius)
+  {
+    SketchPaths paths (1);
+    paths[0].addSphere (center, center, radius);
+    return paths;
+  }
+
+  void finish (SketchPreview& preview)
+  {
+    while (preview.isPending ())
+    {
+      if (preview.finishJob () == false)
+      {
+        std::this_thread::yield ();
+      }
+    }
+  }
+
+  // Previews that are extracted incrementally must match previews that are extracted at once
+  void checkPreview (const SketchPreview& preview, const SketchTree& tree,
+                     const SketchPaths& paths)
+  {
+    SketchPreview fresh;
+    fresh.resolution (preview.resolution ());
+    fresh.update (tree, paths);
+    finish (fresh);
+
+    assert (preview.numVertices () > 0);
+    assert (preview.numVertices () == fresh.numVertices ());
+  }
+}
+
+void TestSketch::test1 ()
+{
+  std::default_random_engine            gen;
+  std::uniform_real_distribution<float> posD (-10.0f, 10.0f);
+  std::uniform_real_distribution<float> deltaD (-1.0f, 1.0f);
+  std::uniform_real_distribution<float> radiusD (0.1f, 1.0f);
+
+  SketchTree               tree;
+  std::vector<SketchNode*> nodes;
+  nodes.push_back (&tree.emplaceRoot (glm::vec3 (0.0f), 1.0f));
+
+  for (unsigned int i = 0; i < 500; i++)
+  {
+    SketchNode& parent = *nodes[std::uniform_int_distribution<unsigned int> (
+      0, nodes.size () - 1) (gen)];
+    nodes.push_back (&parent.emplaceChild (glm::vec3 (posD (gen), posD (gen), posD (gen)),
+                                           radiusD (gen)));
+  }
+
+  SketchPaths paths (3);
+  for (SketchPath& path : paths)
+  {
+    for (unsigned int i = 0; i < 100; i++)
+    {
+      const glm::vec3 p (posD (gen), posD (gen), posD (gen));
+      path.addSphere (p, p, radiusD (gen));
+    }
+  }
+
+  SketchBvh bvh;
+  bvh.build (tree, paths);
+  checkQueries (bvh, tree, paths, gen);
+
+  for (unsigned int i = 0; i < nodes.size (); i += 3)
+  {
+    PrimSphere& sphere = nodes[i]->data ();
+    sphere.center (sphere.center () + glm::vec3 (deltaD (gen), deltaD (gen), deltaD (gen)));
+    sphere.radius (sphere.radius () * 1.5f);
+    bvh.refitNode (*nodes[i]);
+  }
+  checkQueries (bvh, tree, paths, gen);
+
+  paths.emplace_back ();
+  for (unsigned int i = 0; i < 200; i++)
+  {
+    const unsigned int p = i % paths.size ();
+    const glm::vec3    pos (posD (gen), posD (gen), posD (gen));
+
+    paths[p].addSphere (pos, pos, radiusD (gen));
+    bvh.addSphere (paths, p);
+  }
+  checkQueries (bvh, tree, paths, gen);
+}
+
+void TestSketch::test2 ()
+{
+  typedef SketchInstances::Type Type;
+
+  SketchTree  tree;
+  SketchNode& root = tree.emplaceRoot (glm::vec3 (0.0f), 1.0f);
+  root.emplaceChild (glm::vec3 (4.0f, 0.0f, 0.0f), 0.5f);
+
+  SketchPaths paths (1);
+  for (unsigned int i = 0; i < 3; i++)
+  {
+    const glm::vec3 p (0.0f, float(i), 0.0f);
+    paths[0].addSphere (p, p, 0.25f);
+  }
+
+  SketchInstances instances;
+  assert (instances.isPacked () == false);
+
+  instances.pack (tree, paths);
+  assert (instances.isPacked ());
+
+  assert (instances.numInstances (Type::Node) == 2);
+  assert (instances.data (Type::Node)[0] == glm::vec4 (0.0f, 0.0f, 0.0f, 1.0f));
+  assert (instances.data (Type::Node)[1] == glm::vec4 (4.0f, 0.0f, 0.0f, 0.5f));
+
+  assert (instances.numInstances (Type::Bone) == 1);
+  assert (instances.data (Type::Bone).size () == 2);
+  assert (instances.data (Type::Bone)[0] == glm::vec4 (4.0f, 0.0f, 0.0f, 0.5f));
+  assert (instances.data (Type::Bone)[1] == glm::vec4 (0.0f, 0.0f, 0.0f, 1.0f));
+
+  assert (instances.numInstances (Type::Bubble) > 0);
+  for (const glm::vec4& b : instances.data (Type::Bubble))
+  {
+    assert (b.x > 0.0f && b.x < 4.0f && b.y == 0.0f && b.z == 0.0f);
+    assert (b.w >= 0.5f && b.w <= 1.0f);
+  }
+
+  assert (instances.numInstances (Type::Sphere) == 3);
+  assert (instances.data (Type::Sphere)[2] == glm::vec4 (0.0f, 2.0f, 0.0f, 0.25f));
+
+  instances.reset ();
+  assert (instances.isPacked () == false);
+  assert (instances.numInstances (Type::Node) == 0);
+}
+
+void TestSketch::test3 ()
+{
+  std::atomic<unsigned int> numFinishedJobs (0);
+  SketchPreview::onFinishedJob ([&numFinishedJobs]() { numFinishedJobs++; });
+
+  SketchTree  tree;
+  SketchNode& root = tree.emplaceRoot (glm::vec3 (0.0f), 1.0f);
+  root.emplaceChild (glm::vec3 (1.5f, 0.0f, 0.0f), 0.5f);
+
+  SketchPreview preview;
+  preview.resolution (0.1f);
+  preview.update (tree, SketchPaths ());
+
+  const unsigned int numBricks = preview.numPendingBricks ();
+  assert (numBricks > 0);
+  unused (numBricks);
+  finish (preview);
+  checkPreview (preview, tree, SketchPaths ());
+
+  while (numFinishedJobs == 0)
+  {
+    std::this_thread::yield ();
+  }
+  SketchPreview::onFinishedJob (nullptr);
+
+  // Unchanged primitives don't mark any brick
+  preview.update (tree, SketchPaths ());
+  assert (preview.isPending () == false);
+
+  // Added primitives only mark the bricks around them, whose cached samples are extended
+  const SketchPaths paths1 = pathOfSphere (glm::vec3 (0.0f, 1.0f, 0.0f), 0.3f);
+  preview.update (tree, paths1);
+  assert (preview.numPendingBricks () > 0);
+  assert (preview.numPendingBricks () < numBricks);
+  finish (preview);
+  checkPreview (preview, tree, paths1);
+
+  // Moved primitives mark the bricks around their old and new position
+  const SketchPaths paths2 = pathOfSphere (glm::vec3 (0.0f, 1.2f, 0.0f), 0.3f);
+  preview.update (tree, paths2);
+  assert (preview.numPendingBricks () > 0);
+  assert (preview.numPendingBricks () < numBricks);
+  finish (preview);
+  checkPreview (preview, tree, paths2);
+
+  // Removed primitives mark their bricks for resampling
+  preview.update (tree, SketchPaths ());
+  assert (preview.numPendingBricks () > 0);
+  finish (preview);
+  checkPreview (preview, tree, SketchPaths ());
+
+  // Resetting and destroying previews doesn't wait for the workers, which drop cancelled jobs
+  // after their current brick and continue with the next job
+  {
+    SketchPreview cancelled;
+    cancelled.resolution (0.01f);
+    cancelled.update (tree, paths1);
+    assert (cancelled.isPending ());
+
+    cancelled.reset ();
+    assert (cancelled.isPending () == false);
+    assert (cancelled.numPendingBricks () == 0);
+    assert (cancelled.numVertices () == 0);
+
+    cancelled.update (tree, paths1);
+    assert (cancelled.isPending ());
+  }
+  checkPreview (preview, tree, SketchPaths ());
+}
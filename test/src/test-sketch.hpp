@@ -0,0 +1,15 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_TEST_SKETCH
+#define DILAY_TEST_SKETCH
+
+namespace TestSketch
+{
+  void test1 ();
+  void test2 ();
+  void test3 ();
+}
+
+#endif
@@ -3,6 +3,7 @@
  * Use and redistribute under the terms of the GNU General Public License
  */
 #include <cassert>
+#include <vector>
 #include "test-tree.hpp"
 #include "tree.hpp"
 
@@ -102,3 +103,56 @@ void TestTree::test3 ()
   assert (t3.root ().data () == 1);
   assert (t3.root ().lastChild ().data () == 2);
 }
+
+void TestTree::test4 ()
+{
+  Tree<int>                   t;
+  std::vector<TreeNode<int>*> nodes;
+
+  nodes.push_back (&t.emplaceRoot (0));
+  for (int i = 1; i < 2000; i++)
+  {
+    nodes.push_back (&nodes[(i - 1) / 2]->emplaceChild (i));
+  }
+  for (int i = 0; i < 2000; i++)
+  {
+    assert (nodes[i]->data () == i);
+    assert (i == 0 || nodes[i]->parent () == nodes[(i - 1) / 2]);
+  }
+
+  std::vector<bool> visited (2000, false);
+  t.root ().forEachConstNode ([&visited](const TreeNode<int>& n) {
+    assert (n.parent () == nullptr || visited[n.parent ()->data ()]);
+    visited[n.data ()] = true;
+  });
+
+  Tree<int> copy (t);
+  assert (copy.root ().numNodes () == 2000);
+  assert (&copy.root ().lastChild () != &t.root ().lastChild ());
+  assert (copy.root ().lastChild ().parent () == &copy.root ());
+
+  t.root ().deleteChild (*nodes[1]);
+  assert (t.root ().numNodes () == 977);
+  assert (copy.root ().numNodes () == 2000);
+
+  TreeNode<int>& reused = nodes[2]->emplaceChild (-1);
+  assert (reused.parent () == nodes[2]);
+  assert (t.root ().numNodes () == 978);
+
+  nodes[2]->addChild (*nodes[2]);
+  assert (t.root ().numNodes () == 1955);
+  assert (nodes[2]->lastChild ().numNodes () == 977);
+
+  t.root ().forEachNode ([](TreeNode<int>& n) {
+    n.deleteChildIf ([](const TreeNode<int>& c) { return c.data () < 0; });
+  });
+  assert (t.root ().numNodes () == 1953);
+
+  t.rebalance (*nodes[6]);
+  assert (&t.root () == nodes[6]);
+  assert (nodes[6]->parent () == nullptr);
+  assert (nodes[2]->parent () == nodes[6]);
+  assert (nodes[0]->parent () == nodes[2]);
+  assert (t.root ().numNodes () == 1953);
+  assert (t.root ().lastChild ().data () == 2);
+}
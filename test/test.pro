@@ -8,23 +8,33 @@ INCLUDEPATH    += src $$PWD/../lib/src
 
 SOURCES += \
            src/main.cpp \
+           src/test-autosave.cpp \
            src/test-bitset.cpp \
            src/test-distance.cpp \
+           src/test-import-export.cpp \
            src/test-intersection.cpp \
            src/test-maybe.cpp \
+           src/test-mesh-changes.cpp \
            src/test-misc.cpp \
            src/test-octree.cpp \
            src/test-prune.cpp \
+           src/test-remesh.cpp \
+           src/test-sketch.cpp \
            src/test-tree.cpp
 
 HEADERS += \
+           src/test-autosave.hpp \
            src/test-bitset.hpp \
            src/test-distance.hpp \
+           src/test-import-export.hpp \
            src/test-intersection.hpp \
            src/test-maybe.hpp \
+           src/test-mesh-changes.hpp \
            src/test-misc.hpp \
            src/test-octree.hpp \
            src/test-prune.hpp \
+           src/test-remesh.hpp \
+           src/test-sketch.hpp \
            src/test-tree.hpp
 
 win32:CONFIG(release, debug|release):    LIBS += -L$$OUT_PWD/../lib/release/ -ldilay